@@ -0,0 +1,117 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#ifndef FASTQINDEX_BENCHMARKHELPERS_H
+#define FASTQINDEX_BENCHMARKHELPERS_H
+
+#include <chrono>
+#include <experimental/filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+using namespace std;
+using namespace std::chrono;
+using std::experimental::filesystem::path;
+
+/**
+ * Wall time in seconds since start.
+ */
+inline double secondsSince(steady_clock::time_point start) {
+    return duration<double>(steady_clock::now() - start).count();
+}
+
+/**
+ * Escapes text for a JSON string. Quotes and backslashes are escaped, control characters are written as \uXXXX.
+ */
+inline string escapeForJSON(const string &text) {
+    stringstream result;
+    for (auto c : text) {
+        if (c == '"' || c == '\\')
+            result << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20)
+            result << "\\u" << hex << setw(4) << setfill('0') << static_cast<int>(c) << dec;
+        else
+            result << c;
+    }
+    return result.str();
+}
+
+/**
+ * Writes gzip members. The zlib flush mode of each write selects the layout of the member, e.g. Z_BLOCK for a block end
+ * after the data.
+ */
+class GzipWriter {
+
+private:
+
+    ofstream output;
+
+    z_stream stream{};
+
+    bool memberIsOpen{false};
+
+    vector<Bytef> buffer = vector<Bytef>(256 * 1024);
+
+    bool deflateAndWrite(int flushMode) {
+        int result;
+        do {
+            stream.next_out = buffer.data();
+            stream.avail_out = static_cast<uInt>(buffer.size());
+            result = deflate(&stream, flushMode);
+            if (result == Z_STREAM_ERROR)
+                return false;
+            output.write(reinterpret_cast<const char *>(buffer.data()), buffer.size() - stream.avail_out);
+        } while (stream.avail_out == 0);
+        return output.good();
+    }
+
+public:
+
+    u_int64_t members{0};
+
+    explicit GzipWriter(const path &file) : output(file, ios::binary | ios::trunc) {}
+
+    ~GzipWriter() {
+        finishMember();
+    }
+
+    /**
+     * Compresses the data. flushMode is used after the data was passed to zlib, e.g. Z_BLOCK or Z_FULL_FLUSH.
+     */
+    bool write(const string &data, int flushMode) {
+        if (!memberIsOpen) {
+            if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+                return false;
+            memberIsOpen = true;
+            members++;
+        }
+        stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+        stream.avail_in = static_cast<uInt>(data.size());
+        return deflateAndWrite(flushMode);
+    }
+
+    bool finishMember() {
+        if (!memberIsOpen)
+            return true;
+        stream.avail_in = 0;
+        bool result = deflateAndWrite(Z_FINISH);
+        deflateEnd(&stream);
+        memberIsOpen = false;
+        return result;
+    }
+
+    bool close() {
+        bool result = finishMember();
+        output.close();
+        return result && !output.fail();
+    }
+};
+
+#endif //FASTQINDEX_BENCHMARKHELPERS_H
@@ -0,0 +1,339 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+/**
+ * End-to-end benchmark for indexing and extraction. The results are printed as JSON to stdout, so they can be stored
+ * and compared between releases. Progress is printed to stderr.
+ *
+ * Usage: fastqindex_bench <work directory> <FASTQ.gz> [copies] [repetitions] [segments]
+ *
+ * Three files are derived from the input file in the work directory:
+ * - single:       The input file as it is (copied, if it consists of several gzip members).
+ * - concatenated: The input file concatenated [copies] times with itself (default 4).
+ * - tiny-block:   The decompressed input stored in many small gzip members like in files from the SRA.
+ *
+ * Each file is indexed with the BlockDistance and the ByteDistance strategy (both with automatic distances). For each
+ * index, the benchmark measures:
+ * - Indexing time, compressed MB/s, the index size and its number of entries.
+ * - The latency for the extraction of one record at the start, in the middle and at the end of the file. The median of
+ *   [repetitions] runs (default 5) is reported.
+ * - The throughput for the extraction of all [segments] segments (default 8), measured on the decompressed data.
+ * - The peak resident memory of indexing and of segment extraction. The peak is reset before each measurement, if the
+ *   kernel allows it (/proc/self/clear_refs), otherwise it is the peak of the whole process.
+ */
+
+#include "BenchmarkHelpers.h"
+#include "MeasuringSink.h"
+#include "process/extract/Extractor.h"
+#include "process/extract/IndexReader.h"
+#include "process/index/IndexEntryStorageDecisionStrategy.h"
+#include "process/index/Indexer.h"
+#include "process/io/FileSink.h"
+#include "process/io/FileSource.h"
+#include <algorithm>
+#include <experimental/filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <vector>
+#include <zlib.h>
+
+using namespace std;
+using namespace std::chrono;
+using namespace std::experimental::filesystem;
+
+/**
+ * Lines per gzip member of the tiny-block file.
+ */
+const int LINES_PER_TINY_BLOCK = 64;
+
+double toMB(int64_t bytes) {
+    return static_cast<double>(bytes) / MB;
+}
+
+/**
+ * Resets the peak resident set size of the process (VmHWM). Returns false, if the kernel does not support this.
+ */
+bool resetPeakRSS() {
+    ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+    clearRefs.flush();
+    return clearRefs.good();
+}
+
+/**
+ * @return The peak resident set size in kB.
+ */
+int64_t readPeakRSS() {
+    ifstream status("/proc/self/status");
+    string line;
+    while (getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0)
+            return stoll(line.substr(6));
+    }
+    struct rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+bool createConcatenatedFile(const path &fastq, const path &result, int copies) {
+    ifstream input(fastq, ios::binary);
+    string content((istreambuf_iterator<char>(input)), istreambuf_iterator<char>());
+    ofstream output(result, ios::binary | ios::trunc);
+    for (int i = 0; i < copies; i++)
+        output << content;
+    return !content.empty() && output.good();
+}
+
+bool createTinyBlockFile(const path &fastq, const path &result) {
+    gzFile input = gzopen(fastq.c_str(), "rb");
+    if (!input)
+        return false;
+    // Every block is a complete gzip member.
+    GzipWriter output(result);
+    string block;
+    int linesInBlock = 0;
+    char buffer[64 * 1024];
+    int readBytes = 0;
+    bool ok = true;
+    while (ok && (readBytes = gzread(input, buffer, sizeof(buffer))) > 0) {
+        for (int i = 0; ok && i < readBytes; i++) {
+            block += buffer[i];
+            if (buffer[i] == '\n' && ++linesInBlock == LINES_PER_TINY_BLOCK) {
+                ok = output.write(block, Z_NO_FLUSH) && output.finishMember();
+                block.clear();
+                linesInBlock = 0;
+            }
+        }
+    }
+    if (ok && !block.empty())
+        ok = output.write(block, Z_NO_FLUSH);
+    ok = ok && readBytes == 0;
+    gzclose(input);
+    return output.close() && ok;
+}
+
+struct Strategy {
+    string name;
+    function<shared_ptr<IndexEntryStorageDecisionStrategy>()> create;
+};
+
+struct CaseResult {
+    string fileType;
+    string strategy;
+    int64_t compressedBytes{0};
+    bool successful{false};
+    vector<string> errors;
+
+    int64_t lines{0};
+    double indexSeconds{0};
+    int64_t indexBytes{0};
+    int64_t indexEntries{0};
+    int64_t indexPeakRSS{0};
+
+    double startLatency{0};
+    double middleLatency{0};
+    double endLatency{0};
+
+    int segments{0};
+    double segmentSeconds{0};
+    int64_t segmentBytes{0};
+    int64_t segmentPeakRSS{0};
+};
+
+bool runIndexing(const path &fastq, const path &index, const Strategy &strategy, CaseResult &result) {
+    resetPeakRSS();
+    auto start = steady_clock::now();
+    Indexer indexer(make_shared<FileSource>(fastq), make_shared<FileSink>(index, true), strategy.create(),
+                    false, true, false, true);
+    bool ok = indexer.createIndex();
+    result.indexSeconds = secondsSince(start);
+    result.indexPeakRSS = readPeakRSS();
+    if (!ok) {
+        result.errors = indexer.getErrorMessages();
+        return false;
+    }
+
+    IndexReader reader(make_shared<FileSource>(index));
+    if (!reader.tryOpenAndReadHeader()) {
+        result.errors = reader.getErrorMessages();
+        return false;
+    }
+    result.lines = reader.getIndexHeader().linesInIndexedFile;
+    result.indexEntries = reader.getIndicesLeft();
+    result.indexBytes = static_cast<int64_t>(file_size(index));
+    return true;
+}
+
+/**
+ * Runs an extraction and returns the number of extracted Bytes or -1 on errors.
+ */
+int64_t runExtraction(const path &fastq, const path &index, ExtractMode mode, int64_t start, int64_t count,
+                      CaseResult &result) {
+    auto sink = make_shared<MeasuringSink>();
+    Extractor extractor(make_shared<FileSource>(fastq), make_shared<FileSource>(index), sink, false, mode, start,
+                        count, DEFAULT_RECORD_SIZE, false);
+    if (!extractor.fulfillsPremises() || !extractor.extract()) {
+        result.errors = extractor.getErrorMessages();
+        return -1;
+    }
+    return sink->writtenBytes;
+}
+
+/**
+ * @return The median latency in milliseconds for the extraction of one record at the given line or -1 on errors.
+ */
+double measureLatency(const path &fastq, const path &index, int64_t line, int repetitions, CaseResult &result) {
+    vector<double> latencies;
+    for (int i = 0; i < repetitions; i++) {
+        auto start = steady_clock::now();
+        if (runExtraction(fastq, index, ExtractMode::lines, line, DEFAULT_RECORD_SIZE, result) <= 0)
+            return -1;
+        latencies.emplace_back(secondsSince(start) * 1000);
+    }
+    sort(latencies.begin(), latencies.end());
+    return latencies[latencies.size() / 2];
+}
+
+bool runSegments(const path &fastq, const path &index, int segments, CaseResult &result) {
+    resetPeakRSS();
+    auto start = steady_clock::now();
+    for (int segment = 0; segment < segments; segment++) {
+        auto bytes = runExtraction(fastq, index, ExtractMode::segment, segment, segments, result);
+        if (bytes < 0)
+            return false;
+        result.segmentBytes += bytes;
+    }
+    result.segmentSeconds = secondsSince(start);
+    result.segmentPeakRSS = readPeakRSS();
+    result.segments = segments;
+    return true;
+}
+
+CaseResult runCase(const string &fileType, const path &fastq, const Strategy &strategy, const path &workDirectory,
+                   int repetitions, int segments) {
+    CaseResult result;
+    result.fileType = fileType;
+    result.strategy = strategy.name;
+    result.compressedBytes = static_cast<int64_t>(file_size(fastq));
+    cerr << "Running " << fileType << " / " << strategy.name << "\n";
+
+    path index = workDirectory / (fastq.filename().string() + "." + strategy.name + ".fqi");
+    if (!runIndexing(fastq, index, strategy, result))
+        return result;
+
+    // Start at a record boundary.
+    int64_t lastRecord = max(result.lines - DEFAULT_RECORD_SIZE, static_cast<int64_t>(0));
+    int64_t middleRecord = result.lines / 2 / DEFAULT_RECORD_SIZE * DEFAULT_RECORD_SIZE;
+    result.startLatency = measureLatency(fastq, index, 0, repetitions, result);
+    result.middleLatency = measureLatency(fastq, index, middleRecord, repetitions, result);
+    result.endLatency = measureLatency(fastq, index, lastRecord, repetitions, result);
+    if (result.startLatency < 0 || result.middleLatency < 0 || result.endLatency < 0)
+        return result;
+
+    result.successful = runSegments(fastq, index, segments, result);
+    remove(index);
+    return result;
+}
+
+void printJSON(const path &input, int repetitions, bool peakRSSCanBeReset, const vector<CaseResult> &results) {
+    cout << fixed << setprecision(3);
+    cout << "{\n"
+         << "  \"benchmark\": \"fastqindex_bench\",\n"
+         << "  \"indexWriterVersion\": " << IndexWriter::INDEX_WRITER_VERSION << ",\n"
+         << "  \"input\": \"" << escapeForJSON(input.string()) << "\",\n"
+         << "  \"repetitions\": " << repetitions << ",\n"
+         << "  \"peakRSSIsPerMeasurement\": " << (peakRSSCanBeReset ? "true" : "false") << ",\n"
+         << "  \"results\": [";
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto &r = results[i];
+        cout << (i > 0 ? "," : "") << "\n    {\n"
+             << "      \"fileType\": \"" << r.fileType << "\",\n"
+             << "      \"strategy\": \"" << r.strategy << "\",\n"
+             << "      \"compressedBytes\": " << r.compressedBytes << ",\n"
+             << "      \"successful\": " << (r.successful ? "true" : "false") << ",\n";
+        if (!r.successful) {
+            cout << "      \"errors\": [";
+            for (size_t e = 0; e < r.errors.size(); e++)
+                cout << (e > 0 ? ", " : "") << "\"" << escapeForJSON(r.errors[e]) << "\"";
+            cout << "]\n    }";
+            continue;
+        }
+        cout << "      \"lines\": " << r.lines << ",\n"
+             << "      \"index\": {\"seconds\": " << r.indexSeconds
+             << ", \"compressedMBPerSecond\": " << toMB(r.compressedBytes) / r.indexSeconds
+             << ", \"indexBytes\": " << r.indexBytes
+             << ", \"entries\": " << r.indexEntries
+             << ", \"peakRSSkB\": " << r.indexPeakRSS << "},\n"
+             << "      \"extractRecordLatencyMs\": {\"start\": " << r.startLatency
+             << ", \"middle\": " << r.middleLatency
+             << ", \"end\": " << r.endLatency << "},\n"
+             << "      \"segments\": {\"count\": " << r.segments
+             << ", \"seconds\": " << r.segmentSeconds
+             << ", \"decompressedMBPerSecond\": " << toMB(r.segmentBytes) / r.segmentSeconds
+             << ", \"decompressedBytes\": " << r.segmentBytes
+             << ", \"peakRSSkB\": " << r.segmentPeakRSS << "}\n"
+             << "    }";
+    }
+    cout << "\n  ]\n}\n";
+}
+
+int main(int argc, const char *argv[]) {
+    if (argc < 3) {
+        cerr << "Usage: fastqindex_bench <work directory> <FASTQ.gz> [copies] [repetitions] [segments]\n";
+        return 1;
+    }
+
+    path workDirectory = argv[1];
+    path fastq = argv[2];
+    int copies = argc > 3 ? stoi(argv[3]) : 4;
+    int repetitions = argc > 4 ? max(stoi(argv[4]), 1) : 5;
+    int segments = argc > 5 ? max(stoi(argv[5]), 1) : 8;
+
+    if (!is_directory(workDirectory) || !exists(fastq)) {
+        cerr << "The work directory '" << workDirectory.string() << "' or the FASTQ file '" << fastq.string()
+             << "' does not exist.\n";
+        return 1;
+    }
+
+    string baseName = fastq.filename().string();
+    vector<pair<string, path>> files{
+            {"single",       workDirectory / ("single_" + baseName)},
+            {"concatenated", workDirectory / ("concatenated_" + baseName)},
+            {"tiny-block",   workDirectory / ("tinyblock_" + baseName)}
+    };
+    cerr << "Preparing the input files in '" << workDirectory.string() << "'\n";
+    if (!createConcatenatedFile(fastq, files[0].second, 1) ||
+        !createConcatenatedFile(fastq, files[1].second, copies) ||
+        !createTinyBlockFile(fastq, files[2].second)) {
+        cerr << "Could not prepare the input files.\n";
+        return 1;
+    }
+
+    vector<Strategy> strategies{
+            {"BlockDistance", []() { return BlockDistanceStorageDecisionStrategy::getDefault(); }},
+            {"ByteDistance",  []() {
+                return shared_ptr<IndexEntryStorageDecisionStrategy>(
+                        new ByteDistanceStorageDecisionStrategy(IndexEntryStorageDecisionStrategy::AUTO_DISTANCE));
+            }}
+    };
+
+    bool peakRSSCanBeReset = resetPeakRSS();
+    vector<CaseResult> results;
+    for (const auto &[fileType, file] : files)
+        for (const auto &strategy : strategies)
+            results.emplace_back(runCase(fileType, file, strategy, workDirectory, repetitions, segments));
+
+    for (const auto &[fileType, file] : files)
+        remove(file);
+
+    printJSON(fastq, repetitions, peakRSSCanBeReset, results);
+    return all_of(results.begin(), results.end(), [](const CaseResult &r) { return r.successful; }) ? 0 : 1;
+}
@@ -0,0 +1,266 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+/**
+ * Generates synthetic FASTQ.gz files for performance tests. The content only depends on the options and the seed, so
+ * the same command creates the same file on every machine. The random numbers are created with splitmix64 and not with
+ * the std distributions, whose results differ between standard library implementations.
+ *
+ * Usage: fastqgenerator -o=<FASTQ.gz> [-s=<size>] [-r=<read length>] [-q=<quality profile>] [-l=<layout>] [-e=<seed>]
+ *
+ * The ground truth (records, lines, Bytes, gzip members) is printed as JSON to stdout.
+ */
+
+#include "BenchmarkHelpers.h"
+#include "common/CommonStructsAndConstants.h"
+#include "common/StringHelper.h"
+#include "process/io/CompressingSink.h"
+#include "process/io/FileSink.h"
+#include <experimental/filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <tclap/CmdLine.h>
+#include <vector>
+#include <zlib.h>
+
+using namespace std;
+using namespace std::experimental::filesystem;
+using namespace TCLAP;
+
+/**
+ * How the generated FASTQ data is compressed:
+ * - single:       One gzip member, like gzip creates it.
+ * - multi-member: Several concatenated gzip members of --member-size uncompressed Bytes each.
+ * - tiny-blocks:  One gzip member with a deflate block end every --block-size uncompressed Bytes.
+ * - bgzf:         BGZF blocks like bgzip creates them, written by the CompressingSink.
+ * - full-flush:   One gzip member with a full flush point (no back references over it) every --block-size Bytes.
+ */
+const vector<string> LAYOUTS{"single", "multi-member", "tiny-blocks", "bgzf", "full-flush"};
+
+/**
+ * Quality profiles:
+ * - illumina: Qualities around 37 at the start of the read, which decline towards its end, with noise and some '#'
+ *             tails.
+ * - binned:   Like illumina, but binned to the four values of NovaSeq instruments (2, 12, 23, 37).
+ * - constant: All qualities are 37. Compresses much better than real data.
+ */
+const vector<string> QUALITY_PROFILES{"illumina", "binned", "constant"};
+
+/**
+ * splitmix64, see http://prng.di.unimi.it/splitmix64.c
+ */
+class Random {
+
+private:
+
+    u_int64_t state;
+
+public:
+
+    explicit Random(u_int64_t seed) : state(seed) {}
+
+    u_int64_t next() {
+        u_int64_t z = (state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30U)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27U)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31U);
+    }
+
+    /**
+     * @return A number in [0, bound). The small modulo bias does not matter here.
+     */
+    u_int32_t below(u_int32_t bound) {
+        return static_cast<u_int32_t>(next() % bound);
+    }
+};
+
+class RecordGenerator {
+
+private:
+
+    Random random;
+
+    uint readLength;
+
+    string qualityProfile;
+
+    u_int64_t recordNumber{0};
+
+    u_int32_t tile{1101};
+
+    u_int32_t x{1000};
+
+    int phredQuality(uint position) {
+        if (qualityProfile == "constant")
+            return 37;
+
+        // Linear decline from 37 to 30 over the read with some noise.
+        int quality = 37 - static_cast<int>(7 * position / max(readLength, 1U)) + static_cast<int>(random.below(5)) - 2;
+        if (quality > 41)
+            quality = 41;
+        if (qualityProfile == "binned")
+            return quality >= 30 ? 37 : quality >= 20 ? 23 : quality >= 10 ? 12 : 2;
+        return quality;
+    }
+
+public:
+
+    RecordGenerator(u_int64_t seed, uint readLength, const string &qualityProfile) :
+            random(seed), readLength(readLength), qualityProfile(qualityProfile) {}
+
+    void appendRecord(string &target) {
+        static const char bases[] = "ACGT";
+        recordNumber++;
+        x += 1 + random.below(200);
+        if (x > 20000) {
+            x = 1000;
+            tile++;
+        }
+        target += "@SIM:1:FCX00000:1:" + to_string(tile) + ":" + to_string(x) + ":" +
+                  to_string(1000 + random.below(200000)) + " 1:N:0:" + to_string(recordNumber) + "\n";
+
+        bool badTail = random.below(20) == 0;
+        uint tailStart = badTail ? readLength - 1 - random.below(max(readLength / 4, 1U)) : readLength;
+        string qualities(readLength, '#');
+        for (uint i = 0; i < readLength; i++) {
+            bool isN = i >= tailStart ? random.below(4) == 0 : random.below(1000) == 0;
+            target += isN ? 'N' : bases[random.below(4)];
+            if (!isN && i < tailStart)
+                qualities[i] = static_cast<char>(33 + phredQuality(i));
+        }
+        target += "\n+\n";
+        target += qualities;
+        target += "\n";
+    }
+};
+
+/**
+ * Walks over the BGZF blocks with the block sizes stored in their headers.
+ * @return The number of blocks including the EOF block or 0, if the file is not a valid BGZF file.
+ */
+u_int64_t countBgzfBlocks(const path &file) {
+    ifstream input(file, ios::binary);
+    u_int64_t blocks = 0;
+    unsigned char header[CompressingSink::BGZF_HEADER_SIZE];
+    while (input.read(reinterpret_cast<char *>(header), sizeof(header))) {
+        if (header[0] != 0x1f || header[1] != 0x8b || header[12] != 'B' || header[13] != 'C')
+            return 0;
+        auto blockSize = static_cast<u_int32_t>(header[16] | header[17] << 8U) + 1;
+        input.seekg(blockSize - sizeof(header), ios::cur);
+        blocks++;
+    }
+    return blocks;
+}
+
+int main(int argc, const char *argv[]) {
+    CmdLine cmdLineParser("Generates synthetic FASTQ.gz files for performance tests.", '=', "1.0", true);
+
+    ValueArg<u_int64_t> seedArg("e", "seed", "The seed for the random numbers. The same seed and options create the "
+                                             "same file.", false, 1, "uint", cmdLineParser);
+    ValueArg<string> blockSizeArg("b", "block-size", "Uncompressed Bytes between two block ends or flush points for "
+                                                     "the tiny-blocks and the full-flush layout. Accepts units like "
+                                                     "512k, a number without unit is in MB.", false, "4k", "string",
+                                  cmdLineParser);
+    ValueArg<string> memberSizeArg("m", "member-size", "Uncompressed Bytes per gzip member for the multi-member "
+                                                       "layout. Accepts units like 512k, a number without unit is in "
+                                                       "MB.", false, "16m", "string", cmdLineParser);
+    ValuesConstraint<string> layoutConstraint(const_cast<vector<string> &>(LAYOUTS));
+    ValueArg<string> layoutArg("l", "layout", "The layout of the compressed file.", false, "single", &layoutConstraint,
+                               cmdLineParser);
+    ValuesConstraint<string> qualityConstraint(const_cast<vector<string> &>(QUALITY_PROFILES));
+    ValueArg<string> qualityArg("q", "quality-profile", "The quality profile of the reads.", false, "illumina",
+                                &qualityConstraint, cmdLineParser);
+    ValueArg<uint> readLengthArg("r", "read-length", "The length of the reads.", false, 150, "uint", cmdLineParser);
+    ValueArg<string> sizeArg("s", "size", "The minimum uncompressed size of the FASTQ data. Accepts units like 512k "
+                                          "or 2g, a number without unit is in MB.", false, "64m", "string",
+                             cmdLineParser);
+    ValueArg<string> outputArg("o", "output", "The FASTQ.gz file which shall be created.", true, "", "string",
+                               cmdLineParser);
+    cmdLineParser.parse(argc, argv);
+
+    int64_t size = StringHelper::parseStringValue(sizeArg.getValue());
+    int64_t blockSize = StringHelper::parseStringValue(blockSizeArg.getValue());
+    int64_t memberSize = StringHelper::parseStringValue(memberSizeArg.getValue());
+    uint readLength = readLengthArg.getValue();
+    string layout = layoutArg.getValue();
+    path output = outputArg.getValue();
+    if (size <= 0 || blockSize <= 0 || memberSize <= 0 || readLength == 0) {
+        cerr << "The size, block size, member size and read length must be larger than 0.\n";
+        return 1;
+    }
+
+    RecordGenerator generator(seedArg.getValue(), readLength, qualityArg.getValue());
+    shared_ptr<GzipWriter> gzipWriter;
+    shared_ptr<CompressingSink> bgzfWriter;
+    if (layout != "bgzf") {
+        gzipWriter = make_shared<GzipWriter>(output);
+    } else {
+        bgzfWriter = CompressingSink::from(FileSink::from(output, true), BGZF);
+        if (!bgzfWriter->openWithWriteLock()) {
+            cerr << "Could not open '" << output.string() << "'.\n";
+            return 1;
+        }
+    }
+
+    // Records are collected in pieces, which are passed to the compressor at once. Pieces end with a record end, so
+    // block ends, flush points and members are at record boundaries, if the records are smaller than a piece.
+    int64_t pieceSize = layout == "tiny-blocks" || layout == "full-flush" ? blockSize :
+                        layout == "multi-member" ? min(memberSize, static_cast<int64_t>(MB)) : MB;
+    int flushMode = layout == "tiny-blocks" ? Z_BLOCK : layout == "full-flush" ? Z_FULL_FLUSH : Z_NO_FLUSH;
+    u_int64_t records = 0;
+    int64_t uncompressedBytes = 0;
+    int64_t bytesInMember = 0;
+    bool ok = true;
+    string piece;
+    while (ok && uncompressedBytes < size) {
+        piece.clear();
+        while (static_cast<int64_t>(piece.size()) < pieceSize &&
+               uncompressedBytes + static_cast<int64_t>(piece.size()) < size) {
+            generator.appendRecord(piece);
+            records++;
+        }
+        uncompressedBytes += piece.size();
+        if (bgzfWriter) {
+            bgzfWriter->write(piece);
+            continue;
+        }
+        ok = gzipWriter->write(piece, flushMode);
+        bytesInMember += piece.size();
+        if (layout == "multi-member" && bytesInMember >= memberSize) {
+            ok = ok && gzipWriter->finishMember();
+            bytesInMember = 0;
+        }
+    }
+    u_int64_t members;
+    if (bgzfWriter) {
+        ok = bgzfWriter->close();
+        // The blocks are cut at line ends, so their number is only known afterwards.
+        members = countBgzfBlocks(output);
+        ok = ok && members > 0;
+    } else {
+        ok = gzipWriter->close() && ok;
+        members = gzipWriter->members;
+    }
+    if (!ok) {
+        cerr << "Could not write '" << output.string() << "'.\n";
+        return 1;
+    }
+
+    cout << "{\n"
+         << "  \"file\": \"" << escapeForJSON(output.string()) << "\",\n"
+         << "  \"layout\": \"" << layout << "\",\n"
+         << "  \"seed\": " << seedArg.getValue() << ",\n"
+         << "  \"readLength\": " << readLength << ",\n"
+         << "  \"qualityProfile\": \"" << qualityArg.getValue() << "\",\n"
+         << "  \"records\": " << records << ",\n"
+         << "  \"lines\": " << records * 4 << ",\n"
+         << "  \"uncompressedBytes\": " << uncompressedBytes << ",\n"
+         << "  \"compressedBytes\": " << file_size(output) << ",\n"
+         << "  \"gzipMembers\": " << members << "\n"
+         << "}\n";
+    return 0;
+}
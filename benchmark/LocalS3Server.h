@@ -0,0 +1,443 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#ifndef FASTQINDEX_LOCALS3SERVER_H
+#define FASTQINDEX_LOCALS3SERVER_H
+
+#include "SimulatedS3.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <experimental/filesystem>
+#include <fstream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+using namespace std::experimental::filesystem;
+
+/**
+ * Minimal S3 compatible HTTP server on 127.0.0.1, which serves a SimulatedS3Bucket. It lets the benchmark run the real
+ * S3Source, S3Sink, FQIS3Client and AWS SDK code without a bucket: the SDK is pointed at the server with host_base and
+ * use_https = False, see writeConfigFile().
+ *
+ * Supported are the requests of FQIS3Client: HEAD, ranged GET, ListObjects, PUT and the multipart upload requests.
+ * Requests are only accepted with path style addressing, the bucket name must therefore not be a valid DNS label.
+ * Authentication is not checked. Every request is delayed like configured in the SimulatedNetwork.
+ */
+class LocalS3Server {
+
+private:
+
+    struct Request {
+        string method;
+        string bucket;
+        string key;
+        map<string, string> query;
+        map<string, string> headers;
+        string body;
+    };
+
+    struct Response {
+        int status{200};
+        map<string, string> headers;
+        string body;
+        /**
+         * Announced length for HEAD requests, which don't send the body. -1 to use the length of the body.
+         */
+        int64_t contentLength{-1};
+    };
+
+    SimulatedS3Bucket &bucket;
+
+    SimulatedNetwork network;
+
+    SimulatedS3Statistics &statistics;
+
+    int listeningSocket{-1};
+
+    uint16_t port{0};
+
+    thread acceptor;
+
+    mutex connectionsMutex;
+
+    vector<int> connectionSockets;
+
+    vector<thread> connections;
+
+    mutex uploadsMutex;
+
+    map<string, map<int, shared_ptr<const string>>> uploads;
+
+    int64_t uploadCounter{0};
+
+    static string urlDecode(const string &value) {
+        string result;
+        for (size_t i = 0; i < value.size(); i++) {
+            if (value[i] == '%' && i + 2 < value.size()) {
+                result += static_cast<char>(stoi(value.substr(i + 1, 2), nullptr, 16));
+                i += 2;
+            } else {
+                result += value[i];
+            }
+        }
+        return result;
+    }
+
+    static string eTagOf(const string &content) {
+        stringstream eTag;
+        eTag << "\"" << hex << hash<string>{}(content) << "\"";
+        return eTag.str();
+    }
+
+    static const char *reasonOf(int status) {
+        switch (status) {
+            case 100:
+                return "Continue";
+            case 200:
+                return "OK";
+            case 204:
+                return "No Content";
+            case 206:
+                return "Partial Content";
+            case 404:
+                return "Not Found";
+            default:
+                return "Bad Request";
+        }
+    }
+
+    static Response error(int status, const string &code) {
+        Response response;
+        response.status = status;
+        response.headers["Content-Type"] = "application/xml";
+        response.body = "<?xml version=\"1.0\" encoding=\"UTF-8\"?><Error><Code>" + code + "</Code><Message>" + code +
+                        "</Message></Error>";
+        return response;
+    }
+
+    static bool sendAll(int socket, const string &data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            auto result = send(socket, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (result <= 0)
+                return false;
+            sent += static_cast<size_t>(result);
+        }
+        return true;
+    }
+
+    /**
+     * Reads the next request of a connection.
+     * @param pending Received data which was not used yet.
+     * @return false, if the connection was closed.
+     */
+    static bool receiveRequest(int socket, string &pending, Request &request) {
+        char buffer[64 * 1024];
+        size_t headerEnd;
+        while ((headerEnd = pending.find("\r\n\r\n")) == string::npos) {
+            auto received = recv(socket, buffer, sizeof(buffer), 0);
+            if (received <= 0)
+                return false;
+            pending.append(buffer, static_cast<size_t>(received));
+        }
+
+        istringstream header(pending.substr(0, headerEnd));
+        pending.erase(0, headerEnd + 4);
+        string target, version, line;
+        header >> request.method >> target >> version;
+        getline(header, line);
+        while (getline(header, line)) {
+            auto colon = line.find(':');
+            if (colon == string::npos)
+                continue;
+            string name = line.substr(0, colon);
+            transform(name.begin(), name.end(), name.begin(), ::tolower);
+            auto valueStart = line.find_first_not_of(' ', colon + 1);
+            auto valueEnd = line.find_last_not_of("\r ");
+            request.headers[name] =
+                    valueStart == string::npos ? "" : line.substr(valueStart, valueEnd - valueStart + 1);
+        }
+
+        auto questionMark = target.find('?');
+        string path = urlDecode(target.substr(0, questionMark));
+        if (questionMark != string::npos) {
+            istringstream query(target.substr(questionMark + 1));
+            string parameter;
+            while (getline(query, parameter, '&')) {
+                auto equals = parameter.find('=');
+                request.query[urlDecode(parameter.substr(0, equals))] =
+                        equals == string::npos ? "" : urlDecode(parameter.substr(equals + 1));
+            }
+        }
+        // Path style: /bucket/key, the key may contain slashes.
+        auto keyStart = path.find('/', 1);
+        request.bucket = path.substr(1, keyStart == string::npos ? string::npos : keyStart - 1);
+        request.key = keyStart == string::npos ? "" : path.substr(keyStart + 1);
+
+        auto contentLength = request.headers.find("content-length");
+        auto length = contentLength == request.headers.end() ? 0 : stoull(contentLength->second);
+        if (length > 0 && request.headers["expect"] == "100-continue" && pending.empty())
+            sendAll(socket, "HTTP/1.1 100 Continue\r\n\r\n");
+        while (pending.size() < length) {
+            auto received = recv(socket, buffer, sizeof(buffer), 0);
+            if (received <= 0)
+                return false;
+            pending.append(buffer, static_cast<size_t>(received));
+        }
+        request.body = pending.substr(0, length);
+        pending.erase(0, length);
+        return true;
+    }
+
+    static bool sendResponse(int socket, const Request &request, const Response &response) {
+        stringstream header;
+        header << "HTTP/1.1 " << response.status << " " << reasonOf(response.status) << "\r\n";
+        for (const auto &[name, value] : response.headers)
+            header << name << ": " << value << "\r\n";
+        header << "Content-Length: "
+               << (response.contentLength >= 0 ? response.contentLength : static_cast<int64_t>(response.body.size()))
+               << "\r\n\r\n";
+        if (!sendAll(socket, header.str()))
+            return false;
+        return request.method == "HEAD" || sendAll(socket, response.body);
+    }
+
+    Response listObjects(const Request &request) {
+        Response response;
+        response.headers["Content-Type"] = "application/xml";
+        stringstream body;
+        body << "<?xml version=\"1.0\" encoding=\"UTF-8\"?><ListBucketResult><Name>" << request.bucket
+             << "</Name><IsTruncated>false</IsTruncated>";
+        for (const auto &[key, content] : bucket.list()) {
+            body << "<Contents><Key>" << key << "</Key><Size>" << content->size() << "</Size><ETag>"
+                 << eTagOf(*content) << "</ETag></Contents>";
+        }
+        body << "</ListBucketResult>";
+        response.body = body.str();
+        return response;
+    }
+
+    Response getObject(const Request &request, bool headOnly) {
+        auto content = bucket.get(request.key);
+        if (!content)
+            return error(404, "NoSuchKey");
+
+        Response response;
+        response.headers["ETag"] = eTagOf(*content);
+        response.headers["Accept-Ranges"] = "bytes";
+        auto size = static_cast<int64_t>(content->size());
+        int64_t first = 0;
+        int64_t last = size - 1;
+        auto range = request.headers.find("range");
+        if (!headOnly && range != request.headers.end() && range->second.rfind("bytes=", 0) == 0) {
+            auto dash = range->second.find('-');
+            first = stoll(range->second.substr(6, dash - 6));
+            if (dash + 1 < range->second.size())
+                last = min(last, static_cast<int64_t>(stoll(range->second.substr(dash + 1))));
+            response.status = 206;
+            response.headers["Content-Range"] =
+                    "bytes " + to_string(first) + "-" + to_string(last) + "/" + to_string(size);
+        }
+        auto length = max(last - first + 1, static_cast<int64_t>(0));
+        if (headOnly) {
+            response.contentLength = size;
+            network.transfer(0);
+            statistics.requests++;
+        } else {
+            response.body = content->substr(static_cast<size_t>(first), static_cast<size_t>(length));
+            network.transfer(length);
+            statistics.countRequest(length);
+        }
+        return response;
+    }
+
+    Response putObject(const Request &request) {
+        Response response;
+        network.transfer(static_cast<int64_t>(request.body.size()));
+        statistics.countRequest(static_cast<int64_t>(request.body.size()));
+        auto content = make_shared<const string>(request.body);
+        response.headers["ETag"] = eTagOf(*content);
+
+        auto partNumber = request.query.find("partNumber");
+        if (partNumber == request.query.end()) {
+            bucket.put(request.key, content);
+            return response;
+        }
+        lock_guard<mutex> lock(uploadsMutex);
+        auto upload = uploads.find(request.query.at("uploadId"));
+        if (upload == uploads.end())
+            return error(404, "NoSuchUpload");
+        upload->second[stoi(partNumber->second)] = content;
+        return response;
+    }
+
+    Response postObject(const Request &request) {
+        Response response;
+        response.headers["Content-Type"] = "application/xml";
+        network.transfer(0);
+        statistics.requests++;
+        if (request.query.count("uploads")) {
+            string uploadId;
+            {
+                lock_guard<mutex> lock(uploadsMutex);
+                uploadId = "upload" + to_string(++uploadCounter);
+                uploads[uploadId];
+            }
+            response.body = "<?xml version=\"1.0\" encoding=\"UTF-8\"?><InitiateMultipartUploadResult><Bucket>" +
+                            request.bucket + "</Bucket><Key>" + request.key + "</Key><UploadId>" + uploadId +
+                            "</UploadId></InitiateMultipartUploadResult>";
+            return response;
+        }
+
+        // Complete the upload. S3Sink lists all uploaded parts, so the part list in the body is not evaluated.
+        map<int, shared_ptr<const string>> parts;
+        {
+            lock_guard<mutex> lock(uploadsMutex);
+            auto upload = uploads.find(request.query.count("uploadId") ? request.query.at("uploadId") : "");
+            if (upload == uploads.end())
+                return error(404, "NoSuchUpload");
+            parts = std::move(upload->second);
+            uploads.erase(upload);
+        }
+        auto content = make_shared<string>();
+        for (const auto &[partNumber, part] : parts)
+            content->append(*part);
+        bucket.put(request.key, content);
+        response.body = "<?xml version=\"1.0\" encoding=\"UTF-8\"?><CompleteMultipartUploadResult><Bucket>" +
+                        request.bucket + "</Bucket><Key>" + request.key + "</Key><ETag>" + eTagOf(*content) +
+                        "</ETag></CompleteMultipartUploadResult>";
+        return response;
+    }
+
+    Response deleteObject(const Request &request) {
+        Response response;
+        response.status = 204;
+        network.transfer(0);
+        statistics.requests++;
+        if (request.query.count("uploadId")) {
+            lock_guard<mutex> lock(uploadsMutex);
+            uploads.erase(request.query.at("uploadId"));
+        } else {
+            bucket.remove(request.key);
+        }
+        return response;
+    }
+
+    Response handle(const Request &request) {
+        if (request.bucket.empty())
+            return error(400, "InvalidRequest");
+        if (request.key.empty())
+            return request.method == "GET" ? listObjects(request) : error(400, "InvalidRequest");
+        if (request.method == "HEAD" || request.method == "GET")
+            return getObject(request, request.method == "HEAD");
+        if (request.method == "PUT")
+            return putObject(request);
+        if (request.method == "POST")
+            return postObject(request);
+        if (request.method == "DELETE")
+            return deleteObject(request);
+        return error(400, "InvalidRequest");
+    }
+
+    void serve(int socket) {
+        string pending;
+        while (true) {
+            Request request;
+            if (!receiveRequest(socket, pending, request))
+                break;
+            if (!sendResponse(socket, request, handle(request)))
+                break;
+        }
+        shutdown(socket, SHUT_RDWR);
+    }
+
+    void acceptConnections() {
+        while (true) {
+            int socket = accept(listeningSocket, nullptr, nullptr);
+            if (socket < 0)
+                return;
+            int noDelay = 1;
+            setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+            lock_guard<mutex> lock(connectionsMutex);
+            connectionSockets.emplace_back(socket);
+            connections.emplace_back(&LocalS3Server::serve, this, socket);
+        }
+    }
+
+public:
+
+    LocalS3Server(SimulatedS3Bucket &bucket, const SimulatedNetwork &network, SimulatedS3Statistics &statistics) :
+            bucket(bucket), network(network), statistics(statistics) {}
+
+    ~LocalS3Server() {
+        stop();
+    }
+
+    /**
+     * Listens on a free port of 127.0.0.1.
+     */
+    bool start() {
+        listeningSocket = socket(AF_INET, SOCK_STREAM, 0);
+        if (listeningSocket < 0)
+            return false;
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0;
+        socklen_t addressLength = sizeof(address);
+        if (bind(listeningSocket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+            listen(listeningSocket, 64) != 0 ||
+            getsockname(listeningSocket, reinterpret_cast<sockaddr *>(&address), &addressLength) != 0) {
+            ::close(listeningSocket);
+            listeningSocket = -1;
+            return false;
+        }
+        port = ntohs(address.sin_port);
+        acceptor = thread(&LocalS3Server::acceptConnections, this);
+        return true;
+    }
+
+    void stop() {
+        if (listeningSocket < 0)
+            return;
+        shutdown(listeningSocket, SHUT_RDWR);
+        acceptor.join();
+        ::close(listeningSocket);
+        listeningSocket = -1;
+
+        lock_guard<mutex> lock(connectionsMutex);
+        for (auto socket : connectionSockets)
+            shutdown(socket, SHUT_RDWR);
+        for (auto &connection : connections)
+            connection.join();
+        for (auto socket : connectionSockets)
+            ::close(socket);
+        connectionSockets.clear();
+        connections.clear();
+    }
+
+    uint16_t getPort() { return port; }
+
+    /**
+     * Writes an S3 configuration file (see S3Config), which points the SDK to this server.
+     */
+    bool writeConfigFile(const path &file) {
+        ofstream config(file);
+        config << "[default]\n"
+               << "host_base = 127.0.0.1:" << port << "\n"
+               << "use_https = False\n"
+               << "access_key = benchmark\n"
+               << "secret_key = benchmark\n";
+        return config.good();
+    }
+};
+
+#endif //FASTQINDEX_LOCALS3SERVER_H
@@ -0,0 +1,55 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#ifndef FASTQINDEX_MEASURINGSINK_H
+#define FASTQINDEX_MEASURINGSINK_H
+
+#include "process/io/ConsoleSink.h"
+#include <chrono>
+#include <sys/uio.h>
+
+using namespace std;
+using namespace std::chrono;
+
+/**
+ * Drops the extracted data, but counts it and remembers when the first Byte arrived.
+ */
+class MeasuringSink : public ConsoleSink {
+
+private:
+
+    steady_clock::time_point start;
+
+    void count(int64_t bytes) {
+        if (bytes > 0 && writtenBytes == 0)
+            firstByteAfter = duration_cast<microseconds>(steady_clock::now() - start).count();
+        writtenBytes += bytes;
+    }
+
+public:
+
+    int64_t writtenBytes{0};
+
+    /**
+     * Microseconds from start until the first data was written, -1 if nothing was written.
+     */
+    int64_t firstByteAfter{-1};
+
+    explicit MeasuringSink(steady_clock::time_point start = steady_clock::now()) : start(start) {}
+
+    void write(const char * /*message*/, int len) override { count(len); }
+
+    void write(const string &message) override { count(static_cast<int64_t>(message.size())); }
+
+    void writeSpans(const struct iovec *spans, int count) override {
+        for (int i = 0; i < count; i++)
+            this->count(static_cast<int64_t>(spans[i].iov_len));
+    }
+
+    void flush() override {}
+};
+
+#endif //FASTQINDEX_MEASURINGSINK_H
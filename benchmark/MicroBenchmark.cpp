@@ -0,0 +1,284 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+/**
+ * Measures the primitives on the hot paths of the indexer and the extractor. The buffers are taken from a real FASTQ
+ * file, so the numbers can be compared before and after a change to one of the primitives.
+ *
+ * Usage: microbenchmark <FASTQ.gz> [minimum seconds per benchmark]
+ *
+ * The FASTQ file should consist of a single gzip member. Each benchmark repeats its operation until the minimum time
+ * (default 0.5s) is reached and reports the time per operation and the throughput. The results are printed to stdout.
+ */
+
+#include "common/IOHelper.h"
+#include "common/StringHelper.h"
+#include "process/base/ZLibBasedFASTQProcessorBaseClass.h"
+#include "process/extract/IndexReader.h"
+#include "process/index/IndexEntryStorageDecisionStrategy.h"
+#include "process/index/Indexer.h"
+#include "process/io/FileSink.h"
+#include "process/io/FileSource.h"
+#include "process/io/MemoryMappedFileSource.h"
+#include "process/io/StreamSource.h"
+#include <chrono>
+#include <experimental/filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <sys/uio.h>
+#include <vector>
+#include <zlib.h>
+
+using namespace std;
+using namespace std::chrono;
+using namespace std::experimental::filesystem;
+
+double minimumSeconds = 0.5;
+
+/**
+ * Keeps the compiler from removing the calculation of value.
+ */
+template<typename T>
+void keep(T const &value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+/**
+ * Runs benchmark with a growing number of iterations until it took at least minimumSeconds.
+ * @param operations The number of operations per call of benchmark, e.g. the number of read entries.
+ * @param bytes      The number of processed Bytes per call of benchmark.
+ */
+void runMicroBenchmark(const string &name, int64_t operations, int64_t bytes, const function<void()> &benchmark) {
+    benchmark(); // Warm up
+    int64_t iterations = 1;
+    double seconds;
+    while (true) {
+        auto start = steady_clock::now();
+        for (int64_t i = 0; i < iterations; i++)
+            benchmark();
+        seconds = duration<double>(steady_clock::now() - start).count();
+        if (seconds >= minimumSeconds)
+            break;
+        iterations *= 2;
+    }
+    double totalOperations = static_cast<double>(iterations * operations);
+    cout << left << setw(56) << name << right << fixed
+         << setw(14) << setprecision(1) << seconds * 1e9 / totalOperations
+         << setw(12) << setprecision(1) << static_cast<double>(iterations * bytes) / MB / seconds << "\n";
+}
+
+/**
+ * Gives access to the decompression loop of the indexer and the extractor without their processing.
+ */
+class DecompressingProcessor : public ZLibBasedFASTQProcessorBaseClass {
+public:
+
+    explicit DecompressingProcessor(const shared_ptr<Source> &fastq) :
+            ZLibBasedFASTQProcessorBaseClass(fastq, shared_ptr<Source>(), false) {}
+
+    /**
+     * Decompresses the first gzip member block by block, like the indexer does.
+     * @return The number of decompressed Bytes.
+     */
+    int64_t decompress() {
+        sourceFile->open();
+        sourceFile->seek(0, true);
+        totalBytesOut = 0;
+        initializeZStreamForInflate();
+        bool streamEnded = false;
+        while (!streamEnded && readCompressedDataFromSource()) {
+            do {
+                resetSlidingWindowIfNecessary();
+                if (!decompressNextChunkOfData(true, Z_BLOCK)) {
+                    streamEnded = true;
+                    break;
+                }
+                if (checkStreamForBlockEnd())
+                    clearCurrentCompressedBlock();
+            } while (zStream.avail_in != 0);
+        }
+        clearCurrentCompressedBlock();
+        inflateEnd(&zStream);
+        return totalBytesOut;
+    }
+};
+
+string readFile(const path &file) {
+    ifstream input(file, ios::binary);
+    return string((istreambuf_iterator<char>(input)), istreambuf_iterator<char>());
+}
+
+string decompressFile(const path &fastq) {
+    string result;
+    gzFile input = gzopen(fastq.c_str(), "rb");
+    char buffer[64 * 1024];
+    int readBytes;
+    while (input && (readBytes = gzread(input, buffer, sizeof(buffer))) > 0)
+        result.append(buffer, static_cast<size_t>(readBytes));
+    if (input)
+        gzclose(input);
+    return result;
+}
+
+void benchmarkSplitStr(const string &decompressed) {
+    // The extractor splits decompressed chunks of up to a window.
+    string chunk = decompressed.substr(0, WINDOW_SIZE);
+    auto lines = static_cast<int64_t>(StringHelper::splitStr(chunk).size());
+    runMicroBenchmark("StringHelper::splitStr (32kB chunk, per line)", lines, static_cast<int64_t>(chunk.size()),
+                      [&]() { keep(StringHelper::splitStr(chunk)); });
+}
+
+void benchmarkDecompression(const path &fastq) {
+    auto processor = make_shared<DecompressingProcessor>(MemoryMappedFileSource::from(fastq));
+    int64_t decompressedBytes = processor->decompress();
+    runMicroBenchmark("decompressNextChunkOfData (whole file, per MB)", decompressedBytes / MB,
+                      decompressedBytes, [&]() { keep(processor->decompress()); });
+}
+
+void benchmarkIndexReader(const path &fastq, const path &workDirectory) {
+    // An entry for every block gives enough entries for a stable measurement.
+    path index = workDirectory / "micro.fqi";
+    {
+        Indexer indexer(make_shared<FileSource>(fastq), make_shared<FileSink>(index, true),
+                        BlockDistanceStorageDecisionStrategy::from(1), false, true, false, true);
+        indexer.createIndex();
+    }
+    int64_t entries;
+    {
+        IndexReader reader(make_shared<FileSource>(index));
+        reader.tryOpenAndReadHeader();
+        entries = reader.getIndicesLeft();
+    }
+    runMicroBenchmark("IndexReader::readIndexEntryV1 (compressed, per entry)", entries,
+                      static_cast<int64_t>(file_size(index)), [&]() {
+                IndexReader reader(make_shared<FileSource>(index));
+                reader.tryOpenAndReadHeader();
+                while (reader.getIndicesLeft() > 0)
+                    keep(reader.readIndexEntryV1());
+            });
+    remove(index);
+}
+
+void benchmarkDictionaryCompression(const string &decompressed) {
+    // The indexer stores the window before an entry, which is FASTQ data.
+    vector<Bytef> dictionary(decompressed.begin(), decompressed.begin() + WINDOW_SIZE);
+    vector<Bytef> compressed(compressBound(WINDOW_SIZE));
+    vector<Bytef> uncompressed(WINDOW_SIZE);
+    uLongf compressedSize = compressed.size();
+    compress2(compressed.data(), &compressedSize, dictionary.data(), WINDOW_SIZE, 9);
+
+    runMicroBenchmark("compress2 (32kB dictionary, level 9)", 1, WINDOW_SIZE, [&]() {
+        uLongf size = compressed.size();
+        compress2(compressed.data(), &size, dictionary.data(), WINDOW_SIZE, 9);
+        keep(size);
+    });
+    runMicroBenchmark("uncompress2 (32kB dictionary)", 1, WINDOW_SIZE, [&]() {
+        uLongf size = WINDOW_SIZE;
+        uLong sourceSize = compressedSize;
+        uncompress2(uncompressed.data(), &size, compressed.data(), &sourceSize);
+        keep(size);
+    });
+}
+
+void benchmarkStreamSource(const string &compressed) {
+    auto chunks = static_cast<int64_t>(compressed.size() / CHUNK_SIZE);
+    vector<Bytef> buffer(CHUNK_SIZE);
+    runMicroBenchmark("StreamSource::read (16kB chunks, per chunk)", chunks, static_cast<int64_t>(compressed.size()),
+                      [&]() {
+                          istringstream stream(compressed);
+                          StreamSource source(&stream);
+                          source.open();
+                          while (source.read(buffer.data(), CHUNK_SIZE) > 0)
+                              keep(buffer);
+                      });
+    // Like the extractor when it goes back to the start of a block.
+    runMicroBenchmark("StreamSource::read + rewind (8kB back, per chunk)", chunks,
+                      static_cast<int64_t>(compressed.size()), [&]() {
+                istringstream stream(compressed);
+                StreamSource source(&stream);
+                source.open();
+                while (source.read(buffer.data(), CHUNK_SIZE) > 0) {
+                    source.rewind(CHUNK_SIZE / 2);
+                    source.read(buffer.data(), CHUNK_SIZE / 2);
+                    keep(buffer);
+                }
+            });
+}
+
+void benchmarkSinks(const string &decompressed) {
+    // 1MB of complete lines.
+    auto lines = StringHelper::splitStr(decompressed.substr(0, decompressed.find('\n', MB)));
+    int64_t bytes = 0;
+    for (const auto &line : lines)
+        bytes += static_cast<int64_t>(line.size()) + 1;
+    auto lineCount = static_cast<int64_t>(lines.size());
+
+    FileSink sink("/dev/null", true);
+    sink.open();
+    string newLine("\n");
+    runMicroBenchmark("FileSink::write(const char *, int) (per line)", lineCount, bytes, [&]() {
+        for (const auto &line : lines) {
+            sink.write(line.c_str(), static_cast<int>(line.size()));
+            sink.write(newLine.c_str(), 1);
+        }
+    });
+    runMicroBenchmark("FileSink::write(const string &) (per line)", lineCount, bytes, [&]() {
+        for (const auto &line : lines) {
+            sink.write(line);
+            sink.write(newLine);
+        }
+    });
+    // The extractor hands over the lines of a batch with one call.
+    const size_t linesPerCall = 512;
+    vector<struct iovec> spans;
+    for (const auto &line : lines) {
+        spans.push_back({const_cast<char *>(line.data()), line.size()});
+        spans.push_back({const_cast<char *>(newLine.data()), 1});
+    }
+    runMicroBenchmark("FileSink::writeSpans (512 lines per call, per line)", lineCount, bytes, [&]() {
+        for (size_t i = 0; i < spans.size(); i += 2 * linesPerCall)
+            sink.writeSpans(spans.data() + i, static_cast<int>(min(2 * linesPerCall, spans.size() - i)));
+    });
+    sink.close();
+}
+
+int main(int argc, const char *argv[]) {
+    if (argc < 2) {
+        cerr << "Usage: microbenchmark <FASTQ.gz> [minimum seconds per benchmark]\n";
+        return 1;
+    }
+    path fastq = argv[1];
+    if (argc > 2)
+        minimumSeconds = stod(argv[2]);
+
+    string compressed = readFile(fastq);
+    string decompressed = decompressFile(fastq);
+    if (decompressed.size() < static_cast<u_int64_t>(2 * MB)) {
+        cerr << "The FASTQ file '" << fastq.string() << "' must contain at least 2MB of decompressed data.\n";
+        return 1;
+    }
+    auto[createdTempDir, workDirectory] = IOHelper::createTempDir("FastqIndExMicroBenchmark");
+    if (!createdTempDir) {
+        cerr << "Could not create a temporary directory.\n";
+        return 1;
+    }
+
+    cout << left << setw(56) << "Benchmark" << right << setw(14) << "ns/op" << setw(12) << "MB/s" << "\n";
+    benchmarkSplitStr(decompressed);
+    benchmarkDecompression(fastq);
+    benchmarkIndexReader(fastq, workDirectory);
+    benchmarkDictionaryCompression(decompressed);
+    benchmarkStreamSource(compressed);
+    benchmarkSinks(decompressed);
+
+    remove_all(workDirectory);
+    return 0;
+}
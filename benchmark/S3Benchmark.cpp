@@ -0,0 +1,301 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+/**
+ * Measures the S3 code paths (S3Source, S3Sink and the indexer and extractor on top of them) without a bucket.
+ *
+ * By default, the objects are served by in-process stand-ins, which replace the SDK requests and simulate the network
+ * with a fixed latency and bandwidth per request, see SimulatedS3.h. With --http, the real S3Source, S3Sink,
+ * FQIS3Client and AWS SDK code is used instead. The SDK then talks to a local S3 compatible HTTP server (see
+ * LocalS3Server.h), which applies the same network model. This includes the request signing, HTTP handling and response
+ * parsing of the SDK in the measurement.
+ *
+ * Usage: s3benchmark [--http] <FASTQ.gz> [object size in MB] [latency in ms] [MB/s per request] [part size in MiB]
+ *                    [parts]
+ *
+ * If an object size is given, the FASTQ file is concatenated with itself until the object has at least this size. The
+ * defaults are the file size, 20ms, 100MB/s, 8MiB and 8 parallel requests.
+ *
+ * Workloads:
+ * - index:                 Index the object, the index is uploaded to the bucket.
+ * - extract first record:  Extract the first record, object and index are read from the bucket.
+ * - extract segment:       Extract the middle one of 8 segments.
+ * - upload:                Upload the object with a multipart upload.
+ *
+ * "First byte" is the time until the first output was written for extractions and until the first request finished
+ * for the other workloads. The results are printed to stdout, the tool output goes to stderr.
+ */
+
+#include "BenchmarkHelpers.h"
+#include "LocalS3Server.h"
+#include "MeasuringSink.h"
+#include "SimulatedS3.h"
+#include "process/extract/Extractor.h"
+#include "process/index/Indexer.h"
+#include "process/io/s3/S3Service.h"
+#include "process/io/s3/S3Sink.h"
+#include "process/io/s3/S3Source.h"
+#include <experimental/filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sys/uio.h>
+
+using namespace std;
+using namespace std::chrono;
+using namespace std::experimental::filesystem;
+
+struct BenchmarkResult {
+    string workload;
+    bool successful{false};
+    double seconds{0};
+    int64_t firstByteAfter{-1};
+    int64_t transferredBytes{0};
+    int64_t requests{0};
+};
+
+void printResult(const BenchmarkResult &result) {
+    cout << left << setw(24) << result.workload << right << fixed;
+    if (!result.successful) {
+        cout << "  failed\n";
+        return;
+    }
+    double megabytes = static_cast<double>(result.transferredBytes) / 1024 / 1024;
+    cout << setw(10) << setprecision(3) << result.seconds
+         << setw(14) << setprecision(1) << static_cast<double>(result.firstByteAfter) / 1000
+         << setw(10) << setprecision(1) << megabytes / result.seconds
+         << setw(16) << setprecision(1) << megabytes
+         << setw(10) << result.requests << "\n";
+}
+
+shared_ptr<const string> loadObject(const path &fastq, int64_t minimumSize) {
+    ifstream input(fastq, ios::binary);
+    string file((istreambuf_iterator<char>(input)), istreambuf_iterator<char>());
+    // Concatenated gzip files are valid gzip files.
+    auto object = make_shared<string>(file);
+    while (static_cast<int64_t>(object->size()) < minimumSize)
+        object->append(file);
+    return object;
+}
+
+/**
+ * Creates the sources and sinks of the workloads. All objects are stored in one bucket, all requests are counted in
+ * one statistics object.
+ */
+class S3Backend {
+
+public:
+
+    SimulatedS3Bucket bucket;
+
+    SimulatedS3Statistics statistics;
+
+    SimulatedNetwork network;
+
+    u_int64_t partSize;
+
+    uint partsInFlight;
+
+    S3Backend(const SimulatedNetwork &network, u_int64_t partSize, uint partsInFlight) :
+            network(network), partSize(partSize), partsInFlight(partsInFlight) {}
+
+    virtual ~S3Backend() = default;
+
+    virtual shared_ptr<Source> openObject(const string &key) = 0;
+
+    virtual shared_ptr<Sink> createObject(const string &key) = 0;
+};
+
+/**
+ * Uses the in-process stand-ins of SimulatedS3.h.
+ */
+class SimulatedS3Backend : public S3Backend {
+
+public:
+
+    using S3Backend::S3Backend;
+
+    shared_ptr<Source> openObject(const string &key) override {
+        return make_shared<S3Source>(make_shared<SimulatedS3Object>(key, bucket.get(key), network, statistics),
+                                     partsInFlight, partSize);
+    }
+
+    shared_ptr<Sink> createObject(const string &key) override {
+        return make_shared<SimulatedS3Upload>(bucket, key, network, statistics, partSize, partsInFlight);
+    }
+};
+
+/**
+ * Uses S3Source, S3Sink and the AWS SDK with a LocalS3Server.
+ */
+class LocalS3ServerBackend : public S3Backend {
+
+private:
+
+    /**
+     * Underscores are not allowed in DNS labels, so the SDK uses path style requests, which the server understands.
+     */
+    const string bucketName{"fqi_benchmark"};
+
+    LocalS3Server server;
+
+    path configFile;
+
+    S3ServiceOptions options;
+
+public:
+
+    LocalS3ServerBackend(const SimulatedNetwork &network, u_int64_t partSize, uint partsInFlight) :
+            S3Backend(network, partSize, partsInFlight),
+            server(bucket, network, statistics) {}
+
+    ~LocalS3ServerBackend() override {
+        server.stop();
+        if (!configFile.empty())
+            remove(configFile);
+    }
+
+    bool start() {
+        if (!server.start())
+            return false;
+        configFile = temp_directory_path() / ("s3benchmark_" + to_string(getpid()) + ".cfg");
+        if (!server.writeConfigFile(configFile))
+            return false;
+        options.credentialsFile = configFile;
+        options.configFile = configFile;
+        options.configSection = "default";
+        options.partSize = partSize;
+        options.partsInFlight = partsInFlight;
+        S3Service::setS3ServiceOptions(options);
+        return true;
+    }
+
+    shared_ptr<Source> openObject(const string &key) override {
+        return S3Source::from("s3://" + bucketName + "/" + key, options);
+    }
+
+    shared_ptr<Sink> createObject(const string &key) override {
+        return S3Sink::from("s3://" + bucketName + "/" + key, true, options);
+    }
+};
+
+BenchmarkResult runIndex(S3Backend &backend) {
+    shared_ptr<IndexEntryStorageDecisionStrategy> storageStrategy(
+            new ByteDistanceStorageDecisionStrategy(IndexEntryStorageDecisionStrategy::AUTO_DISTANCE));
+    BenchmarkResult result{"index"};
+    backend.statistics.reset();
+    auto index = backend.createObject("benchmark.fastq.gz.fqi");
+    {
+        Indexer indexer(backend.openObject("benchmark.fastq.gz"), index, storageStrategy,
+                        false, true, false, true);
+        result.successful = indexer.createIndex();
+    }
+    result.successful = index->close() && result.successful;
+    result.seconds = secondsSince(backend.statistics.start);
+    result.firstByteAfter = backend.statistics.firstByteAfter;
+    result.transferredBytes = backend.statistics.transferredBytes;
+    result.requests = backend.statistics.requests;
+    return result;
+}
+
+BenchmarkResult runExtract(const string &workload, S3Backend &backend, ExtractMode mode, int64_t start, int64_t count) {
+    BenchmarkResult result{workload};
+    backend.statistics.reset();
+    auto output = make_shared<MeasuringSink>(backend.statistics.start);
+    {
+        Extractor extractor(backend.openObject("benchmark.fastq.gz"), backend.openObject("benchmark.fastq.gz.fqi"),
+                            output, false, mode, start, count, DEFAULT_RECORD_SIZE, false);
+        result.successful = extractor.fulfillsPremises() && extractor.extract();
+    }
+    result.seconds = secondsSince(backend.statistics.start);
+    result.firstByteAfter = output->firstByteAfter;
+    result.transferredBytes = backend.statistics.transferredBytes;
+    result.requests = backend.statistics.requests;
+    return result;
+}
+
+BenchmarkResult runUpload(S3Backend &backend, const shared_ptr<const string> &object) {
+    BenchmarkResult result{"upload"};
+    backend.statistics.reset();
+    auto upload = backend.createObject("upload.fastq.gz");
+    result.successful = upload->open();
+    const u_int64_t chunkSize = 4 * 1024 * 1024;
+    for (u_int64_t offset = 0; result.successful && offset < object->size(); offset += chunkSize) {
+        struct iovec span{const_cast<char *>(object->data() + offset), min(chunkSize, object->size() - offset)};
+        upload->writeSpans(&span, 1);
+    }
+    result.successful = upload->close() && result.successful;
+    result.seconds = secondsSince(backend.statistics.start);
+    auto uploaded = backend.bucket.get("upload.fastq.gz");
+    result.successful = result.successful && uploaded && *uploaded == *object;
+    result.firstByteAfter = backend.statistics.firstByteAfter;
+    result.transferredBytes = backend.statistics.transferredBytes;
+    result.requests = backend.statistics.requests;
+    return result;
+}
+
+int main(int argc, const char *argv[]) {
+    bool useLocalServer = argc > 1 && string(argv[1]) == "--http";
+    if (useLocalServer) {
+        argc--;
+        argv++;
+    }
+    if (argc < 2) {
+        cerr << "Usage: s3benchmark [--http] <FASTQ.gz> [object size in MB] [latency in ms] [MB/s per request]"
+             << " [part size in MiB] [parts]\n";
+        return 1;
+    }
+
+    path fastq = argv[1];
+    int64_t objectSize = argc > 2 ? stoll(argv[2]) * MB : 0;
+    SimulatedNetwork network;
+    if (argc > 3) network.latency = milliseconds(stoll(argv[3]));
+    if (argc > 4) network.bandwidth = stod(argv[4]) * MB;
+    u_int64_t partSize = argc > 5 ? stoull(argv[5]) * MB : 8 * MB;
+    uint partsInFlight = argc > 6 ? static_cast<uint>(stoul(argv[6])) : 8;
+    const int64_t segments = 8;
+
+    auto object = loadObject(fastq, objectSize);
+    if (object->empty()) {
+        cerr << "Could not read '" << fastq.string() << "'.\n";
+        return 1;
+    }
+
+    unique_ptr<S3Backend> backend;
+    if (useLocalServer) {
+        auto localServerBackend = make_unique<LocalS3ServerBackend>(network, partSize, partsInFlight);
+        if (!localServerBackend->start()) {
+            cerr << "Could not start the local S3 server.\n";
+            return 1;
+        }
+        backend = std::move(localServerBackend);
+    } else {
+        backend = make_unique<SimulatedS3Backend>(network, partSize, partsInFlight);
+    }
+    backend->bucket.put("benchmark.fastq.gz", object);
+
+    cerr << "Object size " << object->size() / MB << " MB, latency " << network.latency.count() << "ms, "
+         << network.bandwidth / MB << " MB/s per request, " << partsInFlight << " parts of " << partSize / MB
+         << " MiB, " << (useLocalServer ? "AWS SDK with a local HTTP server" : "in-process stand-ins") << "\n";
+
+    vector<BenchmarkResult> results;
+    results.emplace_back(runIndex(*backend));
+    if (results.back().successful) {
+        results.emplace_back(runExtract("extract first record", *backend, ExtractMode::lines, 0, DEFAULT_RECORD_SIZE));
+        results.emplace_back(runExtract("extract segment", *backend, ExtractMode::segment, segments / 2, segments));
+    }
+    results.emplace_back(runUpload(*backend, object));
+
+    cout << left << setw(24) << "Workload" << right << setw(10) << "Time [s]" << setw(14) << "1st Byte [ms]"
+         << setw(10) << "MB/s" << setw(16) << "Transferred MB" << setw(10) << "Requests" << "\n";
+    bool allSuccessful = true;
+    for (const auto &result : results) {
+        printResult(result);
+        allSuccessful = allSuccessful && result.successful;
+    }
+    return allSuccessful ? 0 : 1;
+}
@@ -0,0 +1,235 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#ifndef FASTQINDEX_SIMULATEDS3_H
+#define FASTQINDEX_SIMULATEDS3_H
+
+#include "process/io/s3/S3RangeSource.h"
+#include "process/io/s3/S3Sink.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using namespace std;
+using namespace std::chrono;
+
+/**
+ * Network model for the S3 stand-ins. Every request waits for the latency and then transfers its data with the given
+ * bandwidth. Requests don't slow each other down, like parallel connections to S3.
+ */
+struct SimulatedNetwork {
+
+    milliseconds latency{20};
+
+    /**
+     * Bytes per second and request.
+     */
+    double bandwidth{100.0 * 1024 * 1024};
+
+    void transfer(int64_t bytes) const {
+        this_thread::sleep_for(latency + duration_cast<microseconds>(duration<double>(bytes / bandwidth)));
+    }
+};
+
+/**
+ * Counters for the requests, which were sent to a stand-in.
+ */
+struct SimulatedS3Statistics {
+
+    steady_clock::time_point start{steady_clock::now()};
+
+    atomic<int64_t> requests{0};
+
+    atomic<int64_t> transferredBytes{0};
+
+    /**
+     * Microseconds from start until the first data was transferred, -1 if nothing was transferred.
+     */
+    atomic<int64_t> firstByteAfter{-1};
+
+    /**
+     * Starts a new measurement. No requests may be running.
+     */
+    void reset() {
+        start = steady_clock::now();
+        requests = 0;
+        transferredBytes = 0;
+        firstByteAfter = -1;
+    }
+
+    void countRequest(int64_t bytes) {
+        requests++;
+        transferredBytes += bytes;
+        int64_t expected = -1;
+        firstByteAfter.compare_exchange_strong(expected,
+                                               duration_cast<microseconds>(steady_clock::now() - start).count());
+    }
+};
+
+/**
+ * The objects of the stand-ins, kept in memory.
+ */
+class SimulatedS3Bucket {
+
+private:
+
+    mutex objectsMutex;
+
+    map<string, shared_ptr<const string>> objects;
+
+public:
+
+    void put(const string &key, const shared_ptr<const string> &content) {
+        lock_guard<mutex> lock(objectsMutex);
+        objects[key] = content;
+    }
+
+    /**
+     * @return The content of the object or nullptr, if there is no such object.
+     */
+    shared_ptr<const string> get(const string &key) {
+        lock_guard<mutex> lock(objectsMutex);
+        auto object = objects.find(key);
+        return object == objects.end() ? nullptr : object->second;
+    }
+
+    bool remove(const string &key) {
+        lock_guard<mutex> lock(objectsMutex);
+        return objects.erase(key) > 0;
+    }
+
+    map<string, shared_ptr<const string>> list() {
+        lock_guard<mutex> lock(objectsMutex);
+        return objects;
+    }
+};
+
+/**
+ * Stand-in for an S3 object, which serves ranged GET and HEAD requests from memory.
+ */
+class SimulatedS3Object : public S3RangeSource {
+
+private:
+
+    shared_ptr<const string> content;
+
+    SimulatedNetwork network;
+
+    SimulatedS3Statistics &statistics;
+
+public:
+
+    SimulatedS3Object(const string &name,
+                      const shared_ptr<const string> &content,
+                      const SimulatedNetwork &network,
+                      SimulatedS3Statistics &statistics) :
+            S3RangeSource("s3://simulated/" + name),
+            content(content ? content : make_shared<const string>()),
+            network(network),
+            statistics(statistics) {}
+
+protected:
+
+    tuple<bool, int64_t, string> fetchObjectSizeAndETag() override {
+        network.transfer(0);
+        statistics.requests++;
+        return {true, static_cast<int64_t>(content->size()), "\"simulated\""};
+    }
+
+    tuple<bool, int64_t> fetchRange(int64_t offset, int64_t length, Bytef *buffer) override {
+        auto available = max(min(length, static_cast<int64_t>(content->size()) - offset), static_cast<int64_t>(0));
+        network.transfer(available);
+        memcpy(buffer, content->data() + offset, static_cast<size_t>(available));
+        statistics.countRequest(available);
+        return {true, available};
+    }
+};
+
+/**
+ * Stand-in for the multipart upload of an S3Sink. The object is assembled in memory and stored in the bucket, when the
+ * upload is completed.
+ */
+class SimulatedS3Upload : public S3Sink {
+
+private:
+
+    SimulatedS3Bucket &bucket;
+
+    string key;
+
+    SimulatedNetwork network;
+
+    SimulatedS3Statistics &statistics;
+
+    mutex partsMutex;
+
+    map<int, string> parts;
+
+public:
+
+    SimulatedS3Upload(SimulatedS3Bucket &bucket,
+                      const string &key,
+                      const SimulatedNetwork &network,
+                      SimulatedS3Statistics &statistics,
+                      u_int64_t partSize,
+                      uint partsInFlight) :
+            S3Sink("s3://simulated/" + key, partSize, partsInFlight),
+            bucket(bucket),
+            key(key),
+            network(network),
+            statistics(statistics) {}
+
+    ~SimulatedS3Upload() override {
+        closeWithoutPublishing();
+    }
+
+protected:
+
+    tuple<bool, string> createMultipartUpload() override {
+        network.transfer(0);
+        statistics.requests++;
+        return {true, "upload"};
+    }
+
+    tuple<bool, string> uploadPart(const string & /*uploadId*/,
+                                   int partNumber,
+                                   const char *data,
+                                   int64_t length) override {
+        network.transfer(length);
+        statistics.countRequest(length);
+        lock_guard<mutex> lock(partsMutex);
+        parts[partNumber] = string(data, static_cast<size_t>(length));
+        return {true, to_string(partNumber)};
+    }
+
+    bool completeMultipartUpload(const string & /*uploadId*/, const map<int, string> &uploadedParts) override {
+        network.transfer(0);
+        statistics.requests++;
+        auto content = make_shared<string>();
+        for (const auto &[partNumber, eTag] : uploadedParts)
+            content->append(parts[partNumber]);
+        bucket.put(key, content);
+        return true;
+    }
+
+    bool abortMultipartUpload(const string & /*uploadId*/) override {
+        return true;
+    }
+
+    bool putObject(const char *data, int64_t length) override {
+        network.transfer(length);
+        statistics.countRequest(length);
+        bucket.put(key, make_shared<const string>(data, static_cast<size_t>(length)));
+        return true;
+    }
+};
+
+#endif //FASTQINDEX_SIMULATEDS3_H
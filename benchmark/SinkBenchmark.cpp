@@ -0,0 +1,175 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+/**
+ * Compares the throughput of the file and console sinks with the iostream based implementations which were used
+ * before.
+ *
+ * Usage: sinkbenchmark [output directory] [MB to write]
+ *
+ * The console benchmarks are only run, if stdout is not a terminal. To test the pipe throughput use e.g.:
+ *   sinkbenchmark /tmp 1024 | cat > /dev/null
+ * Results are printed to stderr.
+ */
+
+#include "process/io/ConsoleSink.h"
+#include "process/io/FileSink.h"
+#include <chrono>
+#include <experimental/filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+using namespace std::experimental::filesystem;
+
+/**
+ * Four lines per record, like a FASTQ file with 100bp reads.
+ */
+vector<string> createRecordLines() {
+    return {"@HWI-ST791:134804979:D1VCPACXX:1:1101:2256:2618/1",
+            string(100, 'A'),
+            "+",
+            string(100, 'F')};
+}
+
+void runBenchmark(const string &name, u_int64_t bytes, const function<void()> &benchmark) {
+    auto start = steady_clock::now();
+    benchmark();
+    auto seconds = duration<double>(steady_clock::now() - start).count();
+    cerr << left << setw(48) << name << right << setw(10) << fixed << setprecision(1)
+         << (static_cast<double>(bytes) / 1024 / 1024 / seconds) << " MB/s\n";
+}
+
+/**
+ * Writes the lines like the extractor did before: Each line and its line end are written separately.
+ */
+template<typename WriteFunction>
+u_int64_t writeLineByLine(const vector<string> &lines, u_int64_t records, WriteFunction write) {
+    u_int64_t bytes = 0;
+    for (u_int64_t i = 0; i < records; i++) {
+        for (const auto &line : lines) {
+            write(line);
+            write(string("\n"));
+            bytes += line.size() + 1;
+        }
+    }
+    return bytes;
+}
+
+/**
+ * Writes the lines like the extractor does now: Lines are collected in a large buffer which is then written at once.
+ */
+void writeBatched(const vector<string> &lines, u_int64_t records, Sink *sink) {
+    string buffer;
+    const u_int64_t bufferSize = 4 * 1024 * 1024;
+    buffer.reserve(bufferSize + 1024);
+    for (u_int64_t i = 0; i < records; i++) {
+        for (const auto &line : lines) {
+            buffer.append(line);
+            buffer.push_back('\n');
+        }
+        if (buffer.size() >= bufferSize) {
+            struct iovec span{const_cast<char *>(buffer.data()), buffer.size()};
+            sink->writeSpans(&span, 1);
+            buffer.clear();
+        }
+    }
+    struct iovec span{const_cast<char *>(buffer.data()), buffer.size()};
+    sink->writeSpans(&span, 1);
+}
+
+int main(int argc, const char *argv[]) {
+    path directory = argc > 1 ? path(argv[1]) : temp_directory_path();
+    u_int64_t megabytes = argc > 2 ? stoull(argv[2]) : 512;
+
+    auto lines = createRecordLines();
+    u_int64_t recordSize = 0;
+    for (const auto &line : lines)
+        recordSize += line.size() + 1;
+    u_int64_t records = megabytes * 1024 * 1024 / recordSize;
+    u_int64_t bytes = records * recordSize;
+
+    path file = directory / "fastqindex_sinkbenchmark.fastq";
+
+    cerr << "Writing " << bytes / 1024 / 1024 << " MB per benchmark to '" << file.string() << "'\n";
+
+    runBenchmark("fstream, line by line (old FileSink)", bytes, [&]() {
+        ofstream stream(file, ios_base::out | ios_base::binary | ios_base::trunc);
+        writeLineByLine(lines, records, [&stream](const string &s) { stream.write(s.c_str(), s.length()); });
+    });
+
+    runBenchmark("FileSink, line by line", bytes, [&]() {
+        ofstream(file, ios_base::trunc).close();
+        FileSink sink(file, true);
+        sink.open();
+        writeLineByLine(lines, records, [&sink](const string &s) { sink.write(s); });
+        sink.close();
+    });
+
+    runBenchmark("FileSink, batched", bytes, [&]() {
+        ofstream(file, ios_base::trunc).close();
+        FileSink sink(file, true);
+        sink.open();
+        writeBatched(lines, records, &sink);
+        sink.close();
+    });
+
+    runBenchmark("FileSink, batched, preallocated", bytes, [&]() {
+        ofstream(file, ios_base::trunc).close();
+        FileSink sink(file, true);
+        sink.setPreallocationSize(bytes);
+        sink.open();
+        writeBatched(lines, records, &sink);
+        sink.close();
+    });
+
+    runBenchmark("FileSink, batched, fsync on close", bytes, [&]() {
+        ofstream(file, ios_base::trunc).close();
+        FileSink sink(file, true);
+        sink.setSyncPolicy(SYNC_ON_CLOSE);
+        sink.open();
+        writeBatched(lines, records, &sink);
+        sink.close();
+    });
+
+    remove(file);
+
+    if (isatty(STDOUT_FILENO)) {
+        cerr << "stdout is a terminal, skipping the console benchmarks.\n";
+        return 0;
+    }
+
+    runBenchmark("cout with mutex, line by line (old ConsoleSink)", bytes, [&]() {
+        mutex mtx;
+        writeLineByLine(lines, records, [&](const string &s) {
+            lock_guard<mutex> lock(mtx);
+            cout << s;
+        });
+        cout.flush();
+    });
+
+    runBenchmark("ConsoleSink, line by line", bytes, [&]() {
+        ConsoleSink sink;
+        writeLineByLine(lines, records, [&sink](const string &s) { sink.write(s); });
+        sink.close();
+    });
+
+    runBenchmark("ConsoleSink, batched", bytes, [&]() {
+        ConsoleSink sink;
+        writeBatched(lines, records, &sink);
+        sink.close();
+    });
+
+    return 0;
+}
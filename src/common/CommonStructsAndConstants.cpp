@@ -5,11 +5,12 @@
  */
 
 #include "CommonStructsAndConstants.h"
+#include <limits>
+#include <stdexcept>
 
 using namespace std;
 
 char FQI_BINARY[16384]{0};
-char S3HELPER_BINARY[16384]{0};
 
 const u_char MAGIC_NUMBER_RAW[4] = {1, 2, 3, 4};
 
@@ -19,6 +20,15 @@ const u_char MAGIC_NUMBER_RAW[4] = {1, 2, 3, 4};
  */
 const uint MAGIC_NUMBER = *(reinterpret_cast<uint *>(const_cast<u_char *>(MAGIC_NUMBER_RAW)));
 
+const u_char TRAILER_MAGIC_NUMBER_RAW[4] = {4, 3, 2, 1};
+
+const uint TRAILER_MAGIC_NUMBER = *(reinterpret_cast<uint *>(const_cast<u_char *>(TRAILER_MAGIC_NUMBER_RAW)));
+
+const u_char READ_NAME_INDEX_MAGIC_NUMBER_RAW[4] = {1, 2, 3, 5};
+
+const uint READ_NAME_INDEX_MAGIC_NUMBER =
+        *(reinterpret_cast<uint *>(const_cast<u_char *>(READ_NAME_INDEX_MAGIC_NUMBER_RAW)));
+
 const int64_t kB = 1024;
 
 const int64_t MB = kB * 1024;
@@ -17,13 +17,22 @@
  * will just keep it here. At the end, it only stores the path to the test binary and is used for tests only.
  */
 extern char FQI_BINARY[16384];
-extern char S3HELPER_BINARY[16384];
 
 /**
  * Used to identify a file as a file created by this binary.
  */
 extern const uint MAGIC_NUMBER;
 
+/**
+ * Used to identify the trailer of an index file.
+ */
+extern const uint TRAILER_MAGIC_NUMBER;
+
+/**
+ * Used to identify a read name index file.
+ */
+extern const uint READ_NAME_INDEX_MAGIC_NUMBER;
+
 extern const int64_t kB;
 
 extern const int64_t MB;
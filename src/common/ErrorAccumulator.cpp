@@ -13,6 +13,12 @@ using namespace std;
 
 int ErrorAccumulator::verbosity = 0;
 
+recursive_mutex ErrorAccumulator::consoleFlushHookMutex;
+
+function<void()> ErrorAccumulator::consoleFlushHook;
+
+const void *ErrorAccumulator::consoleFlushHookOwner = nullptr;
+
 void ErrorAccumulator::setVerbosity(int verbosity) {
     if (verbosity > 0 && verbosity <= 3) {
         if (verbosity > 0)
@@ -23,24 +29,57 @@ void ErrorAccumulator::setVerbosity(int verbosity) {
 
 bool ErrorAccumulator::verbosityIsSetToDebug() { return verbosity >= 3; }
 
+void ErrorAccumulator::setConsoleFlushHook(const void *owner, const function<void()> &hook) {
+    lock_guard<recursive_mutex> lock(consoleFlushHookMutex);
+    consoleFlushHook = hook;
+    consoleFlushHookOwner = owner;
+}
+
+void ErrorAccumulator::removeConsoleFlushHook(const void *owner) {
+    lock_guard<recursive_mutex> lock(consoleFlushHookMutex);
+    if (consoleFlushHookOwner != owner)
+        return;
+    consoleFlushHook = nullptr;
+    consoleFlushHookOwner = nullptr;
+}
+
+void ErrorAccumulator::runConsoleFlushHook() {
+    lock_guard<recursive_mutex> lock(consoleFlushHookMutex);
+    if (consoleFlushHook)
+        consoleFlushHook();
+}
+
 void ErrorAccumulator::always(_cstr s0, _cstr s1, _cstr s2, _cstr s3, _cstr s4, _cstr s5, _cstr s6) {
+    runConsoleFlushHook();
     cerr << ErrorAccumulator::join(s0, s1, s2, s3, s4, s5, s6) << "\n";
 }
 
 void ErrorAccumulator::debug(_cstr s0, _cstr s1, _cstr s2, _cstr s3, _cstr s4, _cstr s5, _cstr s6) {
-    if (verbosityIsSetToDebug()) cerr << ErrorAccumulator::join(s0, s1, s2, s3, s4, s5, s6) << "\n";
+    if (!verbosityIsSetToDebug())
+        return;
+    runConsoleFlushHook();
+    cerr << ErrorAccumulator::join(s0, s1, s2, s3, s4, s5, s6) << "\n";
 }
 
 void ErrorAccumulator::info(const string &msg) {
-    if (verbosity >= 2) cerr << msg << "\n";
+    if (verbosity < 2)
+        return;
+    runConsoleFlushHook();
+    cerr << msg << "\n";
 }
 
 void ErrorAccumulator::warning(const string &msg) {
-    if (verbosity >= 1) cerr << msg << "\n";
+    if (verbosity < 1)
+        return;
+    runConsoleFlushHook();
+    cerr << msg << "\n";
 }
 
 void ErrorAccumulator::severe(const string &msg) {
-    if (verbosity >= 0) cerr << msg << "\n";
+    if (verbosity < 0)
+        return;
+    runConsoleFlushHook();
+    cerr << msg << "\n";
 }
 
 vector<string> ErrorAccumulator::getErrorMessages() { return errorMessages; }
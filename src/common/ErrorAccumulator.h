@@ -7,7 +7,9 @@
 #ifndef FASTQINDEX_ERRORACCUMULATOR_H
 #define FASTQINDEX_ERRORACCUMULATOR_H
 
+#include <functional>
 #include <iostream>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -30,6 +32,20 @@ private:
 
     static int verbosity;
 
+    /**
+     * Guards the console flush hook. Recursive, as the hook might print messages itself.
+     */
+    static std::recursive_mutex consoleFlushHookMutex;
+
+    static std::function<void()> consoleFlushHook;
+
+    static const void *consoleFlushHookOwner;
+
+    /**
+     * Calls the console flush hook, if one is registered. Used before a message is printed to cerr.
+     */
+    static void runConsoleFlushHook();
+
 public:
 
     virtual ~ErrorAccumulator() = default;
@@ -48,6 +64,20 @@ public:
 
     static bool verbosityIsSetToDebug();
 
+    /**
+     * Registers a function, which is called before a message is printed to cerr. A sink, which buffers the output for
+     * cout, uses this to write its data first, like cout is flushed before cerr is written. Only one hook is kept, a
+     * later registration replaces the former hook.
+     *
+     * The hook is called while a lock is held. It must not wait for locks, which are held while messages are printed.
+     */
+    static void setConsoleFlushHook(const void *owner, const std::function<void()> &hook);
+
+    /**
+     * Removes the hook, if it was registered by owner. Waits for a running call of the hook.
+     */
+    static void removeConsoleFlushHook(const void *owner);
+
     static void always(_cstr s0, _cstr s1 = "", _cstr s2 = "", _cstr s3 = "", _cstr s4 = "", _cstr s5 = "", _cstr s6 = "");
 
     static void debug(_cstr s0, _cstr s1 = "", _cstr s2 = "", _cstr s3 = "", _cstr s4 = "", _cstr s5 = "", _cstr s6 = "");
@@ -0,0 +1,147 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#include "common/RunStatistics.h"
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <sys/resource.h>
+
+using namespace std;
+
+atomic<bool> RunStatistics::enabled{false};
+
+atomic<int64_t> RunStatistics::counters[NUMBER_OF_RUN_COUNTERS]{};
+
+atomic<int64_t> RunStatistics::timers[NUMBER_OF_RUN_TIMERS]{};
+
+steady_clock::time_point RunStatistics::start = steady_clock::now();
+
+atomic<RunCounter> RunStatistics::progressCounter{COMPRESSED_BYTES_READ};
+
+atomic<int64_t> RunStatistics::progressTotal{0};
+
+mutex RunStatistics::progressMutex;
+
+condition_variable RunStatistics::progressCondition;
+
+thread RunStatistics::progressThread;
+
+bool RunStatistics::progressStopped{true};
+
+const char *const RunStatistics::COUNTER_NAMES[NUMBER_OF_RUN_COUNTERS] = {
+        "compressedBytesRead",
+        "uncompressedBytesProduced",
+        "blocks",
+        "indexEntriesStored",
+        "linesExtracted",
+        "bytesWritten",
+        "s3Requests",
+        "s3FailedRequests",
+        "s3BytesReceived"
+};
+
+const char *const RunStatistics::TIMER_NAMES[NUMBER_OF_RUN_TIMERS] = {
+        "read",
+        "inflate",
+        "lineScanning",
+        "dictionaryCompression",
+        "sinkWrites",
+        "s3Requests"
+};
+
+void RunStatistics::enable() {
+    for (auto &counter : counters)
+        counter = 0;
+    for (auto &timer : timers)
+        timer = 0;
+    progressCounter = COMPRESSED_BYTES_READ;
+    progressTotal = 0;
+    start = steady_clock::now();
+    enabled = true;
+}
+
+void RunStatistics::disable() {
+    stopProgressReport();
+    enabled = false;
+}
+
+int64_t RunStatistics::getPeakMemory() {
+    struct rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return -1;
+    return static_cast<int64_t>(usage.ru_maxrss) * 1024; // Linux reports kB.
+}
+
+void RunStatistics::startProgressReport(seconds interval) {
+    stopProgressReport();
+    progressStopped = false;
+    progressThread = thread([interval]() {
+        unique_lock<mutex> lock(progressMutex);
+        while (!progressCondition.wait_for(lock, interval, []() { return progressStopped; }))
+            cerr << createProgressLine() << "\n";
+    });
+}
+
+void RunStatistics::stopProgressReport() {
+    {
+        lock_guard<mutex> lock(progressMutex);
+        progressStopped = true;
+    }
+    progressCondition.notify_all();
+    if (progressThread.joinable())
+        progressThread.join();
+}
+
+string RunStatistics::createProgressLine() {
+    double seconds = getWallTimeInSeconds();
+    double compressedMB = static_cast<double>(get(COMPRESSED_BYTES_READ)) / 1024 / 1024;
+    double uncompressedMB = static_cast<double>(get(UNCOMPRESSED_BYTES_PRODUCED)) / 1024 / 1024;
+    stringstream line;
+    line << fixed << setprecision(1) << "Progress: " << compressedMB << " MB read, " << uncompressedMB
+         << " MB decompressed, " << (seconds > 0 ? compressedMB / seconds : 0) << " MB/s";
+
+    int64_t total = progressTotal;
+    int64_t current = get(progressCounter);
+    if (total > 0 && current > 0) {
+        double fraction = min(static_cast<double>(current) / total, 1.0);
+        auto eta = static_cast<int64_t>(seconds / fraction - seconds);
+        line << ", " << fraction * 100 << "%, ETA " << setfill('0') << setw(2) << eta / 3600 << ":"
+             << setw(2) << eta / 60 % 60 << ":" << setw(2) << eta % 60;
+    }
+    return line.str();
+}
+
+string RunStatistics::toJSON(const string &mode, bool successful) {
+    stringstream json;
+    json << "{\n"
+         << "  \"mode\": \"" << mode << "\",\n"
+         << "  \"successful\": " << (successful ? "true" : "false") << ",\n"
+         << "  \"wallTimeSeconds\": " << fixed << setprecision(6) << getWallTimeInSeconds() << ",\n"
+         << "  \"peakMemoryBytes\": " << getPeakMemory() << ",\n"
+         << "  \"counters\": {\n";
+    for (int i = 0; i < NUMBER_OF_RUN_COUNTERS; i++) {
+        json << "    \"" << COUNTER_NAMES[i] << "\": " << get(static_cast<RunCounter>(i))
+             << (i + 1 < NUMBER_OF_RUN_COUNTERS ? ",\n" : "\n");
+    }
+    json << "  },\n"
+         << "  \"timersSeconds\": {\n";
+    for (int i = 0; i < NUMBER_OF_RUN_TIMERS; i++) {
+        json << "    \"" << TIMER_NAMES[i] << "\": " << duration<double>(get(static_cast<RunTimer>(i))).count()
+             << (i + 1 < NUMBER_OF_RUN_TIMERS ? ",\n" : "\n");
+    }
+    json << "  }\n"
+         << "}\n";
+    return json.str();
+}
+
+bool RunStatistics::writeJSON(const path &file, const string &mode, bool successful) {
+    ofstream output(file);
+    output << toJSON(mode, successful);
+    output.close();
+    return output.good();
+}
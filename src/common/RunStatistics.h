@@ -0,0 +1,180 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#ifndef FASTQINDEX_RUNSTATISTICS_H
+#define FASTQINDEX_RUNSTATISTICS_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <experimental/filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using std::atomic;
+using std::string;
+using std::experimental::filesystem::path;
+using namespace std::chrono;
+
+/**
+ * Counters of a run. Keep the order in sync with RunStatistics::COUNTER_NAMES.
+ */
+enum RunCounter {
+    COMPRESSED_BYTES_READ,
+    UNCOMPRESSED_BYTES_PRODUCED,
+    BLOCKS,
+    INDEX_ENTRIES_STORED,
+    LINES_EXTRACTED,
+    BYTES_WRITTEN,
+    S3_REQUESTS,
+    S3_FAILED_REQUESTS,
+    S3_BYTES_RECEIVED,
+    NUMBER_OF_RUN_COUNTERS
+};
+
+/**
+ * Accumulated timers of a run. Keep the order in sync with RunStatistics::TIMER_NAMES.
+ */
+enum RunTimer {
+    TIME_IN_READ,
+    TIME_IN_INFLATE,
+    TIME_IN_LINE_SCANNING,
+    TIME_IN_DICTIONARY_COMPRESSION,
+    TIME_IN_SINK_WRITES,
+    TIME_IN_S3_REQUESTS,
+    NUMBER_OF_RUN_TIMERS
+};
+
+/**
+ * Process wide counters and timers for the indexer, the extractor and the S3 sources. Collection is off by default
+ * and costs a single check per call then. Once enabled, the values are reported periodically as a progress line on
+ * stderr and at the end of the run as a JSON file, see --stats-json.
+ *
+ * All counting methods are thread safe, the S3 sources call them from their download threads. Timers from several
+ * threads add up, so the S3 request time can exceed the wall time.
+ */
+class RunStatistics {
+
+private:
+
+    static atomic<bool> enabled;
+
+    static atomic<int64_t> counters[NUMBER_OF_RUN_COUNTERS];
+
+    static atomic<int64_t> timers[NUMBER_OF_RUN_TIMERS];
+
+    static steady_clock::time_point start;
+
+    /**
+     * The counter which is compared to progressTotal for the percentage and the ETA of the progress report.
+     */
+    static atomic<RunCounter> progressCounter;
+
+    static atomic<int64_t> progressTotal;
+
+    static std::mutex progressMutex;
+
+    static std::condition_variable progressCondition;
+
+    static std::thread progressThread;
+
+    static bool progressStopped;
+
+public:
+
+    static const char *const COUNTER_NAMES[NUMBER_OF_RUN_COUNTERS];
+
+    static const char *const TIMER_NAMES[NUMBER_OF_RUN_TIMERS];
+
+    /**
+     * Resets all values and starts collecting.
+     */
+    static void enable();
+
+    /**
+     * Stops the progress report and collecting. The values are kept until the next call of enable().
+     */
+    static void disable();
+
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    static void count(RunCounter counter, int64_t value = 1) {
+        if (isEnabled())
+            counters[counter].fetch_add(value, std::memory_order_relaxed);
+    }
+
+    static void addTime(RunTimer timer, nanoseconds time) {
+        if (isEnabled())
+            timers[timer].fetch_add(time.count(), std::memory_order_relaxed);
+    }
+
+    static int64_t get(RunCounter counter) { return counters[counter].load(); }
+
+    static nanoseconds get(RunTimer timer) { return nanoseconds(timers[timer].load()); }
+
+    static double getWallTimeInSeconds() { return duration<double>(steady_clock::now() - start).count(); }
+
+    /**
+     * Sets the expected final value of counter, e.g. the size of the compressed file for COMPRESSED_BYTES_READ. Values
+     * <= 0 disable the percentage and the ETA.
+     */
+    static void setProgressTotal(RunCounter counter, int64_t total) {
+        // The progress thread reads the total first, so it never combines a new total with the old counter.
+        progressTotal = 0;
+        progressCounter = counter;
+        progressTotal = total;
+    }
+
+    /**
+     * The peak resident set size of the process in Bytes.
+     */
+    static int64_t getPeakMemory();
+
+    /**
+     * Starts a thread, which prints createProgressLine() to stderr every interval.
+     */
+    static void startProgressReport(seconds interval);
+
+    static void stopProgressReport();
+
+    /**
+     * Something like "Progress: 1024.0 MB read, 4096.0 MB decompressed, 210.3 MB/s, 42.0%, ETA 00:01:13"
+     */
+    static string createProgressLine();
+
+    static string toJSON(const string &mode, bool successful);
+
+    static bool writeJSON(const path &file, const string &mode, bool successful);
+};
+
+/**
+ * Adds the time between construction and destruction to a RunStatistics timer.
+ */
+class ScopedRunTimer {
+
+private:
+
+    RunTimer timer;
+
+    bool active;
+
+    steady_clock::time_point start;
+
+public:
+
+    explicit ScopedRunTimer(RunTimer timer) : timer(timer), active(RunStatistics::isEnabled()) {
+        if (active)
+            start = steady_clock::now();
+    }
+
+    ~ScopedRunTimer() {
+        if (active)
+            RunStatistics::addTime(timer, steady_clock::now() - start);
+    }
+};
+
+#endif //FASTQINDEX_RUNSTATISTICS_H
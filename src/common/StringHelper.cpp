@@ -6,6 +6,7 @@
 
 #include "CommonStructsAndConstants.h"
 #include "StringHelper.h"
+#include <limits>
 #include <regex>
 
 vector<string> StringHelper::splitStr(const string &str, char delimiter) {
@@ -44,3 +45,47 @@ int64_t StringHelper::parseStringValue(const string &str) {
 
     return result;
 }
+
+bool StringHelper::parseByteRange(const string &str, int64_t *start, int64_t *length) {
+    smatch match;
+    if (!regex_match(str, match, regex("([0-9]+)([kmgtKMGT]?):([0-9]+)([kmgtKMGT]?)")))
+        return false;
+
+    // Out of range values are rejected instead of throwing or overflowing.
+    auto toBytes = [](const string &value, const string &unit, int64_t *bytes) -> bool {
+        int64_t factor = 1;
+        if (!unit.empty()) {
+            switch (tolower(unit[0])) {
+                case 'k':
+                    factor = kB;
+                    break;
+                case 'm':
+                    factor = MB;
+                    break;
+                case 'g':
+                    factor = GB;
+                    break;
+                default:
+                    factor = TB;
+            }
+        }
+        try {
+            long long result = stoll(value);
+            if (result > numeric_limits<int64_t>::max() / factor)
+                return false;
+            *bytes = result * factor;
+            return true;
+        } catch (const out_of_range &) {
+            return false;
+        }
+    };
+    int64_t parsedStart{0}, parsedLength{0};
+    if (!toBytes(match[1], match[2], &parsedStart) || !toBytes(match[3], match[4], &parsedLength))
+        return false;
+    // The end of the range needs to be representable as well.
+    if (parsedLength <= 0 || parsedStart > numeric_limits<int64_t>::max() - parsedLength)
+        return false;
+    *start = parsedStart;
+    *length = parsedLength;
+    return true;
+}
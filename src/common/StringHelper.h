@@ -10,6 +10,7 @@
 #include <vector>
 #include <sstream>
 #include <string>
+#include <sys/types.h>
 
 using namespace std;
 
@@ -17,9 +18,31 @@ class StringHelper {
 
 public:
 
+    static constexpr u_int64_t FNV1A_OFFSET_BASIS = 14695981039346656037ULL;
+
+    /**
+     * Continues a 64 bit FNV-1a hash with the data. A text can be hashed in parts, the first part starts with
+     * FNV1A_OFFSET_BASIS.
+     */
+    static u_int64_t fnv1a(const char *data, u_int64_t length, u_int64_t hash = FNV1A_OFFSET_BASIS) {
+        for (u_int64_t i = 0; i < length; i++) {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
     static vector<string> splitStr(const string &str, char delimiter = '\n');
 
     static int64_t parseStringValue(const string &str);
+
+    /**
+     * Parses a range of Bytes in the form <start>:<length>, e.g. 0:4096 or 2G:512M. Unlike for parseStringValue(),
+     * values without a unit are Bytes.
+     * @return false, if the string is no valid range, the length is 0 or the range does not fit into 64 bit. start
+     *         and length are only changed on success.
+     */
+    static bool parseByteRange(const string &str, int64_t *start, int64_t *length);
 };
 
 
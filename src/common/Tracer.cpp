@@ -0,0 +1,120 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#include "common/Tracer.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <unistd.h>
+
+using namespace std;
+
+const u_int64_t Tracer::DEFAULT_MAXIMUM_EVENTS = 1024 * 1024;
+
+atomic<bool> Tracer::enabled{false};
+
+atomic<u_int64_t> Tracer::maximumEvents{Tracer::DEFAULT_MAXIMUM_EVENTS};
+
+atomic<u_int64_t> Tracer::numberOfEvents{0};
+
+steady_clock::time_point Tracer::origin = steady_clock::now();
+
+thread::id Tracer::mainThread;
+
+mutex Tracer::registryMutex;
+
+vector<shared_ptr<Tracer::ThreadBuffer>> Tracer::threadBuffers;
+
+Tracer::ThreadBuffer &Tracer::getBufferOfCurrentThread() {
+    thread_local shared_ptr<ThreadBuffer> buffer;
+    if (!buffer) {
+        buffer = make_shared<ThreadBuffer>();
+        buffer->systemThreadId = this_thread::get_id();
+        lock_guard<mutex> lock(registryMutex);
+        buffer->threadId = static_cast<int>(threadBuffers.size()) + 1;
+        threadBuffers.emplace_back(buffer);
+    }
+    return *buffer;
+}
+
+void Tracer::enable(u_int64_t maximumEvents) {
+    lock_guard<mutex> lock(registryMutex);
+    for (auto &buffer : threadBuffers) {
+        lock_guard<mutex> bufferLock(buffer->bufferMutex);
+        buffer->events.clear();
+        buffer->events.shrink_to_fit();
+    }
+    Tracer::maximumEvents = maximumEvents;
+    numberOfEvents = 0;
+    origin = steady_clock::now();
+    mainThread = this_thread::get_id();
+    enabled = true;
+}
+
+void Tracer::disable() {
+    enabled = false;
+}
+
+void Tracer::record(const char *name, steady_clock::time_point start, steady_clock::time_point end) {
+    if (numberOfEvents.fetch_add(1, memory_order_relaxed) >= maximumEvents.load(memory_order_relaxed))
+        return;
+    auto &buffer = getBufferOfCurrentThread();
+    lock_guard<mutex> lock(buffer.bufferMutex);
+    buffer.events.push_back({name,
+                             duration_cast<nanoseconds>(start - origin).count(),
+                             duration_cast<nanoseconds>(end - start).count()});
+}
+
+vector<TraceEvent> Tracer::getEvents() {
+    vector<TraceEvent> events;
+    lock_guard<mutex> lock(registryMutex);
+    for (auto &buffer : threadBuffers) {
+        lock_guard<mutex> bufferLock(buffer->bufferMutex);
+        events.insert(events.end(), buffer->events.begin(), buffer->events.end());
+    }
+    return events;
+}
+
+u_int64_t Tracer::getNumberOfDroppedEvents() {
+    u_int64_t events = numberOfEvents;
+    u_int64_t maximum = maximumEvents;
+    return events > maximum ? events - maximum : 0;
+}
+
+string Tracer::toJSON() {
+    // Timestamps and durations are in microseconds.
+    auto pid = getpid();
+    stringstream json;
+    json << fixed << setprecision(3) << "{\"traceEvents\":[\n";
+    bool first = true;
+    lock_guard<mutex> lock(registryMutex);
+    for (auto &buffer : threadBuffers) {
+        lock_guard<mutex> bufferLock(buffer->bufferMutex);
+        if (buffer->events.empty())
+            continue;
+        string threadName = buffer->systemThreadId == mainThread ? "main" : "worker " + to_string(buffer->threadId);
+        json << (first ? "" : ",\n")
+             << R"({"name":"thread_name","ph":"M","pid":)" << pid << ",\"tid\":" << buffer->threadId
+             << R"(,"args":{"name":")" << threadName << "\"}}";
+        first = false;
+        for (const auto &event : buffer->events) {
+            json << ",\n{\"name\":\"" << event.name << R"(","cat":"fastqindex","ph":"X","pid":)" << pid
+                 << ",\"tid\":" << buffer->threadId
+                 << ",\"ts\":" << static_cast<double>(event.start) / 1000
+                 << ",\"dur\":" << static_cast<double>(event.duration) / 1000 << "}";
+        }
+    }
+    json << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return json.str();
+}
+
+bool Tracer::writeJSON(const path &file) {
+    ofstream output(file);
+    output << toJSON();
+    output.close();
+    return output.good();
+}
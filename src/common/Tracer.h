@@ -0,0 +1,168 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#ifndef FASTQINDEX_TRACER_H
+#define FASTQINDEX_TRACER_H
+
+#include <atomic>
+#include <chrono>
+#include <experimental/filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::atomic;
+using std::mutex;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+using std::experimental::filesystem::path;
+using namespace std::chrono;
+
+/**
+ * Use FQI_TRACE_SPAN("name") to record the rest of the enclosing scope as a span. name must be a string literal (or
+ * live as long as the process). Without FQI_ENABLE_TRACING (see the CMake option of the same name), the macro is
+ * empty and the instrumentation is compiled out.
+ */
+#ifdef FQI_ENABLE_TRACING
+#define FQI_TRACE_CONCATENATE_(a, b) a##b
+#define FQI_TRACE_CONCATENATE(a, b) FQI_TRACE_CONCATENATE_(a, b)
+#define FQI_TRACE_SPAN(name) TraceSpan FQI_TRACE_CONCATENATE(_traceSpan, __LINE__)(name)
+#else
+#define FQI_TRACE_SPAN(name) do {} while (false)
+#endif
+
+struct TraceEvent {
+
+    const char *name;
+
+    /**
+     * Nanoseconds since Tracer::enable()
+     */
+    int64_t start;
+
+    int64_t duration;
+};
+
+/**
+ * Records spans per thread and writes them in the Chrome trace event format, which can be opened with Perfetto
+ * (https://ui.perfetto.dev) or chrome://tracing. See --trace.
+ *
+ * Every thread appends to its own buffer, so the threads don't wait for each other. The buffers are kept after a
+ * thread ended, they are written out with writeJSON(). The number of recorded spans is limited, later spans are
+ * dropped and only counted.
+ */
+class Tracer {
+
+private:
+
+    struct ThreadBuffer {
+
+        mutex bufferMutex;
+
+        int threadId{0};
+
+        std::thread::id systemThreadId;
+
+        vector<TraceEvent> events;
+    };
+
+    static atomic<bool> enabled;
+
+    static atomic<u_int64_t> maximumEvents;
+
+    /**
+     * The number of spans passed to record() since enable(), including the dropped ones.
+     */
+    static atomic<u_int64_t> numberOfEvents;
+
+    static steady_clock::time_point origin;
+
+    /**
+     * The thread, which called enable(), is named "main" in the trace.
+     */
+    static std::thread::id mainThread;
+
+    static mutex registryMutex;
+
+    static vector<shared_ptr<ThreadBuffer>> threadBuffers;
+
+    static ThreadBuffer &getBufferOfCurrentThread();
+
+public:
+
+    /**
+     * About 24MB of spans, enough for the timeline of a long run.
+     */
+    static const u_int64_t DEFAULT_MAXIMUM_EVENTS;
+
+    /**
+     * false, if the application was built without FQI_ENABLE_TRACING and no spans will be recorded.
+     */
+    static constexpr bool isCompiledIn() {
+#ifdef FQI_ENABLE_TRACING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * Drops all recorded spans and starts recording.
+     * @param maximumEvents The number of spans, which are kept. Further spans are dropped.
+     */
+    static void enable(u_int64_t maximumEvents = DEFAULT_MAXIMUM_EVENTS);
+
+    /**
+     * Stops recording, the recorded spans are kept until the next call of enable().
+     */
+    static void disable();
+
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    static void record(const char *name, steady_clock::time_point start, steady_clock::time_point end);
+
+    static vector<TraceEvent> getEvents();
+
+    /**
+     * The number of spans, which were dropped since enable(), because the limit was reached.
+     */
+    static u_int64_t getNumberOfDroppedEvents();
+
+    static string toJSON();
+
+    static bool writeJSON(const path &file);
+};
+
+/**
+ * Records the time between construction and destruction as a span, use it with FQI_TRACE_SPAN.
+ */
+class TraceSpan {
+
+private:
+
+    const char *name;
+
+    bool active;
+
+    steady_clock::time_point start;
+
+public:
+
+    explicit TraceSpan(const char *name) : name(name), active(Tracer::isEnabled()) {
+        if (active)
+            start = steady_clock::now();
+    }
+
+    ~TraceSpan() {
+        if (active)
+            Tracer::record(name, start, steady_clock::now());
+    }
+};
+
+#endif //FASTQINDEX_TRACER_H
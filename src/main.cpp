@@ -11,11 +11,8 @@
 int main(int argc, const char *argv[]) {
     // Store the application binary path.
     path fqiBinaryPath = IOHelper::getApplicationPath();
-    path s3HelperBinary = IOHelper::fullPath(fqiBinaryPath.parent_path().string() + "/fastqindexs3iohelper");
     strcpy(FQI_BINARY, fqiBinaryPath.string().c_str());
-    strcpy(S3HELPER_BINARY, s3HelperBinary.string().c_str());
-    ErrorAccumulator::always("FQI binary path:       '", fqiBinaryPath, "'");
-    ErrorAccumulator::always("S3 helper binary path: '", s3HelperBinary, "'");
+    ErrorAccumulator::always("FQI binary path: '", fqiBinaryPath, "'");
 
     Starter starter;
     auto runner = starter.createRunner(argc, argv);
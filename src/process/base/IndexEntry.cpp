@@ -8,14 +8,14 @@
 
 IndexEntry::IndexEntry(u_int64_t id,
                        u_int32_t bits,
-                       u_int16_t offsetOfFirstValidLine,
+                       u_int32_t offsetOfFirstValidLine,
                        u_int64_t offsetInRawFile,
                        u_int64_t startingLineInEntry) :
         id(id),
         blockOffsetInRawFile(offsetInRawFile),
         startingLineInEntry(startingLineInEntry),
-        offsetToNextLineStart(offsetOfFirstValidLine),
-        bits(bits) {}
+        bits(bits),
+        offsetToNextLineStart(offsetOfFirstValidLine) {}
 
 bool IndexEntry::operator==(const IndexEntry &rhs) const {
     return id == rhs.id &&
@@ -27,13 +27,14 @@ struct IndexEntry {
     u_int64_t startingLineInEntry{0};
     u_int64_t compressedDictionarySize{0};
     u_int32_t bits{0};
-    u_int16_t offsetToNextLineStart{0};
+    u_int32_t offsetToNextLineStart{0};
+    int64_t offsetInUncompressedData{-1}; // -1, if unknown, see IndexHeader::entriesHaveUncompressedOffsets
 
     Bytef window[WINDOW_SIZE]{0};
 
     IndexEntry(u_int64_t id,
                u_int32_t bits,
-               u_int16_t offsetOfFirstValidLine,
+               u_int32_t offsetOfFirstValidLine,
                u_int64_t offsetInRawFile,
                u_int64_t startingLineInEntry);
 
@@ -26,5 +26,6 @@ bool IndexHeader::operator==(const IndexHeader &rhs) const {
 IndexHeader::operator bool() const {
     return magicNumber == MAGIC_NUMBER &&
            blockInterval > 0 &&
-           (indexWriterVersion == 1 && sizeOfIndexEntry == sizeof(IndexEntryV1));
+           (indexWriterVersion >= INDEX_WITH_LINE_ENTRIES && indexWriterVersion <= INDEX_WITH_UNCOMPRESSED_OFFSETS &&
+            sizeOfIndexEntry == sizeof(IndexEntryV1));
 }
\ No newline at end of file
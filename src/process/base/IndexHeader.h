@@ -11,6 +11,39 @@
 #include "IndexEntry.h"
 #include "IndexEntryV1.h"
 
+/**
+ * Values of IndexHeader::completion.
+ */
+enum IndexCompletion : Bytef {
+    /**
+     * Written by versions of FastqIndEx, which did not know the marker. These files are accepted as they are.
+     */
+    INDEX_COMPLETION_UNKNOWN = 0,
+    /**
+     * The index is still written or its creation failed.
+     */
+    INDEX_IS_INCOMPLETE = 1,
+    INDEX_IS_COMPLETE = 2
+};
+
+/**
+ * Values of IndexHeader::indexWriterVersion. All versions use IndexEntryV1. The version is raised for every change,
+ * which older readers would misinterpret, they refuse unknown versions.
+ */
+enum IndexWriterVersion : u_int32_t {
+    INDEX_WITH_LINE_ENTRIES = 1,
+    /**
+     * The entries start with FASTQ records, see IndexHeader::entriesStartWithRecords. offsetToNextLineStart might skip
+     * several lines, readers of version 1 would start their extractions at the wrong line.
+     */
+    INDEX_WITH_RECORD_ENTRIES = 2,
+    /**
+     * The entries are extended by their uncompressed offsets, see IndexHeader::entriesHaveUncompressedOffsets. The
+     * entries might also start with records.
+     */
+    INDEX_WITH_UNCOMPRESSED_OFFSETS = 3
+};
+
 /**
  * The header for an gz index file
  * The size of the header struct is 512Byte including 4Byte overhead by padding.
@@ -56,7 +89,35 @@ struct IndexHeader {
      * the followup value when you look it up in written fqi files. C++ does not do a clean write in this case.
      */
     bool dictionariesAreCompressed{false};
-    Bytef placeholder[7]{0};
+
+    /**
+     * Set, if the index was written to a sink which can't seek back (like a pipe). numberOfEntries and
+     * linesInIndexedFile are then 0 in the header and stored in an IndexTrailer at the end of the file.
+     */
+    bool hasTrailer{false};
+
+    /**
+     * The IndexWriter writes INDEX_IS_INCOMPLETE and patches in INDEX_IS_COMPLETE, when the index was created
+     * successfully. Readers don't need a lock then, they only reject incomplete files. Index files with a trailer keep
+     * INDEX_IS_INCOMPLETE, for them the trailer is the marker.
+     */
+    Bytef completion{INDEX_COMPLETION_UNKNOWN};
+
+    /**
+     * Set by the record aware Indexer, which validated the FASTQ records of the file. startingLineInEntry of every entry
+     * is then the first line of a record (a multiple of 4) and offsetToNextLineStart points to this record instead of
+     * the next line. Such indices are written with INDEX_WITH_RECORD_ENTRIES.
+     */
+    bool entriesStartWithRecords{false};
+
+    /**
+     * Set, if every entry stores the offset of its compressed block in the uncompressed data. The offset is written as
+     * an 8 Byte extension directly behind the fixed part of each entry (in front of the dictionary), so entries of
+     * indices without the flag keep their size. Such indices are written with INDEX_WITH_UNCOMPRESSED_OFFSETS.
+     */
+    bool entriesHaveUncompressedOffsets{false};
+
+    Bytef placeholder[3]{0};
 
     /**
      * Reserved space for information which might be added in
@@ -84,5 +145,24 @@ struct IndexHeader {
     bool operator!() { return !this; }
 };
 
+/**
+ * Closes an index file, if IndexHeader::hasTrailer is set. The writer does not know the counts before all entries are
+ * written, so they are appended instead of being patched into the header.
+ * The size of the struct is 24 Bytes.
+ */
+struct IndexTrailer {
+
+    int64_t numberOfEntries{0};
+
+    int64_t linesInIndexedFile{0};
+
+    u_int32_t magicNumber = TRAILER_MAGIC_NUMBER;
+
+    /**
+     * CRC32 of the whole index file up to (and excluding) this field.
+     */
+    u_int32_t checksum{0};
+};
+
 
 #endif //FASTQINDEX_INDEXHEADER_H
@@ -0,0 +1,80 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#ifndef FASTQINDEX_READNAMEINDEX_H
+#define FASTQINDEX_READNAMEINDEX_H
+
+#include "common/CommonStructsAndConstants.h"
+#include "common/StringHelper.h"
+#include <string>
+
+using namespace std;
+
+/**
+ * A read name index maps the read names of a FASTQ file to their record numbers. It is an optional file next to the
+ * index (<index file>.names), which is written by the record aware Indexer.
+ *
+ * The file consists of a ReadNameIndexHeader and one ReadNameEntry per record, sorted by hash and record. Only a 64 bit
+ * hash of each name is stored, which keeps the entries at a fixed size of 16 Byte. A lookup can therefore return
+ * records with a different name, the caller needs to compare the names of the extracted records.
+ */
+struct ReadNameIndexHeader {
+
+    u_int32_t magicNumber = READ_NAME_INDEX_MAGIC_NUMBER;
+
+    u_int32_t version{1};
+
+    u_int64_t numberOfEntries{0};
+
+    /**
+     * Reserved space for information which might be added in the future.
+     */
+    int64_t reserved[6]{0};
+};
+
+struct ReadNameEntry {
+
+    u_int64_t hash{0};
+
+    u_int64_t record{0};
+
+    bool operator<(const ReadNameEntry &rhs) const {
+        return hash < rhs.hash || (hash == rhs.hash && record < rhs.record);
+    }
+};
+
+/**
+ * 64 bit FNV-1a hash of a read name. The name can be passed in parts, like it is found in the decompressed data.
+ */
+struct ReadNameHash {
+
+    u_int64_t value{StringHelper::FNV1A_OFFSET_BASIS};
+
+    void add(const char *data, u_int64_t length) {
+        value = StringHelper::fnv1a(data, length, value);
+    }
+
+    static bool isSeparator(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+    /**
+     * The read name is the header line without the leading '@' up to the first whitespace.
+     */
+    static string readNameOf(const string &headerLine) {
+        string::size_type start = !headerLine.empty() && headerLine[0] == '@' ? 1 : 0;
+        string::size_type end = start;
+        while (end < headerLine.size() && !isSeparator(headerLine[end]))
+            end++;
+        return headerLine.substr(start, end - start);
+    }
+
+    static u_int64_t of(const string &readName) {
+        ReadNameHash hash;
+        hash.add(readName.data(), readName.size());
+        return hash.value;
+    }
+};
+
+#endif //FASTQINDEX_READNAMEINDEX_H
@@ -4,6 +4,8 @@
  * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
  */
 
+#include "common/RunStatistics.h"
+#include "common/Tracer.h"
 #include "process/io/FileSource.h"
 #include "ZLibBasedFASTQProcessorBaseClass.h"
 #include <experimental/filesystem>
@@ -50,8 +52,14 @@ bool ZLibBasedFASTQProcessorBaseClass::initializeZStream(int mode) {
 }
 
 bool ZLibBasedFASTQProcessorBaseClass::readCompressedDataFromSource() {
-    /* get some compressed data from input file */
-    int64_t result = this->sourceFile->read(input, CHUNK_SIZE);
+    /* get some compressed data from input file. Sources with internal buffers can pass the data without copying. */
+    const Bytef *data{nullptr};
+    int64_t result;
+    {
+        FQI_TRACE_SPAN("read");
+        ScopedRunTimer timer(TIME_IN_READ);
+        result = this->sourceFile->readView(&data, input, CHUNK_SIZE);
+    }
 
     if (result == -1) {
         this->addErrorMessage("Could not read source file '", sourceFile->toString(), "'.");
@@ -63,7 +71,7 @@ bool ZLibBasedFASTQProcessorBaseClass::readCompressedDataFromSource() {
         this->addErrorMessage("There was no data available in the compressed stream.");
         return false;
     }
-    zStream.next_in = input;
+    zStream.next_in = const_cast<Bytef *>(data);
     return true;
 }
 
@@ -115,12 +123,18 @@ bool ZLibBasedFASTQProcessorBaseClass::decompressNextChunkOfData(bool checkForSt
     int64_t availableOutBeforeInflate = zStream.avail_out;
     u_int32_t windowPositionBeforeInflate = WINDOW_SIZE - zStream.avail_out;
 
-    zlibResult = inflate(&zStream, flushMode);
+    {
+        FQI_TRACE_SPAN("inflate");
+        ScopedRunTimer timer(TIME_IN_INFLATE);
+        zlibResult = inflate(&zStream, flushMode);
+    }
     int64_t readBytes = availableInBeforeInflate - zStream.avail_in;
     int64_t writtenBytes = availableOutBeforeInflate - zStream.avail_out;
 
     totalBytesIn += readBytes;
     totalBytesOut += writtenBytes;
+    RunStatistics::count(COMPRESSED_BYTES_READ, readBytes);
+    RunStatistics::count(UNCOMPRESSED_BYTES_PRODUCED, writtenBytes);
 
     // The window buffer used by inflate will be filled at somewhere between 0 <= n <= WINDOW_SIZE
     // as we work with a string append method, we need to copy the read data to a fresh buffer first.
@@ -144,6 +158,63 @@ bool ZLibBasedFASTQProcessorBaseClass::decompressNextChunkOfData(bool checkForSt
     return true;
 }
 
+bool ZLibBasedFASTQProcessorBaseClass::seekAndPrimeZStreamForIndexEntry(const shared_ptr<IndexEntry> &entry) {
+    off_t initialOffset = entry->blockOffsetInRawFile;
+    totalBytesIn += initialOffset;
+    int startBits = entry->bits;
+    if (startBits > 0)
+        initialOffset--;
+    // Streams can't jump, they read and drop the compressed data up to the offset. This is still a lot cheaper than
+    // decompressing it.
+    auto seekResult = sourceFile->seek(initialOffset, true);
+    if (seekResult == -1 || sourceFile->tell() != initialOffset) {
+        addErrorMessage("Could not jump to position '", to_string(initialOffset),
+                        "' in file '", sourceFile->toString(), "'");
+        return false;
+    }
+
+    if (startBits > 0) {
+        // The partial Byte at offset - 1 is already part of blockOffsetInRawFile, don't count it twice. Otherwise the
+        // search for the next concatenated part starts one Byte too late.
+        int ret = sourceFile->readChar();
+        if (ret == -1) {
+            ret = sourceFile->lastError() ? Z_ERRNO : Z_DATA_ERROR;
+            addErrorMessage("Could not read from source file '", sourceFile->toString(),
+                            "'. The latest zlib error code was '", to_string(ret), "'.");
+            return false;
+        }
+        // The following line will pop up a clang-tidy warning, but as Mark Adler does it, I don't want to change it.
+        zlibResult = inflatePrime(&zStream, startBits, ret >> (8 - startBits));
+        if (zlibResult != 0) {
+            addErrorMessage("Could not prime the zStream for extraction. zlib reported: '", zStream.msg, "'.");
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ZLibBasedFASTQProcessorBaseClass::setDictionaryForIndexEntry(const shared_ptr<IndexEntry> &entry) {
+    if (entry->compressedDictionarySize > 0) {
+        // Decompress!
+        Bytef uncompressedDictionary[WINDOW_SIZE]{0};
+        uLongf destLen = WINDOW_SIZE;
+        uLong sourceLen = entry->compressedDictionarySize;
+        // Ignore result here as zlib will fail anyways upon inflateSetDictionary, if the step went wrong.
+        FQI_TRACE_SPAN("decompress dictionary");
+        ScopedRunTimer timer(TIME_IN_DICTIONARY_COMPRESSION);
+        uncompress2(uncompressedDictionary, &destLen, entry->window, &sourceLen);
+        zlibResult = inflateSetDictionary(&zStream, uncompressedDictionary, WINDOW_SIZE);
+    } else {
+        zlibResult = inflateSetDictionary(&zStream, entry->window, WINDOW_SIZE);
+    }
+    if (zlibResult != 0) {
+        addErrorMessage("There was an error when trying to set to dictionary for decompression. zlib reported: '",
+                        zStream.msg, "'.");
+        return false;
+    }
+    return true;
+}
+
 void ZLibBasedFASTQProcessorBaseClass::clearCurrentCompressedBlock() {
     currentDecompressedBlock.str("");
     currentDecompressedBlock.clear();
@@ -164,6 +164,20 @@ public:
     bool decompressNextChunkOfData(bool checkForStreamEnd, int flushMode);
 
     void clearCurrentCompressedBlock();
+
+    /**
+     * Moves the source to the compressed block of entry and feeds the partial Byte in front of the block to zlib. The
+     * zStream needs to be initialized for raw inflate and the source needs to be open.
+     * If the method fails, sourceFile will not be closed automatically.
+     * @return true, if the operation was successful.
+     */
+    bool seekAndPrimeZStreamForIndexEntry(const shared_ptr<IndexEntry> &entry);
+
+    /**
+     * Sets the (eventually compressed) dictionary of entry for the raw inflate.
+     * @return true, if the operation was successful.
+     */
+    bool setDictionaryForIndexEntry(const shared_ptr<IndexEntry> &entry);
 };
 
 
@@ -0,0 +1,286 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#include "ByteRangeExtractor.h"
+#include "common/RunStatistics.h"
+#include "common/Tracer.h"
+#include "Extractor.h"
+#include <algorithm>
+#include <cstring>
+
+ByteRangeExtractor::ByteRangeExtractor(const shared_ptr<Source> &sourceFile,
+                                       const shared_ptr<Source> &indexFile,
+                                       const shared_ptr<Sink> &resultSink,
+                                       u_int64_t start,
+                                       u_int64_t length,
+                                       bool alignToRecords,
+                                       uint recordSize) :
+        ZLibBasedFASTQProcessorBaseClass(sourceFile, indexFile, false),
+        resultSink(resultSink),
+        start(start),
+        length(length),
+        alignToRecords(alignToRecords),
+        recordSize(recordSize) {
+    indexReader = make_shared<IndexReader>(indexFile);
+}
+
+bool ByteRangeExtractor::fulfillsPremises() {
+    bool fulfilled = true;
+    if (length == 0) {
+        addErrorMessage("The length of the Byte range must be larger than 0.");
+        fulfilled = false;
+    }
+    if (recordSize == 0) {
+        addErrorMessage("The record size must be larger than 0.");
+        fulfilled = false;
+    }
+    if (!resultSink->fulfillsPremises())
+        fulfilled = false;
+    if (!indexReader->tryOpenAndReadHeader())
+        return false;
+    auto header = indexReader->getIndexHeader();
+    if (!header.entriesHaveUncompressedOffsets) {
+        addErrorMessage("The index file '", inputIndexFile->toString(), "' does not store uncompressed offsets, create it ",
+                        "with index --uncompressedOffsets to extract Byte ranges.");
+        fulfilled = false;
+    }
+    // The records are found with the line numbers of the entries. Only the record aware Indexer validates them, line
+    // based indices can e.g. count the lines of concatenated files wrong. The records would then be cut.
+    if (alignToRecords && recordSize > 1) {
+        if (!header.entriesStartWithRecords) {
+            addErrorMessage("The index file '", inputIndexFile->toString(), "' is not record aware, create it with ",
+                            "index --recordAware to align Byte ranges to records.");
+            fulfilled = false;
+        } else if (header.linesInIndexedFile % recordSize != 0) {
+            addErrorMessage("The total number of lines '", to_string(header.linesInIndexedFile),
+                            "' is not a multiple of the record size '", to_string(recordSize), "'.");
+            fulfilled = false;
+        }
+    }
+    return fulfilled;
+}
+
+void ByteRangeExtractor::findIndexEntryForExtraction() {
+    usedIndexEntry.reset();
+    extractionEndOffset = -1;
+    if (!indexReader->tryOpenAndReadHeader())
+        return;
+
+    // With alignToRecords, the first line of the entry is the first place at which we know that a line starts.
+    auto keyOf = [&](const shared_ptr<IndexEntry> &entry) {
+        return static_cast<u_int64_t>(entry->offsetInUncompressedData) +
+               (alignToRecords ? static_cast<u_int64_t>(entry->offsetToNextLineStart) : 0);
+    };
+
+    u_int64_t end = start + length;
+    int64_t entryNumber = 0;
+    bool endWasPassed = false;
+    while (indexReader->getIndicesLeft() > 0) {
+        auto entry = indexReader->readIndexEntry();
+        if (!entry)
+            break;
+        if (!usedIndexEntry || keyOf(entry) <= start) {
+            usedIndexEntry = entry;
+            usedIndexEntryNumber = entryNumber;
+        } else if (endWasPassed) {
+            // A record, which starts in front of the end of the range, might reach into the next block.
+            extractionEndOffset = entry->blockOffsetInRawFile;
+            break;
+        } else if (static_cast<u_int64_t>(entry->offsetInUncompressedData) > end) {
+            endWasPassed = true;
+        }
+        entryNumber++;
+    }
+}
+
+bool ByteRangeExtractor::extract() {
+    wasStarted = true;
+
+    findIndexEntryForExtraction();
+    if (!usedIndexEntry) {
+        addErrorMessage("The index file '", inputIndexFile->toString(), "' does not contain any entries.");
+        return false;
+    }
+    auto entry = usedIndexEntry;
+
+    if (!resultSink->openWithWriteLock()) {
+        addErrorMessage("Could not open the output '", resultSink->toString(), "' for writing.");
+        return false;
+    }
+
+    if (!alignToRecords)
+        RunStatistics::setProgressTotal(BYTES_WRITTEN, static_cast<int64_t>(length));
+
+    totalBytesIn = 0;
+    currentStreamIsRawDeflateStream = true;
+    position = static_cast<u_int64_t>(entry->offsetInUncompressedData);
+    currentLine = entry->startingLineInEntry;
+    bytesToSkip = alignToRecords ? entry->offsetToNextLineStart : 0;
+
+    sourceFile->open();
+    if (!initializeZStreamForRawInflate()) {
+        sourceFile->close();
+        resultSink->close();
+        return false;
+    }
+
+    off_t initialOffset = entry->blockOffsetInRawFile;
+    if (entry->bits > 0)
+        initialOffset--;
+    sourceFile->setReadStart(initialOffset);
+    sourceFile->adviseRange(initialOffset, extractionEndOffset > initialOffset ? extractionEndOffset - initialOffset : 0);
+
+    if (seekAndPrimeZStreamForIndexEntry(entry) && setDictionaryForIndexEntry(entry)) {
+        while (!rangeIsComplete) {
+            if (zStream.avail_in == 0) {
+                if (!sourceFile->canRead())
+                    break;
+                if (!readCompressedDataFromSource()) {
+                    errorWasRaised = true;
+                    break;
+                }
+            }
+
+            resetSlidingWindowIfNecessary();
+            const Bytef *output = zStream.next_out;
+            int64_t availableInBeforeInflate = zStream.avail_in;
+            int64_t availableOutBeforeInflate = zStream.avail_out;
+            {
+                FQI_TRACE_SPAN("inflate");
+                ScopedRunTimer timer(TIME_IN_INFLATE);
+                zlibResult = inflate(&zStream, Z_NO_FLUSH);
+            }
+            int64_t readBytes = availableInBeforeInflate - zStream.avail_in;
+            int64_t writtenBytes = availableOutBeforeInflate - zStream.avail_out;
+            totalBytesIn += readBytes;
+            totalBytesOut += writtenBytes;
+            RunStatistics::count(COMPRESSED_BYTES_READ, readBytes);
+            RunStatistics::count(UNCOMPRESSED_BYTES_PRODUCED, writtenBytes);
+
+            if (zlibResult == Z_NEED_DICT || zlibResult == Z_DATA_ERROR || zlibResult == Z_MEM_ERROR) {
+                string message = join("The data in '", sourceFile->toString(), "' could not be decompressed at offset ",
+                                      to_string(totalBytesIn), ". zlib reported: '", zStream.msg ? zStream.msg : "",
+                                      "'.");
+                addErrorMessage(message);
+                severe(message);
+                errorWasRaised = true;
+                break;
+            }
+
+            if (alignToRecords)
+                scanDecompressedDataForRecords(reinterpret_cast<const char *>(output),
+                                               static_cast<u_int64_t>(writtenBytes));
+            else
+                scanDecompressedData(reinterpret_cast<const char *>(output), static_cast<u_int64_t>(writtenBytes));
+
+            if (zlibResult == Z_STREAM_END && !prepareForNextConcatenatedPart())
+                break;
+        }
+    } else {
+        errorWasRaised = true;
+    }
+    inflateEnd(&zStream);
+    sourceFile->close();
+
+    flushOutputBuffer();
+    bool resultSinkWasClosed;
+    {
+        ScopedRunTimer timer(TIME_IN_SINK_WRITES);
+        resultSinkWasClosed = resultSink->close();
+    }
+
+    finishedSuccessful = !errorWasRaised && indexReader->getErrorMessages().empty() && resultSinkWasClosed;
+    return finishedSuccessful;
+}
+
+bool ByteRangeExtractor::prepareForNextConcatenatedPart() {
+    // Like for the Extractor, the next gzip stream starts directly after the trailer of the current one.
+    if (currentStreamIsRawDeflateStream)
+        totalBytesIn += 8;
+    currentStreamIsRawDeflateStream = false;
+
+    sourceFile->seek(totalBytesIn, true);
+    if (!sourceFile->canRead())
+        return false;
+
+    inflateEnd(&zStream);
+    if (!initializeZStreamForInflate()) {
+        errorWasRaised = true;
+        return false;
+    }
+    return true;
+}
+
+void ByteRangeExtractor::scanDecompressedData(const char *data, u_int64_t dataLength) {
+    u_int64_t end = start + length;
+    u_int64_t dataEnd = position + dataLength;
+    if (dataEnd > start && position < end) {
+        u_int64_t first = max(position, start);
+        u_int64_t last = min(dataEnd, end);
+        outputBuffer.append(data + (first - position), last - first);
+        extractedBytes += last - first;
+        if (outputBuffer.size() >= Extractor::OUTPUT_BUFFER_SIZE)
+            flushOutputBuffer();
+    }
+    position = dataEnd;
+    rangeIsComplete = position >= end;
+}
+
+void ByteRangeExtractor::scanDecompressedDataForRecords(const char *data, u_int64_t dataLength) {
+    ScopedRunTimer timer(TIME_IN_LINE_SCANNING);
+    u_int64_t end = start + length;
+    u_int64_t skipped = min(bytesToSkip, dataLength);
+    bytesToSkip -= skipped;
+    position += skipped;
+    const char *current = data + skipped;
+    const char *dataEnd = data + dataLength;
+    while (current < dataEnd) {
+        if (atLineStart) {
+            if (currentLine % recordSize == 0) {
+                // Every record belongs to the range in which it starts.
+                if (position >= end) {
+                    rangeIsComplete = true;
+                    break;
+                }
+                recordIsWanted = position >= start;
+            }
+            atLineStart = false;
+        }
+        auto newline = static_cast<const char *>(memchr(current, '\n', static_cast<size_t>(dataEnd - current)));
+        const char *lineEnd = newline ? newline + 1 : dataEnd;
+        auto bytes = static_cast<u_int64_t>(lineEnd - current);
+        if (recordIsWanted) {
+            outputBuffer.append(current, bytes);
+            extractedBytes += bytes;
+        }
+        position += bytes;
+        current = lineEnd;
+        if (newline) {
+            currentLine++;
+            atLineStart = true;
+        }
+    }
+    if (outputBuffer.size() >= Extractor::OUTPUT_BUFFER_SIZE)
+        flushOutputBuffer();
+}
+
+void ByteRangeExtractor::flushOutputBuffer() {
+    if (outputBuffer.empty())
+        return;
+    {
+        ScopedRunTimer timer(TIME_IN_SINK_WRITES);
+        resultSink->write(outputBuffer);
+    }
+    RunStatistics::count(BYTES_WRITTEN, static_cast<int64_t>(outputBuffer.size()));
+    outputBuffer.clear();
+}
+
+vector<string> ByteRangeExtractor::getErrorMessages() {
+    vector<string> a = ErrorAccumulator::getErrorMessages();
+    vector<string> b = indexReader->getErrorMessages();
+    vector<string> c = resultSink->getErrorMessages();
+    return concatenateVectors(a, b, c);
+}
@@ -0,0 +1,133 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#ifndef FASTQINDEX_BYTERANGEEXTRACTOR_H
+#define FASTQINDEX_BYTERANGEEXTRACTOR_H
+
+#include "common/CommonStructsAndConstants.h"
+#include "process/base/ZLibBasedFASTQProcessorBaseClass.h"
+#include "process/extract/IndexReader.h"
+
+using namespace std;
+
+/**
+ * Extracts a range of the uncompressed data, which is given by Byte offsets instead of line numbers. This needs an
+ * index with uncompressed offsets, see IndexHeader::entriesHaveUncompressedOffsets. The extraction starts at the last
+ * index entry in front of the range.
+ *
+ * Either the exact Bytes of the range are extracted or, if alignToRecords is set, the complete records, which start
+ * within the range. Consecutive ranges then split the file into records without gaps or overlaps, like the splits of
+ * chunked readers.
+ */
+class ByteRangeExtractor : public ZLibBasedFASTQProcessorBaseClass {
+
+private:
+
+    shared_ptr<IndexReader> indexReader;
+
+    shared_ptr<Sink> resultSink;
+
+    /**
+     * The first Byte of the range in the uncompressed data.
+     */
+    u_int64_t start;
+
+    u_int64_t length;
+
+    bool alignToRecords;
+
+    /**
+     * The number of lines of a record, only used with alignToRecords.
+     */
+    uint recordSize;
+
+    shared_ptr<IndexEntry> usedIndexEntry;
+
+    int64_t usedIndexEntryNumber{0};
+
+    /**
+     * An offset in the compressed file behind the extracted data or -1, see Extractor::extractionEndOffset.
+     */
+    int64_t extractionEndOffset{-1};
+
+    /**
+     * The next gzip stream after the end of the current one is inflated with its header, see Extractor.
+     */
+    bool currentStreamIsRawDeflateStream{true};
+
+    /**
+     * The offset of the next decompressed Byte in the uncompressed data.
+     */
+    u_int64_t position{0};
+
+    /**
+     * The data in front of the first line of the used index entry, only skipped with alignToRecords.
+     */
+    u_int64_t bytesToSkip{0};
+
+    u_int64_t currentLine{0};
+
+    bool atLineStart{true};
+
+    /**
+     * Set, if the current record starts in the range.
+     */
+    bool recordIsWanted{false};
+
+    bool rangeIsComplete{false};
+
+    u_int64_t extractedBytes{0};
+
+    string outputBuffer;
+
+    bool prepareForNextConcatenatedPart();
+
+    void scanDecompressedData(const char *data, u_int64_t dataLength);
+
+    void scanDecompressedDataForRecords(const char *data, u_int64_t dataLength);
+
+    void flushOutputBuffer();
+
+public:
+
+    /**
+     * @param sourceFile     The file from which we will extract data
+     * @param indexFile      The index of the file, which needs uncompressed offsets.
+     * @param resultSink     The result file or stream.
+     * @param start          The first Byte of the range in the uncompressed data.
+     * @param length         The length of the range.
+     * @param alignToRecords Extract the complete records, which start in the range, instead of the exact range.
+     * @param recordSize     The number of lines of a record.
+     */
+    ByteRangeExtractor(const shared_ptr<Source> &sourceFile,
+                       const shared_ptr<Source> &indexFile,
+                       const shared_ptr<Sink> &resultSink,
+                       u_int64_t start,
+                       u_int64_t length,
+                       bool alignToRecords,
+                       uint recordSize);
+
+    shared_ptr<Sink> getResultSink() { return resultSink; }
+
+    shared_ptr<IndexEntry> getUsedIndexEntry() { return usedIndexEntry; }
+
+    u_int64_t getExtractedBytes() { return extractedBytes; }
+
+    bool fulfillsPremises();
+
+    /**
+     * Finds the last index entry in front of the range. With alignToRecords, its first line needs to start in front of
+     * the range as well. Fills usedIndexEntry, usedIndexEntryNumber and extractionEndOffset.
+     */
+    void findIndexEntryForExtraction();
+
+    bool extract();
+
+    vector<string> getErrorMessages() override;
+};
+
+
+#endif //FASTQINDEX_BYTERANGEEXTRACTOR_H
@@ -6,11 +6,13 @@
 
 #include "Extractor.h"
 #include "common/IOHelper.h"
-#include "common/StringHelper.h"
+#include "common/RunStatistics.h"
+#include "common/Tracer.h"
 #include "runners/IndexStatsRunner.h"
 #include "process/base/ZLibBasedFASTQProcessorBaseClass.h"
 #include "process/io/FileSource.h"
 #include <chrono>
+#include <cstring>
 #include <experimental/filesystem>
 #include <iostream>
 #include <zlib.h>
@@ -21,6 +23,10 @@ using namespace std::chrono;
 
 using experimental::filesystem::path;
 
+const u_int64_t Extractor::OUTPUT_BUFFER_SIZE = 4 * 1024 * 1024;
+
+const uint Extractor::MAXIMUM_ENTRIES_FOR_END_OFFSET = 32;
+
 Extractor::Extractor(const shared_ptr<Source> &sourceFile,
                      const shared_ptr<Source> &indexFile,
                      const shared_ptr<Sink> &resultSink,
@@ -44,7 +50,7 @@ bool Extractor::fulfillsPremises() {
         return false;
     }
 
-    if (mode == ExtractMode::segment && start >= count) {
+    if ((mode == ExtractMode::segment || mode == ExtractMode::alignedSegment) && start >= count) {
         addErrorMessage("Segment number '", to_string(start + 1), "' exceeds the segment count of '",
                         to_string(count), "'.");
         return false;
@@ -86,78 +92,128 @@ void Extractor::calculateStartingLineAndLineCount() {
         if (start == count - 1) { // Last segment
             lineCount = recordsInLastSegment * recordSize;
         }
+    } else if (mode == ExtractMode::alignedSegment) {
+        calculateIndexAlignedStartingLineAndLineCount();
     }
 }
 
+void Extractor::calculateIndexAlignedStartingLineAndLineCount() {
+    // Read the first entry before anything else, this will also open the index and read its header, if necessary.
+    auto entry = indexReader->readIndexEntry();
+    int64_t entryNumber = 0;
+    usedIndexEntry = entry;
+    usedIndexEntryNumber = 0;
+
+    u_int64_t totalLines = indexReader->getIndexHeader().linesInIndexedFile;
+    u_int64_t totalRecords = totalLines / recordSize;
+
+    // The boundaries of the segment, if all segments were of equal size.
+    u_int64_t idealStart = (totalRecords * start / count) * recordSize;
+    u_int64_t idealEnd = (totalRecords * (start + 1) / count) * recordSize;
+
+    auto roundUpToRecord = [&](u_int64_t line) -> u_int64_t {
+        return min(((line + recordSize - 1) / recordSize) * recordSize, totalLines);
+    };
+
+    // The candidates are sorted, so the nearest candidate is found, as soon as we pass the ideal boundary. On a tie,
+    // the lower candidate wins. The end boundary of a segment therefore always matches the start of the next one.
+    auto snap = [](u_int64_t candidate, u_int64_t ideal, u_int64_t &boundary, bool &settled) -> bool {
+        if (settled) return false;
+        if (candidate <= ideal) {
+            boundary = candidate;
+            return true;
+        }
+        settled = true;
+        if (candidate - ideal < ideal - boundary) {
+            boundary = candidate;
+            return true;
+        }
+        return false;
+    };
+
+    u_int64_t startBoundary = roundUpToRecord(entry->startingLineInEntry);
+    u_int64_t endBoundary = startBoundary;
+    bool startSettled = false;
+    // The last segment always ends with the file.
+    bool endSettled = start == count - 1;
+    if (endSettled)
+        endBoundary = totalLines;
+
+    while (!(startSettled && endSettled) && indexReader->getIndicesLeft() > 0) {
+        entry = indexReader->readIndexEntry();
+        entryNumber++;
+        u_int64_t candidate = roundUpToRecord(entry->startingLineInEntry);
+        if (snap(candidate, idealStart, startBoundary, startSettled)) {
+            usedIndexEntry = entry;
+            usedIndexEntryNumber = entryNumber;
+        }
+        snap(candidate, idealEnd, endBoundary, endSettled);
+    }
+
+    // The end of the file is a valid boundary as well. A start boundary placed there results in an empty segment, which
+    // only happens, if there are more segments than index entries.
+    snap(totalLines, idealStart, startBoundary, startSettled);
+    snap(totalLines, idealEnd, endBoundary, endSettled);
+
+    startingLine = startBoundary;
+    lineCount = endBoundary > startBoundary ? endBoundary - startBoundary : 0;
+    findExtractionEndOffset(entry);
+}
+
 void Extractor::findIndexEntryForExtraction() {
     shared_ptr<IndexEntry> previousEntry = indexReader->readIndexEntry();
     shared_ptr<IndexEntry> latestIndexEntry = previousEntry;
+    shared_ptr<IndexEntry> entryAfterStart;
 
     int64_t latestIndexEntryNumber = 0;
     while (indexReader->getIndicesLeft() > 0) {
         auto entry = indexReader->readIndexEntry();
         latestIndexEntryNumber++;
         if (entry->startingLineInEntry > startingLine) {
+            entryAfterStart = entry;
             break;
         }
         latestIndexEntry = entry;
     }
     this->usedIndexEntry = latestIndexEntry;
     this->usedIndexEntryNumber = latestIndexEntryNumber;
+
+    findExtractionEndOffset(entryAfterStart);
+}
+
+void Extractor::findExtractionEndOffset(shared_ptr<IndexEntry> entry) {
+    // The last line may continue in the block of the first entry behind the extracted lines, so the end is the entry
+    // after that one.
+    u_int64_t endLine = startingLine + lineCount;
+    if (endLine < startingLine)
+        endLine = UINT64_MAX;
+    bool passedEndLine = false;
+    for (uint i = 0; entry && i < MAXIMUM_ENTRIES_FOR_END_OFFSET; i++) {
+        // Even if the end is not found, the data up to the latest entry is needed for sure. The source extends the
+        // range on its own, if this is not enough.
+        extractionEndOffset = entry->blockOffsetInRawFile;
+        if (passedEndLine)
+            return;
+        passedEndLine = entry->startingLineInEntry > endLine;
+        entry = indexReader->getIndicesLeft() > 0 ? indexReader->readIndexEntry() : nullptr;
+    }
+    // The extraction ends with the file.
+    if (!entry)
+        extractionEndOffset = -1;
 }
 
 bool Extractor::openFastqAndPrepareZStream() {
     sourceFile->open();
     off_t initialOffset = usedIndexEntry->blockOffsetInRawFile;
-    totalBytesIn += initialOffset;
-    int startBits = usedIndexEntry->bits;
-    if (startBits > 0)
+    if (usedIndexEntry->bits > 0)
         initialOffset--;
     sourceFile->setReadStart(initialOffset); // This is for S3. Could be integrated into seek. Dont' know yet.
-    auto seekResult = sourceFile->seek(initialOffset, true);
-    if (seekResult == -1) {
-        addErrorMessage("Could not jump to position '", to_string(initialOffset),
-                        "' in file '", sourceFile->toString(), "'");
-        return false;
-    }
-
-    if (startBits > 0) {
-        int ret = sourceFile->readChar();
-        totalBytesIn++;
-        if (ret == -1) {
-            ret = sourceFile->lastError() ? Z_ERRNO : Z_DATA_ERROR;
-            addErrorMessage("Could not read from source file '", sourceFile->toString(),
-                            "'. The latest zlib error code was '", to_string(ret), "'.");
-            return false;
-        }
-        // The following line will pop up a clang-tidy warning, but as Mark Adler does it, I don't want to change it.
-        zlibResult = inflatePrime(&zStream, startBits, ret >> (8 - startBits));
-        if (zlibResult != 0) {
-            addErrorMessage("Could not prime the zStream for extraction. zlib reported: '", zStream.msg, "'.");
-            return false;
-        }
-    }
-    return true;
+    sourceFile->adviseRange(initialOffset, extractionEndOffset > initialOffset ? extractionEndOffset - initialOffset : 0);
+    return seekAndPrimeZStreamForIndexEntry(usedIndexEntry);
 }
 
 bool Extractor::setDictionaryForZStream() {
-    if (usedIndexEntry->compressedDictionarySize > 0) {
-        // Decompress!
-        Bytef uncompressedDictionary[WINDOW_SIZE]{0};
-        uLongf destLen = WINDOW_SIZE;
-        uLong sourceLen = usedIndexEntry->compressedDictionarySize;
-        // Ignore result here as zlib will fail anyways upon inflateSetDictionary, if the step went wrong.
-        uncompress2(uncompressedDictionary, &destLen, usedIndexEntry->window, &sourceLen);
-        zlibResult = inflateSetDictionary(&zStream, uncompressedDictionary, WINDOW_SIZE);
-    } else {
-        zlibResult = inflateSetDictionary(&zStream, usedIndexEntry->window, WINDOW_SIZE);
-    }
-    if (zlibResult != 0) {
-        addErrorMessage("There was an error when trying to set to dictionary for decompression. zlib reported: '",
-                        zStream.msg, "'.");
-        return false;
-    }
-    return true;
+    return setDictionaryForIndexEntry(usedIndexEntry);
 }
 
 bool Extractor::extract() {
@@ -166,7 +222,9 @@ bool Extractor::extract() {
 
     calculateStartingLineAndLineCount();
 
-    findIndexEntryForExtraction();
+    // In alignedSegment mode, the index entry was already selected during the boundary calculation.
+    if (mode != ExtractMode::alignedSegment)
+        findIndexEntryForExtraction();
 
     if (!openFastqAndPrepareZStream() ||
         !setDictionaryForZStream()) {
@@ -174,10 +232,27 @@ bool Extractor::extract() {
         return false;
     }
 
-    IndexStatsRunner::printIndexEntryToConsole(usedIndexEntry, usedIndexEntryNumber, true);
+    if (!resultSink->openWithWriteLock()) {
+        addErrorMessage("Could not open the output '", resultSink->toString(), "' for writing.");
+        sourceFile->close();
+        return false;
+    }
+
+    if (printUsedIndexEntry)
+        IndexStatsRunner::printIndexEntryToConsole(usedIndexEntry, usedIndexEntryNumber, true);
+
+    if (!enableDebugging)
+        outputBuffer.reserve(OUTPUT_BUFFER_SIZE + CLEAN_WINDOW_SIZE);
 
     // The number of lines which will be skipped from the beginning of the referenced compressed block.
     skip = startingLine - usedIndexEntry->startingLineInEntry;
+    lineOffsetsMightBeTruncated = indexReader->getIndexHeader().indexWriterVersion == INDEX_WITH_LINE_ENTRIES;
+
+    // The line count can exceed the file, e.g. when everything after the starting line is requested.
+    int64_t linesInFile = indexReader->getIndexHeader().linesInIndexedFile;
+    int64_t expectedLines = linesInFile > 0 ? min<int64_t>(lineCount, max<int64_t>(linesInFile - startingLine, 0))
+                                            : lineCount;
+    RunStatistics::setProgressTotal(LINES_EXTRACTED, expectedLines);
 
     bool keepExtracting{false};
     bool finalAbort{false};
@@ -218,27 +293,39 @@ bool Extractor::extract() {
     // Free the file pointer and close the file.
     sourceFile->close();
 
-    resultSink->close();
+    flushOutputBuffer();
+
+    // Compressing sinks write out their remaining data upon close, so this can fail as well.
+    bool resultSinkWasClosed;
+    {
+        FQI_TRACE_SPAN("close sink");
+        ScopedRunTimer timer(TIME_IN_SINK_WRITES);
+        resultSinkWasClosed = resultSink->close();
+    }
 
     inflateEnd(&zStream);
 
     if (errorWasRaised)
         addErrorMessage(string("Last error message from zlib: ") + zStream.msg);
 
-    return !errorWasRaised;
+    return !errorWasRaised && resultSinkWasClosed;
 }
 
 bool Extractor::prepareForNextConcatenatedPartIfNecessary(bool finalAbort) {
     if (finalAbort) return false;
 
-    totalBytesIn += 8 + 10; // Plus 8 Byte (for what? they are missing...) and 10 Byte for the next header
+    if (currentStreamIsRawDeflateStream)
+        totalBytesIn += 8; // Skip the 8 Byte gzip trailer (CRC32 and ISIZE) of the finished stream.
+    currentStreamIsRawDeflateStream = false;
     int64_t streamEndPosition = totalBytesIn;
     sourceFile->seek(streamEndPosition, true);
 
     if (!sourceFile->canRead()) return false;
 
+    // Let zlib read the header of the next gzip stream. Headers can have different sizes, e.g. BGZF blocks use the
+    // extra field and have 18 instead of 10 Bytes. A new stream also does not need a dictionary.
     inflateEnd(&zStream);
-    if (!initializeZStreamForRawInflate()) {
+    if (!initializeZStreamForInflate()) {
         finishedSuccessful = false;
         return false;
     }
@@ -247,79 +334,93 @@ bool Extractor::prepareForNextConcatenatedPartIfNecessary(bool finalAbort) {
     memset(window, 0, WINDOW_SIZE);
     memset(input, 0, CHUNK_SIZE);
     zStream.avail_in = CHUNK_SIZE;
-    firstPass = true;
-
-    Bytef dict[WINDOW_SIZE]{0};
-    zlibResult = inflateSetDictionary(&zStream, dict, WINDOW_SIZE);
+    // Don't set firstPass here. The first line of the next stream is no broken line, which needs to be removed. It
+    // is either a fresh line or the continuation of incompleteLastLine.
+    firstPass = false;
 
     return true;
 }
 
-bool Extractor::processDecompressedChunkOfData(const string &str, const shared_ptr<IndexEntry> &startingIndexLine) {
+bool Extractor::processDecompressedChunkOfData(const string &chunk, const shared_ptr<IndexEntry> &startingIndexLine) {
     if (extractedLines >= lineCount)
         return false;
-    vector<string> splitLines = StringHelper::splitStr(str);
-    totalSplitCount += splitLines.size();
 
-    // In the case, that we invoke this method the first time, the index entry
-    bool removeIncompleteFirstLine = firstPass && startingIndexLine->offsetToNextLineStart > 0;
-    if (removeIncompleteFirstLine) splitLines.erase(splitLines.begin());
+    // The data in front of the first valid line of the index entry is skipped. For a record aware index, this can be
+    // several lines and also more than the first chunk.
+    if (firstPass) {
+        skipToFirstNewline = lineOffsetsMightBeTruncated && startingIndexLine->offsetToNextLineStart > 0;
+        bytesToSkipAtStart = lineOffsetsMightBeTruncated ? 0 : startingIndexLine->offsetToNextLineStart;
+    }
     firstPass = false;
-
-    // Strip away incomplete last line, store this line for the next block.
-    string curIncompleteLastLine;
-
-    char lastChar{0};
-    if (!str.empty())
-        lastChar = str[str.size() - 1];
-    if (lastChar != '\n') {
-        if (!splitLines.empty()) {
-            curIncompleteLastLine = splitLines[splitLines.size() - 1];
-            splitLines.pop_back();
-        }
-        totalSplitCount--;
+    u_int64_t skipped;
+    if (skipToFirstNewline) {
+        auto newline = static_cast<const char *>(memchr(chunk.data(), '\n', chunk.size()));
+        skipped = newline ? static_cast<u_int64_t>(newline - chunk.data()) + 1 : chunk.size();
+        skipToFirstNewline = newline == nullptr;
+    } else {
+        skipped = min<u_int64_t>(bytesToSkipAtStart, chunk.size());
+        bytesToSkipAtStart -= skipped;
     }
-
-    // Even if the split string fails, there could still be a newline in the string. Add this and continue.
-    if (splitLines.empty()) {
-        incompleteLastLine += curIncompleteLastLine;
+    if (skipped == chunk.size())
         return false;
-    }
-
-    bool result = true;
-    // Basically two cases, first case, we have enough data here and can output something, or we skip the whole chunk
-    if (skip >= splitLines.size()) {    // Ignore
-        result = false;
-    } else {                            // Output
-        int64_t iStart = skip;
-        if (iStart == 0) { // We start right away, also use incompleteLastLine.
-            storeOrOutputLine(incompleteLastLine + splitLines[0]);
-            extractedLines++;
-            iStart = 1;
-        }
-        // iStart is 0 or 1
-        for (u_int64_t i = iStart; i < splitLines.size() && extractedLines < lineCount; ++i) {
-            storeOrOutputLine(splitLines[i]);
-            extractedLines++;
+    const char *current = chunk.data() + skipped;
+    const char *chunkEnd = chunk.data() + chunk.size();
+    u_int64_t extractedLinesBefore = extractedLines;
+    {
+        ScopedRunTimer timer(TIME_IN_LINE_SCANNING);
+        while (current < chunkEnd && extractedLines < lineCount) {
+            auto newline = static_cast<const char *>(memchr(current, '\n', static_cast<size_t>(chunkEnd - current)));
+            if (!newline)
+                break;
+            totalSplitCount++;
+            if (skip > 0) {
+                skip--;
+                incompleteLastLine.clear();
+            } else {
+                storeOrOutputLine(current, static_cast<u_int64_t>(newline - current));
+                extractedLines++;
+            }
+            current = newline + 1;
         }
+        // Strip away incomplete last line, store this line for the next block.
+        if (extractedLines < lineCount)
+            incompleteLastLine.append(current, static_cast<size_t>(chunkEnd - current));
     }
-    incompleteLastLine = curIncompleteLastLine;
-    if (skip > 0) skip -= min(splitLines.size(), skip);
+    if (outputBuffer.size() >= OUTPUT_BUFFER_SIZE)
+        flushOutputBuffer();
+    RunStatistics::count(LINES_EXTRACTED, extractedLines - extractedLinesBefore);
 
-    return result;
+    return extractedLines > extractedLinesBefore;
 }
 
-void Extractor::storeOrOutputLine(const string &line) {
+void Extractor::storeOrOutputLine(const char *line, u_int64_t length) {
     // For later! Roundtrip buffers could be an easy option to recognize if an empty line was forgotten.
     //    roundtripBufferPosition = extractedLines % recordSize;
     //    roundtripBuffer[roundtripBufferPosition] = line;
 
-    if (enableDebugging)
-        storedLines.emplace_back(line);
-    else {
-        resultSink->write(line);
-        resultSink->write("\n");
+    // A line, which started in the previous chunk, is completed with the data in front of the newline.
+    if (enableDebugging) {
+        storedLines.emplace_back(incompleteLastLine);
+        storedLines.back().append(line, length);
+    } else {
+        outputBuffer.append(incompleteLastLine);
+        outputBuffer.append(line, length);
+        outputBuffer.push_back('\n');
+    }
+    incompleteLastLine.clear();
+}
+
+void Extractor::flushOutputBuffer() {
+    if (outputBuffer.empty())
+        return;
+    struct iovec span{const_cast<char *>(outputBuffer.data()), outputBuffer.size()};
+    {
+        FQI_TRACE_SPAN("flush output");
+        ScopedRunTimer timer(TIME_IN_SINK_WRITES);
+        resultSink->writeSpans(&span, 1);
     }
+    RunStatistics::count(BYTES_WRITTEN, static_cast<int64_t>(outputBuffer.size()));
+    outputBuffer.clear();
 }
 
 void Extractor::storeLinesOfCurrentBlockForDebugMode() {
@@ -21,10 +21,15 @@ using experimental::filesystem::path;
 /**
  * Extraction can be either done on a per line / record base (starting record, number of records) or segement wise
  * (selected segment, number of segments).
+ *
+ * alignedSegment is a variant of segment, where the segment boundaries are moved to the nearest index entry. Segments
+ * might then differ slightly in size but each extraction starts right at the beginning of an index entry and does not
+ * need to decompress and discard data before its first line.
  */
 enum ExtractMode {
     lines,
-    segment
+    segment,
+    alignedSegment
 };
 
 class Extractor : public ZLibBasedFASTQProcessorBaseClass {
@@ -86,6 +91,24 @@ private:
      */
     int64_t usedIndexEntryNumber{0};
 
+    /**
+     * An offset in the compressed file behind the extracted data or -1, if the extraction ends with the file. Only used
+     * as a hint for the source, so it can stop reading ahead. For S3 this bounds the ranged requests.
+     * This value is set by findExtractionEndOffset()
+     */
+    int64_t extractionEndOffset{-1};
+
+    /**
+     * Limits the amount of index entries which are read to find extractionEndOffset.
+     */
+    static const uint MAXIMUM_ENTRIES_FOR_END_OFFSET;
+
+    /**
+     * The extraction starts with a raw deflate stream. zlib does not read the gzip trailer of such a stream, so we
+     * need to skip it ourselves. All following concatenated streams are inflated including their header and trailer.
+     */
+    bool currentStreamIsRawDeflateStream{true};
+
     /**
      * If a block starts with an offset, this can be used to complete the unfinished line of the last block (if necessary)
      */
@@ -93,6 +116,12 @@ private:
 
     string incompleteLastLine;
 
+    /**
+     * Extracted lines are collected here and passed to the result sink in large batches. This saves a lot of (virtual)
+     * calls and locking in the sinks.
+     */
+    string outputBuffer;
+
     u_int64_t extractedLines = 0;
 
     /**
@@ -100,6 +129,28 @@ private:
      */
     u_int64_t skip = 0;
 
+    /**
+     * The number of bytes in front of the first valid line of the used index entry, which still need to be skipped.
+     */
+    u_int64_t bytesToSkipAtStart = 0;
+
+    /**
+     * Set for indices of INDEX_WITH_LINE_ENTRIES. Their Indexer stored offsetToNextLineStart with 16 Bit, so the offset
+     * is wrong for lines of 64kB and more. Only the incomplete first line is dropped for these indices, the offset
+     * just tells, if there is one.
+     */
+    bool lineOffsetsMightBeTruncated = false;
+
+    /**
+     * Set, while the incomplete first line of a INDEX_WITH_LINE_ENTRIES index entry is dropped.
+     */
+    bool skipToFirstNewline = false;
+
+    /**
+     * Print the used index entry to cerr, before the extraction starts.
+     */
+    bool printUsedIndexEntry = true;
+
     /**
      * Keep track of all split lines. Merely for debugging
      */
@@ -119,6 +170,11 @@ private:
 
 public:
 
+    /**
+     * The output buffer is passed to the result sink, when it reaches this size.
+     */
+    static const u_int64_t OUTPUT_BUFFER_SIZE;
+
     /**
      * @param sourceFile         The file from which we will extract data
      * @param indexFile         The index file for this file
@@ -150,6 +206,10 @@ public:
 
     int64_t getLineCount() { return lineCount; }
 
+    shared_ptr<IndexEntry> getUsedIndexEntry() { return usedIndexEntry; }
+
+    int64_t getExtractionEndOffset() { return extractionEndOffset; }
+
     /**
      * Will call tryOpenAndReadHeader on the internal indexReader.
      */
@@ -173,18 +233,44 @@ public:
         this->firstPass = firstPass;
     }
 
+    /**
+     * Turn this off for extractions, which are part of another mode, like the spot checks of the Verifier.
+     */
+    void setPrintUsedIndexEntry(bool value) {
+        this->printUsedIndexEntry = value;
+    }
+
     /**
      * Calculates the starting line and the line count based on the start, count and mode settings.
      */
     void calculateStartingLineAndLineCount();
 
+    /**
+     * Used for alignedSegment mode by calculateStartingLineAndLineCount(). Each segment boundary is moved to the
+     * starting line of the index entry, which is closest to the boundary of the equally sized segment. The starting
+     * lines of the index entries are rounded up to full records first. As both boundaries of a segment are calculated
+     * in the same way, neighbouring segments will always fit together.
+     *
+     * The method reads the index entries up to the end boundary of the segment and therefore also fills the variables
+     * usedIndexEntry and usedIndexEntryNumber. findIndexEntryForExtraction() must not be called afterwards.
+     */
+    void calculateIndexAlignedStartingLineAndLineCount();
+
     /**
      * Find the index entry in the index file, which is closest to the starting line. Fills the variables:
      * - usedIndexEntry
      * - usedIndexEntryNumber
+     * - extractionEndOffset
      */
     void findIndexEntryForExtraction();
 
+    /**
+     * Reads on from the given index entry to find the offset of the compressed data behind the last extracted line
+     * and stores it in extractionEndOffset. If the end is too far away, the offset of the last inspected entry is
+     * used. It is a lower bound then, which the source will extend.
+     */
+    void findExtractionEndOffset(shared_ptr<IndexEntry> entry);
+
     /**
      * Open the FASTQ file and prepare initially prepare the zStream.
      * If the method fails, sourceFile will not be closed automatically.
@@ -211,15 +297,23 @@ public:
      * Will reset the firstPass variable, if called for the first time.
      *
      * @param out The stream to put the data to
-     * @param str The string of decompressed chunk data
+     * @param chunk The string of decompressed chunk data
      * @param startingIndexLine The index entry which was used to step into the gzip file.
      * @return true, if something was written out or false otherwise.
      */
-    bool processDecompressedChunkOfData(const string &str, const shared_ptr<IndexEntry> &startingIndexLine);
+    bool processDecompressedChunkOfData(const string &chunk, const shared_ptr<IndexEntry> &startingIndexLine);
 
     bool prepareForNextConcatenatedPartIfNecessary(bool finalAbort);
 
-    void storeOrOutputLine(const string &line);
+    /**
+     * Stores or outputs the line, which ends in front of line + length. Prepends and clears incompleteLastLine.
+     */
+    void storeOrOutputLine(const char *line, u_int64_t length);
+
+    /**
+     * Passes all lines in the output buffer to the result sink.
+     */
+    void flushOutputBuffer();
 
     void storeLinesOfCurrentBlockForDebugMode();
 
@@ -9,6 +9,7 @@
 #include "process/io/Source.h"
 #include <experimental/filesystem>
 #include <fstream>
+#include <zlib.h>
 
 using namespace std;
 using std::experimental::filesystem::path;
@@ -31,9 +32,9 @@ bool IndexReader::tryOpenAndReadHeader() {
         addErrorMessage("Index file '", indexFile->toString(), "' does not exist.");
         return false;
     }
-    bool gotLock = indexFile->openWithReadLock();
-    if (!gotLock) {
-        addErrorMessage("Could not get a lock for index file '", indexFile->toString(), "'.");
+    // Index files are published atomically by the IndexWriter, no lock is needed.
+    if (!indexFile->open()) {
+        addErrorMessage("Could not open index file '", indexFile->toString(), "'.");
         return false;
     }
 
@@ -58,12 +59,28 @@ bool IndexReader::tryOpenAndReadHeader() {
 
     this->readIndexHeader();
 
+    if (this->readHeader.hasTrailer) {
+        if (!readIndexTrailer(fileSize)) {
+            indexFile->close();
+            return false;
+        }
+        fileSize -= sizeof(IndexTrailer);
+    } else if (this->readHeader.completion == INDEX_IS_INCOMPLETE) {
+        addErrorMessage("Index file '", indexFile->toString(),
+                        "' is incomplete. Either it is still written or its creation failed.");
+        indexFile->close();
+        return false;
+    }
+
     /**
      * Which IndexReader / IndexEntry version must be used. Extract this from the header and go on.
      */
     uint sizeOfIndexEntry;
-    if (this->readHeader.indexWriterVersion == 1) {
+    if (this->readHeader.indexWriterVersion >= INDEX_WITH_LINE_ENTRIES &&
+        this->readHeader.indexWriterVersion <= IndexWriter::INDEX_WRITER_VERSION) {
         sizeOfIndexEntry = sizeof(IndexEntryV1);
+        if (this->readHeader.entriesHaveUncompressedOffsets)
+            sizeOfIndexEntry += sizeof(u_int64_t);
     } else {
         addErrorMessage("Index version '", to_string(this->readHeader.indexWriterVersion),
                         "' is not readable with this version of FastqIndEx (The maximum is ", to_string(
@@ -117,9 +134,48 @@ bool IndexReader::tryOpenAndReadHeader() {
     return readerIsOpen;
 }
 
+bool IndexReader::readIndexTrailer(int64_t fileSize) {
+    auto trailerSize = static_cast<int64_t>(sizeof(IndexTrailer));
+    if (fileSize < static_cast<int64_t>(sizeof(IndexHeader)) + trailerSize) {
+        addErrorMessage("Index file '", indexFile->toString(), "' is incomplete, its trailer is missing.");
+        return false;
+    }
+
+    if (indexFile->readAt(fileSize - trailerSize, reinterpret_cast<Bytef *>(&readTrailer), trailerSize) != trailerSize) {
+        addErrorMessage("Could not read the trailer of index file '", indexFile->toString(),
+                        "'. The index was written to a stream and needs to be stored in a file or in S3 before use.");
+        return false;
+    }
+
+    if (readTrailer.magicNumber != TRAILER_MAGIC_NUMBER) {
+        addErrorMessage("Index file '", indexFile->toString(), "' is incomplete, its trailer is missing.");
+        return false;
+    }
+
+    this->readHeader.numberOfEntries = readTrailer.numberOfEntries;
+    this->readHeader.linesInIndexedFile = readTrailer.linesInIndexedFile;
+    return true;
+}
+
+int64_t IndexReader::readAndChecksum(Bytef *targetBuffer, int64_t length) {
+    int64_t result = indexFile->read(targetBuffer, static_cast<int>(length));
+    if (result > 0)
+        checksum = crc32(checksum, targetBuffer, static_cast<uInt>(result));
+    return result;
+}
+
+void IndexReader::verifyChecksum() {
+    checksum = crc32(checksum, reinterpret_cast<const Bytef *>(&readTrailer),
+                     sizeof(IndexTrailer) - sizeof(readTrailer.checksum));
+    checksumIsValid = checksum == readTrailer.checksum;
+    if (!checksumIsValid)
+        addErrorMessage("The checksum of index file '", indexFile->toString(), "' does not match, the file is damaged.");
+}
+
 IndexHeader IndexReader::readIndexHeader() {
     IndexHeader header;
-    indexFile->read(reinterpret_cast<Bytef *>(&header), sizeof(IndexHeader));
+    checksum = crc32(0L, Z_NULL, 0);
+    readAndChecksum(reinterpret_cast<Bytef *>(&header), sizeof(IndexHeader));
 
     this->readHeader = header;
     headerWasRead = true;
@@ -134,13 +190,14 @@ vector<shared_ptr<IndexEntry>> IndexReader::readIndexFile() {
         return convertedLines;
     }
 
-    // Read in and convert a specific header version to an IndexEntry vector
-    if (this->readHeader.indexWriterVersion == 1) {
-        auto entries = readIndexFileV1();
-        for (auto const &entry : entries) {
-            convertedLines.emplace_back(entry->toIndexEntry());
-        }
-    } // We do not need an else branch, a version range check is applied earlier.
+    // Read in and convert a specific header version to an IndexEntry vector. readIndexEntry() also takes over the
+    // uncompressed offsets, which are not part of IndexEntryV1.
+    while (indicesLeft > 0) {
+        auto entry = readIndexEntry();
+        if (!entry)
+            break;
+        convertedLines.emplace_back(entry);
+    }
 
     return convertedLines;
 }
@@ -165,8 +222,14 @@ shared_ptr<IndexEntry> IndexReader::readIndexEntry() {
     }
 
     // Read in and convert a specific header version to an IndexEntry vector
-    if (this->readHeader.indexWriterVersion == 1) {
-        return readIndexEntryV1()->toIndexEntry();
+    if (this->readHeader.indexWriterVersion <= IndexWriter::INDEX_WRITER_VERSION) {
+        int64_t offsetInUncompressedData{-1};
+        auto entryV1 = readIndexEntryV1(&offsetInUncompressedData);
+        if (!entryV1)
+            return shared_ptr<IndexEntry>(nullptr);
+        auto entry = entryV1->toIndexEntry();
+        entry->offsetInUncompressedData = offsetInUncompressedData;
+        return entry;
     } // We do not need an else branch, a version range check is applied earlier.
 
     // To avoid clang-tidy from complaining, we return an empty shared_ptr. And we also add an error message just to be
@@ -175,7 +238,7 @@ shared_ptr<IndexEntry> IndexReader::readIndexEntry() {
     return shared_ptr<IndexEntry>(nullptr);
 }
 
-shared_ptr<IndexEntryV1> IndexReader::readIndexEntryV1() {
+shared_ptr<IndexEntryV1> IndexReader::readIndexEntryV1(int64_t *offsetInUncompressedData) {
     if (!readerIsOpen) {
         addErrorMessage("BUG: You have to open the IndexReader instance first with tryOpenAndReadHeader()");
         return shared_ptr<IndexEntryV1>(nullptr);
@@ -189,15 +252,24 @@ shared_ptr<IndexEntryV1> IndexReader::readIndexEntryV1() {
 
     auto entry = make_shared<IndexEntryV1>();
     int headerSize = sizeof(IndexEntryV1) - sizeof(entry->dictionary);
-    indexFile->read(reinterpret_cast<Bytef *>(entry.get()), headerSize);
+    readAndChecksum(reinterpret_cast<Bytef *>(entry.get()), headerSize);
+    if (readHeader.entriesHaveUncompressedOffsets) {
+        u_int64_t offset{0};
+        readAndChecksum(reinterpret_cast<Bytef *>(&offset), sizeof(offset));
+        if (offsetInUncompressedData)
+            *offsetInUncompressedData = static_cast<int64_t>(offset);
+    }
     if (entry->compressedDictionarySize == 0) { // No compression
-        indexFile->read(reinterpret_cast<Bytef *>(entry.get()) + headerSize, sizeof(entry->dictionary));
+        readAndChecksum(reinterpret_cast<Bytef *>(entry.get()) + headerSize, sizeof(entry->dictionary));
     } else {
         // Set the dictionary to 0 first, so we won't have any issues with memory garbage.
         memset(reinterpret_cast<char *>(entry->dictionary), 0, WINDOW_SIZE);
-        indexFile->read(reinterpret_cast<Bytef *>(entry.get()) + headerSize, entry->compressedDictionarySize);
+        readAndChecksum(reinterpret_cast<Bytef *>(entry.get()) + headerSize, entry->compressedDictionarySize);
     }
     indicesLeft--;
 
+    if (indicesLeft == 0 && readHeader.hasTrailer)
+        verifyChecksum();
+
     return entry;
 }
\ No newline at end of file
@@ -46,12 +46,37 @@ private:
     int64_t indicesLeft{0};
 
     int64_t indicesCount{0};
+
+    bool checksumIsValid{false};
     /**
      * Putting this into a smart pointer always raised: "Assertion `px != 0' failed" during object construction. I do
      * not know, why this happened, but I do a workaround by not using a smart pointer (or any pointer).
      */
     IndexHeader readHeader;
 
+    /**
+     * Only used, if readHeader.hasTrailer is set.
+     */
+    IndexTrailer readTrailer;
+
+    /**
+     * CRC32 of the data read so far. It is compared to the trailer checksum, after the last entry was read.
+     */
+    uLong checksum{0};
+
+    /**
+     * Reads the data and adds it to the checksum.
+     */
+    int64_t readAndChecksum(Bytef *targetBuffer, int64_t length);
+
+    /**
+     * Reads the IndexTrailer from the end of the file and copies its counts to readHeader. This needs a source which
+     * supports readAt(), the trailer cannot be reached in a pipe.
+     */
+    bool readIndexTrailer(int64_t fileSize);
+
+    void verifyChecksum();
+
     /**
      * Reads the header (and stores it internally in readHeader). If the header was already read, the existing entry
      * will be returned. Not available for public use, automatically read in tryOpen...
@@ -98,9 +123,10 @@ public:
      * In Java programs, I'd go for more generics or polymorphism. But this is a bit trickier in C++, so for now, we'll
      * stick to several readIndexEntryV[n] methods, assuming, that we will not change the index format to often. If so
      * we could also implement subclasses of IndexReader later.
+     * @param offsetInUncompressedData Receives the uncompressed offset of the entry, if the index stores it.
      * @return
      */
-    shared_ptr<IndexEntryV1> readIndexEntryV1();
+    shared_ptr<IndexEntryV1> readIndexEntryV1(int64_t *offsetInUncompressedData = nullptr);
 
     // Example for further versions.
     // shared_ptr<IndexEntryV1> readIndexEntryV2();
@@ -110,6 +136,11 @@ public:
 
     int64_t getIndicesLeft() { return indicesLeft; }
 
+    /**
+     * Set, after the last entry of an index with a trailer was read and the checksum matched.
+     */
+    bool checksumWasVerified() { return checksumIsValid; }
+
 };
 
 
@@ -0,0 +1,329 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#include "ReadNameExtractor.h"
+#include "common/RunStatistics.h"
+#include "common/Tracer.h"
+#include "process/index/FastqRecordScanner.h"
+#include "Extractor.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+const uint ReadNameExtractor::MAXIMUM_REPORTED_MISSING_NAMES = 20;
+
+ReadNameExtractor::ReadNameExtractor(const shared_ptr<Source> &sourceFile,
+                                     const shared_ptr<Source> &indexFile,
+                                     const shared_ptr<Source> &readNameIndexFile,
+                                     const shared_ptr<Source> &namesFile,
+                                     const shared_ptr<Sink> &resultSink,
+                                     bool enableDebugging) :
+        ZLibBasedFASTQProcessorBaseClass(sourceFile, indexFile, enableDebugging),
+        namesFile(namesFile),
+        resultSink(resultSink) {
+    indexReader = make_shared<IndexReader>(indexFile);
+    readNameIndexReader = make_shared<ReadNameIndexReader>(readNameIndexFile);
+}
+
+bool ReadNameExtractor::fulfillsPremises() {
+    if (!resultSink->fulfillsPremises() ||
+        !indexReader->tryOpenAndReadHeader() ||
+        !readNameIndexReader->tryOpenAndReadHeader())
+        return false;
+
+    // The read name index is only written along with a record aware index. If the index was written again without it,
+    // the read name index is left over from the previous run and its record numbers might not match the file anymore.
+    if (!indexReader->getIndexHeader().entriesStartWithRecords) {
+        addErrorMessage("The index file '", inputIndexFile->toString(), "' is not record aware, so the read name ",
+                        "index does not belong to it. Create both again with index --readNameIndex.");
+        return false;
+    }
+
+    // The read name index is written along with the index, so both need to know the same number of records.
+    auto records = static_cast<u_int64_t>(indexReader->getIndexHeader().linesInIndexedFile) /
+                   FastqRecordScanner::LINES_PER_RECORD;
+    if (readNameIndexReader->getNumberOfEntries() != records) {
+        addErrorMessage("The read name index contains ", to_string(readNameIndexReader->getNumberOfEntries()),
+                        " names, but the index knows ", to_string(records), " records. It does not belong to the index.");
+        return false;
+    }
+    return readRequestedNames();
+}
+
+bool ReadNameExtractor::readRequestedNames() {
+    if (!namesFile->open()) {
+        addErrorMessage("Could not open the file with the read names '", namesFile->toString(), "'.");
+        return false;
+    }
+    string names;
+    Bytef buffer[CHUNK_SIZE];
+    int64_t readBytes;
+    while ((readBytes = namesFile->read(buffer, CHUNK_SIZE)) > 0)
+        names.append(reinterpret_cast<const char *>(buffer), static_cast<size_t>(readBytes));
+    namesFile->close();
+
+    string::size_type lineStart = 0;
+    while (lineStart < names.size()) {
+        auto lineEnd = names.find('\n', lineStart);
+        if (lineEnd == string::npos)
+            lineEnd = names.size();
+        string name = ReadNameHash::readNameOf(names.substr(lineStart, lineEnd - lineStart));
+        if (!name.empty())
+            requestedNames.insert(name);
+        lineStart = lineEnd + 1;
+    }
+    if (requestedNames.empty()) {
+        addErrorMessage("The file '", namesFile->toString(), "' does not contain any read names.");
+        return false;
+    }
+    return true;
+}
+
+vector<ReadNameExtractor::RecordGroup> ReadNameExtractor::groupRecordsByIndexEntry(const vector<u_int64_t> &records) {
+    vector<RecordGroup> groups;
+    if (records.empty() || !indexReader->tryOpenAndReadHeader())
+        return groups;
+
+    auto addGroup = [&](const shared_ptr<IndexEntry> &entry, int64_t endOffset, size_t first, size_t last) {
+        if (first < last)
+            groups.push_back({entry, endOffset, vector<u_int64_t>(records.begin() + first, records.begin() + last)});
+    };
+
+    auto previousEntry = indexReader->readIndexEntry();
+    size_t record = 0;
+    while (record < records.size() && indexReader->getIndicesLeft() > 0) {
+        auto entry = indexReader->readIndexEntry();
+        size_t firstRecord = record;
+        while (record < records.size() &&
+               records[record] * FastqRecordScanner::LINES_PER_RECORD < entry->startingLineInEntry)
+            record++;
+        addGroup(previousEntry, entry->blockOffsetInRawFile, firstRecord, record);
+        previousEntry = entry;
+    }
+    addGroup(previousEntry, -1, record, records.size());
+    return groups;
+}
+
+bool ReadNameExtractor::extract() {
+    wasStarted = true;
+
+    vector<u_int64_t> hashes;
+    for (const auto &name : requestedNames)
+        hashes.push_back(ReadNameHash::of(name));
+    sort(hashes.begin(), hashes.end());
+    hashes.erase(unique(hashes.begin(), hashes.end()), hashes.end());
+
+    vector<u_int64_t> records;
+    for (const auto &entry : readNameIndexReader->findEntries(hashes))
+        records.push_back(entry.record);
+    sort(records.begin(), records.end());
+    records.erase(unique(records.begin(), records.end()), records.end());
+
+    auto groups = groupRecordsByIndexEntry(records);
+
+    if (!resultSink->openWithWriteLock()) {
+        addErrorMessage("Could not open the output '", resultSink->toString(), "' for writing.");
+        return false;
+    }
+
+    sourceFile->open();
+    bool successful = readNameIndexReader->getErrorMessages().empty() && indexReader->getErrorMessages().empty();
+    for (const auto &group : groups) {
+        if (!successful)
+            break;
+        successful = extractGroup(group);
+    }
+    sourceFile->close();
+
+    flushOutputBuffer();
+    bool resultSinkWasClosed;
+    {
+        ScopedRunTimer timer(TIME_IN_SINK_WRITES);
+        resultSinkWasClosed = resultSink->close();
+    }
+
+    cerr << "Extracted " << extractedRecords << " records for " << foundNames.size() << " of "
+         << requestedNames.size() << " read names from " << groups.size() << " index entries.\n";
+    // Missing names are always reported, but a long list would bury everything else.
+    auto missingNames = getMissingNames();
+    for (u_int64_t i = 0; i < missingNames.size() && i < MAXIMUM_REPORTED_MISSING_NAMES; i++)
+        always("The read name '", missingNames[i], "' was not found.");
+    if (missingNames.size() > MAXIMUM_REPORTED_MISSING_NAMES)
+        always("... and ", to_string(missingNames.size() - MAXIMUM_REPORTED_MISSING_NAMES),
+               " more read names were not found.");
+
+    finishedSuccessful = successful && resultSinkWasClosed;
+    return finishedSuccessful;
+}
+
+vector<string> ReadNameExtractor::getMissingNames() {
+    vector<string> missingNames;
+    for (const auto &name : requestedNames) {
+        if (foundNames.count(name) == 0)
+            missingNames.emplace_back(name);
+    }
+    sort(missingNames.begin(), missingNames.end());
+    return missingNames;
+}
+
+bool ReadNameExtractor::extractGroup(const RecordGroup &group) {
+    FQI_TRACE_SPAN("extract record group");
+    auto entry = group.entry;
+    totalBytesIn = 0;
+    currentStreamIsRawDeflateStream = true;
+    currentLine = entry->startingLineInEntry;
+    bytesToSkip = entry->offsetToNextLineStart;
+    nextRecord = 0;
+    currentRecord.clear();
+
+    if (!initializeZStreamForRawInflate())
+        return false;
+
+    off_t initialOffset = entry->blockOffsetInRawFile;
+    if (entry->bits > 0)
+        initialOffset--;
+    sourceFile->setReadStart(initialOffset);
+    sourceFile->adviseRange(initialOffset, group.endOffset > initialOffset ? group.endOffset - initialOffset : 0);
+
+    if (!seekAndPrimeZStreamForIndexEntry(entry) || !setDictionaryForIndexEntry(entry)) {
+        inflateEnd(&zStream);
+        return false;
+    }
+
+    while (nextRecord < group.records.size()) {
+        if (zStream.avail_in == 0) {
+            if (!sourceFile->canRead())
+                break;
+            if (!readCompressedDataFromSource()) {
+                errorWasRaised = true;
+                break;
+            }
+        }
+
+        resetSlidingWindowIfNecessary();
+        const Bytef *output = zStream.next_out;
+        int64_t availableInBeforeInflate = zStream.avail_in;
+        int64_t availableOutBeforeInflate = zStream.avail_out;
+        {
+            FQI_TRACE_SPAN("inflate");
+            ScopedRunTimer timer(TIME_IN_INFLATE);
+            zlibResult = inflate(&zStream, Z_NO_FLUSH);
+        }
+        int64_t readBytes = availableInBeforeInflate - zStream.avail_in;
+        int64_t writtenBytes = availableOutBeforeInflate - zStream.avail_out;
+        totalBytesIn += readBytes;
+        totalBytesOut += writtenBytes;
+        RunStatistics::count(COMPRESSED_BYTES_READ, readBytes);
+        RunStatistics::count(UNCOMPRESSED_BYTES_PRODUCED, writtenBytes);
+
+        if (zlibResult == Z_NEED_DICT || zlibResult == Z_DATA_ERROR || zlibResult == Z_MEM_ERROR) {
+            string message = join("The data in '", sourceFile->toString(), "' could not be decompressed at offset ",
+                                  to_string(totalBytesIn), ". zlib reported: '", zStream.msg ? zStream.msg : "", "'.");
+            addErrorMessage(message);
+            severe(message);
+            errorWasRaised = true;
+            break;
+        }
+
+        scanDecompressedData(reinterpret_cast<const char *>(output), static_cast<u_int64_t>(writtenBytes), group);
+
+        if (zlibResult == Z_STREAM_END && !prepareForNextConcatenatedPart())
+            break;
+    }
+
+    // The last record of the file does not need to end with a newline.
+    if (!errorWasRaised && nextRecord < group.records.size() && !currentRecord.empty() &&
+        currentLine == group.records[nextRecord] * FastqRecordScanner::LINES_PER_RECORD + 3) {
+        currentRecord.push_back('\n');
+        finishRecord();
+    }
+
+    inflateEnd(&zStream);
+    return !errorWasRaised;
+}
+
+bool ReadNameExtractor::prepareForNextConcatenatedPart() {
+    // Like for the Extractor, the next gzip stream starts directly after the trailer of the current one.
+    if (currentStreamIsRawDeflateStream)
+        totalBytesIn += 8;
+    currentStreamIsRawDeflateStream = false;
+
+    sourceFile->seek(totalBytesIn, true);
+    if (!sourceFile->canRead())
+        return false;
+
+    inflateEnd(&zStream);
+    if (!initializeZStreamForInflate()) {
+        errorWasRaised = true;
+        return false;
+    }
+    return true;
+}
+
+void ReadNameExtractor::scanDecompressedData(const char *data, u_int64_t length, const RecordGroup &group) {
+    ScopedRunTimer timer(TIME_IN_LINE_SCANNING);
+    u_int64_t skipped = min(bytesToSkip, length);
+    bytesToSkip -= skipped;
+    const char *position = data + skipped;
+    const char *end = data + length;
+    while (position < end && nextRecord < group.records.size()) {
+        u_int64_t firstLineOfRecord = group.records[nextRecord] * FastqRecordScanner::LINES_PER_RECORD;
+        auto newline = static_cast<const char *>(memchr(position, '\n', static_cast<size_t>(end - position)));
+        bool lineIsWanted = currentLine >= firstLineOfRecord;
+        if (lineIsWanted)
+            currentRecord.append(position, (newline ? newline : end) - position);
+        if (!newline)
+            break;
+        if (lineIsWanted) {
+            currentRecord.push_back('\n');
+            if (currentLine == firstLineOfRecord + FastqRecordScanner::LINES_PER_RECORD - 1)
+                finishRecord();
+        }
+        currentLine++;
+        position = newline + 1;
+    }
+}
+
+void ReadNameExtractor::finishRecord() {
+    nextRecord++;
+    string name = ReadNameHash::readNameOf(currentRecord.substr(0, currentRecord.find('\n')));
+    // Records with another name have the same hash as one of the requested names.
+    if (requestedNames.count(name) > 0) {
+        foundNames.insert(name);
+        extractedRecords++;
+        if (enableDebugging) {
+            string::size_type lineStart = 0;
+            while (lineStart < currentRecord.size()) {
+                auto lineEnd = currentRecord.find('\n', lineStart);
+                storedLines.emplace_back(currentRecord.substr(lineStart, lineEnd - lineStart));
+                lineStart = lineEnd + 1;
+            }
+        } else {
+            outputBuffer.append(currentRecord);
+            if (outputBuffer.size() >= Extractor::OUTPUT_BUFFER_SIZE)
+                flushOutputBuffer();
+        }
+    }
+    currentRecord.clear();
+}
+
+void ReadNameExtractor::flushOutputBuffer() {
+    if (outputBuffer.empty())
+        return;
+    {
+        ScopedRunTimer timer(TIME_IN_SINK_WRITES);
+        resultSink->write(outputBuffer);
+    }
+    RunStatistics::count(BYTES_WRITTEN, static_cast<int64_t>(outputBuffer.size()));
+    outputBuffer.clear();
+}
+
+vector<string> ReadNameExtractor::getErrorMessages() {
+    vector<string> a = ErrorAccumulator::getErrorMessages();
+    vector<string> b = concatenateVectors(indexReader->getErrorMessages(), readNameIndexReader->getErrorMessages());
+    vector<string> c = resultSink->getErrorMessages();
+    return concatenateVectors(a, b, c);
+}
@@ -0,0 +1,148 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#ifndef FASTQINDEX_READNAMEEXTRACTOR_H
+#define FASTQINDEX_READNAMEEXTRACTOR_H
+
+#include "common/CommonStructsAndConstants.h"
+#include "process/base/ZLibBasedFASTQProcessorBaseClass.h"
+#include "process/extract/IndexReader.h"
+#include "process/extract/ReadNameIndexReader.h"
+#include <unordered_set>
+
+using namespace std;
+
+/**
+ * Extracts the FASTQ records for a list of read names. The names are resolved to record numbers with the read name
+ * index, the records are grouped by the index entry they belong to and only the intervals starting at these entries
+ * are decompressed, up to the last wanted record of each group.
+ *
+ * The read name index only stores hashes, so the name of each decompressed record is compared with the requested
+ * names before it is written. The records are written in the order of the FASTQ file, not in the order of the names.
+ */
+class ReadNameExtractor : public ZLibBasedFASTQProcessorBaseClass {
+
+public:
+
+    /**
+     * The records which start in the interval of an index entry. The records are sorted.
+     */
+    struct RecordGroup {
+
+        shared_ptr<IndexEntry> entry;
+
+        /**
+         * The offset of the next index entry or -1. Only used as a hint for the source.
+         */
+        int64_t endOffset{-1};
+
+        vector<u_int64_t> records;
+    };
+
+private:
+
+    shared_ptr<IndexReader> indexReader;
+
+    shared_ptr<ReadNameIndexReader> readNameIndexReader;
+
+    /**
+     * A text file with one read name per line. A line can also be a complete FASTQ header line.
+     */
+    shared_ptr<Source> namesFile;
+
+    shared_ptr<Sink> resultSink;
+
+    unordered_set<string> requestedNames;
+
+    unordered_set<string> foundNames;
+
+    u_int64_t extractedRecords{0};
+
+    /**
+     * The next gzip stream after the end of the current one is inflated with its header, see Extractor.
+     */
+    bool currentStreamIsRawDeflateStream{true};
+
+    /**
+     * The number of the line, which is currently scanned.
+     */
+    u_int64_t currentLine{0};
+
+    /**
+     * The data in front of the first line of the used index entry.
+     */
+    u_int64_t bytesToSkip{0};
+
+    /**
+     * The position of the next wanted record in the records of the current group.
+     */
+    size_t nextRecord{0};
+
+    /**
+     * The lines of the currently scanned record, if it is wanted.
+     */
+    string currentRecord;
+
+    string outputBuffer;
+
+    bool readRequestedNames();
+
+    bool extractGroup(const RecordGroup &group);
+
+    bool prepareForNextConcatenatedPart();
+
+    void scanDecompressedData(const char *data, u_int64_t length, const RecordGroup &group);
+
+    void finishRecord();
+
+    void flushOutputBuffer();
+
+public:
+
+    /**
+     * At most this many read names, which were not found, are printed after an extraction.
+     */
+    static const uint MAXIMUM_REPORTED_MISSING_NAMES;
+
+    ReadNameExtractor(const shared_ptr<Source> &sourceFile,
+                      const shared_ptr<Source> &indexFile,
+                      const shared_ptr<Source> &readNameIndexFile,
+                      const shared_ptr<Source> &namesFile,
+                      const shared_ptr<Sink> &resultSink,
+                      bool enableDebugging = false);
+
+    shared_ptr<Sink> getResultSink() { return resultSink; }
+
+    /**
+     * Opens the index and the read name index and reads the requested names.
+     */
+    bool fulfillsPremises();
+
+    /**
+     * Assigns each record to the last index entry, which starts at or before the first line of the record. Only
+     * entries with records are returned.
+     * @param records The sorted record numbers.
+     */
+    vector<RecordGroup> groupRecordsByIndexEntry(const vector<u_int64_t> &records);
+
+    bool extract();
+
+    u_int64_t getNumberOfRequestedNames() { return requestedNames.size(); }
+
+    u_int64_t getNumberOfFoundNames() { return foundNames.size(); }
+
+    /**
+     * @return The requested read names, which were not found, in sorted order.
+     */
+    vector<string> getMissingNames();
+
+    u_int64_t getNumberOfExtractedRecords() { return extractedRecords; }
+
+    vector<string> getErrorMessages() override;
+};
+
+
+#endif //FASTQINDEX_READNAMEEXTRACTOR_H
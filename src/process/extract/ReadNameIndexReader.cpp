@@ -0,0 +1,103 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#include "ReadNameIndexReader.h"
+
+const u_int64_t ReadNameIndexReader::ENTRIES_PER_BLOCK = 4096;
+
+const u_int64_t ReadNameIndexReader::MAXIMUM_CACHED_BLOCKS = 256;
+
+ReadNameIndexReader::~ReadNameIndexReader() {
+    if (readerIsOpen)
+        nameIndexFile->close();
+}
+
+bool ReadNameIndexReader::tryOpenAndReadHeader() {
+    if (readerIsOpen)
+        return true;
+
+    if (!nameIndexFile->exists()) {
+        addErrorMessage("Read name index file '", nameIndexFile->toString(),
+                        "' does not exist. It is written by the index mode with --readNameIndex.");
+        return false;
+    }
+    if (!nameIndexFile->open()) {
+        addErrorMessage("Could not open read name index file '", nameIndexFile->toString(), "'.");
+        return false;
+    }
+    readerIsOpen = true;
+
+    auto headerSize = static_cast<int64_t>(sizeof(ReadNameIndexHeader));
+    if (nameIndexFile->readAt(0, reinterpret_cast<Bytef *>(&header), headerSize) != headerSize ||
+        header.magicNumber != READ_NAME_INDEX_MAGIC_NUMBER) {
+        addErrorMessage("The file '", nameIndexFile->toString(), "' is no read name index.");
+        return false;
+    }
+    if (header.version != 1) {
+        addErrorMessage("The read name index '", nameIndexFile->toString(), "' has the unknown version ",
+                        to_string(header.version), ".");
+        return false;
+    }
+    auto expectedSize = headerSize + static_cast<int64_t>(header.numberOfEntries * sizeof(ReadNameEntry));
+    if (nameIndexFile->size() != expectedSize) {
+        addErrorMessage("The read name index '", nameIndexFile->toString(), "' has ", to_string(nameIndexFile->size()),
+                        " instead of ", to_string(expectedSize), " Bytes.");
+        return false;
+    }
+    return true;
+}
+
+const ReadNameEntry *ReadNameIndexReader::getEntry(u_int64_t number) {
+    u_int64_t blockNumber = number / ENTRIES_PER_BLOCK;
+    auto block = cachedBlocks.find(blockNumber);
+    if (block == cachedBlocks.end()) {
+        if (cachedBlocks.size() >= MAXIMUM_CACHED_BLOCKS)
+            cachedBlocks.clear();
+        u_int64_t firstEntry = blockNumber * ENTRIES_PER_BLOCK;
+        vector<ReadNameEntry> entries(min(ENTRIES_PER_BLOCK, header.numberOfEntries - firstEntry));
+        auto offset = static_cast<int64_t>(sizeof(ReadNameIndexHeader) + firstEntry * sizeof(ReadNameEntry));
+        auto size = static_cast<int64_t>(entries.size() * sizeof(ReadNameEntry));
+        if (nameIndexFile->readAt(offset, reinterpret_cast<Bytef *>(entries.data()), size) != size) {
+            addErrorMessage("Could not read the entries #", to_string(firstEntry), " to #",
+                            to_string(firstEntry + entries.size() - 1), " of the read name index '",
+                            nameIndexFile->toString(), "'.");
+            return nullptr;
+        }
+        block = cachedBlocks.emplace(blockNumber, move(entries)).first;
+    }
+    return &block->second[number - block->first * ENTRIES_PER_BLOCK];
+}
+
+vector<ReadNameEntry> ReadNameIndexReader::findEntries(const vector<u_int64_t> &hashes) {
+    vector<ReadNameEntry> result;
+    if (!tryOpenAndReadHeader())
+        return result;
+
+    // The hashes are sorted, so each search can start behind the entries of the previous hash.
+    u_int64_t low = 0;
+    for (u_int64_t hash : hashes) {
+        u_int64_t high = header.numberOfEntries;
+        while (low < high) {
+            u_int64_t middle = low + (high - low) / 2;
+            auto entry = getEntry(middle);
+            if (!entry)
+                return result;
+            if (entry->hash < hash)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        for (; low < header.numberOfEntries; low++) {
+            auto entry = getEntry(low);
+            if (!entry)
+                return result;
+            if (entry->hash != hash)
+                break;
+            result.push_back(*entry);
+        }
+    }
+    return result;
+}
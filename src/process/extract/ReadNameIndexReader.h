@@ -0,0 +1,70 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#ifndef FASTQINDEX_READNAMEINDEXREADER_H
+#define FASTQINDEX_READNAMEINDEXREADER_H
+
+#include "common/ErrorAccumulator.h"
+#include "process/base/ReadNameIndex.h"
+#include "process/io/Source.h"
+#include <map>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Looks up read name hashes in a read name index, see ReadNameIndexHeader. The entries are not loaded completely, each
+ * lookup is a binary search over blocks of entries. The blocks are read with one readAt() call and kept for the next
+ * lookups, so a search in an index in S3 needs a few requests instead of one request per probe.
+ */
+class ReadNameIndexReader : public ErrorAccumulator {
+
+private:
+
+    shared_ptr<Source> nameIndexFile;
+
+    ReadNameIndexHeader header;
+
+    bool readerIsOpen{false};
+
+    map<u_int64_t, vector<ReadNameEntry>> cachedBlocks;
+
+    /**
+     * Reads the block of the entry, if it is not cached yet.
+     * @return The entry or nullptr, if its block could not be read.
+     */
+    const ReadNameEntry *getEntry(u_int64_t number);
+
+public:
+
+    /**
+     * 64kB per block.
+     */
+    static const u_int64_t ENTRIES_PER_BLOCK;
+
+    /**
+     * The cache is cleared, when it exceeds this many blocks (16MB).
+     */
+    static const u_int64_t MAXIMUM_CACHED_BLOCKS;
+
+    explicit ReadNameIndexReader(const shared_ptr<Source> &nameIndexFile) : nameIndexFile(nameIndexFile) {}
+
+    ~ReadNameIndexReader() override;
+
+    bool tryOpenAndReadHeader();
+
+    u_int64_t getNumberOfEntries() { return header.numberOfEntries; }
+
+    /**
+     * Finds all entries for the given hashes. Names with the same hash result in several entries.
+     * @param hashes The hashes, which need to be sorted.
+     * @return The found entries, sorted by hash and record.
+     */
+    vector<ReadNameEntry> findEntries(const vector<u_int64_t> &hashes);
+};
+
+
+#endif //FASTQINDEX_READNAMEINDEXREADER_H
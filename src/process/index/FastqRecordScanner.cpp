@@ -0,0 +1,109 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#include "FastqRecordScanner.h"
+#include <cstring>
+
+const uint FastqRecordScanner::LINES_PER_RECORD = 4;
+
+bool FastqRecordScanner::scan(const char *data,
+                              u_int64_t length,
+                              int64_t *firstRecordStart,
+                              u_int64_t *lineOfFirstRecordStart) {
+    *firstRecordStart = -1;
+    if (malformed)
+        return false;
+
+    const char *position = data;
+    const char *end = data + length;
+    while (position < end) {
+        const char *lineData = position;
+        if (atLineStart) {
+            if (*firstRecordStart < 0 && lines % LINES_PER_RECORD == 0) {
+                *firstRecordStart = position - data;
+                *lineOfFirstRecordStart = lines;
+            }
+            firstCharacterOfLine = static_cast<unsigned char>(*position);
+            lengthOfLine = 0;
+            atLineStart = false;
+            if (firstCharacterOfLine == '@')
+                lineData++;
+        }
+        auto newline = static_cast<const char *>(memchr(position, '\n', static_cast<size_t>(end - position)));
+        if (collectReadNames && lines % LINES_PER_RECORD == 0)
+            addToReadName(lineData, newline ? newline : end);
+        if (!newline) {
+            lengthOfLine += end - position;
+            break;
+        }
+        lengthOfLine += newline - position;
+        if (!finishLine())
+            return false;
+        position = newline + 1;
+    }
+    return true;
+}
+
+bool FastqRecordScanner::finish() {
+    if (malformed)
+        return false;
+    if (!atLineStart && !finishLine())
+        return false;
+    if (lines % LINES_PER_RECORD != 0)
+        return reportMalformedRecord("The data ends in the middle of record #" + to_string(getRecords()) + ".");
+    return true;
+}
+
+void FastqRecordScanner::addToReadName(const char *begin, const char *end) {
+    if (readNameIsComplete)
+        return;
+    const char *position = begin;
+    while (position < end && !ReadNameHash::isSeparator(*position))
+        position++;
+    readNameHash.add(begin, static_cast<u_int64_t>(position - begin));
+    readNameIsComplete = position < end;
+}
+
+bool FastqRecordScanner::finishLine() {
+    u_int64_t record = getRecords();
+    switch (lines % LINES_PER_RECORD) {
+        case 0:
+            if (firstCharacterOfLine != '@')
+                return reportMalformedRecord("The header line #" + to_string(lines) + " of record #" +
+                                             to_string(record) + " does not start with '@'.");
+            if (collectReadNames) {
+                readNames.push_back({readNameHash.value, record});
+                readNameHash = ReadNameHash();
+                readNameIsComplete = false;
+            }
+            break;
+        case 1:
+            lengthOfSequence = lengthOfLine;
+            break;
+        case 2:
+            if (firstCharacterOfLine != '+')
+                return reportMalformedRecord("The separator line #" + to_string(lines) + " of record #" +
+                                             to_string(record) + " does not start with '+'.");
+            break;
+        default:
+            if (lengthOfLine != lengthOfSequence)
+                return reportMalformedRecord("The quality string of record #" + to_string(record) + " has " +
+                                             to_string(lengthOfLine) + " characters, but the sequence has " +
+                                             to_string(lengthOfSequence) + ".");
+    }
+    lines++;
+    atLineStart = true;
+    return true;
+}
+
+bool FastqRecordScanner::reportMalformedRecord(const string &problem) {
+    malformed = true;
+    // The runners don't print error messages after a run, so the problem is also printed directly.
+    string message = "The FASTQ data is malformed. " + problem;
+    addErrorMessage(message);
+    severe(message);
+    return false;
+}
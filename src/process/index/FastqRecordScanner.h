@@ -0,0 +1,101 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#ifndef FASTQINDEX_FASTQRECORDSCANNER_H
+#define FASTQINDEX_FASTQRECORDSCANNER_H
+
+#include "common/ErrorAccumulator.h"
+#include "process/base/ReadNameIndex.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Used by the record aware Indexer to validate the FASTQ records of the decompressed data and to find the record
+ * starts. A record consists of a header line starting with '@', the sequence, a separator line starting with '+' and
+ * the quality string, which needs to have the same length as the sequence.
+ *
+ * The data is passed in chunks as it is decompressed, lines and records may span several chunks. The scanner jumps from
+ * newline to newline with memchr and does not split the data into strings.
+ */
+class FastqRecordScanner : public ErrorAccumulator {
+
+public:
+
+    static const uint LINES_PER_RECORD;
+
+private:
+
+    /**
+     * The number of finished lines.
+     */
+    u_int64_t lines{0};
+
+    bool atLineStart{true};
+
+    int firstCharacterOfLine{-1};
+
+    u_int64_t lengthOfLine{0};
+
+    u_int64_t lengthOfSequence{0};
+
+    bool malformed{false};
+
+    bool collectReadNames{false};
+
+    /**
+     * The hash of the read name in the current header line. The name ends at the first whitespace.
+     */
+    ReadNameHash readNameHash;
+
+    bool readNameIsComplete{false};
+
+    vector<ReadNameEntry> readNames;
+
+    void addToReadName(const char *begin, const char *end);
+
+    bool finishLine();
+
+    bool reportMalformedRecord(const string &problem);
+
+public:
+
+    /**
+     * Also collect the hashes of the read names with their record numbers for a read name index. This needs 16 Byte
+     * of memory per record.
+     */
+    void enableReadNameCollection() { collectReadNames = true; }
+
+    vector<ReadNameEntry> &getReadNames() { return readNames; }
+
+    /**
+     * Scans the next chunk of decompressed data.
+     * @param data                   The decompressed data.
+     * @param length                 The length of the data.
+     * @param firstRecordStart       Receives the offset of the first record start in the data or -1, if no record
+     *                               starts in the data.
+     * @param lineOfFirstRecordStart Receives the number of the first line of this record.
+     * @return false, if the data is no valid FASTQ data. The scanner will not accept any data afterwards.
+     */
+    bool scan(const char *data, u_int64_t length, int64_t *firstRecordStart, u_int64_t *lineOfFirstRecordStart);
+
+    /**
+     * Call this after the last chunk of data. A last line without a newline is counted as well.
+     * @return false, if the data ends within a record.
+     */
+    bool finish();
+
+    /**
+     * The number of lines found so far. After finish(), this is the number of lines in the file.
+     */
+    u_int64_t getLines() { return lines; }
+
+    u_int64_t getRecords() { return lines / LINES_PER_RECORD; }
+};
+
+
+#endif //FASTQINDEX_FASTQRECORDSCANNER_H
@@ -7,13 +7,21 @@
 #include "common/ErrorAccumulator.h"
 #include "IndexWriter.h"
 #include <iostream>
+#include <zlib.h>
 
-const unsigned int IndexWriter::INDEX_WRITER_VERSION = 1;
+const unsigned int IndexWriter::INDEX_WRITER_VERSION = INDEX_WITH_UNCOMPRESSED_OFFSETS;
 
 IndexWriter::IndexWriter(const shared_ptr<Sink> &indexFile, bool forceOverwrite, bool compressionIsActive) {
     this->indexFile = indexFile;
     this->forceOverwrite = forceOverwrite;
     this->compressionIsActive = compressionIsActive;
+    this->useTrailer = !indexFile->canSeekBack();
+    this->checksum = crc32(0L, Z_NULL, 0);
+}
+
+void IndexWriter::writeAndChecksum(const char *data, int length) {
+    indexFile->write(data, length);
+    checksum = crc32(checksum, reinterpret_cast<const Bytef *>(data), static_cast<uInt>(length));
 }
 
 IndexWriter::~IndexWriter() {
@@ -30,16 +38,9 @@ bool IndexWriter::tryOpen() {
         return false;
     }
 
-    if (!indexFile->openWithWriteLock()) {
-        addErrorMessage("Could not get a lock for index file: '" + indexFile->toString(), "'.");
-        return false;
-    }
-
-    indexFile->write("", 0);
-
-    if (!indexFile->exists()) {
+    // Readers don't lock the index, it must only become visible when it is complete.
+    if (!indexFile->openForPublishing()) {
         addErrorMessage("Could not create index file '" + indexFile->toString() + "'.");
-        indexFile->unlock();
         return false;
     }
 
@@ -60,14 +61,18 @@ bool IndexWriter::writeIndexHeader(const shared_ptr<IndexHeader> &header) {
         return false;
     }
 
-    indexFile->write(reinterpret_cast<char *>( header.get()), sizeof(IndexHeader));
+    IndexHeader headerToWrite = *header;
+    headerToWrite.hasTrailer = useTrailer;
+    headerToWrite.completion = INDEX_IS_INCOMPLETE;
+    writeAndChecksum(reinterpret_cast<char *>(&headerToWrite), sizeof(IndexHeader));
 
     this->headerWasWritten = true;
+    this->writeUncompressedOffsets = header->entriesHaveUncompressedOffsets;
 
     return true;
 }
 
-bool IndexWriter::writeIndexEntry(const shared_ptr<IndexEntryV1> &entry) {
+bool IndexWriter::writeIndexEntry(const shared_ptr<IndexEntryV1> &entry, u_int64_t offsetInUncompressedData) {
     lock_guard<mutex> lock(iwMutex);
     if (!this->writerIsOpen) {
         addErrorMessage(
@@ -82,12 +87,16 @@ bool IndexWriter::writeIndexEntry(const shared_ptr<IndexEntryV1> &entry) {
 
     numberOfWrittenEntries++;
 
-    if (entry->compressedDictionarySize == 0) // No compression
-        indexFile->write(reinterpret_cast<char *>( entry.get()), sizeof(IndexEntryV1));
+    int headerSize = sizeof(IndexEntryV1) - sizeof(entry->dictionary);
+    if (!writeUncompressedOffsets && entry->compressedDictionarySize == 0) // No compression
+        writeAndChecksum(reinterpret_cast<char *>( entry.get()), sizeof(IndexEntryV1));
     else {
-        int headerSize = sizeof(IndexEntryV1) - sizeof(entry->dictionary);
-        indexFile->write(reinterpret_cast<char *>(entry.get()), headerSize);
-        indexFile->write(reinterpret_cast<char *>( entry.get()) + headerSize, entry->compressedDictionarySize);
+        writeAndChecksum(reinterpret_cast<char *>(entry.get()), headerSize);
+        if (writeUncompressedOffsets)
+            writeAndChecksum(reinterpret_cast<char *>(&offsetInUncompressedData), sizeof(offsetInUncompressedData));
+        int dictionarySize = entry->compressedDictionarySize == 0 ? sizeof(entry->dictionary)
+                                                                  : entry->compressedDictionarySize;
+        writeAndChecksum(reinterpret_cast<char *>( entry.get()) + headerSize, dictionarySize);
     }
 
     return true;
@@ -98,19 +107,40 @@ void IndexWriter::flush() {
     this->indexFile->flush();
 }
 
-void IndexWriter::finalize() {
+void IndexWriter::finalize(bool indexIsComplete) {
     lock_guard<mutex> lock(iwMutex);
     if (this->indexFile->isOpen()) {
+        bool writerWasOpen = this->writerIsOpen;
         this->writerIsOpen = false;
         // Without flush, the file size was 0, even after closing the stream.
         // Important: I do not work with reentrant locks! Don't call the this->flush() or you'll encounter a deadlock.
         indexFile->flush();
-        indexFile->seek(16, true);
-        indexFile->write(reinterpret_cast<const char *>( &numberOfWrittenEntries), 8);
-        indexFile->seek(24, true);
-        indexFile->write(reinterpret_cast<const char *>(&numberOfLinesInFile), 8);
+        if (useTrailer) {
+            // Console sinks never report to be closed, so take care to write the trailer only once. An index without a
+            // header is incomplete anyways, don't make it look like a valid one.
+            if (writerWasOpen && headerWasWritten && indexIsComplete) {
+                IndexTrailer trailer;
+                trailer.numberOfEntries = numberOfWrittenEntries;
+                trailer.linesInIndexedFile = numberOfLinesInFile;
+                trailer.checksum = crc32(checksum, reinterpret_cast<const Bytef *>(&trailer),
+                                         sizeof(IndexTrailer) - sizeof(trailer.checksum));
+                indexFile->write(reinterpret_cast<const char *>(&trailer), sizeof(IndexTrailer));
+            }
+        } else if (headerWasWritten) {
+            indexFile->seek(16, true);
+            indexFile->write(reinterpret_cast<const char *>( &numberOfWrittenEntries), 8);
+            indexFile->seek(24, true);
+            indexFile->write(reinterpret_cast<const char *>(&numberOfLinesInFile), 8);
+            Bytef completion = indexIsComplete ? INDEX_IS_COMPLETE : INDEX_IS_INCOMPLETE;
+            indexFile->seek(offsetof(IndexHeader, completion), true);
+            indexFile->write(reinterpret_cast<const char *>(&completion), 1);
+        }
         indexFile->flush();
-        this->indexFile->close();
+        // A failed run must not replace an existing index with an incomplete one.
+        if (indexIsComplete)
+            this->indexFile->close();
+        else
+            this->indexFile->closeWithoutPublishing();
     }
 }
 
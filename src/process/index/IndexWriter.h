@@ -11,6 +11,7 @@
 #include "process/base/IndexHeader.h"
 #include "process/io/locks/FileLockHandler.h"
 #include "process/io/Sink.h"
+#include <cstddef>
 #include <experimental/filesystem>
 #include <fstream>
 
@@ -44,8 +45,28 @@ private:
      */
     int64_t numberOfLinesInFile{0};
 
+    /**
+     * Set, if the sink can't seek back to the header. The counts are then written to an IndexTrailer.
+     */
+    bool useTrailer{false};
+
+    /**
+     * Taken from the written header, see IndexHeader::entriesHaveUncompressedOffsets.
+     */
+    bool writeUncompressedOffsets{false};
+
+    /**
+     * CRC32 of all data written so far, for the IndexTrailer.
+     */
+    uLong checksum{0};
+
 //    std::fstream fStream = std::fstream();
 
+    /**
+     * Writes the data and adds it to the checksum.
+     */
+    void writeAndChecksum(const char *data, int length);
+
 public:
 
     static const unsigned int INDEX_WRITER_VERSION;
@@ -69,7 +90,10 @@ public:
 
     bool writeIndexHeader(const shared_ptr<IndexHeader> &header);
 
-    bool writeIndexEntry(const shared_ptr<IndexEntryV1> &entry);
+    /**
+     * @param offsetInUncompressedData Only written, if the header has IndexHeader::entriesHaveUncompressedOffsets set.
+     */
+    bool writeIndexEntry(const shared_ptr<IndexEntryV1> &entry, u_int64_t offsetInUncompressedData = 0);
 
     void flush();
 
@@ -79,7 +103,15 @@ public:
         return true;
     };
 
-    void finalize();
+    /**
+     * Completes the index. Either the entry and line counts and the completion marker are patched into the header or, if
+     * the sink can't seek back, the IndexTrailer is appended.
+     * @param indexIsComplete If not set, e.g. after errors during indexing, the index stays marked as incomplete and no
+     *                        trailer is written. Readers will reject it.
+     */
+    void finalize(bool indexIsComplete = true);
+
+    bool writesTrailer() { return useTrailer; }
 
     vector<string> getErrorMessages() override;
 };
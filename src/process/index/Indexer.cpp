@@ -7,6 +7,8 @@
 #include "Indexer.h"
 #include "IndexEntryStorageDecisionStrategy.h"
 #include "common/IOHelper.h"
+#include "common/RunStatistics.h"
+#include "common/Tracer.h"
 #include "common/StringHelper.h"
 #include <cstdlib>
 #include <cstring>
@@ -35,14 +37,23 @@ Indexer::Indexer(
 }
 
 bool Indexer::fulfillsPremises() {
+    if (readNameIndexWriter && !readNameIndexWriter->fulfillsPremises())
+        return false;
     if (!forbidWriteFQI)
         return indexWriter->tryOpen();
     return true;
 }
 
 shared_ptr<IndexHeader> Indexer::createHeader() {
-    auto header = make_shared<IndexHeader>(Indexer::INDEXER_VERSION, sizeof(IndexEntryV1), 0,
-                                           compressDictionaries);
+    // Readers, which don't know record entries or the extended entries, must refuse the index.
+    u_int32_t version = Indexer::INDEXER_VERSION;
+    if (storeUncompressedOffsets)
+        version = INDEX_WITH_UNCOMPRESSED_OFFSETS;
+    else if (recordAware)
+        version = INDEX_WITH_RECORD_ENTRIES;
+    auto header = make_shared<IndexHeader>(version, sizeof(IndexEntryV1), 0, compressDictionaries);
+    header->entriesStartWithRecords = recordAware;
+    header->entriesHaveUncompressedOffsets = storeUncompressedOffsets;
     return header;
 }
 
@@ -71,6 +82,7 @@ bool Indexer::createIndex() {
     }
 
     auto sizeOfFastq = sourceFile->size();
+    RunStatistics::setProgressTotal(COMPRESSED_BYTES_READ, sizeOfFastq);
     // If not already set, recalculate the interval for index entries.
     storageStrategy->useFileSizeForCalculation(sizeOfFastq);
 
@@ -88,6 +100,7 @@ bool Indexer::createIndex() {
     }
 
     sourceFile->open();
+    sourceFile->adviseRange(0, 0); // The whole file is read sequentially.
 
     bool keepProcessing = true;
 
@@ -100,7 +113,7 @@ bool Indexer::createIndex() {
         partialBlockinfoStream.open(storageForPartialDecompressedBlocks);
     }
 
-    while (keepProcessing) {
+    while (keepProcessing && !errorWasRaised) {
 
         do {
             if (!sourceFile->canRead()) {
@@ -133,7 +146,7 @@ bool Indexer::createIndex() {
 
                 firstPass = false;
 
-            } while (zStream.avail_in != 0);
+            } while (zStream.avail_in != 0 && !errorWasRaised);
 
             keepProcessing = zlibResult != Z_STREAM_END && sourceFile->canRead();
 
@@ -157,6 +170,13 @@ bool Indexer::createIndex() {
     sourceFile->close();
     inflateEnd(&zStream);
 
+    // The scanner follows the lines across concatenated gzip streams, so its line count is used for the whole index.
+    if (recordAware) {
+        if (!errorWasRaised && !recordScanner.finish())
+            errorWasRaised = true;
+        lineCountForNextIndexEntry = recordScanner.getLines();
+    }
+
     // Set line info for index file, which will be written, when the index writer is deleted.
     indexWriter->setNumberOfLinesInFile(this->lineCountForNextIndexEntry);
 
@@ -168,12 +188,22 @@ bool Indexer::createIndex() {
         cerr << "Finished indexing with the last entry for compressed block #" << lastStoredEntry->blockIndex
              << " starting with line number " << lastStoredEntry->startingLineInEntry << "\n"
              << " The indexed file contains " << this->lineCountForNextIndexEntry << " lines\n";
+        if (recordAware)
+            cerr << " All " << recordScanner.getRecords() << " FASTQ records are valid.\n";
         if (numberOfConcatenatedFiles > 1) {
             cerr << " The source data consisted of " << numberOfConcatenatedFiles << " concatenated gzip streams.\n";
         }
     }
 
-    indexWriter->finalize();
+    indexWriter->finalize(finishedSuccessful);
+
+    if (finishedSuccessful && readNameIndexWriter) {
+        finishedSuccessful = readNameIndexWriter->write(recordScanner.getReadNames());
+        if (finishedSuccessful)
+            cerr << " Wrote the read name index with " << recordScanner.getReadNames().size() << " names.\n";
+        else
+            severe("The read name index could not be written.");
+    }
     return finishedSuccessful;
 }
 
@@ -243,18 +273,26 @@ bool Indexer::checkAndPrepareForNextConcatenatedPart() {
 void Indexer::finalizeProcessingForCurrentBlock(stringstream &currentDecompressedBlock, z_stream *strm) {
     int64_t blockOffset = offset;     // Store current blockOffsetInRawFile.
     offset = totalBytesIn;          // Set new blockOffsetInRawFile.
+    uncompressedOffsetOfCurrentBlock = uncompressedOffset;
+    uncompressedOffset = totalBytesOut;
     if (firstPass) {
         clearCurrentCompressedBlock();
         return;
     }
 
+    FQI_TRACE_SPAN("finalize block");
     blockID++;
+    RunStatistics::count(BLOCKS);
 
     // String representation of currentDecompressedBlock. Might or might not start with a fresh line, we need to
     // figure this out.
     u_int32_t numberOfLinesInBlock{0};
     string currentBlockString = currentDecompressedBlock.str();
-    std::vector<string> lines = StringHelper::splitStr(currentBlockString);
+    std::vector<string> lines;
+    {
+        ScopedRunTimer timer(TIME_IN_LINE_SCANNING);
+        lines = StringHelper::splitStr(currentBlockString);
+    }
     bool currentBlockEndedWithNewLine{false};
     bool blockIsEmpty = currentBlockString.empty();
 
@@ -270,18 +308,25 @@ void Indexer::finalizeProcessingForCurrentBlock(stringstream &currentDecompresse
     }
 
 
-    shared_ptr<IndexEntryV1> entry = createIndexEntryFromBlockData(
-            currentBlockString,
-            lines,
-            blockOffset,
-            lastBlockEndedWithNewline,
-            &currentBlockEndedWithNewLine,
-            &numberOfLinesInBlock
-    );
+    shared_ptr<IndexEntryV1> entry;
+    bool entryIsUsable{true};
+    {
+        ScopedRunTimer timer(TIME_IN_LINE_SCANNING);
+        entry = createIndexEntryFromBlockData(
+                currentBlockString,
+                lines,
+                blockOffset,
+                lastBlockEndedWithNewline,
+                &currentBlockEndedWithNewLine,
+                &numberOfLinesInBlock
+        );
+        if (recordAware)
+            entryIsUsable = moveEntryToFirstRecordInBlock(currentBlockString, entry);
+    }
 
     storeDictionaryForEntry(strm, entry);
 
-    bool written = writeIndexEntryIfPossible(entry, lines, blockIsEmpty);
+    bool written = writeIndexEntryIfPossible(entry, lines, blockIsEmpty || !entryIsUsable);
 
     if (writeOutOfPartialDecompressedBlocks) {
 
@@ -330,7 +375,12 @@ bool Indexer::writeIndexEntryIfPossible(shared_ptr<IndexEntryV1> &entry,
     if (compressDictionaries) {
         Bytef compressedDictionary[WINDOW_SIZE]{0};              // Around 60% decrease in size.
         u_int64_t compressedBytes = WINDOW_SIZE;
-        auto result = compress2(compressedDictionary, &compressedBytes, entry->dictionary, WINDOW_SIZE, 9);
+        int result;
+        {
+            FQI_TRACE_SPAN("compress dictionary");
+            ScopedRunTimer timer(TIME_IN_DICTIONARY_COMPRESSION);
+            result = compress2(compressedDictionary, &compressedBytes, entry->dictionary, WINDOW_SIZE, 9);
+        }
         if (result != 0) {
             addErrorMessage("Could not compress dictionary. zlib reports '", zStream.msg, "'.");
             return false;
@@ -340,8 +390,12 @@ bool Indexer::writeIndexEntryIfPossible(shared_ptr<IndexEntryV1> &entry,
         memcpy(entry->dictionary, compressedDictionary, compressedBytes);
     }
 
-    if (!forbidWriteFQI)
-        indexWriter->writeIndexEntry(entry);
+    if (!forbidWriteFQI) {
+        FQI_TRACE_SPAN("write index entry");
+        ScopedRunTimer timer(TIME_IN_SINK_WRITES);
+        indexWriter->writeIndexEntry(entry, static_cast<u_int64_t>(uncompressedOffsetOfCurrentBlock));
+    }
+    RunStatistics::count(INDEX_ENTRIES_STORED);
     lastStoredEntry = entry;
     if (enableDebugging) {
         storedEntries.emplace_back(entry);
@@ -349,6 +403,21 @@ bool Indexer::writeIndexEntryIfPossible(shared_ptr<IndexEntryV1> &entry,
     return true;
 }
 
+bool Indexer::moveEntryToFirstRecordInBlock(const string &currentBlockString, const shared_ptr<IndexEntryV1> &entry) {
+    int64_t firstRecordStart{-1};
+    u_int64_t lineOfFirstRecordStart{0};
+    if (!recordScanner.scan(currentBlockString.data(), currentBlockString.size(), &firstRecordStart,
+                            &lineOfFirstRecordStart)) {
+        errorWasRaised = true;
+        return false;
+    }
+    if (firstRecordStart < 0)
+        return false;
+    entry->startingLineInEntry = lineOfFirstRecordStart;
+    entry->offsetToNextLineStart = static_cast<u_int32_t>(firstRecordStart);
+    return true;
+}
+
 void Indexer::storeDictionaryForEntry(z_stream *strm, const shared_ptr<IndexEntryV1> &entry) {
     // Compared to the original zran example, which uses two memcpy operations to retrieve the dictionary, we
     // use zlibs inflateGetDictionaryMethod. This looks more clean and works, whereas I could not get the
@@ -382,12 +451,12 @@ shared_ptr<IndexEntryV1> Indexer::createIndexEntryFromBlockData(const string &cu
     }
 
     // Find the first newline character to get the blockOffsetInRawFile of the line inside
-    ushort offsetOfFirstLine{0};
+    u_int32_t offsetOfFirstLine{0};
     if (currentBlockString.empty()) {
     } else if (!lastBlockEndedWithNewline) {
         (*numberOfLinesInBlock)--;  // If the last block ended with an incomplete line (and not '\n'), reduce this.
         if (hasAnyLineBreaks)   // See case 3.1 in testlayout. a block with a \n at any position
-            offsetOfFirstLine = static_cast<ushort>(lines[0].size() + 1);
+            offsetOfFirstLine = static_cast<u_int32_t>(lines[0].size() + 1);
     }
     //!*currentBlockEndedWithNewLine &&
     // Only store every n'th block.
@@ -424,10 +493,10 @@ void Indexer::storeLinesOfCurrentBlockForDebugMode(std::stringstream &currentDec
 }
 
 vector<string> Indexer::getErrorMessages() {
-    if (!forbidWriteFQI) {
-        vector<string> l = ErrorAccumulator::getErrorMessages();
-        vector<string> r = indexWriter->getErrorMessages();
-        return concatenateVectors(l, r);
-    }
-    return ErrorAccumulator::getErrorMessages();
+    vector<string> l = ErrorAccumulator::getErrorMessages();
+    vector<string> r = forbidWriteFQI ? vector<string>() : indexWriter->getErrorMessages();
+    vector<string> s = recordScanner.getErrorMessages();
+    if (readNameIndexWriter)
+        s = concatenateVectors(s, readNameIndexWriter->getErrorMessages());
+    return concatenateVectors(l, r, s);
 }
\ No newline at end of file
@@ -9,8 +9,10 @@
 
 #include "common/CommonStructsAndConstants.h"
 #include "common/ErrorAccumulator.h"
+#include "process/index/FastqRecordScanner.h"
 #include "process/index/IndexEntryStorageDecisionStrategy.h"
 #include "process/index/IndexWriter.h"
+#include "process/index/ReadNameIndexWriter.h"
 #include "process/io/Sink.h"
 #include "process/base/ZLibBasedFASTQProcessorBaseClass.h"
 #include <string>
@@ -49,6 +51,24 @@ private:
 
     bool compressDictionaries{true};
 
+    /**
+     * If set, the FASTQ records are validated and the entries point to the first record in their block, see
+     * IndexHeader::entriesStartWithRecords.
+     */
+    bool recordAware{false};
+
+    FastqRecordScanner recordScanner;
+
+    /**
+     * Store the offset of each entry in the uncompressed data, see IndexHeader::entriesHaveUncompressedOffsets.
+     */
+    bool storeUncompressedOffsets{false};
+
+    /**
+     * Only set, if a read name index shall be written next to the index.
+     */
+    shared_ptr<ReadNameIndexWriter> readNameIndexWriter;
+
     /**
      * For debug and test purposes, used when debuggingEnabled is true
      * keeps the index header
@@ -90,6 +110,13 @@ private:
      */
     long offset{0};
 
+    /**
+     * Offset of the current block in the uncompressed data, like offset for the compressed data.
+     */
+    int64_t uncompressedOffset{0};
+
+    int64_t uncompressedOffsetOfCurrentBlock{0};
+
     /**
      * Marks, if the last inflated block ended with the newline character.
      * If true, the blockOffsetInRawFile for the first line in the new block will be 0.
@@ -137,6 +164,23 @@ public:
         this->compressDictionaries = value;
     }
 
+    void setRecordAwareIndexing(bool value) {
+        this->recordAware = value;
+    }
+
+    void setUncompressedOffsetStorage(bool value) {
+        this->storeUncompressedOffsets = value;
+    }
+
+    /**
+     * Also write a read name index, see ReadNameIndexHeader. This requires and enables record aware indexing.
+     */
+    void setReadNameIndex(const shared_ptr<Sink> &readNameIndex) {
+        this->recordAware = true;
+        this->readNameIndexWriter = make_shared<ReadNameIndexWriter>(readNameIndex);
+        this->recordScanner.enableReadNameCollection();
+    }
+
     bool fulfillsPremises();
 
     /**
@@ -186,6 +230,13 @@ public:
                                                            bool *currentBlockEndedWithNewLine,
                                                            u_int32_t *numberOfLinesInBlock);
 
+    /**
+     * Validates the records of the block and moves the entry to the first record, which starts in the block.
+     * @return false, if the block contains malformed FASTQ data or no record starts in it. Such an entry must not be
+     * stored.
+     */
+    bool moveEntryToFirstRecordInBlock(const string &currentBlockString, const shared_ptr<IndexEntryV1> &entry);
+
     void storeDictionaryForEntry(z_stream *strm, const shared_ptr<IndexEntryV1>& entry);
 
     bool writeIndexEntryIfPossible(shared_ptr<IndexEntryV1> &entry, const vector<string> &lines, bool blockIsEmpty);
@@ -0,0 +1,41 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#include "ReadNameIndexWriter.h"
+#include <algorithm>
+
+bool ReadNameIndexWriter::fulfillsPremises() {
+    return nameIndexFile->fulfillsPremises();
+}
+
+bool ReadNameIndexWriter::write(vector<ReadNameEntry> &entries) {
+    sort(entries.begin(), entries.end());
+
+    if (!nameIndexFile->openForPublishing()) {
+        addErrorMessage("Could not create the read name index file '", nameIndexFile->toString(), "'.");
+        return false;
+    }
+
+    ReadNameIndexHeader header;
+    header.numberOfEntries = entries.size();
+    nameIndexFile->write(reinterpret_cast<const char *>(&header), sizeof(ReadNameIndexHeader));
+
+    // Sinks take an int as length, so the entries are written in batches.
+    const size_t entriesPerWrite = 64 * 1024;
+    for (size_t i = 0; i < entries.size(); i += entriesPerWrite) {
+        size_t count = min(entriesPerWrite, entries.size() - i);
+        nameIndexFile->write(reinterpret_cast<const char *>(entries.data() + i),
+                             static_cast<int>(count * sizeof(ReadNameEntry)));
+    }
+    nameIndexFile->flush();
+    return nameIndexFile->close();
+}
+
+vector<string> ReadNameIndexWriter::getErrorMessages() {
+    vector<string> l = ErrorAccumulator::getErrorMessages();
+    vector<string> r = nameIndexFile->getErrorMessages();
+    return concatenateVectors(l, r);
+}
@@ -0,0 +1,45 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#ifndef FASTQINDEX_READNAMEINDEXWRITER_H
+#define FASTQINDEX_READNAMEINDEXWRITER_H
+
+#include "common/ErrorAccumulator.h"
+#include "process/base/ReadNameIndex.h"
+#include "process/io/Sink.h"
+#include <vector>
+
+using namespace std;
+
+/**
+ * Writes a read name index, see ReadNameIndexHeader. Like the index, the file only becomes visible, when it is
+ * complete.
+ */
+class ReadNameIndexWriter : public ErrorAccumulator {
+
+private:
+
+    shared_ptr<Sink> nameIndexFile;
+
+public:
+
+    explicit ReadNameIndexWriter(const shared_ptr<Sink> &nameIndexFile) : nameIndexFile(nameIndexFile) {}
+
+    /**
+     * Checks, if the file can be written. This does not create it yet.
+     */
+    bool fulfillsPremises();
+
+    /**
+     * Sorts the entries and writes them to the file.
+     */
+    bool write(vector<ReadNameEntry> &entries);
+
+    vector<string> getErrorMessages() override;
+};
+
+
+#endif //FASTQINDEX_READNAMEINDEXWRITER_H
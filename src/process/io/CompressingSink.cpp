@@ -0,0 +1,424 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#include "CompressingSink.h"
+#include "common/Tracer.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+const u_int64_t CompressingSink::BGZF_CHUNK_SIZE = 0xff00;
+
+const u_int64_t CompressingSink::DEFAULT_GZIP_CHUNK_SIZE = 128 * kB;
+
+const int64_t CompressingSink::DEFAULT_INDEX_ENTRY_DISTANCE = 16 * MB;
+
+/**
+ * A gzip header without file name and timestamp, OS is set to Unix.
+ */
+static const unsigned char GZIP_HEADER[10]{0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 3};
+
+/**
+ * BGZF block header. The last two Bytes (BSIZE) are the total block size minus 1 and are set for each block.
+ */
+static const unsigned char BGZF_HEADER[18]{0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C', 2, 0, 0, 0};
+
+/**
+ * The empty block, which marks the end of a BGZF file.
+ */
+static const unsigned char BGZF_EOF_BLOCK[28]{0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C', 2, 0, 0x1b, 0,
+                                              3, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+static void putLittleEndian32(unsigned char *target, u_int32_t value) {
+    for (int i = 0; i < 4; i++)
+        target[i] = static_cast<unsigned char>((value >> (8 * i)) & 0xff);
+}
+
+CompressingSink::CompressingSink(const shared_ptr<Sink> &target,
+                                 CompressionFormat format,
+                                 uint numberOfThreads,
+                                 const shared_ptr<Sink> &indexFile,
+                                 u_int64_t chunkSize,
+                                 int64_t indexEntryDistance) :
+        Sink(true), target(target), format(format) {
+    this->numberOfThreads = max(numberOfThreads, 1U);
+
+    u_int64_t maximumChunkSize = format == BGZF ? BGZF_CHUNK_SIZE : DEFAULT_GZIP_CHUNK_SIZE;
+    if (chunkSize == 0)
+        this->chunkSize = maximumChunkSize;
+    else
+        this->chunkSize = format == BGZF ? min(chunkSize, BGZF_CHUNK_SIZE) : chunkSize;
+
+    if (format == BGZF && indexFile) {
+        indexWriter = make_shared<IndexWriter>(indexFile, true, true);
+        storageStrategy = make_shared<ByteDistanceStorageDecisionStrategy>(indexEntryDistance);
+
+        Bytef emptyDictionary[WINDOW_SIZE]{0};
+        uLongf compressedSize = WINDOW_SIZE;
+        compress2(compressedEmptyDictionary, &compressedSize, emptyDictionary, WINDOW_SIZE, 9);
+        compressedEmptyDictionarySize = static_cast<u_int16_t>(compressedSize);
+    }
+}
+
+CompressingSink::~CompressingSink() {
+    if (sinkIsOpen)
+        close();
+    stopAndJoinWorkers();
+}
+
+bool CompressingSink::compressChunk(CompressionJob *job, CompressionFormat format, int compressionLevel) {
+    FQI_TRACE_SPAN("compress output chunk");
+    job->crc = crc32(0L, reinterpret_cast<const Bytef *>(job->data.data()), static_cast<uInt>(job->data.size()));
+    job->numberOfLines = static_cast<u_int64_t>(count(job->data.begin(), job->data.end(), '\n'));
+
+    z_stream strm{};
+    if (deflateInit2(&strm, compressionLevel, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return false;
+
+    if (!job->dictionary.empty()) {
+        deflateSetDictionary(&strm,
+                             reinterpret_cast<const Bytef *>(job->dictionary.data()),
+                             static_cast<uInt>(job->dictionary.size()));
+    }
+
+    // deflateBound() covers a finished stream, a sync flush adds up to 5 more Bytes for an empty stored block.
+    u_int64_t headerSize = format == BGZF ? sizeof(BGZF_HEADER) : 0;
+    u_int64_t trailerSize = format == BGZF ? 8 : 0;
+    u_int64_t bound = deflateBound(&strm, static_cast<uLong>(job->data.size())) + 16;
+    job->result.resize(headerSize + bound + trailerSize);
+
+    strm.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(job->data.data()));
+    strm.avail_in = static_cast<uInt>(job->data.size());
+    strm.next_out = reinterpret_cast<Bytef *>(&job->result[headerSize]);
+    strm.avail_out = static_cast<uInt>(bound);
+
+    // Only the last chunk of a GZIP stream may finish the deflate stream, all others end on a Byte boundary, so that
+    // the next chunk can simply be appended.
+    bool finish = format == BGZF || job->isLast;
+    int result = deflate(&strm, finish ? Z_FINISH : Z_SYNC_FLUSH);
+    bool successful = finish ? result == Z_STREAM_END : (result == Z_OK && strm.avail_in == 0);
+    u_int64_t deflatedSize = bound - strm.avail_out;
+    deflateEnd(&strm);
+
+    if (!successful)
+        return false;
+
+    job->result.resize(headerSize + deflatedSize + trailerSize);
+
+    if (format == BGZF) {
+        u_int64_t blockSize = job->result.size();
+        if (blockSize > 65536)
+            return false;
+        auto *block = reinterpret_cast<unsigned char *>(&job->result[0]);
+        memcpy(block, BGZF_HEADER, sizeof(BGZF_HEADER));
+        block[16] = static_cast<unsigned char>((blockSize - 1) & 0xff);
+        block[17] = static_cast<unsigned char>(((blockSize - 1) >> 8) & 0xff);
+        putLittleEndian32(block + blockSize - 8, static_cast<u_int32_t>(job->crc));
+        putLittleEndian32(block + blockSize - 4, static_cast<u_int32_t>(job->data.size()));
+    }
+
+    return true;
+}
+
+bool CompressingSink::fulfillsPremises() {
+    if (!target->fulfillsPremises())
+        return false;
+    if (indexWriter && !indexWriter->tryOpen())
+        return false;
+    return true;
+}
+
+bool CompressingSink::open() {
+    if (sinkIsOpen)
+        return true;
+    if (!target->open())
+        return false;
+    return startStream();
+}
+
+bool CompressingSink::openWithWriteLock() {
+    if (sinkIsOpen)
+        return true;
+    if (!target->openWithWriteLock())
+        return false;
+    return startStream();
+}
+
+bool CompressingSink::startStream() {
+    if (indexWriter) {
+        auto header = make_shared<IndexHeader>(IndexWriter::INDEX_WRITER_VERSION, sizeof(IndexEntryV1), 0, true);
+        if (!indexWriter->tryOpen() || !indexWriter->writeIndexHeader(header)) {
+            addErrorMessage("Could not create the index for the compressed output '", target->toString(), "'.");
+            return false;
+        }
+    }
+
+    if (format == GZIP) {
+        target->write(reinterpret_cast<const char *>(GZIP_HEADER), sizeof(GZIP_HEADER));
+        compressedBytes += sizeof(GZIP_HEADER);
+    }
+
+    startWorkers();
+    sinkIsOpen = true;
+    return true;
+}
+
+void CompressingSink::startWorkers() {
+    stopWorkers = false;
+    for (uint i = 0; i < numberOfThreads; i++) {
+        workers.emplace_back(&CompressingSink::workerLoop, this);
+    }
+}
+
+void CompressingSink::stopAndJoinWorkers() {
+    {
+        lock_guard<mutex> lock(jobMutex);
+        stopWorkers = true;
+    }
+    jobAvailable.notify_all();
+    for (auto &worker : workers) {
+        if (worker.joinable())
+            worker.join();
+    }
+    workers.clear();
+}
+
+void CompressingSink::workerLoop() {
+    while (true) {
+        shared_ptr<CompressionJob> job;
+        {
+            unique_lock<mutex> lock(jobMutex);
+            jobAvailable.wait(lock, [this] { return stopWorkers || !openJobs.empty(); });
+            if (openJobs.empty())
+                return;
+            job = openJobs.front();
+            openJobs.pop_front();
+        }
+
+        bool successful = compressChunk(job.get(), format, compressionLevel);
+
+        {
+            lock_guard<mutex> lock(jobMutex);
+            job->successful = successful;
+            job->finished = true;
+        }
+        jobFinished.notify_all();
+    }
+}
+
+void CompressingSink::write(const char *message) {
+    write(message, static_cast<int>(strlen(message)));
+}
+
+void CompressingSink::write(const string &message) {
+    write(message.c_str(), static_cast<int>(message.length()));
+}
+
+void CompressingSink::write(const char *message, int len) {
+    if (!sinkIsOpen) {
+        addErrorMessage("BUG: You cannot write to a closed compressed output.");
+        return;
+    }
+    if (len <= 0)
+        return;
+    currentChunk.append(message, static_cast<u_int64_t>(len));
+    uncompressedBytes += len;
+    if (currentChunk.size() >= chunkSize)
+        queueFullChunks();
+}
+
+void CompressingSink::writeSpans(const struct iovec *spans, int count) {
+    if (!sinkIsOpen) {
+        addErrorMessage("BUG: You cannot write to a closed compressed output.");
+        return;
+    }
+    for (int i = 0; i < count; i++) {
+        currentChunk.append(static_cast<const char *>(spans[i].iov_base), spans[i].iov_len);
+        uncompressedBytes += spans[i].iov_len;
+    }
+    if (currentChunk.size() >= chunkSize)
+        queueFullChunks();
+}
+
+int64_t CompressingSink::seek(int64_t nByte, bool absolute) {
+    addErrorMessage("BUG: You cannot seek ", absolute ? "to position " : "by ", to_string(nByte),
+                    " in the compressed output '", target->toString(), "'.");
+    return 0;
+}
+
+int64_t CompressingSink::skip(int64_t nByte) {
+    addErrorMessage("BUG: You cannot skip ", to_string(nByte), " Bytes in the compressed output '", target->toString(),
+                    "'.");
+    return 0;
+}
+
+int64_t CompressingSink::rewind(int64_t nByte) {
+    addErrorMessage("BUG: You cannot rewind ", to_string(nByte), " Bytes in the compressed output '",
+                    target->toString(), "'.");
+    return 0;
+}
+
+void CompressingSink::queueFullChunks() {
+    while (currentChunk.size() >= chunkSize) {
+        u_int64_t cut = chunkSize;
+        if (format == BGZF) {
+            // Cut behind the last line end in the chunk, so that the next BGZF block starts with a fresh line and can
+            // be referenced by an index entry. Lines which are larger than a block are cut anywhere.
+            auto lastNewLine = currentChunk.rfind('\n', chunkSize - 1);
+            if (lastNewLine != string::npos)
+                cut = lastNewLine + 1;
+        }
+        string data = currentChunk.substr(0, cut);
+        currentChunk.erase(0, cut);
+        queueChunk(move(data), false);
+    }
+}
+
+void CompressingSink::queueChunk(string &&data, bool isLast) {
+    // Empty BGZF blocks are useless, the end of the file is marked by the EOF block. A GZIP stream needs the final
+    // deflate block though.
+    if (format == BGZF && data.empty())
+        return;
+
+    auto job = make_shared<CompressionJob>();
+    job->isLast = isLast;
+    job->startsWithNewLine = lastChunkEndedWithNewLine;
+    if (!data.empty())
+        lastChunkEndedWithNewLine = data[data.size() - 1] == '\n';
+
+    if (format == GZIP) {
+        job->dictionary = lastWindow;
+        if (data.size() >= WINDOW_SIZE) {
+            lastWindow.assign(data, data.size() - WINDOW_SIZE, WINDOW_SIZE);
+        } else {
+            lastWindow.append(data);
+            if (lastWindow.size() > WINDOW_SIZE)
+                lastWindow.erase(0, lastWindow.size() - WINDOW_SIZE);
+        }
+    }
+    job->data = move(data);
+
+    {
+        lock_guard<mutex> lock(jobMutex);
+        jobsInOrder.emplace_back(job);
+        openJobs.emplace_back(job);
+    }
+    jobAvailable.notify_one();
+
+    writeFinishedJobs(false);
+}
+
+void CompressingSink::writeFinishedJobs(bool waitForAll) {
+    // Allow some more queued jobs than workers, so the workers don't run idle while we write.
+    u_int64_t maximumQueuedJobs = 2 * numberOfThreads;
+
+    unique_lock<mutex> lock(jobMutex);
+    while (!jobsInOrder.empty()) {
+        auto job = jobsInOrder.front();
+        if (!job->finished) {
+            if (!waitForAll && jobsInOrder.size() <= maximumQueuedJobs)
+                break;
+            jobFinished.wait(lock, [&job] { return job->finished; });
+        }
+        jobsInOrder.pop_front();
+
+        lock.unlock();
+        writeJob(job);
+        lock.lock();
+    }
+}
+
+void CompressingSink::writeJob(const shared_ptr<CompressionJob> &job) {
+    if (!job->successful) {
+        addErrorMessage("Could not compress chunk #", to_string(writtenChunks), " for output '", target->toString(),
+                        "'.");
+        return;
+    }
+
+    if (indexWriter)
+        storeIndexEntryIfPossible(job);
+
+    if (format == GZIP)
+        crc = crc32_combine(crc, job->crc, static_cast<z_off_t>(job->data.size()));
+
+    {
+        FQI_TRACE_SPAN("write output chunk");
+        target->write(job->result.data(), static_cast<int>(job->result.size()));
+    }
+    compressedBytes += job->result.size();
+    writtenLines += job->numberOfLines;
+    writtenChunks++;
+}
+
+void CompressingSink::storeIndexEntryIfPossible(const shared_ptr<CompressionJob> &job) {
+    if (!job->startsWithNewLine)
+        return;
+
+    // The entry points to the deflate data right behind the BGZF header. As each block is an independent gzip stream,
+    // neither bits nor a dictionary are needed for extraction.
+    auto entry = IndexEntryV1::from(0, writtenChunks, 0, compressedBytes + BGZF_HEADER_SIZE, writtenLines);
+    if (!storageStrategy->shallStore(entry, lastStoredIndexEntry, job->data.empty()))
+        return;
+
+    entry->compressedDictionarySize = compressedEmptyDictionarySize;
+    memcpy(entry->dictionary, compressedEmptyDictionary, compressedEmptyDictionarySize);
+    indexWriter->writeIndexEntry(entry);
+    lastStoredIndexEntry = entry;
+}
+
+void CompressingSink::flush() {
+    if (!sinkIsOpen)
+        return;
+    if (!currentChunk.empty()) {
+        string data;
+        data.swap(currentChunk);
+        queueChunk(move(data), false);
+    }
+    writeFinishedJobs(true);
+    target->flush();
+}
+
+bool CompressingSink::close() {
+    if (!sinkIsOpen)
+        return target->close();
+
+    queueFullChunks();
+    string data;
+    data.swap(currentChunk);
+    queueChunk(move(data), true);
+    writeFinishedJobs(true);
+    stopAndJoinWorkers();
+
+    if (format == GZIP) {
+        unsigned char trailer[8]{0};
+        putLittleEndian32(trailer, static_cast<u_int32_t>(crc));
+        putLittleEndian32(trailer + 4, static_cast<u_int32_t>(uncompressedBytes & 0xffffffff));
+        target->write(reinterpret_cast<const char *>(trailer), sizeof(trailer));
+        compressedBytes += sizeof(trailer);
+    } else {
+        target->write(reinterpret_cast<const char *>(BGZF_EOF_BLOCK), sizeof(BGZF_EOF_BLOCK));
+        compressedBytes += sizeof(BGZF_EOF_BLOCK);
+    }
+
+    if (indexWriter) {
+        indexWriter->setNumberOfLinesInFile(writtenLines);
+        indexWriter->finalize(ErrorAccumulator::getErrorMessages().empty());
+    }
+
+    sinkIsOpen = false;
+    target->flush();
+    bool closed = target->close();
+    return closed && ErrorAccumulator::getErrorMessages().empty();
+}
+
+vector<string> CompressingSink::getErrorMessages() {
+    vector<string> l = ErrorAccumulator::getErrorMessages();
+    vector<string> r = target->getErrorMessages();
+    if (indexWriter)
+        return concatenateVectors(l, r, indexWriter->getErrorMessages());
+    return concatenateVectors(l, r);
+}
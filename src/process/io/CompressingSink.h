@@ -0,0 +1,302 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#ifndef FASTQINDEX_COMPRESSINGSINK_H
+#define FASTQINDEX_COMPRESSINGSINK_H
+
+#include "common/CommonStructsAndConstants.h"
+#include "process/index/IndexEntryStorageDecisionStrategy.h"
+#include "process/index/IndexWriter.h"
+#include "process/io/Sink.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+
+using namespace std;
+
+/**
+ * The output formats which are supported by the CompressingSink.
+ * - GZIP is a single gzip stream, which is compressed in independent chunks (like pigz does it).
+ * - BGZF is a series of small gzip streams (blocks) like it is used by bgzip / htslib.
+ */
+enum CompressionFormat {
+    GZIP,
+    BGZF
+};
+
+/**
+ * A single chunk of data which is compressed by one of the worker threads of the CompressingSink.
+ */
+struct CompressionJob {
+
+    string data;
+
+    /**
+     * For GZIP, the last 32kB of the preceding chunk are used as the dictionary for this chunk. Empty for BGZF.
+     */
+    string dictionary;
+
+    bool isLast{false};
+
+    /**
+     * Tells, if the chunk starts with a fresh line. Only those BGZF blocks can be referenced by an index entry.
+     */
+    bool startsWithNewLine{false};
+
+    string result;
+
+    u_long crc{0};
+
+    u_int64_t numberOfLines{0};
+
+    bool finished{false};
+
+    bool successful{false};
+};
+
+/**
+ * Sink decorator which compresses all written data before it passes it on to the wrapped sink. The data is collected
+ * in chunks which are then deflated in parallel by a configurable number of worker threads. The compressed chunks are
+ * written to the wrapped sink in the order in which their data was written to this sink.
+ *
+ * For BGZF output, chunks are cut at line ends (if possible) and an index file can be written on the fly. Each index
+ * entry points to the start of a BGZF block, so no dictionary is necessary for extraction.
+ *
+ * The sink can only write data. Seeking and rewinding are not supported, tell() returns the number of uncompressed
+ * Bytes written so far.
+ */
+class CompressingSink : public Sink {
+
+private:
+
+    shared_ptr<Sink> target;
+
+    CompressionFormat format;
+
+    int compressionLevel{Z_DEFAULT_COMPRESSION};
+
+    uint numberOfThreads{1};
+
+    u_int64_t chunkSize{0};
+
+    /**
+     * Only set for BGZF output. If set, an index file will be created while the data is compressed.
+     */
+    shared_ptr<IndexWriter> indexWriter;
+
+    shared_ptr<IndexEntryStorageDecisionStrategy> storageStrategy;
+
+    IndexEntryV1_S lastStoredIndexEntry;
+
+    /**
+     * Compressed form of an empty dictionary. Entries pointing to the start of a BGZF block don't need a dictionary.
+     */
+    Bytef compressedEmptyDictionary[WINDOW_SIZE]{0};
+
+    u_int16_t compressedEmptyDictionarySize{0};
+
+    bool sinkIsOpen{false};
+
+    string currentChunk;
+
+    /**
+     * The last WINDOW_SIZE Bytes of the last chunk, used as the dictionary for the next GZIP chunk.
+     */
+    string lastWindow;
+
+    bool lastChunkEndedWithNewLine{true};
+
+    /**
+     * All jobs, which were not written yet. The order is the order of the output file.
+     */
+    deque<shared_ptr<CompressionJob>> jobsInOrder;
+
+    /**
+     * All jobs, which were not picked up by a worker thread yet.
+     */
+    deque<shared_ptr<CompressionJob>> openJobs;
+
+    vector<thread> workers;
+
+    mutex jobMutex;
+
+    condition_variable jobAvailable;
+
+    condition_variable jobFinished;
+
+    bool stopWorkers{false};
+
+    u_int64_t uncompressedBytes{0};
+
+    u_int64_t compressedBytes{0};
+
+    u_int64_t writtenLines{0};
+
+    u_int64_t writtenChunks{0};
+
+    u_long crc{0};
+
+    void startWorkers();
+
+    void stopAndJoinWorkers();
+
+    void workerLoop();
+
+    /**
+     * Cuts off full chunks from currentChunk and queues them for compression.
+     */
+    void queueFullChunks();
+
+    void queueChunk(string &&data, bool isLast);
+
+    /**
+     * Writes all finished jobs at the head of jobsInOrder to the target.
+     * @param waitForAll Wait, until all queued jobs are written.
+     */
+    void writeFinishedJobs(bool waitForAll);
+
+    void writeJob(const shared_ptr<CompressionJob> &job);
+
+    void storeIndexEntryIfPossible(const shared_ptr<CompressionJob> &job);
+
+    bool startStream();
+
+public:
+
+    /**
+     * BGZF blocks must not be larger than 64kB compressed. 0xff00 Bytes of uncompressed data safely stay below this
+     * limit, even for incompressible data. This is the same value as used by htslib.
+     */
+    static const u_int64_t BGZF_CHUNK_SIZE;
+
+    static const u_int64_t DEFAULT_GZIP_CHUNK_SIZE;
+
+    /**
+     * The default minimum distance of two index entries written for BGZF output.
+     */
+    static const int64_t DEFAULT_INDEX_ENTRY_DISTANCE;
+
+    static const u_int32_t BGZF_HEADER_SIZE = 18;
+
+    static shared_ptr<CompressingSink> from(const shared_ptr<Sink> &target,
+                                            CompressionFormat format,
+                                            uint numberOfThreads = 1,
+                                            const shared_ptr<Sink> &indexFile = nullptr) {
+        return make_shared<CompressingSink>(target, format, numberOfThreads, indexFile);
+    }
+
+    /**
+     * @param target            The sink to which the compressed data is written.
+     * @param format            GZIP or BGZF
+     * @param numberOfThreads   The number of compression threads, at least one thread will be started.
+     * @param indexFile         If set and the format is BGZF, an index for the compressed output will be written.
+     * @param chunkSize         The amount of uncompressed data per chunk. 0 selects the default size for the format.
+     *                          For BGZF, the size is limited to BGZF_CHUNK_SIZE.
+     * @param indexEntryDistance The minimum distance of two index entries in compressed Bytes. Used for BGZF only.
+     */
+    CompressingSink(const shared_ptr<Sink> &target,
+                    CompressionFormat format,
+                    uint numberOfThreads = 1,
+                    const shared_ptr<Sink> &indexFile = nullptr,
+                    u_int64_t chunkSize = 0,
+                    int64_t indexEntryDistance = DEFAULT_INDEX_ENTRY_DISTANCE);
+
+    ~CompressingSink() override;
+
+    /**
+     * Compresses the chunk in job. This is called by the worker threads but can also be used without them.
+     */
+    static bool compressChunk(CompressionJob *job, CompressionFormat format, int compressionLevel);
+
+    CompressionFormat getFormat() { return format; }
+
+    uint getNumberOfThreads() { return numberOfThreads; }
+
+    shared_ptr<Sink> getTarget() { return target; }
+
+    bool writesIndex() { return indexWriter.get() != nullptr; }
+
+    u_int64_t getCompressedBytes() { return compressedBytes; }
+
+    bool fulfillsPremises() override;
+
+    bool open() override;
+
+    bool openWithWriteLock() override;
+
+    /**
+     * Compresses and writes all remaining data, writes the stream trailer and finalizes the index. Closes the wrapped
+     * sink afterwards.
+     */
+    bool close() override;
+
+    bool hasLock() override { return target->hasLock(); }
+
+    bool unlock() override { return target->unlock(); }
+
+    bool isOpen() override { return sinkIsOpen; }
+
+    bool eof() override { return false; }
+
+    bool isGood() override { return target->isGood(); }
+
+    bool isFile() override { return target->isFile(); }
+
+    bool isStream() override { return target->isStream(); }
+
+    bool isSymlink() override { return target->isSymlink(); }
+
+    bool canSeekBack() override { return false; }
+
+    bool exists() override { return target->exists(); }
+
+    int64_t size() override { return target->size(); }
+
+    bool empty() override { return uncompressedBytes == 0 && target->empty(); }
+
+    bool canRead() override { return false; }
+
+    bool canWrite() override { return target->canWrite(); }
+
+    /**
+     * The compressed output is written strictly sequential. seek(), skip() and rewind() don't move and only record an
+     * error message.
+     */
+    int64_t seek(int64_t nByte, bool absolute) override;
+
+    int64_t skip(int64_t nByte) override;
+
+    int64_t rewind(int64_t nByte) override;
+
+    string toString() override { return target->toString(); }
+
+    int64_t tell() override { return uncompressedBytes; }
+
+    int lastError() override { return target->lastError(); }
+
+    void write(const char *message) override;
+
+    void write(const char *message, int len) override;
+
+    void write(const string &message) override;
+
+    void writeSpans(const struct iovec *spans, int count) override;
+
+    /**
+     * Compresses and writes all data which was passed to the sink so far. Note, that this will create a smaller chunk
+     * and slightly decrease the compression ratio.
+     */
+    void flush() override;
+
+    vector<string> getErrorMessages() override;
+};
+
+
+#endif //FASTQINDEX_COMPRESSINGSINK_H
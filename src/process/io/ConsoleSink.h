@@ -8,11 +8,14 @@
 #define FASTQINDEX_CONSOLESINK_H
 
 #include "Sink.h"
+#include "process/io/FileDescriptorWriter.h"
 #include <string>
 #include <cstring>
 #include <ostream>
 #include <memory>
 #include <mutex>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace std;
 
@@ -22,28 +25,97 @@ enum ConsoleSinkType {
 };
 
 /**
- * This Sink implementation is specific for the console streams cerr and cout
+ * This Sink implementation is specific for the console streams cerr and cout. The data is written directly to the
+ * file descriptors of the streams. For cout, the data is buffered in large buffers and spliced into the pipe, if the
+ * output is piped to another process. cerr is not buffered.
+ *
+ * If cout and cerr go to the same terminal, file or pipe, the buffered data is written before a message is printed via
+ * the ErrorAccumulator. The output then keeps its order, like with cout, which is flushed before cerr is written.
  */
 class ConsoleSink : public Sink {
 private:
 
-    mutex _mtx;
+    /**
+     * Recursive, so the console flush hook can try to lock it, if the writer prints a message while it is locked.
+     */
+    recursive_mutex _mtx;
 
     ostream *stream;
 
+    FileDescriptorWriter writer;
+
+    /**
+     * Set while the writer is in use. The console flush hook must not flush a writer in the middle of an operation.
+     */
+    bool writerInUse{false};
+
+    /**
+     * Locks the writer and runs action with it.
+     */
+    template<typename F>
+    bool useWriter(F action) {
+        lock_guard<recursive_mutex> lock(_mtx);
+        writerInUse = true;
+        bool result = action();
+        writerInUse = false;
+        return result;
+    }
+
+    /**
+     * Writes the buffered data before a message is printed. Other threads might wait for the hook, while they use the
+     * writer, so it does not wait for the lock. It also skips a flush, if the writer itself prints the message.
+     */
+    void flushBeforeConsoleMessage() {
+        unique_lock<recursive_mutex> lock(_mtx, try_to_lock);
+        if (!lock.owns_lock() || writerInUse)
+            return;
+        writerInUse = true;
+        writer.flush();
+        writerInUse = false;
+    }
+
+    static bool stdoutAndStderrAreTheSame() {
+        struct stat stdoutStat{};
+        struct stat stderrStat{};
+        return fstat(STDOUT_FILENO, &stdoutStat) == 0 && fstat(STDERR_FILENO, &stderrStat) == 0 &&
+               stdoutStat.st_dev == stderrStat.st_dev && stdoutStat.st_ino == stderrStat.st_ino;
+    }
+
+    /**
+     * Before we write the first time, data in the C++ stream needs to be flushed to keep the order of the output.
+     */
+    bool attached{false};
+
+    void attachIfNecessary() {
+        if (attached)
+            return;
+        stream->flush();
+        writer.attach(stream == &std::cout ? STDOUT_FILENO : STDERR_FILENO, stream == &std::cout);
+        attached = true;
+        if (writer.getBufferSize() > 0 && stdoutAndStderrAreTheSame())
+            ErrorAccumulator::setConsoleFlushHook(this, [this]() { flushBeforeConsoleMessage(); });
+    }
+
 public:
 
     static shared_ptr<ConsoleSink> create(ConsoleSinkType type = COUT) {
         return make_shared<ConsoleSink>(type);
     }
 
-    explicit ConsoleSink(ConsoleSinkType type = ConsoleSinkType::COUT) : Sink(true) {
+    explicit ConsoleSink(ConsoleSinkType type = ConsoleSinkType::COUT) :
+            Sink(true),
+            writer(type == COUT ? FileDescriptorWriter::DEFAULT_BUFFER_SIZE : 0) {
         if (type == CERR)
             this->stream = &std::cerr;
         if (type == COUT)
             this->stream = &std::cout;
     }
 
+    ~ConsoleSink() override {
+        ErrorAccumulator::removeConsoleFlushHook(this);
+        flush();
+    }
+
     bool hasLock() override {
         return true;
     }
@@ -52,7 +124,7 @@ public:
         return true;
     }
 
-    int64_t rewind(int64_t nByte) override {
+    int64_t rewind(int64_t /*nByte*/) override {
         return 0;
     }
 
@@ -69,7 +141,8 @@ public:
     }
 
     bool close() override {
-        return true;
+        // Will not actually close the stream but write all buffered data.
+        return useWriter([this]() { return !attached || writer.flush(); });
     }
 
     bool isOpen() override {
@@ -96,6 +169,10 @@ public:
         return false;
     }
 
+    bool canSeekBack() override {
+        return false;
+    }
+
     bool exists() override {
         return true;//stream;
     }
@@ -116,18 +193,18 @@ public:
         return true;// stream;
     }
 
-    int64_t seek(int64_t nByte, bool absolute) override {
+    int64_t seek(int64_t /*nByte*/, bool /*absolute*/) override {
         return 0;
     }
 
-    int64_t skip(int64_t nByte) override {
+    int64_t skip(int64_t /*nByte*/) override {
         return 0;
     }
 
     string toString() override {
         if (stream == &std::cout)
             return "cout";
-        else if (stream == &std::cout)
+        else if (stream == &std::cerr)
             return "cerr";
         else
             return "unknown stream type or no stream";
@@ -142,26 +219,44 @@ public:
     }
 
     void write(const char *message) override {
-        lock_guard<mutex> lock(_mtx);
-        if (stream)
-            *stream << message;
+        write(message, static_cast<int>(strlen(message)));
     }
 
     void write(const char *message, int len) override {
-        lock_guard<mutex> lock(_mtx);
-        if (stream)
-            stream->write(message, len);
+        if (!stream || len <= 0)
+            return;
+        useWriter([&]() {
+            attachIfNecessary();
+            return writer.write(message, static_cast<u_int64_t>(len));
+        });
     }
 
     void write(const string &message) override {
-        lock_guard<mutex> lock(_mtx);
-        if (stream)
-            *stream << message;
+        write(message.c_str(), static_cast<int>(message.length()));
+    }
+
+    void writeSpans(const struct iovec *spans, int count) override {
+        if (!stream)
+            return;
+        useWriter([&]() {
+            attachIfNecessary();
+            bool result = true;
+            for (int i = 0; i < count; i++)
+                result &= writer.write(static_cast<const char *>(spans[i].iov_base), spans[i].iov_len);
+            return result;
+        });
     }
 
     void flush() override {
-        lock_guard<mutex> lock(_mtx);
-        stream->flush();
+        useWriter([this]() {
+            bool result = !attached || writer.flush();
+            stream->flush();
+            return result;
+        });
+    }
+
+    vector<string> getErrorMessages() override {
+        return concatenateVectors(ErrorAccumulator::getErrorMessages(), writer.getErrorMessages());
     }
 };
 
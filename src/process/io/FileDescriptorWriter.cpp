@@ -0,0 +1,201 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#include "FileDescriptorWriter.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+const u_int64_t FileDescriptorWriter::DEFAULT_BUFFER_SIZE = 1024 * 1024;
+
+const int FileDescriptorWriter::PIPE_DRAIN_POLL_TIMEOUT = 1;
+
+bool FileDescriptorWriter::writeAll(int fd, const char *data, u_int64_t length) {
+    while (length > 0) {
+        auto written = ::write(fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        data += written;
+        length -= static_cast<u_int64_t>(written);
+    }
+    return true;
+}
+
+FileDescriptorWriter::FileDescriptorWriter(u_int64_t bufferSize) : bufferSize(bufferSize) {}
+
+FileDescriptorWriter::~FileDescriptorWriter() {
+    detach();
+    free(buffers[0]);
+    free(buffers[1]);
+}
+
+bool FileDescriptorWriter::allocateBuffers() {
+    if (buffers[0])
+        return true;
+    auto pageSize = static_cast<u_int64_t>(sysconf(_SC_PAGESIZE));
+    void *first{nullptr};
+    void *second{nullptr};
+    if (posix_memalign(&first, pageSize, bufferSize) != 0)
+        return false;
+    if (posix_memalign(&second, pageSize, bufferSize) != 0) {
+        free(first);
+        return false;
+    }
+    buffers[0] = static_cast<char *>(first);
+    buffers[1] = static_cast<char *>(second);
+    return true;
+}
+
+void FileDescriptorWriter::attach(int fd, bool trySplice) {
+    detach();
+    this->fd = fd;
+    this->flushedBytes = 0;
+    this->useVMSplice = false;
+    this->pipeSize = 0;
+
+    if (bufferSize > 0 && !allocateBuffers()) {
+        addErrorMessage("Could not allocate the output buffers, data will be written unbuffered.");
+        bufferSize = 0;
+    }
+
+    if (!trySplice || bufferSize == 0)
+        return;
+
+    struct stat fileStat{};
+    if (fstat(fd, &fileStat) != 0 || !S_ISFIFO(fileStat.st_mode))
+        return;
+
+    // The kernel rounds up the pipe size. If it is larger than our buffers, we can't tell, when a buffer is reusable.
+    fcntl(fd, F_SETPIPE_SZ, static_cast<int>(bufferSize));
+    pipeSize = fcntl(fd, F_GETPIPE_SZ);
+    useVMSplice = pipeSize > 0 && static_cast<u_int64_t>(pipeSize) <= bufferSize;
+    if (useVMSplice)
+        debug("Splicing output to pipe with a pipe size of ", to_string(pipeSize), " Bytes.");
+}
+
+bool FileDescriptorWriter::detach() {
+    bool result = true;
+    if (fd >= 0) {
+        result = flush();
+        // The buffers might be used for another descriptor and the owner might close this one.
+        if (bufferMayBeInPipe[0] || bufferMayBeInPipe[1])
+            waitUntilPipeIsDrained();
+    }
+    fd = -1;
+    return result;
+}
+
+void FileDescriptorWriter::waitUntilPipeIsDrained() {
+    // FIONREAD also works for the writing end of a pipe. If the reader is gone, the pages won't be read anymore.
+    // There is no event for an empty pipe. poll() sleeps until the reader made room in a full pipe or closed it, in
+    // all other cases it returns after the timeout.
+    while (true) {
+        int bytesInPipe{0};
+        if (ioctl(fd, FIONREAD, &bytesInPipe) != 0 || bytesInPipe == 0)
+            break;
+        struct pollfd pipeState{fd, static_cast<short>(pipeSize > 0 && bytesInPipe >= pipeSize ? POLLOUT : 0), 0};
+        if (poll(&pipeState, 1, PIPE_DRAIN_POLL_TIMEOUT) > 0 && (pipeState.revents & POLLERR))
+            break;
+    }
+    bufferMayBeInPipe[0] = false;
+    bufferMayBeInPipe[1] = false;
+}
+
+bool FileDescriptorWriter::spliceAll(const char *data, u_int64_t length, u_int64_t *splicedBytes) {
+    *splicedBytes = 0;
+    while (length > 0) {
+        struct iovec span{const_cast<char *>(data), length};
+        auto spliced = vmsplice(fd, &span, 1, 0);
+        if (spliced < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        data += spliced;
+        length -= static_cast<u_int64_t>(spliced);
+        *splicedBytes += static_cast<u_int64_t>(spliced);
+    }
+    return true;
+}
+
+bool FileDescriptorWriter::flushActiveBuffer() {
+    if (bufferFill == 0)
+        return true;
+
+    bool result;
+    if (useVMSplice && bufferFill == bufferSize) {
+        u_int64_t splicedBytes{0};
+        result = spliceAll(buffers[activeBuffer], bufferFill, &splicedBytes);
+        if (splicedBytes > 0)
+            bufferMayBeInPipe[activeBuffer] = true;
+        if (result) {
+            // The pipe can't hold more than this buffer, so all pages of the other buffer were read.
+            bufferMayBeInPipe[1 - activeBuffer] = false;
+        } else {
+            // Some pipes (or kernels) don't support it. Continue with the normal way.
+            useVMSplice = false;
+            result = writeAll(fd, buffers[activeBuffer] + splicedBytes, bufferFill - splicedBytes);
+        }
+    } else {
+        result = writeAll(fd, buffers[activeBuffer], bufferFill);
+        // Without a completely spliced buffer, we don't know anymore, when the other buffer can be reused without
+        // waiting for the reader.
+        useVMSplice = false;
+    }
+
+    if (!result)
+        addErrorMessage("Could not write to file descriptor ", to_string(fd), ": ", strerror(errno));
+
+    flushedBytes += bufferFill;
+    bufferFill = 0;
+    activeBuffer = 1 - activeBuffer;
+    return result;
+}
+
+bool FileDescriptorWriter::write(const char *data, u_int64_t length) {
+    if (fd < 0) {
+        addErrorMessage("BUG: You cannot write to a detached file descriptor writer.");
+        return false;
+    }
+
+    // Large chunks of data don't need to go through the buffer, unless we splice them.
+    if (bufferSize == 0 || (bufferFill == 0 && length >= bufferSize && !useVMSplice)) {
+        bool result = writeAll(fd, data, length);
+        if (!result)
+            addErrorMessage("Could not write to file descriptor ", to_string(fd), ": ", strerror(errno));
+        flushedBytes += length;
+        return result;
+    }
+
+    bool result = true;
+    while (length > 0) {
+        if (bufferFill == 0 && bufferMayBeInPipe[activeBuffer])
+            waitUntilPipeIsDrained();
+        u_int64_t copy = min(length, bufferSize - bufferFill);
+        memcpy(buffers[activeBuffer] + bufferFill, data, copy);
+        bufferFill += copy;
+        data += copy;
+        length -= copy;
+        if (bufferFill == bufferSize)
+            result &= flushActiveBuffer();
+    }
+    return result;
+}
+
+bool FileDescriptorWriter::flush() {
+    if (fd < 0)
+        return true;
+    return flushActiveBuffer();
+}
@@ -0,0 +1,137 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#ifndef FASTQINDEX_FILEDESCRIPTORWRITER_H
+#define FASTQINDEX_FILEDESCRIPTORWRITER_H
+
+#include "common/ErrorAccumulator.h"
+#include <string>
+#include <sys/types.h>
+
+using namespace std;
+
+/**
+ * Buffered writer for a plain file descriptor. This is the common base for the file and console sinks and replaces the
+ * iostream layer, which was used before.
+ *
+ * The writer collects data in page aligned buffers and writes them with large write() calls. If the descriptor is a
+ * pipe and splicing is requested, full buffers are passed to the pipe with vmsplice(). This saves the copy of the data
+ * into the pipe. vmsplice() only references the pages, so a buffer must not be reused before the reader consumed it.
+ * To make sure of this, the writer uses two buffers and sets the pipe size to the buffer size: If one buffer was
+ * spliced completely, the pipe can't contain any page of the other buffer anymore. In all other cases (a partial flush,
+ * a failed splice or a detach), the writer waits until the pipe is drained, before a spliced buffer is reused.
+ *
+ * The writer does not own the file descriptor, it will not close it.
+ */
+class FileDescriptorWriter : public ErrorAccumulator {
+
+private:
+
+    int fd{-1};
+
+    u_int64_t bufferSize{0};
+
+    char *buffers[2]{nullptr, nullptr};
+
+    int activeBuffer{0};
+
+    /**
+     * Set for a buffer, which was spliced and whose pages might still be referenced by the pipe.
+     */
+    bool bufferMayBeInPipe[2]{false, false};
+
+    u_int64_t bufferFill{0};
+
+    u_int64_t flushedBytes{0};
+
+    bool useVMSplice{false};
+
+    /**
+     * The size of the pipe, as far as it is known.
+     */
+    int pipeSize{0};
+
+    bool allocateBuffers();
+
+    /**
+     * Writes the active buffer to the file descriptor and switches to the other buffer.
+     */
+    bool flushActiveBuffer();
+
+    /**
+     * @param splicedBytes Receives the number of spliced Bytes, also if splicing fails.
+     */
+    bool spliceAll(const char *data, u_int64_t length, u_int64_t *splicedBytes);
+
+    /**
+     * The time in milliseconds, for which waitUntilPipeIsDrained() sleeps in poll() before it looks at the pipe again.
+     */
+    static const int PIPE_DRAIN_POLL_TIMEOUT;
+
+    /**
+     * Waits until the reader consumed all data in the pipe or closed the pipe. Afterwards, no buffer is referenced by
+     * the pipe anymore.
+     */
+    void waitUntilPipeIsDrained();
+
+public:
+
+    /**
+     * The default buffer size of 1MB. Needs to be a power of two and a multiple of the page size for splicing.
+     */
+    static const u_int64_t DEFAULT_BUFFER_SIZE;
+
+    /**
+     * Writes all Bytes to fd. Interrupted and partial writes are repeated.
+     * @return true, if all data was written.
+     */
+    static bool writeAll(int fd, const char *data, u_int64_t length);
+
+    /**
+     * @param bufferSize The size of each of the two buffers. With a size of 0, all data is written directly.
+     */
+    explicit FileDescriptorWriter(u_int64_t bufferSize = DEFAULT_BUFFER_SIZE);
+
+    ~FileDescriptorWriter() override;
+
+    /**
+     * Sets the file descriptor to write to. Buffered data for a previous descriptor is written first.
+     * @param trySplice Use vmsplice(), if fd is a pipe and the pipe size can be set to the buffer size.
+     */
+    void attach(int fd, bool trySplice = false);
+
+    /**
+     * Writes all buffered data and detaches the file descriptor. If buffers were spliced, this waits until the reader
+     * consumed them.
+     */
+    bool detach();
+
+    int getFileDescriptor() { return fd; }
+
+    u_int64_t getBufferSize() { return bufferSize; }
+
+    bool isUsingVMSplice() { return useVMSplice; }
+
+    /**
+     * The number of Bytes which are held in the buffer and were not written yet.
+     */
+    u_int64_t getBufferedBytes() { return bufferFill; }
+
+    /**
+     * The number of Bytes passed to this writer since it was attached, including buffered data.
+     */
+    u_int64_t getTotalBytes() { return flushedBytes + bufferFill; }
+
+    bool write(const char *data, u_int64_t length);
+
+    /**
+     * Writes all buffered data to the file descriptor. Note, that a partially filled buffer is never spliced, as the
+     * buffer could then be reused too early.
+     */
+    bool flush();
+};
+
+#endif //FASTQINDEX_FILEDESCRIPTORWRITER_H
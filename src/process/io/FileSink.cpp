@@ -6,7 +6,11 @@
 
 #include "FileSink.h"
 
+#include <cerrno>
+#include <cstring>
 #include <experimental/filesystem>
+#include <fcntl.h>
+#include <sys/stat.h>
 
 using namespace std;
 using namespace std::experimental::filesystem;
@@ -17,6 +21,10 @@ FileSink::FileSink(const path &file, bool forceOverwrite) :
         lockHandler(file) {
 }
 
+FileSink::~FileSink() {
+    close();
+}
+
 bool FileSink::fulfillsPremises() {
     if (!forceOverwrite && exists()) {
         addErrorMessage(
@@ -30,9 +38,30 @@ bool FileSink::fulfillsPremises() {
 }
 
 bool FileSink::open() {
-    if (!isOpen())
-        this->fStream.open(file, ios_base::out | ios_base::in | ios_base::binary);
-    return isOpen();
+    if (isOpen())
+        return true;
+
+    // Like before with the fstream (in | out), the file is neither created nor truncated here. This is done by the
+    // lock handler.
+    return openFile(file, false);
+}
+
+bool FileSink::openFile(const path &fileToOpen, bool create, mode_t mode) {
+    fd = ::open(fileToOpen.c_str(), O_RDWR | O_CLOEXEC | (create ? O_CREAT | O_TRUNC : 0), mode);
+    if (fd < 0) {
+        lastErrorNumber = errno;
+        return false;
+    }
+    lastErrorNumber = 0;
+
+    if (preallocationSize > 0) {
+        // Keep the size, so we don't need to truncate the file later. Not all file systems support this, just go on.
+        if (fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(preallocationSize)) != 0)
+            debug("Could not preallocate ", to_string(preallocationSize), " Bytes for file '", fileToOpen.string(), "'.");
+    }
+
+    writer.attach(fd);
+    return true;
 }
 
 bool FileSink::openWithWriteLock() {
@@ -46,6 +75,36 @@ bool FileSink::openWithWriteLock() {
     return true;
 }
 
+bool FileSink::openForPublishing() {
+    if (isOpen())
+        return true;
+
+    struct stat fileStat{};
+    bool fileExists = stat(file.c_str(), &fileStat) == 0;
+    if (fileExists && !S_ISREG(fileStat.st_mode)) {
+        if (!openFile(file, false)) {
+            addErrorMessage("Could not open '", file.string(), "' for writing: ", strerror(lastErrorNumber));
+            return false;
+        }
+        return true;
+    }
+
+    // Like the IndexCache downloads, each process uses its own file. The file gets the permissions of the replaced
+    // file right away, so it is never readable for more users than the old one. They are set again after the open, as
+    // the umask might have removed some of them.
+    temporaryFile = file.string() + ".incomplete." + to_string(getpid());
+    mode_t mode = fileExists ? fileStat.st_mode & 07777 : 0666;
+    if (!openFile(temporaryFile, true, mode) || (fileExists && fchmod(fd, mode) != 0)) {
+        lastErrorNumber = errno;
+        addErrorMessage("Could not create the temporary file '", temporaryFile.string(), "': ", strerror(lastErrorNumber));
+        if (isOpen())
+            closeWithoutPublishing();
+        temporaryFile.clear();
+        return false;
+    }
+    return true;
+}
+
 void FileSink::write(const char *message) {
     write(string(message));
 }
@@ -55,42 +114,94 @@ void FileSink::write(const char *message, int streamSize) {
         addErrorMessage("BUG: You cannot write to a closed file.");
         return;
     }
-    this->fStream.write(message, streamSize);
+    if (streamSize > 0 && !writer.write(message, static_cast<u_int64_t>(streamSize)))
+        lastErrorNumber = errno;
 }
 
 void FileSink::write(const string &message) {
+    write(message.c_str(), static_cast<int>(message.length()));
+}
+
+void FileSink::writeSpans(const struct iovec *spans, int count) {
     if (!isOpen()) {
         addErrorMessage("BUG: You cannot write to a closed file.");
         return;
     }
-    this->fStream.write(message.c_str(), message.length());
+    for (int i = 0; i < count; i++) {
+        if (!writer.write(static_cast<const char *>(spans[i].iov_base), spans[i].iov_len))
+            lastErrorNumber = errno;
+    }
+}
+
+bool FileSink::sync() {
+    if (fsync(fd) == 0)
+        return true;
+    lastErrorNumber = errno;
+    addErrorMessage("Could not sync file '", file.string(), "' to disk.");
+    return false;
 }
 
 void FileSink::flush() {
-    if (fStream && fStream.is_open()) {
-        fStream.flush();
-    }
+    if (!isOpen())
+        return;
+    if (!writer.flush())
+        lastErrorNumber = errno;
+    if (syncPolicy == SYNC_ON_FLUSH)
+        sync();
 }
 
 bool FileSink::close() {
-    if (fStream.is_open())
-        fStream.close();
+    bool result = true;
+    if (isOpen()) {
+        result = writer.detach();
+        // Published files are always synced, otherwise a crash after the rename might leave an empty file behind.
+        if (syncPolicy != SYNC_NEVER || isPublishing())
+            result &= sync();
+        result &= ::close(fd) == 0;
+        fd = -1;
+    }
+    if (isPublishing()) {
+        std::error_code errorCode;
+        result &= isGood();
+        if (result)
+            rename(temporaryFile, file, errorCode);
+        if (!result || errorCode) {
+            addErrorMessage("Could not publish '", file.string(), "', the written data is discarded.");
+            remove(temporaryFile, errorCode);
+            result = false;
+        }
+        temporaryFile.clear();
+    }
     if (lockHandler.hasLock())
         lockHandler.unlock();
-    return true;
+    return result;
+}
+
+bool FileSink::closeWithoutPublishing() {
+    if (!isPublishing())
+        return close();
 
+    writer.detach();
+    ::close(fd);
+    fd = -1;
+    std::error_code errorCode;
+    remove(temporaryFile, errorCode);
+    temporaryFile.clear();
+    if (lockHandler.hasLock())
+        lockHandler.unlock();
+    return true;
 }
 
 bool FileSink::isOpen() {
-    return fStream.is_open();
+    return fd >= 0;
 }
 
 bool FileSink::eof() {
-    return fStream.eof();
+    return false;
 }
 
 bool FileSink::isGood() {
-    return fStream.good();
+    return lastErrorNumber == 0;
 }
 
 bool FileSink::isFile() {
@@ -105,11 +216,23 @@ bool FileSink::isSymlink() {
     return false;
 }
 
+bool FileSink::canSeekBack() {
+    std::error_code errorCode;
+    auto fileStatus = status(file, errorCode);
+    return !is_fifo(fileStatus) && !is_character_file(fileStatus) && !is_socket(fileStatus);
+}
+
 bool FileSink::exists() {
     return std::experimental::filesystem::exists(file);
 }
 
 int64_t FileSink::size() {
+    if (isOpen()) {
+        // Also respect the data in the write buffer.
+        struct stat fileStat{};
+        fstat(fd, &fileStat);
+        return max(static_cast<int64_t>(fileStat.st_size), tell());
+    }
     if (exists())
         return file_size(file);
     return 0;
@@ -128,17 +251,28 @@ bool FileSink::canWrite() {
 }
 
 int64_t FileSink::seek(int64_t nByte, bool absolute) {
+    // Reopening would publish an incomplete file.
+    if (lastError() && isPublishing())
+        return 0;
+
     if (lastError()) {
         // Seek / Read can run over file borders and it might be necessary to just reopen it. We do this here.
         close();
         if (!open()) return 0;
     }
 
-    if (absolute)
-        fStream.seekg(nByte, std::ifstream::beg);
-    else
-        fStream.seekg(nByte, std::ifstream::cur);
-    return (!fStream.fail() && !fStream.bad()) ? 1 : 0;
+    if (!isOpen())
+        return 0;
+
+    if (!writer.flush()) {
+        lastErrorNumber = errno;
+        return 0;
+    }
+    if (lseek(fd, nByte, absolute ? SEEK_SET : SEEK_CUR) < 0) {
+        lastErrorNumber = errno;
+        return 0;
+    }
+    return 1;
 }
 
 int64_t FileSink::skip(int64_t nBytes) {
@@ -150,17 +284,18 @@ string FileSink::toString() {
 }
 
 int64_t FileSink::tell() {
-    if (fStream.is_open())
-        return fStream.tellg();
-    return 0;
+    if (!isOpen())
+        return 0;
+    return lseek(fd, 0, SEEK_CUR) + static_cast<int64_t>(writer.getBufferedBytes());
 }
 
 int FileSink::lastError() {
-    return fStream.fail() || fStream.bad();
+    return lastErrorNumber;
 }
 
 vector<string> FileSink::getErrorMessages() {
-    return concatenateVectors(ErrorAccumulator::getErrorMessages(), lockHandler.getErrorMessages());
+    return concatenateVectors(ErrorAccumulator::getErrorMessages(), writer.getErrorMessages(),
+                              lockHandler.getErrorMessages());
 }
 
 bool FileSink::hasLock() {
@@ -9,25 +9,67 @@
 
 #include "Sink.h"
 #include "common/IOHelper.h"
+#include "process/io/FileDescriptorWriter.h"
 #include "process/io/locks/LockHandler.h"
 #include "process/io/locks/FileLockHandler.h"
 #include <experimental/filesystem>
-#include <fstream>
+#include <memory>
 #include <unistd.h>
 
 using namespace std;
 using namespace std::experimental::filesystem;
 
+/**
+ * Defines, when the written data is synced to the disk with fsync().
+ */
+enum FileSyncPolicy {
+    SYNC_NEVER,
+    SYNC_ON_CLOSE,
+    SYNC_ON_FLUSH
+};
+
+/**
+ * Sink for local files. The sink works directly on a file descriptor and buffers the written data in large buffers.
+ */
 class FileSink : public Sink {
 
 private:
 
     path file;
 
-    std::fstream fStream;
+    int fd{-1};
+
+    /**
+     * The errno of the last failed operation or 0.
+     */
+    int lastErrorNumber{0};
+
+    FileDescriptorWriter writer;
+
+    /**
+     * If set, the file system will be asked to reserve this amount of space when the file is opened. This reduces
+     * fragmentation for large files. The file size is not changed by this.
+     */
+    u_int64_t preallocationSize{0};
+
+    FileSyncPolicy syncPolicy{SYNC_NEVER};
 
     FileLockHandler lockHandler;
 
+    /**
+     * Set, if the sink was opened with openForPublishing(). The data is written to this file and renamed to the target
+     * file on close().
+     */
+    path temporaryFile;
+
+    bool sync();
+
+    /**
+     * Opens the file descriptor for the given file. The file must exist, if create is not set.
+     * @param mode The permissions for a created file, the umask is applied.
+     */
+    bool openFile(const path &fileToOpen, bool create, mode_t mode = 0666);
+
 public:
 
     static shared_ptr<FileSink> from(const path &file, bool forceOverwrite = false) {
@@ -36,12 +78,45 @@ public:
 
     explicit FileSink(const path &file, bool forceOverwrite = false);
 
+    ~FileSink() override;
+
+    /**
+     * Set this before the file is opened.
+     */
+    void setPreallocationSize(u_int64_t size) { preallocationSize = size; }
+
+    u_int64_t getPreallocationSize() { return preallocationSize; }
+
+    void setSyncPolicy(FileSyncPolicy policy) { syncPolicy = policy; }
+
+    FileSyncPolicy getSyncPolicy() { return syncPolicy; }
+
     bool fulfillsPremises() override;
 
     bool open() override;
 
     bool openWithWriteLock() override;
 
+    /**
+     * Writes to a temporary file next to the target file, which is renamed to the target file on close(). The rename is
+     * atomic, readers see either the old file or the complete new one and don't need a lock. Concurrent writers don't
+     * block each other, the last one wins.
+     *
+     * Named pipes and devices like /dev/stdout can't be replaced, they are written directly. Symlinks are resolved when
+     * the sink is created, so the file behind a link is replaced and the link is kept. The new file gets the
+     * permissions of the replaced file.
+     */
+    bool openForPublishing() override;
+
+    /**
+     * Removes the temporary file, if the sink is publishing. The target file is not touched.
+     */
+    bool closeWithoutPublishing() override;
+
+    bool isPublishing() { return !temporaryFile.empty(); }
+
+    path getTemporaryFile() { return temporaryFile; }
+
     path getPath() {
         return file;
     }
@@ -56,6 +131,8 @@ public:
 
     void write(const string &message) override;
 
+    void writeSpans(const struct iovec *spans, int count) override;
+
     void flush() override;
 
     bool close() override;
@@ -72,6 +149,11 @@ public:
 
     bool isSymlink() override;
 
+    /**
+     * False for named pipes and devices like /dev/stdout.
+     */
+    bool canSeekBack() override;
+
     bool exists() override;
 
     int64_t size() override;
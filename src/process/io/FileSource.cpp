@@ -5,6 +5,9 @@
  */
 
 #include "FileSource.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
 
 FileSource::FileSource(const path &file) : file(IOHelper::fullPath(file)), lockHandler(file) {
 //    fStream = std::ifstream(file, std::ifstream::binary);
@@ -36,6 +39,8 @@ bool FileSource::open() {
         fStream.open(file);
         std::ifstream(file, std::ifstream::binary);
     }
+    if (fStream.is_open() && positionalReadFD < 0)
+        positionalReadFD = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
     return fStream.is_open();
 }
 
@@ -49,6 +54,10 @@ bool FileSource::openWithReadLock() {
 bool FileSource::close() {
     if (fStream.is_open())
         fStream.close();
+    if (positionalReadFD >= 0) {
+        ::close(positionalReadFD);
+        positionalReadFD = -1;
+    }
     if (lockHandler.hasLock())
         lockHandler.unlock();
     return true;
@@ -60,6 +69,33 @@ int64_t FileSource::read(Bytef *targetBuffer, int numberOfBytes) {
     return amountRead;
 }
 
+int64_t FileSource::readAt(int64_t offset, Bytef *targetBuffer, int64_t length) {
+    if (positionalReadFD < 0)
+        return -1;
+    int64_t totalRead = 0;
+    while (totalRead < length) {
+        auto result = pread(positionalReadFD, targetBuffer + totalRead, static_cast<size_t>(length - totalRead),
+                            static_cast<off_t>(offset + totalRead));
+        if (result < 0) {
+            if (errno == EINTR)
+                continue;
+            return totalRead > 0 ? totalRead : -1;
+        }
+        if (result == 0)
+            break; // End of file
+        totalRead += result;
+    }
+    return totalRead;
+}
+
+void FileSource::adviseRange(int64_t offset, int64_t length) {
+    if (positionalReadFD < 0)
+        return;
+    posix_fadvise(positionalReadFD, 0, 0, POSIX_FADV_SEQUENTIAL);
+    if (length > 0)
+        posix_fadvise(positionalReadFD, offset, length, POSIX_FADV_WILLNEED);
+}
+
 int FileSource::readChar() {
     Byte result = 0;
     int res = static_cast<int>(this->read(&result, 1));
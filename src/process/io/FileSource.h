@@ -25,6 +25,12 @@ private:
 
     std::ifstream fStream;
 
+    /**
+     * A second handle for the file, used for positional reads with pread(). As pread() does not change the file
+     * offset, the handle can be shared by all threads which use readAt().
+     */
+    int positionalReadFD{-1};
+
     FileLockHandler lockHandler;
 
 public:
@@ -79,6 +85,21 @@ public:
 
     int readChar() override;
 
+    /**
+     * Thread safe positional read with pread(). Needs an open source.
+     */
+    int64_t readAt(int64_t offset, Bytef *targetBuffer, int64_t length) override;
+
+    /**
+     * The file will be read sequentially. If length is set, the kernel is asked to load the range in advance.
+     */
+    void adviseRange(int64_t offset, int64_t length) override;
+
+    /**
+     * The descriptor used for positional reads, -1 if the source is not open.
+     */
+    int getFileDescriptor() { return positionalReadFD; }
+
     int64_t seek(int64_t nByte, bool absolute) override;
 
     int64_t skip(int64_t nBytes) override;
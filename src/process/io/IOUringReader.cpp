@@ -0,0 +1,143 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#include "IOUringReader.h"
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+
+IOUringReader::~IOUringReader() {
+    release();
+}
+
+void IOUringReader::release() {
+    if (submissionEntries)
+        munmap(submissionEntries, submissionEntriesSize);
+    if (completionRing && completionRing != submissionRing)
+        munmap(completionRing, completionRingSize);
+    if (submissionRing)
+        munmap(submissionRing, submissionRingSize);
+    if (ringFD >= 0)
+        close(ringFD);
+    submissionEntries = nullptr;
+    completionRing = nullptr;
+    submissionRing = nullptr;
+    ringFD = -1;
+}
+
+bool IOUringReader::initialize(unsigned queueDepth) {
+    struct io_uring_params params{};
+    ringFD = static_cast<int>(syscall(__NR_io_uring_setup, queueDepth, &params));
+    if (ringFD < 0) {
+        ringFD = -1;
+        debug("io_uring is not available: ", strerror(errno));
+        return false;
+    }
+    entries = params.sq_entries;
+
+    submissionRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    completionRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool singleMMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMMap)
+        submissionRingSize = completionRingSize = max(submissionRingSize, completionRingSize);
+
+    submissionRing = mmap(nullptr, submissionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFD,
+                          IORING_OFF_SQ_RING);
+    if (submissionRing == MAP_FAILED) {
+        submissionRing = nullptr;
+        release();
+        return false;
+    }
+
+    if (singleMMap) {
+        completionRing = submissionRing;
+    } else {
+        completionRing = mmap(nullptr, completionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFD,
+                              IORING_OFF_CQ_RING);
+        if (completionRing == MAP_FAILED) {
+            completionRing = nullptr;
+            release();
+            return false;
+        }
+    }
+
+    submissionEntriesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    auto sqes = mmap(nullptr, submissionEntriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFD,
+                     IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        release();
+        return false;
+    }
+    submissionEntries = static_cast<struct io_uring_sqe *>(sqes);
+
+    auto sq = static_cast<char *>(submissionRing);
+    sqHead = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sqMask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+
+    auto cq = static_cast<char *>(completionRing);
+    cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cqMask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    completionEntries = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+    return true;
+}
+
+bool IOUringReader::submitRead(int fd, const struct iovec *target, u_int64_t offset, u_int64_t userData) {
+    unsigned tail = *sqTail;
+    unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+    if (tail - head >= entries) {
+        addErrorMessage("BUG: The io_uring submission queue is full.");
+        return false;
+    }
+
+    unsigned index = tail & *sqMask;
+    struct io_uring_sqe *entry = &submissionEntries[index];
+    memset(entry, 0, sizeof(*entry));
+    // READV instead of READ is supported by older kernels as well.
+    entry->opcode = IORING_OP_READV;
+    entry->fd = fd;
+    entry->addr = reinterpret_cast<u_int64_t>(target);
+    entry->len = 1;
+    entry->off = offset;
+    entry->user_data = userData;
+    sqArray[index] = index;
+    __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+
+    while (true) {
+        auto submitted = syscall(__NR_io_uring_enter, ringFD, 1, 0, 0, nullptr, 0);
+        if (submitted >= 0)
+            return true;
+        if (errno != EINTR && errno != EAGAIN) {
+            addErrorMessage("Could not submit a read to io_uring: ", strerror(errno));
+            return false;
+        }
+    }
+}
+
+bool IOUringReader::waitForCompletion(u_int64_t *userData, int32_t *result) {
+    while (true) {
+        unsigned head = *cqHead;
+        if (head != __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+            struct io_uring_cqe *entry = &completionEntries[head & *cqMask];
+            *userData = entry->user_data;
+            *result = entry->res;
+            __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+            return true;
+        }
+        auto waited = syscall(__NR_io_uring_enter, ringFD, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+        if (waited < 0 && errno != EINTR && errno != EAGAIN) {
+            addErrorMessage("Could not wait for io_uring completions: ", strerror(errno));
+            return false;
+        }
+    }
+}
@@ -0,0 +1,81 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#ifndef FASTQINDEX_IOURINGREADER_H
+#define FASTQINDEX_IOURINGREADER_H
+
+#include "common/ErrorAccumulator.h"
+#include <cstdint>
+#include <linux/io_uring.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+/**
+ * Minimal wrapper around an io_uring instance, which is only capable of asynchronous reads. It uses the raw system
+ * calls, so we don't need liburing as an additional dependency.
+ *
+ * The class is not thread safe, submission and completion have to happen on the same thread.
+ */
+class IOUringReader : public ErrorAccumulator {
+
+private:
+
+    int ringFD{-1};
+
+    void *submissionRing{nullptr};
+
+    size_t submissionRingSize{0};
+
+    void *completionRing{nullptr};
+
+    size_t completionRingSize{0};
+
+    struct io_uring_sqe *submissionEntries{nullptr};
+
+    size_t submissionEntriesSize{0};
+
+    unsigned *sqHead{nullptr};
+    unsigned *sqTail{nullptr};
+    unsigned *sqMask{nullptr};
+    unsigned *sqArray{nullptr};
+
+    unsigned *cqHead{nullptr};
+    unsigned *cqTail{nullptr};
+    unsigned *cqMask{nullptr};
+    struct io_uring_cqe *completionEntries{nullptr};
+
+    unsigned entries{0};
+
+    void release();
+
+public:
+
+    IOUringReader() = default;
+
+    ~IOUringReader() override;
+
+    /**
+     * Sets up the ring. Fails, if io_uring is not supported by the kernel or forbidden (e.g. in some containers).
+     * @param queueDepth The maximum number of reads in flight.
+     */
+    bool initialize(unsigned queueDepth);
+
+    bool isInitialized() { return ringFD >= 0; }
+
+    /**
+     * Queues and submits a read. The iovec needs to stay valid until the read is completed.
+     * @param userData Will be passed back by waitForCompletion().
+     */
+    bool submitRead(int fd, const struct iovec *target, u_int64_t offset, u_int64_t userData);
+
+    /**
+     * Waits for the next completed read.
+     * @param result The result of the read, like for pread(): The number of read Bytes or -errno.
+     */
+    bool waitForCompletion(u_int64_t *userData, int32_t *result);
+};
+
+#endif //FASTQINDEX_IOURINGREADER_H
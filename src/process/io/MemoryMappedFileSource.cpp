@@ -0,0 +1,128 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#include "MemoryMappedFileSource.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MemoryMappedFileSource::~MemoryMappedFileSource() {
+    close();
+}
+
+bool MemoryMappedFileSource::fulfillsPremises() {
+    if (!exists()) {
+        addErrorMessage("File ", toString(), " does not exist.");
+        return false;
+    }
+    return true;
+}
+
+bool MemoryMappedFileSource::open() {
+    if (_isOpen)
+        return true;
+
+    int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        lastErrorNumber = errno;
+        addErrorMessage("Could not open '", toString(), "': ", strerror(lastErrorNumber));
+        return false;
+    }
+
+    struct stat fileStatus{};
+    if (fstat(fd, &fileStatus) != 0) {
+        lastErrorNumber = errno;
+        ::close(fd);
+        addErrorMessage("Could not determine the size of '", toString(), "'.");
+        return false;
+    }
+    mappedSize = fileStatus.st_size;
+
+    // mmap() refuses empty mappings, empty files are handled without one.
+    if (mappedSize > 0) {
+        void *mapping = mmap(nullptr, static_cast<size_t>(mappedSize), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            lastErrorNumber = errno;
+            ::close(fd);
+            addErrorMessage("Could not map '", toString(), "' into memory: ", strerror(lastErrorNumber));
+            return false;
+        }
+        // The advice values are no flags, they can't be combined.
+        madvise(mapping, static_cast<size_t>(mappedSize), MADV_SEQUENTIAL);
+        madvise(mapping, static_cast<size_t>(mappedSize), MADV_WILLNEED);
+        data = static_cast<const Bytef *>(mapping);
+    }
+    // The mapping stays valid without the descriptor.
+    ::close(fd);
+
+    position = 0;
+    lastErrorNumber = 0;
+    _isOpen = true;
+    return true;
+}
+
+bool MemoryMappedFileSource::close() {
+    if (data)
+        munmap(const_cast<Bytef *>(data), static_cast<size_t>(mappedSize));
+    data = nullptr;
+    _isOpen = false;
+    return true;
+}
+
+int64_t MemoryMappedFileSource::size() {
+    if (_isOpen)
+        return mappedSize;
+    return exists() ? static_cast<int64_t>(file_size(file)) : 0;
+}
+
+int64_t MemoryMappedFileSource::readAt(int64_t offset, Bytef *targetBuffer, int64_t length) {
+    if (!_isOpen || offset < 0)
+        return -1;
+    int64_t available = min(length, mappedSize - offset);
+    if (available <= 0)
+        return 0;
+    memcpy(targetBuffer, data + offset, static_cast<size_t>(available));
+    return available;
+}
+
+int64_t MemoryMappedFileSource::read(Bytef *targetBuffer, int numberOfBytes) {
+    int64_t result = readAt(position, targetBuffer, numberOfBytes);
+    if (result > 0) {
+        position += result;
+        totalReadBytes += result;
+    }
+    return result;
+}
+
+int64_t MemoryMappedFileSource::readView(const Bytef **view, Bytef * /*fallbackBuffer*/, int64_t maximumBytes) {
+    if (!_isOpen)
+        return -1;
+    int64_t available = min(maximumBytes, mappedSize - position);
+    if (available <= 0)
+        return 0;
+    *view = data + position;
+    position += available;
+    totalReadBytes += available;
+    return available;
+}
+
+int MemoryMappedFileSource::readChar() {
+    if (!_isOpen || position >= mappedSize)
+        return -1;
+    totalReadBytes++;
+    return data[position++];
+}
+
+int64_t MemoryMappedFileSource::seek(int64_t nByte, bool absolute) {
+    int64_t target = absolute ? nByte : position + nByte;
+    if (target < 0)
+        return -1;
+    position = target;
+    return 1;
+}
@@ -0,0 +1,99 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#ifndef FASTQINDEX_MEMORYMAPPEDFILESOURCE_H
+#define FASTQINDEX_MEMORYMAPPEDFILESOURCE_H
+
+#include "process/io/Source.h"
+#include <memory>
+
+/**
+ * Read only source for a local file, which is mapped into memory. All reads are simple memory copies and readView()
+ * does not copy at all. Meant for files which don't change while they are open, like the files in the IndexCache.
+ *
+ * The source does not lock the file, openWithReadLock() is the same as open().
+ */
+class MemoryMappedFileSource : public Source {
+
+private:
+
+    path file;
+
+    const Bytef *data{nullptr};
+
+    int64_t mappedSize{0};
+
+    int64_t position{0};
+
+    bool _isOpen{false};
+
+    int lastErrorNumber{0};
+
+public:
+
+    static shared_ptr<MemoryMappedFileSource> from(const path &file) {
+        return make_shared<MemoryMappedFileSource>(file);
+    }
+
+    explicit MemoryMappedFileSource(const path &file) : file(file) {}
+
+    ~MemoryMappedFileSource() override;
+
+    bool fulfillsPremises() override;
+
+    bool open() override;
+
+    bool openWithReadLock() override { return open(); }
+
+    bool close() override;
+
+    bool isOpen() override { return _isOpen; }
+
+    bool eof() override { return position >= size(); }
+
+    bool isGood() override { return lastErrorNumber == 0; }
+
+    bool isFile() override { return true; }
+
+    bool isStream() override { return false; }
+
+    bool isSymlink() override { return is_symlink(symlink_status(file)); }
+
+    bool exists() override { return v1::exists(file); }
+
+    int64_t size() override;
+
+    bool empty() override { return size() == 0; }
+
+    bool canRead() override { return _isOpen && position < mappedSize; }
+
+    bool canWrite() override { return false; }
+
+    int64_t read(Bytef *targetBuffer, int numberOfBytes) override;
+
+    int64_t readView(const Bytef **view, Bytef *fallbackBuffer, int64_t maximumBytes) override;
+
+    int readChar() override;
+
+    /**
+     * Thread safe, as the mapping is never changed while the source is open.
+     */
+    int64_t readAt(int64_t offset, Bytef *targetBuffer, int64_t length) override;
+
+    int64_t seek(int64_t nByte, bool absolute) override;
+
+    int64_t skip(int64_t nBytes) override { return seek(nBytes, false); }
+
+    int64_t tell() override { return position; }
+
+    string toString() override { return file.string(); }
+
+    int lastError() override { return lastErrorNumber; }
+
+    path getPath() { return file; }
+};
+
+#endif //FASTQINDEX_MEMORYMAPPEDFILESOURCE_H
@@ -0,0 +1,380 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#include "ReadAheadSource.h"
+#include "common/Tracer.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+const uint ReadAheadSource::DEFAULT_NUMBER_OF_BUFFERS = 4;
+
+const u_int64_t ReadAheadSource::DEFAULT_BUFFER_SIZE = 4 * 1024 * 1024;
+
+shared_ptr<Source> ReadAheadSource::wrapIfPossible(const shared_ptr<Source> &source) {
+    if (dynamic_pointer_cast<FileSource>(source))
+        return ReadAheadSource::from(source);
+    return source;
+}
+
+ReadAheadSource::ReadAheadSource(const shared_ptr<Source> &source,
+                                 uint numberOfBuffers,
+                                 u_int64_t bufferSize,
+                                 ReadAheadBackend backend) :
+        source(source),
+        fileSource(dynamic_pointer_cast<FileSource>(source)),
+        bufferSize(bufferSize > 0 ? bufferSize : DEFAULT_BUFFER_SIZE),
+        requestedBackend(backend),
+        readAheadExtension(static_cast<int64_t>(this->bufferSize)) {
+    buffers.resize(max(numberOfBuffers, 1U));
+}
+
+ReadAheadSource::~ReadAheadSource() {
+    close();
+    for (auto &buffer : buffers)
+        free(buffer.data);
+}
+
+bool ReadAheadSource::open() {
+    if (sourceIsOpen)
+        return true;
+    if (!source->open())
+        return false;
+    return startBackend();
+}
+
+bool ReadAheadSource::openWithReadLock() {
+    if (sourceIsOpen)
+        return source->openWithReadLock();
+    if (!source->openWithReadLock())
+        return false;
+    return startBackend();
+}
+
+bool ReadAheadSource::startBackend() {
+    auto pageSize = static_cast<u_int64_t>(sysconf(_SC_PAGESIZE));
+    for (auto &buffer : buffers) {
+        if (buffer.data)
+            continue;
+        void *memory{nullptr};
+        if (posix_memalign(&memory, pageSize, bufferSize) != 0) {
+            addErrorMessage("Could not allocate the read ahead buffers for '", source->toString(), "'.");
+            return false;
+        }
+        buffer.data = static_cast<Bytef *>(memory);
+    }
+
+    sourceSize = source->size();
+    nextRequestOffset = source->tell();
+    consumerBuffer = 0;
+    assignedBuffers = 0;
+    cursor = 0;
+    readFailed = false;
+
+    activeBackend = READ_AHEAD_THREADS;
+    if (requestedBackend != READ_AHEAD_THREADS && fileSource && fileSource->getFileDescriptor() >= 0) {
+        ring = make_unique<IOUringReader>();
+        if (ring->initialize(static_cast<unsigned>(buffers.size()))) {
+            activeBackend = READ_AHEAD_IO_URING;
+        } else {
+            ring.reset();
+            debug("Falling back to worker threads for reading '", source->toString(), "'.");
+        }
+    }
+
+    if (activeBackend == READ_AHEAD_THREADS) {
+        stopWorkers = false;
+        // Local disks don't profit from many parallel reads, remote sources like S3 need one request per buffer.
+        auto numberOfWorkers = static_cast<uint>(buffers.size());
+        if (fileSource)
+            numberOfWorkers = min(numberOfWorkers, 4U);
+        for (uint i = 0; i < numberOfWorkers; i++)
+            workers.emplace_back(&ReadAheadSource::workerLoop, this);
+    }
+
+    sourceIsOpen = true;
+    return true;
+}
+
+void ReadAheadSource::stopBackend() {
+    drain();
+    {
+        lock_guard<mutex> lock(bufferMutex);
+        stopWorkers = true;
+    }
+    requestAvailable.notify_all();
+    for (auto &worker : workers)
+        worker.join();
+    workers.clear();
+    ring.reset();
+}
+
+bool ReadAheadSource::close() {
+    if (sourceIsOpen) {
+        stopBackend();
+        sourceIsOpen = false;
+    }
+    return source->close();
+}
+
+void ReadAheadSource::workerLoop() {
+    while (true) {
+        uint index;
+        {
+            unique_lock<mutex> lock(bufferMutex);
+            requestAvailable.wait(lock, [this] { return stopWorkers || !requestQueue.empty(); });
+            if (requestQueue.empty())
+                return;
+            index = requestQueue.front();
+            requestQueue.pop_front();
+        }
+        auto &buffer = buffers[index];
+        int64_t result;
+        {
+            FQI_TRACE_SPAN("read ahead");
+            result = source->readAt(buffer.offset, buffer.data, static_cast<int64_t>(buffer.wanted));
+        }
+        {
+            lock_guard<mutex> lock(bufferMutex);
+            completeRead(index, result < 0 ? -EIO : result);
+        }
+        requestFinished.notify_all();
+    }
+}
+
+bool ReadAheadSource::submit(uint index) {
+    auto &buffer = buffers[index];
+    buffer.state = BUFFER_PENDING;
+    if (activeBackend == READ_AHEAD_IO_URING) {
+        buffer.target.iov_base = buffer.data + buffer.length;
+        buffer.target.iov_len = buffer.wanted - buffer.length;
+        if (!ring->submitRead(fileSource->getFileDescriptor(), &buffer.target,
+                              static_cast<u_int64_t>(buffer.offset) + buffer.length, index)) {
+            buffer.state = BUFFER_FAILED;
+            return false;
+        }
+    } else {
+        {
+            lock_guard<mutex> lock(bufferMutex);
+            requestQueue.push_back(index);
+        }
+        requestAvailable.notify_one();
+    }
+    return true;
+}
+
+void ReadAheadSource::completeRead(uint index, int64_t result) {
+    // Note: The worker threads call this with a locked bufferMutex, but they never pass -EINTR / -EAGAIN and don't
+    // resubmit short reads, so submit() will not be called from there.
+    auto &buffer = buffers[index];
+    if (result < 0) {
+        if (result == -EINTR || result == -EAGAIN) {
+            submit(index);
+            return;
+        }
+        buffer.state = BUFFER_FAILED;
+        return;
+    }
+    buffer.length += static_cast<u_int64_t>(result);
+    if (result > 0 && buffer.length < buffer.wanted && activeBackend == READ_AHEAD_IO_URING) {
+        submit(index); // Short read, request the rest.
+        return;
+    }
+    // The source might have been shorter than expected.
+    buffer.truncated = buffer.length < buffer.wanted;
+    buffer.wanted = buffer.length;
+    buffer.state = BUFFER_READY;
+}
+
+void ReadAheadSource::requestData() {
+    while (assignedBuffers < buffers.size() && nextRequestOffset < sourceSize) {
+        if (nextRequestOffset >= readAheadLimit) {
+            if (assignedBuffers > 0)
+                break;
+            // The consumer needs more than the advised range.
+            readAheadLimit = nextRequestOffset + readAheadExtension;
+            readAheadExtension = min(readAheadExtension * 2, static_cast<int64_t>(bufferSize * buffers.size()));
+        }
+        uint index = (consumerBuffer + assignedBuffers) % buffers.size();
+        auto &buffer = buffers[index];
+        buffer.offset = nextRequestOffset;
+        buffer.wanted = static_cast<u_int64_t>(min({static_cast<int64_t>(bufferSize),
+                                                    sourceSize - nextRequestOffset,
+                                                    readAheadLimit - nextRequestOffset}));
+        buffer.length = 0;
+        buffer.truncated = false;
+        nextRequestOffset += buffer.wanted;
+        assignedBuffers++;
+        if (!submit(index))
+            readFailed = true;
+    }
+}
+
+bool ReadAheadSource::waitForBuffer(uint index) {
+    auto &buffer = buffers[index];
+    if (activeBackend == READ_AHEAD_IO_URING) {
+        while (buffer.state == BUFFER_PENDING) {
+            u_int64_t completedIndex{0};
+            int32_t result{0};
+            if (!ring->waitForCompletion(&completedIndex, &result)) {
+                buffer.state = BUFFER_FAILED;
+                break;
+            }
+            completeRead(static_cast<uint>(completedIndex), result);
+        }
+    } else {
+        unique_lock<mutex> lock(bufferMutex);
+        requestFinished.wait(lock, [&buffer] { return buffer.state != BUFFER_PENDING; });
+    }
+    return buffer.state == BUFFER_READY;
+}
+
+void ReadAheadSource::drain() {
+    if (activeBackend == READ_AHEAD_THREADS) {
+        // Requests which were not picked up by a worker yet are cancelled.
+        lock_guard<mutex> lock(bufferMutex);
+        for (auto index : requestQueue)
+            buffers[index].state = BUFFER_EMPTY;
+        requestQueue.clear();
+    }
+    for (uint i = 0; i < assignedBuffers; i++)
+        waitForBuffer((consumerBuffer + i) % buffers.size());
+}
+
+void ReadAheadSource::recycleConsumerBuffer() {
+    buffers[consumerBuffer].state = BUFFER_EMPTY;
+    consumerBuffer = (consumerBuffer + 1) % buffers.size();
+    assignedBuffers--;
+    cursor = 0;
+}
+
+int ReadAheadSource::prepareConsumerBuffer() {
+    while (true) {
+        if (assignedBuffers == 0)
+            requestData();
+        if (assignedBuffers == 0)
+            return 0; // End of source
+
+        if (!waitForBuffer(consumerBuffer)) {
+            readFailed = true;
+            addErrorMessage("Could not read from '", source->toString(), "' at offset ",
+                            to_string(buffers[consumerBuffer].offset), ".");
+            return -1;
+        }
+
+        auto &buffer = buffers[consumerBuffer];
+        if (cursor < buffer.length) {
+            requestData(); // Keep the ring busy
+            return 1;
+        }
+
+        bool reachedEndOfSource = buffer.truncated;
+        recycleConsumerBuffer();
+        if (reachedEndOfSource) {
+            // The source ended before its expected size. Don't read any further.
+            drain();
+            assignedBuffers = 0;
+            nextRequestOffset = sourceSize = buffer.offset + static_cast<int64_t>(buffer.length);
+            return 0;
+        }
+    }
+}
+
+int64_t ReadAheadSource::readView(const Bytef **data, Bytef * /*fallbackBuffer*/, int64_t maximumBytes) {
+    int state = prepareConsumerBuffer();
+    if (state <= 0)
+        return state;
+    auto &buffer = buffers[consumerBuffer];
+    auto available = static_cast<int64_t>(buffer.length - cursor);
+    int64_t result = min(available, maximumBytes);
+    *data = buffer.data + cursor;
+    cursor += result;
+    totalReadBytes += result;
+    return result;
+}
+
+int64_t ReadAheadSource::read(Bytef *targetBuffer, int numberOfBytes) {
+    int64_t totalRead = 0;
+    while (totalRead < numberOfBytes) {
+        const Bytef *data{nullptr};
+        int64_t result = readView(&data, nullptr, numberOfBytes - totalRead);
+        if (result < 0)
+            return totalRead > 0 ? totalRead : -1;
+        if (result == 0)
+            break;
+        memcpy(targetBuffer + totalRead, data, static_cast<size_t>(result));
+        totalRead += result;
+    }
+    return totalRead;
+}
+
+int ReadAheadSource::readChar() {
+    Byte result = 0;
+    auto res = read(&result, 1);
+    return res <= 0 ? -1 : static_cast<int>(result);
+}
+
+void ReadAheadSource::adviseRange(int64_t offset, int64_t length) {
+    source->adviseRange(offset, length);
+    readAheadLimit = length > 0 ? offset + length : INT64_MAX;
+    readAheadExtension = static_cast<int64_t>(bufferSize);
+}
+
+int64_t ReadAheadSource::tell() {
+    if (assignedBuffers == 0)
+        return nextRequestOffset;
+    return buffers[consumerBuffer].offset + static_cast<int64_t>(cursor);
+}
+
+int64_t ReadAheadSource::seek(int64_t nByte, bool absolute) {
+    int64_t target = absolute ? nByte : tell() + nByte;
+    if (target < 0)
+        return 0;
+
+    if (!sourceIsOpen) {
+        source->seek(target, true);
+        nextRequestOffset = target;
+        return 1;
+    }
+
+    // Jumps into the requested data are cheap. We just need to skip the buffers in front of the target.
+    if (assignedBuffers > 0 && target >= buffers[consumerBuffer].offset && target < nextRequestOffset) {
+        while (assignedBuffers > 0) {
+            // The amount of data in a buffer is only known for sure, when its read is finished.
+            waitForBuffer(consumerBuffer);
+            auto &buffer = buffers[consumerBuffer];
+            if (target < buffer.offset + static_cast<int64_t>(buffer.wanted)) {
+                cursor = static_cast<u_int64_t>(target - buffer.offset);
+                requestData();
+                return 1;
+            }
+            recycleConsumerBuffer();
+        }
+        // The source was shorter than expected, so the target is behind its end.
+        nextRequestOffset = min(target, sourceSize);
+        return 1;
+    }
+
+    // Otherwise start over at the new position.
+    drain();
+    for (auto &buffer : buffers)
+        buffer.state = BUFFER_EMPTY;
+    consumerBuffer = 0;
+    assignedBuffers = 0;
+    cursor = 0;
+    nextRequestOffset = min(target, sourceSize);
+    return 1;
+}
+
+vector<string> ReadAheadSource::getErrorMessages() {
+    auto l = ErrorAccumulator::getErrorMessages();
+    auto r = source->getErrorMessages();
+    if (ring)
+        return concatenateVectors(l, r, ring->getErrorMessages());
+    return concatenateVectors(l, r);
+}
@@ -0,0 +1,274 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#ifndef FASTQINDEX_READAHEADSOURCE_H
+#define FASTQINDEX_READAHEADSOURCE_H
+
+#include "process/io/FileSource.h"
+#include "process/io/IOUringReader.h"
+#include "process/io/Source.h"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+enum ReadAheadBackend {
+    /**
+     * io_uring for file sources, if the kernel allows it, worker threads otherwise.
+     */
+    READ_AHEAD_AUTO,
+    READ_AHEAD_IO_URING,
+    READ_AHEAD_THREADS
+};
+
+/**
+ * Source decorator, which keeps several large reads of the wrapped source in flight, so that the consumer (normally
+ * zlib) does not need to wait for small synchronous reads. This is especially useful for network file systems.
+ *
+ * The data is read into a ring of buffers. Reads are issued asynchronously with io_uring or, if io_uring is not
+ * available or the source is no FileSource, by worker threads using readAt(). The consumer can access the buffers
+ * without copying by using readView().
+ *
+ * The decorator supports seeking. Jumps within the data which was already requested are cheap, otherwise all buffers
+ * are discarded and reading restarts at the new position.
+ */
+class ReadAheadSource : public Source {
+
+private:
+
+    enum BufferState {
+        BUFFER_EMPTY,
+        BUFFER_PENDING,
+        BUFFER_READY,
+        BUFFER_FAILED
+    };
+
+    struct ReadAheadBuffer {
+        Bytef *data{nullptr};
+        int64_t offset{0};
+        /**
+         * The amount of Bytes requested for this buffer.
+         */
+        u_int64_t wanted{0};
+        /**
+         * The amount of Bytes which were read so far.
+         */
+        u_int64_t length{0};
+        /**
+         * Set, if the source returned less data than requested, which means, that it ended.
+         */
+        bool truncated{false};
+        BufferState state{BUFFER_EMPTY};
+        struct iovec target{};
+    };
+
+    shared_ptr<Source> source;
+
+    /**
+     * Set, if the wrapped source is a FileSource. Necessary for io_uring.
+     */
+    shared_ptr<FileSource> fileSource;
+
+    u_int64_t bufferSize;
+
+    ReadAheadBackend requestedBackend;
+
+    ReadAheadBackend activeBackend{READ_AHEAD_THREADS};
+
+    bool sourceIsOpen{false};
+
+    vector<ReadAheadBuffer> buffers;
+
+    /**
+     * The buffer from which the consumer reads. The following buffers in the ring hold the following data.
+     */
+    uint consumerBuffer{0};
+
+    /**
+     * The number of buffers (starting with consumerBuffer) which hold or will hold data.
+     */
+    uint assignedBuffers{0};
+
+    /**
+     * The read position in the consumer buffer.
+     */
+    u_int64_t cursor{0};
+
+    /**
+     * The offset for the next read request. If no buffer is assigned, this is the current position.
+     */
+    int64_t nextRequestOffset{0};
+
+    int64_t sourceSize{0};
+
+    /**
+     * Don't read ahead behind this offset, see adviseRange(). Requests are cut off at the limit. If the consumer needs
+     * more data, the limit is moved by readAheadExtension.
+     */
+    int64_t readAheadLimit{INT64_MAX};
+
+    /**
+     * The amount of Bytes by which readAheadLimit is extended next. Starts with one buffer and doubles with every
+     * extension, until it covers all buffers.
+     */
+    int64_t readAheadExtension{0};
+
+    bool readFailed{false};
+
+    unique_ptr<IOUringReader> ring;
+
+    vector<thread> workers;
+
+    deque<uint> requestQueue;
+
+    mutex bufferMutex;
+
+    condition_variable requestAvailable;
+
+    condition_variable requestFinished;
+
+    bool stopWorkers{false};
+
+    bool startBackend();
+
+    void stopBackend();
+
+    void workerLoop();
+
+    /**
+     * Assigns empty buffers to the next offsets and requests the data.
+     */
+    void requestData();
+
+    bool submit(uint index);
+
+    /**
+     * Handles the completion of a read for the buffer with the given index. Short reads are resubmitted.
+     */
+    void completeRead(uint index, int64_t result);
+
+    bool waitForBuffer(uint index);
+
+    /**
+     * Cancels all queued requests and waits for the requests in flight, so that all buffers can be reused.
+     */
+    void drain();
+
+    /**
+     * Frees the consumer buffer and moves on to the next buffer.
+     */
+    void recycleConsumerBuffer();
+
+    /**
+     * Makes sure, that the consumer buffer holds unread data.
+     * @return 1, if data is available, 0 at the end of the source and -1 on errors.
+     */
+    int prepareConsumerBuffer();
+
+public:
+
+    static const uint DEFAULT_NUMBER_OF_BUFFERS;
+
+    static const u_int64_t DEFAULT_BUFFER_SIZE;
+
+    static shared_ptr<ReadAheadSource> from(const shared_ptr<Source> &source,
+                                            uint numberOfBuffers = DEFAULT_NUMBER_OF_BUFFERS,
+                                            u_int64_t bufferSize = DEFAULT_BUFFER_SIZE,
+                                            ReadAheadBackend backend = READ_AHEAD_AUTO) {
+        return make_shared<ReadAheadSource>(source, numberOfBuffers, bufferSize, backend);
+    }
+
+    /**
+     * Wraps local file sources. All other sources are returned as they are, as they either cannot read at arbitrary
+     * positions (streams) or have their own strategy (S3).
+     */
+    static shared_ptr<Source> wrapIfPossible(const shared_ptr<Source> &source);
+
+    ReadAheadSource(const shared_ptr<Source> &source,
+                    uint numberOfBuffers = DEFAULT_NUMBER_OF_BUFFERS,
+                    u_int64_t bufferSize = DEFAULT_BUFFER_SIZE,
+                    ReadAheadBackend backend = READ_AHEAD_AUTO);
+
+    ~ReadAheadSource() override;
+
+    shared_ptr<Source> getSource() { return source; }
+
+    ReadAheadBackend getActiveBackend() { return activeBackend; }
+
+    bool fulfillsPremises() override { return source->fulfillsPremises(); }
+
+    bool open() override;
+
+    bool openWithReadLock() override;
+
+    bool close() override;
+
+    bool hasLock() override { return source->hasLock(); }
+
+    bool unlock() override { return source->unlock(); }
+
+    bool isOpen() override { return sourceIsOpen; }
+
+    bool eof() override { return tell() >= size(); }
+
+    bool isGood() override { return !readFailed && source->isGood(); }
+
+    bool isFile() override { return source->isFile(); }
+
+    bool isStream() override { return source->isStream(); }
+
+    bool isSymlink() override { return source->isSymlink(); }
+
+    bool exists() override { return source->exists(); }
+
+    int64_t size() override { return sourceIsOpen ? sourceSize : source->size(); }
+
+    bool empty() override { return source->empty(); }
+
+    bool canRead() override { return tell() < size(); }
+
+    bool canWrite() override { return false; }
+
+    void setReadStart(int64_t startBytes) override {
+        Source::setReadStart(startBytes);
+        source->setReadStart(startBytes);
+    }
+
+    int64_t read(Bytef *targetBuffer, int numberOfBytes) override;
+
+    int64_t readView(const Bytef **data, Bytef *fallbackBuffer, int64_t maximumBytes) override;
+
+    int readChar() override;
+
+    int64_t readAt(int64_t offset, Bytef *targetBuffer, int64_t length) override {
+        return source->readAt(offset, targetBuffer, length);
+    }
+
+    /**
+     * Passes the hint on to the wrapped source and stops reading ahead behind the end of the range. Reads behind the
+     * range extend it step by step, so a too small range costs a few more requests, but a too large range is never
+     * downloaded.
+     */
+    void adviseRange(int64_t offset, int64_t length) override;
+
+    int64_t seek(int64_t nByte, bool absolute) override;
+
+    int64_t skip(int64_t nBytes) override { return seek(nBytes, false); }
+
+    int64_t tell() override;
+
+    string toString() override { return source->toString(); }
+
+    int lastError() override { return readFailed ? 1 : source->lastError(); }
+
+    vector<string> getErrorMessages() override;
+};
+
+#endif //FASTQINDEX_READAHEADSOURCE_H
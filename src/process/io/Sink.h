@@ -8,6 +8,7 @@
 #define FASTQINDEX_SINK_H
 
 #include "process/io/IOBase.h"
+#include <sys/uio.h>
 
 /**
  * Base class for various different types of output sinks:
@@ -32,14 +33,42 @@ public:
 
     virtual bool openWithWriteLock() { return true; };
 
+    /**
+     * Open the sink in a way, that readers never see partially written data. The data becomes visible with close(). By
+     * default, this is the same as openWithWriteLock().
+     */
+    virtual bool openForPublishing() { return openWithWriteLock(); }
+
+    /**
+     * Closes a sink after a failed write. Data written after openForPublishing() is discarded and an existing target
+     * stays as it is. By default, this is the same as close().
+     */
+    virtual bool closeWithoutPublishing() { return close(); }
+
     virtual void write(const char *message) = 0;
 
     virtual void write(const char *message, int len) = 0;
 
     virtual void write(const string &message) = 0;
 
+    /**
+     * Writes several memory regions (spans) in the given order with a single call. This allows callers to hand over
+     * large batches of data at once. The default implementation calls write() for each span, sinks should override
+     * this, if they can do better, e.g. by only locking once or by issuing less system calls.
+     */
+    virtual void writeSpans(const struct iovec *spans, int count) {
+        for (int i = 0; i < count; i++)
+            write(static_cast<const char *>(spans[i].iov_base), static_cast<int>(spans[i].iov_len));
+    }
+
     virtual void flush() = 0;
 
+    /**
+     * Sinks like pipes or the console can't go back to data, which was already written. Writers which patch data after
+     * writing it, like the IndexWriter, need to use a different layout for them.
+     */
+    virtual bool canSeekBack() { return true; }
+
 };
 
 #endif //FASTQINDEX_SINK_H
@@ -10,6 +10,8 @@
 #include "common/ErrorAccumulator.h"
 #include "process/io/IOBase.h"
 #include <experimental/filesystem>
+#include <functional>
+#include <mutex>
 #include <zlib.h>
 
 using namespace std;
@@ -26,6 +28,11 @@ protected:
 
     int64_t readStart{0};
 
+    /**
+     * Used by the default implementation of readAt() to serialize the positional reads.
+     */
+    mutex readAtMutex;
+
     Source() = default;
 
 public:
@@ -59,6 +66,52 @@ public:
      */
     virtual int readChar() = 0;
 
+    /**
+     * Zero copy variant of read(). Points data to the next maximumBytes (or less) Bytes of the source. The data stays
+     * valid until the next call of a read or seek method of the source. The default implementation reads the data
+     * into fallbackBuffer, which needs to be large enough for maximumBytes.
+     * @return The number of available Bytes, 0 at the end of the source or -1 on errors.
+     */
+    virtual int64_t readView(const Bytef **data, Bytef *fallbackBuffer, int64_t maximumBytes) {
+        *data = fallbackBuffer;
+        return read(fallbackBuffer, static_cast<int>(maximumBytes));
+    }
+
+    /**
+     * Tells the source, that the range starting at offset will be read next. Sources can use this to prefetch data.
+     * @param length The length of the range. 0 or less means "until the end of the source".
+     */
+    virtual void adviseRange(int64_t /*offset*/, int64_t /*length*/) {}
+
+    /**
+     * Reads up to length Bytes, starting at the absolute position offset in the source. The call is thread safe and
+     * does not change the current position of the source, so multiple readers can share one open source.
+     *
+     * The default implementation locks the source, jumps to offset, reads the data and jumps back. It is only as
+     * capable as seek() of the implementing class, e.g. a stream source can only jump back within its rewind buffer.
+     * Sources which can do better (like FileSource with pread()) override this.
+     *
+     * @return The number of read Bytes or -1, if the position could not be reached.
+     */
+    virtual int64_t readAt(int64_t offset, Bytef *targetBuffer, int64_t length) {
+        lock_guard<mutex> lock(readAtMutex);
+        int64_t position = tell();
+        seek(offset, true);
+        if (tell() != offset) {
+            seek(position, true);
+            return -1;
+        }
+        int64_t result = read(targetBuffer, static_cast<int>(length));
+        seek(position, true);
+        return result;
+    }
+
 };
 
+/**
+ * Creates a new instance of a Source, e.g. one for every worker thread, as the sequential read methods of a Source are
+ * not thread safe.
+ */
+typedef function<shared_ptr<Source>()> SourceFactory;
+
 #endif //FASTQINDEX_SOURCE_H
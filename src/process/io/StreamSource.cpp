@@ -32,28 +32,37 @@ int64_t StreamSource::size() {
     return -1;
 }
 
-int64_t StreamSource::getRewindBufferSize() {
-    int total = 0;
-    for (auto length : rewindBufferEntryLength) {
-        total += length;
+bool StreamSource::isFile() { return false; }
+
+bool StreamSource::isStream() { return true; }
+
+int64_t StreamSource::fillRingFromStream(int64_t numberOfBytes) {
+    int64_t ringOffset = streamPosition % ringCapacity;
+    int64_t amount = min(numberOfBytes, ringCapacity - ringOffset);
+    inputStream->read(reinterpret_cast<char *>(ringBuffer.data() + ringOffset), amount);
+    int64_t amountRead = inputStream->gcount();
+    if (amountRead > 0) {
+        streamPosition += amountRead;
+        rewoundBytes += amountRead;
+        bufferedBytes = min(bufferedBytes + amountRead, ringCapacity);
     }
-    return total;
+    return amountRead;
 }
 
-char *StreamSource::joinRewindBuffer() {
-    char *buf = new char[getRewindBufferSize()];
-    int bufPos = 0;
-    for (u_int64_t i = 0; i < rewindBuffer.size(); i++) {
-        memcpy(buf + bufPos, rewindBuffer[i], static_cast<size_t>(rewindBufferEntryLength[i]));
-        bufPos += rewindBufferEntryLength[i];
+int64_t StreamSource::consumeFromRing(Bytef *target, int64_t numberOfBytes) {
+    int64_t consumed = 0;
+    while (consumed < numberOfBytes && rewoundBytes > 0) {
+        int64_t ringOffset = currentPosition % ringCapacity;
+        int64_t amount = min(min(numberOfBytes - consumed, rewoundBytes), ringCapacity - ringOffset);
+        if (target != nullptr)
+            memcpy(target + consumed, ringBuffer.data() + ringOffset, static_cast<size_t>(amount));
+        consumed += amount;
+        currentPosition += amount;
+        rewoundBytes -= amount;
     }
-    return buf;
+    return consumed;
 }
 
-bool StreamSource::isFile() { return false; }
-
-bool StreamSource::isStream() { return true; }
-
 /**
  * Reads numberOfBytes into the targetBuffer.
  * @param targetBuffer targetBuffer is either a valid Byte array OR nullptr! In case of nullptr, the read bytes are
@@ -62,67 +71,31 @@ bool StreamSource::isStream() { return true; }
  * @return
  */
 int64_t StreamSource::read(Bytef *targetBuffer, int numberOfBytes) {
-    if (rewoundBytes > 0) {
-        return readFromBuffer(targetBuffer, numberOfBytes);
-    } else {
-        return readFromStream(targetBuffer, numberOfBytes);
+    int64_t totalRead = 0;
+    while (totalRead < numberOfBytes) {
+        if (rewoundBytes == 0 && fillRingFromStream(numberOfBytes - totalRead) <= 0)
+            break;
+        totalRead += consumeFromRing(targetBuffer != nullptr ? targetBuffer + totalRead : nullptr,
+                                     numberOfBytes - totalRead);
     }
+    totalReadBytes += totalRead;
+    return totalRead;
 }
 
-int64_t StreamSource::readFromBuffer(Bytef *targetBuffer, int numberOfBytes) {
-    char *buf = joinRewindBuffer();
-    int64_t bufLen = getRewindBufferSize();
-
-    int64_t copiedBytes = numberOfBytes;
-    if (numberOfBytes > bufLen) {
-        // Cut it, copy less!
-        copiedBytes = bufLen;
-    }
-
-    if (numberOfBytes > rewoundBytes) {
-        copiedBytes = rewoundBytes;
-    }
-
-    // Copy copiedBytes of data from the right side!
-    if (targetBuffer != nullptr)
-        memcpy(targetBuffer, buf + bufLen - rewoundBytes, copiedBytes); // TODO
-    rewoundBytes -= copiedBytes;
-    currentPosition += copiedBytes;
-
-    delete[] buf;
-
-    return copiedBytes;
-}
-
-int64_t StreamSource::readFromStream(Bytef *targetBuffer, int numberOfBytes) {
-    char *readBuffer = new char[numberOfBytes]{0};
-    inputStream->sync();
-
-    inputStream->read(readBuffer, numberOfBytes);
-    streamsize amountRead = inputStream->gcount();
-
-    if (amountRead > 0) {
-        if (targetBuffer != nullptr)
-            memcpy(targetBuffer, readBuffer, amountRead);// TODO
-        rewindBuffer.emplace_back(readBuffer);
-        rewindBufferEntryLength.emplace_back(amountRead);
-        if (rewindBuffer.size() > maxSegmentsInBuffer) {
-            char *front = rewindBuffer.front();
-            rewindBuffer.pop_front();
-            rewindBufferEntryLength.pop_front();
-            delete[] front;
-        }
-        currentPosition += amountRead;          // Advance current position marker
-    } else {
-        delete[] readBuffer;
-    }
-    return amountRead;
+int64_t StreamSource::readView(const Bytef **data, Bytef * /*fallbackBuffer*/, int64_t maximumBytes) {
+    if (rewoundBytes == 0 && fillRingFromStream(maximumBytes) <= 0)
+        return 0;
+    int64_t ringOffset = currentPosition % ringCapacity;
+    *data = ringBuffer.data() + ringOffset;
+    int64_t result = consumeFromRing(nullptr, min(maximumBytes, ringCapacity - ringOffset));
+    totalReadBytes += result;
+    return result;
 }
 
 int StreamSource::readChar() {
     Byte result = 0;
     int res = static_cast<int>(this->read(&result, 1));
-    return res < 0 ? res : (int) result;
+    return res <= 0 ? -1 : static_cast<int>(result);
 }
 
 /**
@@ -153,7 +126,7 @@ int64_t StreamSource::seek(int64_t nByte, bool absolute) {
     }
 
     if (nByte > currentPosition) {
-        return skip(nByte);
+        return skip(nByte - currentPosition);
     } else {
         int64_t difference = currentPosition - nByte;
         return rewind(difference);
@@ -173,7 +146,7 @@ int64_t StreamSource::rewind(int64_t nByte) {
 
     // Check, if the rewind is too far
     // We also need to be aware of a previous rewind!
-    if (nByte + rewoundBytes > getRewindBufferSize()) {
+    if (nByte + rewoundBytes > bufferedBytes) {
         return -1; // We cannot go back further than the rewind buffer. This counts as an error
     }
 
@@ -185,32 +158,24 @@ int64_t StreamSource::rewind(int64_t nByte) {
 }
 
 /**
- * Skips nByte bytes and stores them in the buffer for possible rewinds.
+ * Skips nByte bytes and stores them in the buffer for possible rewinds. The data is read in chunks of the ring size,
+ * istream::ignore() is not used, as it takes the data Byte by Byte from cin, if cin is synchronized with stdio.
  * @param nByte
- * @return
+ * @return The number of skipped Bytes
  */
 int64_t StreamSource::skip(int64_t nByte) {
-    if (nByte == 0) return true;
-
-    int maxDefaultBufferSize = maxSegmentsInBuffer * defaultChunkSizeForReads;
-    if (nByte > maxDefaultBufferSize) {
-        // Ignore some bytes, build up new buffer.
-        inputStream->ignore(nByte - maxDefaultBufferSize);
-
-        for (int i = 0; i < maxSegmentsInBuffer; i++) {
-            this->read(nullptr, defaultChunkSizeForReads);
-        }
-    } else {
-        // Fill buffer until nByte is reached.
-        int64_t skip = nByte;
-        for (; skip >= defaultChunkSizeForReads; skip -= defaultChunkSizeForReads) {
-            this->read(nullptr, defaultChunkSizeForReads);
-        }
-        if (skip > 0) {
-            this->read(nullptr, skip); // TODO
-        }
+    if (nByte <= 0) return 0;
+
+    int64_t skipped = consumeFromRing(nullptr, nByte);
+    int64_t remaining = nByte - skipped;
+    while (remaining > 0) {
+        if (fillRingFromStream(remaining) <= 0)
+            break;
+        int64_t consumed = consumeFromRing(nullptr, remaining);
+        skipped += consumed;
+        remaining -= consumed;
     }
-    return true;
+    return skipped;
 }
 
 int64_t StreamSource::tell() {
@@ -227,6 +192,8 @@ int StreamSource::lastError() {
  * @return
  */
 bool StreamSource::canRead() {
+    if (rewoundBytes > 0)
+        return true;
     this->inputStream->peek();
     return !this->inputStream->eof();
 }
@@ -260,7 +227,7 @@ bool StreamSource::canWrite() {
 }
 
 string StreamSource::toString() {
-    return std::__cxx11::string();
+    return string();
 }
 
 bool StreamSource::openWithReadLock() {
@@ -8,9 +8,17 @@
 #define FASTQINDEX_STREAMSOURCE_H
 
 #include "Source.h"
-#include <deque>
 #include <iostream>
+#include <vector>
 
+/**
+ * Source for non seekable input streams like stdin or the S3 helper pipe.
+ *
+ * All data is read from the stream into a fixed size ring buffer, which also serves as the history for rewinds. The
+ * ring keeps the last maxSegmentsInBuffer * defaultChunkSizeForReads Bytes. Reading does not allocate memory and seeking
+ * within the retained data is O(1). Forward skips read the data into the ring without decompressing or copying it
+ * anywhere else.
+ */
 class StreamSource : public Source {
 
 protected:
@@ -22,21 +30,44 @@ protected:
     int64_t currentPosition{0};
 
     /**
-     * Last 8 read chunks from the input source.
+     * The number of Bytes taken from the input stream so far. The stream is always at or in front of currentPosition.
+     */
+    int64_t streamPosition{0};
+
+    /**
+     * Holds the data in front of streamPosition. The Byte at position p is stored at ringBuffer[p % ringCapacity].
      */
-    deque<char *> rewindBuffer;
+    vector<Bytef> ringBuffer;
+
+    int64_t ringCapacity{0};
 
     /**
-     * Length of each entry in the rewindBuffer.
+     * The number of valid Bytes in the ring, always ending at streamPosition.
      */
-    deque<int> rewindBufferEntryLength;
+    int64_t bufferedBytes{0};
 
+    /**
+     * The number of Bytes between currentPosition and streamPosition, which will be served from the ring.
+     */
     int64_t rewoundBytes{0};
 
     int maxSegmentsInBuffer{8};
 
     int defaultChunkSizeForReads{32768};
 
+    /**
+     * Reads up to numberOfBytes from the stream into the ring. Stops at the end of the ring memory, so the caller has to
+     * loop for larger amounts. Must only be called, if rewoundBytes is 0.
+     * @return The number of Bytes taken from the stream.
+     */
+    int64_t fillRingFromStream(int64_t numberOfBytes);
+
+    /**
+     * Moves currentPosition forward over up to numberOfBytes of the rewound data, optionally copying it to target.
+     * @return The number of consumed Bytes.
+     */
+    int64_t consumeFromRing(Bytef *target, int64_t numberOfBytes);
+
 public:
 
     static shared_ptr<StreamSource> from(
@@ -49,14 +80,20 @@ public:
     /**
      * ifstream behaves different when read() is called than istream
      * for ifstream, read() will return the number of read Bytes, for istream you need gcount()
+     *
+     * The retained history (and the size of the ring buffer) is maxSegmentsInBuffer * defaultChunkSizeForReads Bytes.
      */
     explicit StreamSource(
             istream *source,
             int maxSegmentsInBuffer = 8,
             int defaultChunkSizeForReads = 32768
     ) : inputStream(source),
+        ringCapacity(max(static_cast<int64_t>(maxSegmentsInBuffer) * defaultChunkSizeForReads,
+                         static_cast<int64_t>(1))),
         maxSegmentsInBuffer(maxSegmentsInBuffer),
-        defaultChunkSizeForReads(defaultChunkSizeForReads) {};
+        defaultChunkSizeForReads(defaultChunkSizeForReads) {
+        ringBuffer.resize(static_cast<size_t>(ringCapacity));
+    };
 
     int64_t getTotalReadBytes() override;
 
@@ -88,9 +125,10 @@ public:
 
     int64_t read(Bytef *targetBuffer, int numberOfBytes) override;
 
-    int64_t readFromBuffer(Bytef *targetBuffer, int numberOfBytes);
-
-    int64_t readFromStream(Bytef *targetBuffer, int numberOfBytes);
+    /**
+     * Passes a pointer into the ring buffer, so the data is not copied.
+     */
+    int64_t readView(const Bytef **data, Bytef *fallbackBuffer, int64_t maximumBytes) override;
 
     int readChar() override;
 
@@ -98,11 +136,17 @@ public:
 
     int64_t rewind(int64_t nByte) override;
 
-    int64_t getRewindBufferSize();
-
-    char *joinRewindBuffer();
+    /**
+     * The number of Bytes which are kept for rewinds.
+     */
+    int64_t getRewindBufferSize() { return bufferedBytes; }
 
-    int64_t getSegmentsInRewindBuffer() { return rewindBuffer.size(); };
+    /**
+     * The retained history measured in chunks of defaultChunkSizeForReads Bytes.
+     */
+    int64_t getSegmentsInRewindBuffer() {
+        return (bufferedBytes + defaultChunkSizeForReads - 1) / max(defaultChunkSizeForReads, 1);
+    };
 
     int64_t getRewoundBytes() { return rewoundBytes; }
 
@@ -16,15 +16,25 @@
 #include <cstdio>
 #include <fcntl.h>
 #include <list>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <streambuf>
 
 #include <aws/core/auth/AWSAuthSigner.h>
 #include <aws/core/auth/AWSCredentialsProvider.h>
 #include <aws/core/utils/HashingUtils.h>
 #include <aws/core/Aws.h>
+#include <aws/s3/model/AbortMultipartUploadRequest.h>
+#include <aws/s3/model/CompletedMultipartUpload.h>
+#include <aws/s3/model/CompletedPart.h>
+#include <aws/s3/model/CompleteMultipartUploadRequest.h>
+#include <aws/s3/model/CreateMultipartUploadRequest.h>
 #include <aws/s3/model/GetObjectRequest.h>
+#include <aws/s3/model/HeadObjectRequest.h>
 #include <aws/s3/model/ListObjectsRequest.h>
 #include <aws/s3/model/PutObjectRequest.h>
+#include <aws/s3/model/UploadPartRequest.h>
 #include <aws/s3/S3Client.h>
 
 using namespace Aws::Utils;
@@ -44,6 +54,54 @@ struct S3Object {
     }
 };
 
+/**
+ * Stream buffer which writes to a fixed memory area. Used to let the SDK download directly into our buffers.
+ * Writes behind the end of the area fail.
+ */
+class FixedMemoryStreamBuffer : public std::streambuf {
+public:
+    FixedMemoryStreamBuffer(char *memory, int64_t length) {
+        setp(memory, memory + length);
+    }
+
+    int64_t getWrittenBytes() { return pptr() - pbase(); }
+
+    /**
+     * Used as the response stream factory of a request. The SDK calls it for every attempt of a request, the data of a
+     * failed attempt is discarded then.
+     */
+    std::iostream *createStreamForAttempt() {
+        setp(pbase(), epptr());
+        return Aws::New<std::iostream>("FQIS3Client", this);
+    }
+};
+
+/**
+ * Stream buffer which reads from a fixed memory area. Used to upload our buffers without copying them. The SDK seeks
+ * in request bodies (e.g. to calculate checksums or to retry), so seeking is supported.
+ */
+class MemoryInputStreamBuffer : public std::streambuf {
+public:
+    MemoryInputStreamBuffer(const char *memory, int64_t length) {
+        auto begin = const_cast<char *>(memory);
+        setg(begin, begin, begin + length);
+    }
+
+protected:
+    pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode which) override {
+        char *base = direction == std::ios_base::beg ? eback() : direction == std::ios_base::cur ? gptr() : egptr();
+        char *target = base + offset;
+        if (!(which & std::ios_base::in) || target < eback() || target > egptr())
+            return pos_type(off_type(-1));
+        setg(eback(), target, egptr());
+        return pos_type(target - eback());
+    }
+
+    pos_type seekpos(pos_type position, std::ios_base::openmode which) override {
+        return seekoff(off_type(position), std::ios_base::beg, which);
+    }
+};
+
 /**
  * This could actually be a nice helper class which could be stored as an Object, if needed. But I am working
  */
@@ -61,6 +119,11 @@ protected:
 
     S3ServiceOptions serviceOptions;
 
+    /**
+     * Ranged reads are run from several threads.
+     */
+    mutex errorMessageMutex;
+
 public:
 
     FQIS3Client(const string &s3Path,
@@ -68,14 +131,43 @@ public:
         this->s3Path = s3Path;
         this->s3Config = S3Service::getInstance()->getConfig();
         this->serviceOptions = s3ServiceOptions;
-        auto split = StringHelper::splitStr(s3Path, '/'); // s3://bucket/object
-
-        if (split.size() != 4) {
+        bool valid;
+        tie(valid, bucketName, objectName) = splitS3Path(s3Path);
+        if (!valid)
             addErrorMessage("The S3 string '", s3Path, "' must look like s3://<bucket>/<object>");
-        } else {
-            bucketName = split[2];
-            objectName = split[3];
-        }
+    }
+
+    /**
+     * Splits an S3 path into the bucket and the object name. Object names may contain slashes, e.g. s3://bucket/a/b
+     * refers to the object "a/b".
+     * @return A tuple indicating [success, bucket, object]
+     */
+    static tuple<bool, string, string> splitS3Path(const string &s3Path) {
+        const string prefix = "s3://";
+        auto slash = s3Path.find('/', prefix.size());
+        if (s3Path.compare(0, prefix.size(), prefix) != 0 || slash == string::npos)
+            return {false, "", ""};
+        string bucket = s3Path.substr(prefix.size(), slash - prefix.size());
+        string object = s3Path.substr(slash + 1);
+        if (bucket.empty() || object.empty())
+            return {false, "", ""};
+        return {true, bucket, object};
+    }
+
+    /**
+     * Checks the Content-Range header of a response to a ranged GET request. A server, which ignores the Range header,
+     * answers with the complete object instead (and without the header). A body, which is shorter than the range,
+     * would look like the end of the object to the reader.
+     * @param contentRange The header value, like "bytes 100-199/1000".
+     * @return true, if the response starts at position and the whole range, up to the end of the object, was received.
+     */
+    static bool isCompleteRangeResponse(const string &contentRange, int64_t position, int64_t length,
+                                        int64_t receivedBytes) {
+        long long first{0}, last{0}, total{0};
+        if (sscanf(contentRange.c_str(), "bytes %lld-%lld/%lld", &first, &last, &total) != 3)
+            return false;
+        return first == position && last == min<int64_t>(position + length, total) - 1 &&
+               receivedBytes == last - first + 1;
     }
 
     bool isValid() {
@@ -110,6 +202,7 @@ public:
         auto outcome = s3Request(*S3Service::getInstance()->getClient().get());
         if (!outcome.IsSuccess()) {
             const auto &error = outcome.GetError();
+            lock_guard<mutex> lock(errorMessageMutex);
             addErrorMessage("S3 error: ", string(error.GetExceptionName()), ": ", string(error.GetMessage()));
             result = false;
         } else {
@@ -175,52 +268,157 @@ public:
         return {found, size};
     }
 
-    FQIS3ClientRequestBooleanResult putFile(const string &file) {
-        bool couldPut = false;
+    /**
+     * Requests the size and the ETag of this clients object with a HEAD request.
+     * @return A tuple indicating [success, size, ETag]
+     */
+    tuple<bool, int64_t, string> getObjectSizeAndETag() {
+        int64_t size{0};
+        string eTag;
+        bool success = request<HeadObjectOutcome>([&](S3Client &client) -> HeadObjectOutcome {
+            HeadObjectRequest objectRequest;
+            objectRequest.SetBucket(bucketName.c_str());
+            objectRequest.SetKey(objectName.c_str());
+            auto outcome = client.HeadObject(objectRequest);
+            if (outcome.IsSuccess()) {
+                size = outcome.GetResult().GetContentLength();
+                eTag = string(outcome.GetResult().GetETag());
+            }
+            return outcome;
+        });
+        return {success, size, eTag};
+    }
 
-        bool requestResult = request<PutObjectOutcome>([=](S3Client &client) -> PutObjectOutcome {
+    /**
+     * Uploads an object, which fits into memory, with a single PUT request.
+     */
+    bool putData(const char *data, int64_t length) {
+        return request<PutObjectOutcome>([&](S3Client &client) -> PutObjectOutcome {
+            MemoryInputStreamBuffer streamBuffer(data, length);
             PutObjectRequest objectRequest;
             objectRequest.SetBucket(bucketName.c_str());
             objectRequest.SetKey(objectName.c_str());
-            auto inputData =
-                    Aws::MakeShared<FStream>("FASTQ index", file.c_str(), std::ios_base::in | std::ios_base::binary);
-            objectRequest.SetBody(inputData);
+            objectRequest.SetBody(Aws::MakeShared<std::iostream>("FQIS3Client", &streamBuffer));
+            objectRequest.SetContentLength(length);
             objectRequest.SetContentMD5(
                     HashingUtils::Base64Encode(HashingUtils::CalculateMD5(*objectRequest.GetBody())));
             return client.PutObject(objectRequest);
         });
+    }
 
-        return FQIS3ClientRequestBooleanResult(requestResult, requestResult);
+    /**
+     * Starts a multipart upload for this clients object.
+     * @return A tuple indicating [success, upload id]
+     */
+    tuple<bool, string> createMultipartUpload() {
+        string uploadId;
+        bool success = request<CreateMultipartUploadOutcome>([&](S3Client &client) -> CreateMultipartUploadOutcome {
+            CreateMultipartUploadRequest objectRequest;
+            objectRequest.SetBucket(bucketName.c_str());
+            objectRequest.SetKey(objectName.c_str());
+            auto outcome = client.CreateMultipartUpload(objectRequest);
+            if (outcome.IsSuccess())
+                uploadId = string(outcome.GetResult().GetUploadId());
+            return outcome;
+        });
+        return {success, uploadId};
     }
 
     /**
-     * As I had big memory issues when using the same S3 stream for the whole index / extract process, I now try to read
-     * things chunk-wise. This might not be the most efficient way, but the memory consumption was around 1.2 times as
-     * as the file size. Dealing with larger files (think of 30 or 40GB) is simply not possible.
+     * Uploads a single part of a multipart upload directly from memory. The method is thread safe.
+     * @return A tuple indicating [success, ETag of the part]
+     */
+    tuple<bool, string> uploadPart(const string &uploadId, int partNumber, const char *data, int64_t length) {
+        string eTag;
+        bool success = request<UploadPartOutcome>([&](S3Client &client) -> UploadPartOutcome {
+            MemoryInputStreamBuffer streamBuffer(data, length);
+            UploadPartRequest partRequest;
+            partRequest.SetBucket(bucketName.c_str());
+            partRequest.SetKey(objectName.c_str());
+            partRequest.SetUploadId(uploadId.c_str());
+            partRequest.SetPartNumber(partNumber);
+            partRequest.SetBody(Aws::MakeShared<std::iostream>("FQIS3Client", &streamBuffer));
+            partRequest.SetContentLength(length);
+            partRequest.SetContentMD5(HashingUtils::Base64Encode(HashingUtils::CalculateMD5(*partRequest.GetBody())));
+            auto outcome = client.UploadPart(partRequest);
+            if (outcome.IsSuccess())
+                eTag = string(outcome.GetResult().GetETag());
+            return outcome;
+        });
+        return {success, eTag};
+    }
+
+    /**
+     * Finishes a multipart upload.
+     * @param parts The ETags of all uploaded parts by part number.
+     */
+    bool completeMultipartUpload(const string &uploadId, const map<int, string> &parts) {
+        return request<CompleteMultipartUploadOutcome>([&](S3Client &client) -> CompleteMultipartUploadOutcome {
+            CompletedMultipartUpload completedUpload;
+            for (const auto &[partNumber, eTag] : parts)
+                completedUpload.AddParts(CompletedPart().WithETag(eTag.c_str()).WithPartNumber(partNumber));
+            CompleteMultipartUploadRequest completeRequest;
+            completeRequest.SetBucket(bucketName.c_str());
+            completeRequest.SetKey(objectName.c_str());
+            completeRequest.SetUploadId(uploadId.c_str());
+            completeRequest.SetMultipartUpload(completedUpload);
+            return client.CompleteMultipartUpload(completeRequest);
+        });
+    }
+
+    /**
+     * Aborts a multipart upload, so that S3 discards the uploaded parts.
+     */
+    bool abortMultipartUpload(const string &uploadId) {
+        return request<AbortMultipartUploadOutcome>([&](S3Client &client) -> AbortMultipartUploadOutcome {
+            AbortMultipartUploadRequest abortRequest;
+            abortRequest.SetBucket(bucketName.c_str());
+            abortRequest.SetKey(objectName.c_str());
+            abortRequest.SetUploadId(uploadId.c_str());
+            return client.AbortMultipartUpload(abortRequest);
+        });
+    }
+
+    /**
+     * Reads a block of data with a ranged GET request. The SDK writes the response directly to the buffer, so no
+     * intermediate copy or temporary file is involved. The method is thread safe.
      * @param position From where to take
      * @param length   How much to take
      * @param buffer   Where to store to. This buffer needs to be large enough to hold the data!
      * @return A tuple with a success indicator and the amount of read Bytes.
      */
     tuple<bool, int64_t> readBlockOfData(int64_t position, int64_t length, Bytef *buffer) {
-        int64_t readBytes{0};
+        if (length <= 0)
+            return tuple<bool, int64_t>(true, 0);
+
+        FixedMemoryStreamBuffer target(reinterpret_cast<char *>(buffer), length);
+        string contentRange;
         bool success = request<GetObjectOutcome>([&](S3Client &client) -> GetObjectOutcome {
             GetObjectRequest objectRequest;
             objectRequest.SetBucket(bucketName.c_str());
             objectRequest.SetKey(objectName.c_str());
-            auto getObjectOutcome = client.GetObject(objectRequest);
-            if (getObjectOutcome.IsSuccess()) {
-                auto &retrievedFile = getObjectOutcome.GetResult().GetBody();
-                retrievedFile.seekg(position, ios_base::beg);
-                retrievedFile.readsome(reinterpret_cast<char *>( buffer), length);
-            }
-            return getObjectOutcome;
+            auto range = string("bytes=") + to_string(position) + "-" + to_string(position + length - 1);
+            objectRequest.SetRange(range.c_str());
+            objectRequest.SetResponseStreamFactory([&target]() { return target.createStreamForAttempt(); });
+            auto outcome = client.GetObject(objectRequest);
+            if (outcome.IsSuccess())
+                contentRange = string(outcome.GetResult().GetContentRange());
+            return outcome;
         });
 
-        return tuple<bool, int64_t>(success, readBytes);
+        if (success && !isCompleteRangeResponse(contentRange, position, length, target.getWrittenBytes())) {
+            lock_guard<mutex> lock(errorMessageMutex);
+            addErrorMessage("S3 error: The ranged request at offset ", to_string(position), " of '", s3Path,
+                            join("' was answered with ", to_string(target.getWrittenBytes()), " Bytes and the range '",
+                                 contentRange, "'."));
+            success = false;
+        }
+
+        return tuple<bool, int64_t>(success, target.getWrittenBytes());
     }
 
     vector<string> getErrorMessages() override {
+        lock_guard<mutex> lock(errorMessageMutex);
         auto l = ErrorAccumulator::getErrorMessages();
         auto r = s3Config.getErrorMessages();
         return concatenateVectors(l, r);
@@ -0,0 +1,134 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#include "IndexCache.h"
+#include "common/StringHelper.h"
+#include "process/io/FileSink.h"
+#include "process/io/s3/S3Source.h"
+#include <iomanip>
+#include <sstream>
+#include <unistd.h>
+
+const uint IndexCache::MAXIMUM_FILE_NAME_LENGTH = 200;
+
+string IndexCache::toFileName(const string &text) {
+    string result;
+    for (auto c : text) {
+        if (c == '"')
+            continue;
+        result += isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_' || c == '.' ? c : '_';
+    }
+    // Don't allow "." or "..".
+    if (result.find_first_not_of('.') == string::npos)
+        result = "_" + result;
+    return result;
+}
+
+string IndexCache::toUniqueFileName(const string &text) {
+    string result = toFileName(text);
+    if (result == text && result.size() <= MAXIMUM_FILE_NAME_LENGTH)
+        return result;
+
+    // Different names like "a/b" and "a_b" would share a file otherwise. The hash (64 bit FNV-1a) keeps them apart.
+    u_int64_t hash = StringHelper::fnv1a(text.data(), text.size());
+    stringstream suffix;
+    suffix << "." << hex << setw(16) << setfill('0') << hash;
+    return result.substr(0, MAXIMUM_FILE_NAME_LENGTH) + suffix.str();
+}
+
+path IndexCache::getCacheFile(const shared_ptr<S3RangeSource> &object) {
+    string s3Path = object->toString();
+    auto[valid, bucket, objectName] = FQIS3Client::splitS3Path(s3Path);
+    if (!valid) {
+        addErrorMessage("The S3 string '", s3Path, "' must look like s3://<bucket>/<object>");
+        return path();
+    }
+
+    // size() sends the HEAD request, which also delivers the ETag.
+    if (object->size() < 0 || object->getETag().empty()) {
+        addErrorMessage("Could not look up the current version of '", s3Path, "'.");
+        return path();
+    }
+    return directory / toFileName(bucket) / toUniqueFileName(objectName) / (toFileName(object->getETag()) + ".fqi");
+}
+
+bool IndexCache::download(const shared_ptr<S3RangeSource> &object,
+                          const path &target,
+                          uint partsInFlight,
+                          u_int64_t partSize) {
+    std::error_code errorCode;
+    create_directories(target.parent_path(), errorCode);
+    if (errorCode) {
+        addErrorMessage("Could not create the cache directory '", target.parent_path().string(), "'.");
+        return false;
+    }
+
+    S3Source source(object, partsInFlight, partSize);
+    if (!source.open()) {
+        addErrorMessage("Could not open '", object->toString(), "' for download.");
+        return false;
+    }
+
+    // Other processes might download the same object at the same time, so each one uses its own file.
+    path temporaryFile = target.string() + ".download." + to_string(getpid());
+    int64_t downloadedBytes{0};
+    bool ok;
+    {
+        FileSink sink(temporaryFile, true);
+        ok = sink.openWithWriteLock();
+        vector<Bytef> buffer(1024 * 1024);
+        while (ok) {
+            auto result = source.read(buffer.data(), static_cast<int>(buffer.size()));
+            if (result <= 0) {
+                ok = result == 0;
+                break;
+            }
+            sink.write(reinterpret_cast<const char *>(buffer.data()), static_cast<int>(result));
+            downloadedBytes += result;
+        }
+        sink.flush();
+        ok = ok && sink.isGood() && downloadedBytes == object->size();
+        sink.close();
+    }
+    source.close();
+
+    if (ok) {
+        rename(temporaryFile, target, errorCode);
+        ok = !errorCode;
+    }
+    if (!ok) {
+        addErrorMessage("Could not store a copy of '", object->toString(), "' in '", target.string(), "'.");
+        remove(temporaryFile, errorCode);
+    }
+    return ok;
+}
+
+void IndexCache::removeOutdatedCopies(const path &current) {
+    std::error_code errorCode;
+    for (const auto &entry : directory_iterator(current.parent_path(), errorCode)) {
+        // Ignore the download files of other processes.
+        if (entry.path() != current && entry.path().extension() == ".fqi")
+            remove(entry.path(), errorCode);
+    }
+}
+
+shared_ptr<Source> IndexCache::fetch(const shared_ptr<S3RangeSource> &object, uint partsInFlight, u_int64_t partSize) {
+    path cacheFile = getCacheFile(object);
+    if (cacheFile.empty())
+        return nullptr;
+
+    std::error_code errorCode;
+    auto cachedSize = static_cast<int64_t>(file_size(cacheFile, errorCode));
+    if (!errorCode && cachedSize == object->size()) {
+        debug("Using the cached index '", cacheFile.string(), "' for '", object->toString(), "'.");
+    } else {
+        debug("Downloading '", object->toString(), "' to the index cache.");
+        if (!download(object, cacheFile, partsInFlight, partSize))
+            return nullptr;
+        removeOutdatedCopies(cacheFile);
+    }
+    return MemoryMappedFileSource::from(cacheFile);
+}
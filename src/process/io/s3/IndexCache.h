@@ -0,0 +1,82 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#ifndef FASTQINDEX_INDEXCACHE_H
+#define FASTQINDEX_INDEXCACHE_H
+
+#include "common/ErrorAccumulator.h"
+#include "process/io/MemoryMappedFileSource.h"
+#include "process/io/s3/S3RangeSource.h"
+#include <experimental/filesystem>
+#include <memory>
+
+using namespace std;
+using namespace std::experimental::filesystem;
+
+/**
+ * Local directory with copies of index files, which are stored in S3. Extracting many segments from the same FASTQ
+ * file then only downloads its index once.
+ *
+ * The copies are stored as <directory>/<bucket>/<object>/<ETag>.fqi. Object names, which are no valid file names
+ * (e.g. nested keys like "runs/1/sample.fastq.gz.fqi"), are sanitized and get a hash of the full name appended.
+ *
+ * Every lookup sends a HEAD request for the object. If the ETag changed, the new version is downloaded and the outdated
+ * copies are removed. Downloads are written to a temporary file first and renamed afterwards, so several processes can
+ * share the directory.
+ *
+ * The copies are read with a MemoryMappedFileSource.
+ */
+class IndexCache : public ErrorAccumulator {
+
+private:
+
+    path directory;
+
+    /**
+     * Removes the quotes around an ETag and replaces all characters, which are not allowed in a file name.
+     */
+    static string toFileName(const string &text);
+
+    /**
+     * Like toFileName(), but different texts always result in different file names. Object names may contain slashes
+     * and are longer than file names may be.
+     */
+    static string toUniqueFileName(const string &text);
+
+    bool download(const shared_ptr<S3RangeSource> &object, const path &target, uint partsInFlight, u_int64_t partSize);
+
+    /**
+     * Removes the copies of other versions of the object.
+     */
+    void removeOutdatedCopies(const path &current);
+
+public:
+
+    /**
+     * Longer object names are shortened, the appended hash keeps them unique.
+     */
+    static const uint MAXIMUM_FILE_NAME_LENGTH;
+
+    explicit IndexCache(const path &directory) : directory(directory) {}
+
+    path getDirectory() { return directory; }
+
+    /**
+     * Looks up the current version of the object (this needs a HEAD request) and returns the path of its copy. The copy
+     * might not exist yet.
+     * @return The path or an empty path, if the object could not be looked up.
+     */
+    path getCacheFile(const shared_ptr<S3RangeSource> &object);
+
+    /**
+     * Returns a source for the copy of the object. If there is no copy of its current version yet, it is downloaded with
+     * parallel ranged requests first.
+     * @return The source or nullptr on errors.
+     */
+    shared_ptr<Source> fetch(const shared_ptr<S3RangeSource> &object, uint partsInFlight, u_int64_t partSize);
+};
+
+#endif //FASTQINDEX_INDEXCACHE_H
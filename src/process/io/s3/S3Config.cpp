@@ -96,6 +96,7 @@ void S3Config::fillAWSClientConfiguration(Aws::Client::ClientConfiguration &conf
     configuration.proxyScheme = getProxyScheme();
     configuration.proxyHost = getProxyHost();
     configuration.proxyPort = getProxyPort();
+    configuration.scheme = getScheme();
     configuration.caFile = getCaFile();
     configuration.endpointOverride = getEndpointOverride();
     configuration.region = getRegion();
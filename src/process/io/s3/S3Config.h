@@ -244,7 +244,18 @@ public:
         return getSchemeSafe("", defaultConfiguration.proxyScheme);
     }
 
-    Scheme getScheme() { return getSchemeSafe("use_https", defaultConfiguration.scheme); }
+    /**
+     * use_https is a boolean in s3cmd configuration files. "http" and "https" are accepted as well.
+     */
+    Scheme getScheme() {
+        string value = getStringSafe("use_https");
+        transform(value.begin(), value.end(), value.begin(), ::tolower);
+        if (value == "true")
+            return Scheme::HTTPS;
+        if (value == "false")
+            return Scheme::HTTP;
+        return getSchemeSafe("use_https", defaultConfiguration.scheme);
+    }
 
 //    TransferLibType getHttpLibOverride() {
 //        return defaultConfiguration.httpLibOverride;
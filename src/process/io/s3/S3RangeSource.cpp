@@ -0,0 +1,146 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#include "S3RangeSource.h"
+#include "common/RunStatistics.h"
+#include "common/Tracer.h"
+#include <thread>
+
+const uint S3RangeSource::MAXIMUM_ATTEMPTS = 3;
+
+const chrono::milliseconds S3RangeSource::RETRY_DELAY(50);
+
+tuple<bool, int64_t, string> S3RangeSource::fetchObjectSizeAndETag() {
+    return fqiS3Client->getObjectSizeAndETag();
+}
+
+tuple<bool, int64_t> S3RangeSource::fetchRange(int64_t offset, int64_t length, Bytef *buffer) {
+    return fqiS3Client->readBlockOfData(offset, length, buffer);
+}
+
+void S3RangeSource::addErrorMessageSafe(const string &message) {
+    lock_guard<mutex> lock(errorMessageMutex);
+    addErrorMessage(message);
+}
+
+bool S3RangeSource::fulfillsPremises() {
+    if (!fqiS3Client)
+        return size() >= 0;
+
+    if (!fqiS3Client->isValid())
+        return false;
+
+    auto result = fqiS3Client->checkObjectExistence();
+    if (!result.success) {
+        addErrorMessage("Lookup for '", name, "' failed.");
+        return false;
+    }
+
+    if (!result.result) {
+        addErrorMessage("File '", name, "' does not exist. ");
+        return false;
+    }
+    return true;
+}
+
+bool S3RangeSource::open() {
+    if (_isOpen)
+        return true;
+    if (size() < 0) {
+        addErrorMessage("Could not request the size of '", name, "'.");
+        return false;
+    }
+    position = 0;
+    _isOpen = true;
+    return true;
+}
+
+bool S3RangeSource::close() {
+    _isOpen = false;
+    return true;
+}
+
+int64_t S3RangeSource::size() {
+    if (!sizeRequested) {
+        RunStatistics::count(S3_REQUESTS);
+        bool success;
+        int64_t size;
+        string tag;
+        {
+            FQI_TRACE_SPAN("S3 HEAD request");
+            ScopedRunTimer timer(TIME_IN_S3_REQUESTS);
+            tie(success, size, tag) = fetchObjectSizeAndETag();
+        }
+        objectSize = success ? size : -1;
+        eTag = tag;
+        sizeRequested = true;
+    }
+    return objectSize;
+}
+
+int64_t S3RangeSource::readAt(int64_t offset, Bytef *targetBuffer, int64_t length) {
+    if (!_isOpen || offset < 0)
+        return -1;
+    length = min(length, size() - offset);
+    if (length <= 0)
+        return 0;
+
+    for (uint attempt = 1; attempt <= MAXIMUM_ATTEMPTS; attempt++) {
+        if (attempt > 1)
+            this_thread::sleep_for(RETRY_DELAY * (1 << (attempt - 2)));
+        RunStatistics::count(S3_REQUESTS);
+        bool success;
+        int64_t readBytes;
+        {
+            FQI_TRACE_SPAN("S3 range request");
+            ScopedRunTimer timer(TIME_IN_S3_REQUESTS);
+            tie(success, readBytes) = fetchRange(offset, length, targetBuffer);
+        }
+        // The length ends at the end of the object at the latest, a shorter answer would look like its end.
+        if (success && readBytes == length) {
+            RunStatistics::count(S3_BYTES_RECEIVED, readBytes);
+            return readBytes;
+        }
+        RunStatistics::count(S3_FAILED_REQUESTS);
+        debug("Ranged request for '", name, "' at offset ", to_string(offset), " failed, attempt ",
+              to_string(attempt), success ? join(", only ", to_string(readBytes), " Bytes were received") : "");
+    }
+    addErrorMessageSafe(join("Could not read ", to_string(length), " Bytes at offset ", to_string(offset), " of '", name,
+                             "'."));
+    return -1;
+}
+
+int64_t S3RangeSource::read(Bytef *targetBuffer, int numberOfBytes) {
+    auto result = readAt(position, targetBuffer, numberOfBytes);
+    if (result > 0) {
+        position += result;
+        totalReadBytes += result;
+    }
+    return result;
+}
+
+int S3RangeSource::readChar() {
+    Byte result = 0;
+    auto res = read(&result, 1);
+    return res <= 0 ? -1 : static_cast<int>(result);
+}
+
+int64_t S3RangeSource::seek(int64_t nByte, bool absolute) {
+    int64_t target = absolute ? nByte : position + nByte;
+    if (target < 0)
+        return -1;
+    position = target;
+    return 1;
+}
+
+vector<string> S3RangeSource::getErrorMessages() {
+    lock_guard<mutex> lock(errorMessageMutex);
+    auto l = ErrorAccumulator::getErrorMessages();
+    if (!fqiS3Client)
+        return l;
+    auto r = fqiS3Client->getErrorMessages();
+    return concatenateVectors(l, r);
+}
@@ -0,0 +1,135 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#ifndef FASTQINDEX_S3RANGESOURCE_H
+#define FASTQINDEX_S3RANGESOURCE_H
+
+#include "process/io/Source.h"
+#include "process/io/s3/FQIS3Client.h"
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+/**
+ * Random access view of an S3 object. Every read is a ranged GET request, there is no buffering at all. The class is
+ * meant to be wrapped by a ReadAheadSource, which runs several of these requests in parallel, see S3Source.
+ *
+ * readAt() is thread safe. The sequential read methods are not.
+ */
+class S3RangeSource : public Source {
+
+private:
+
+    bool _isOpen{false};
+
+    bool sizeRequested{false};
+
+    int64_t objectSize{-1};
+
+    string eTag;
+
+    int64_t position{0};
+
+    mutex errorMessageMutex;
+
+protected:
+
+    string name;
+
+    shared_ptr<FQIS3Client> fqiS3Client;
+
+    /**
+     * For test implementations which don't access S3.
+     */
+    explicit S3RangeSource(const string &name) : name(name) {}
+
+    /**
+     * Requests size and ETag of the object.
+     * @return A tuple indicating [success, size, ETag]
+     */
+    virtual tuple<bool, int64_t, string> fetchObjectSizeAndETag();
+
+    /**
+     * Downloads length Bytes starting at offset. Must be thread safe.
+     * @return A tuple indicating [success, read Bytes]
+     */
+    virtual tuple<bool, int64_t> fetchRange(int64_t offset, int64_t length, Bytef *buffer);
+
+    void addErrorMessageSafe(const string &message);
+
+public:
+
+    /**
+     * Failed requests are repeated this often.
+     */
+    static const uint MAXIMUM_ATTEMPTS;
+
+    /**
+     * The wait time before the first repetition of a failed request, it is doubled for every further repetition.
+     */
+    static const chrono::milliseconds RETRY_DELAY;
+
+    S3RangeSource(const string &s3Path, const S3ServiceOptions &s3ServiceOptions) :
+            name(s3Path),
+            fqiS3Client(make_shared<FQIS3Client>(s3Path, s3ServiceOptions)) {}
+
+    shared_ptr<FQIS3Client> getClient() { return fqiS3Client; }
+
+    /**
+     * The ETag of the object, as reported when the source was opened.
+     */
+    string getETag() { return eTag; }
+
+    bool fulfillsPremises() override;
+
+    bool open() override;
+
+    bool openWithReadLock() override { return open(); }
+
+    bool close() override;
+
+    bool isOpen() override { return _isOpen; }
+
+    bool eof() override { return position >= size(); }
+
+    bool isGood() override { return true; }
+
+    bool isFile() override { return true; }
+
+    bool isStream() override { return true; }
+
+    bool isSymlink() override { return false; }
+
+    bool exists() override { return size() >= 0; }
+
+    int64_t size() override;
+
+    bool empty() override { return size() <= 0; }
+
+    bool canRead() override { return position < size(); }
+
+    bool canWrite() override { return false; }
+
+    int64_t readAt(int64_t offset, Bytef *targetBuffer, int64_t length) override;
+
+    int64_t read(Bytef *targetBuffer, int numberOfBytes) override;
+
+    int readChar() override;
+
+    int64_t seek(int64_t nByte, bool absolute) override;
+
+    int64_t skip(int64_t nBytes) override { return seek(nBytes, false); }
+
+    int64_t tell() override { return position; }
+
+    string toString() override { return name; }
+
+    int lastError() override { return 0; }
+
+    vector<string> getErrorMessages() override;
+};
+
+#endif //FASTQINDEX_S3RANGESOURCE_H
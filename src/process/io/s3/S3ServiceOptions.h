@@ -9,6 +9,7 @@
 
 #include <experimental/filesystem>
 #include <string>
+#include <sys/types.h>
 
 using namespace std;
 using namespace std::experimental::filesystem;
@@ -21,12 +22,31 @@ struct S3ServiceOptions {
 
     string configSection;
 
+    /**
+     * Objects are downloaded with ranged requests and uploaded in parts of this size.
+     */
+    u_int64_t partSize{8 * 1024 * 1024};
+
+    /**
+     * The number of ranged requests or part uploads which are run in parallel.
+     */
+    uint partsInFlight{8};
+
+    /**
+     * Index files in S3 are copied to this directory and read from there, see IndexCache. Empty to disable the cache.
+     */
+    path indexCacheDirectory;
+
     S3ServiceOptions() : S3ServiceOptions(string(""), string(""), "") {}
 
     S3ServiceOptions(const string &credentialsFile, const string &configFile, const string &configSection);
 
     S3ServiceOptions(const S3ServiceOptions &opts)
-            : S3ServiceOptions(opts.credentialsFile, opts.configFile, opts.configSection) {};
+            : S3ServiceOptions(opts.credentialsFile, opts.configFile, opts.configSection) {
+        partSize = opts.partSize;
+        partsInFlight = opts.partsInFlight;
+        indexCacheDirectory = opts.indexCacheDirectory;
+    };
 };
 
 #endif //FASTQINDEX_S3SERVICEOPTIONS_H
@@ -0,0 +1,342 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#include "S3Sink.h"
+#include "S3RangeSource.h"
+#include <cstring>
+
+const u_int64_t S3Sink::MINIMUM_PART_SIZE = 5 * 1024 * 1024;
+
+const uint S3Sink::MAXIMUM_ATTEMPTS = 3;
+
+S3Sink::~S3Sink() {
+    // Subclasses are already destroyed here, so only the non-virtual parts are used. The upload is not completed, an
+    // unclosed sink might still miss data.
+    if (!_isOpen)
+        return;
+    stopUploads();
+    if (uploadStarted && fqiS3Client)
+        fqiS3Client->abortMultipartUpload(uploadId);
+    ErrorAccumulator::severe(join("The upload of '", name, "' was not closed and is aborted."));
+    release();
+}
+
+tuple<bool, string> S3Sink::createMultipartUpload() {
+    return fqiS3Client->createMultipartUpload();
+}
+
+tuple<bool, string> S3Sink::uploadPart(const string &uploadId, int partNumber, const char *data, int64_t length) {
+    return fqiS3Client->uploadPart(uploadId, partNumber, data, length);
+}
+
+bool S3Sink::completeMultipartUpload(const string &uploadId, const map<int, string> &parts) {
+    return fqiS3Client->completeMultipartUpload(uploadId, parts);
+}
+
+bool S3Sink::abortMultipartUpload(const string &uploadId) {
+    return fqiS3Client->abortMultipartUpload(uploadId);
+}
+
+bool S3Sink::putObject(const char *data, int64_t length) {
+    return fqiS3Client->putData(data, length);
+}
+
+bool S3Sink::open() {
+    if (isOpen())
+        return true;
+
+    if (fqiS3Client) {
+        if (!fqiS3Client->isValid())
+            return false;
+
+        auto result = fqiS3Client->checkObjectExistence();
+        if (!result.success)
+            return false;
+
+        objectAlreadyExists = result.result;
+
+        if (objectAlreadyExists && !this->forceOverwrite) {
+            addErrorMessage("File '", name, "' already exists. ",
+                            "Use -w to force the application to overwrite the file.");
+            return false;
+        }
+    }
+
+    reset();
+    firstPart.reserve(partSize);
+    _isOpen = true;
+    return true;
+}
+
+void S3Sink::reset() {
+    firstPart.clear();
+    currentPart.clear();
+    currentPartNumber = 1;
+    position = 0;
+    writtenSize = 0;
+    writeFailed = false;
+    uploadId.clear();
+    uploadStarted = false;
+    uploadQueue.clear();
+    freeBuffers.clear();
+    allocatedBuffers = 0;
+    runningUploads = 0;
+    uploadedParts.clear();
+    uploadFailed = false;
+    stopUploaders = false;
+}
+
+bool S3Sink::startUpload() {
+    auto[success, id] = createMultipartUpload();
+    if (!success) {
+        addErrorMessage("Could not start the upload of '", name, "'.");
+        return false;
+    }
+    uploadId = id;
+    uploadStarted = true;
+    for (uint i = 0; i < partsInFlight; i++)
+        uploaders.emplace_back(&S3Sink::uploaderLoop, this);
+    return true;
+}
+
+void S3Sink::uploaderLoop() {
+    while (true) {
+        int partNumber;
+        vector<char> data;
+        {
+            unique_lock<mutex> lock(uploadMutex);
+            uploadStateChanged.wait(lock, [this] { return stopUploaders || !uploadQueue.empty(); });
+            if (uploadQueue.empty())
+                return;
+            tie(partNumber, data) = std::move(uploadQueue.front());
+            uploadQueue.pop_front();
+            runningUploads++;
+        }
+
+        bool success = false;
+        string eTag;
+        for (uint attempt = 1; attempt <= MAXIMUM_ATTEMPTS && !success; attempt++) {
+            // Back off like the ranged requests, a failed part is most likely caused by throttling or a network issue.
+            if (attempt > 1)
+                this_thread::sleep_for(S3RangeSource::RETRY_DELAY * (1 << (attempt - 2)));
+            tie(success, eTag) = uploadPart(uploadId, partNumber, data.data(), static_cast<int64_t>(data.size()));
+            if (!success)
+                debug("Upload of part ", to_string(partNumber), " of '", name, "' failed, attempt ", to_string(attempt));
+        }
+
+        {
+            lock_guard<mutex> lock(uploadMutex);
+            runningUploads--;
+            if (success) {
+                uploadedParts[partNumber] = eTag;
+            } else {
+                uploadFailed = true;
+                addErrorMessage("Could not upload part ", to_string(partNumber), " of '", name, "'.");
+            }
+            // The first part is not taken from the pool.
+            if (partNumber > 1) {
+                data.clear();
+                freeBuffers.emplace_back(std::move(data));
+            }
+        }
+        uploadStateChanged.notify_all();
+    }
+}
+
+bool S3Sink::acquireBuffer(vector<char> &buffer) {
+    unique_lock<mutex> lock(uploadMutex);
+    // The current part needs one buffer, the others may be uploaded in the meantime.
+    uploadStateChanged.wait(lock, [this] {
+        return uploadFailed || !freeBuffers.empty() || allocatedBuffers < partsInFlight + 1;
+    });
+    if (uploadFailed)
+        return false;
+    if (!freeBuffers.empty()) {
+        buffer = std::move(freeBuffers.back());
+        freeBuffers.pop_back();
+    } else {
+        buffer = vector<char>();
+        buffer.reserve(partSize);
+        allocatedBuffers++;
+    }
+    return true;
+}
+
+void S3Sink::queuePart(int partNumber, vector<char> &&data) {
+    {
+        lock_guard<mutex> lock(uploadMutex);
+        uploadQueue.emplace_back(partNumber, std::move(data));
+    }
+    uploadStateChanged.notify_all();
+}
+
+bool S3Sink::startNextPart() {
+    // All parts but the last one need to be complete. If the writer jumped over some data, it is filled with zeros.
+    if (currentPartNumber == 1) {
+        firstPart.resize(partSize);
+        if (!uploadStarted && !startUpload())
+            return false;
+    } else {
+        currentPart.resize(partSize);
+        queuePart(currentPartNumber, std::move(currentPart));
+    }
+    if (!acquireBuffer(currentPart)) {
+        addErrorMessageSafe(join("Stopped writing to '", name, "' as the upload failed."));
+        return false;
+    }
+    currentPartNumber++;
+    return true;
+}
+
+void S3Sink::write(const char *message) {
+    write(message, static_cast<int>(strlen(message)));
+}
+
+void S3Sink::write(const string &message) {
+    write(message.c_str(), static_cast<int>(message.size()));
+}
+
+void S3Sink::write(const char *message, int len) {
+    if (!_isOpen || writeFailed)
+        return;
+
+    auto remaining = static_cast<int64_t>(len);
+    while (remaining > 0) {
+        int64_t partIndex = position / static_cast<int64_t>(partSize);
+        int partNumber = static_cast<int>(partIndex) + 1;
+        if (partNumber > currentPartNumber) {
+            if (!startNextPart()) {
+                writeFailed = true;
+                return;
+            }
+            continue;
+        }
+
+        vector<char> *part{nullptr};
+        if (partNumber == 1)
+            part = &firstPart;
+        else if (partNumber == currentPartNumber)
+            part = &currentPart;
+        else {
+            addErrorMessageSafe(join("Could not write to offset ", to_string(position), " of '", name,
+                                     "', the data at this position was already uploaded."));
+            writeFailed = true;
+            return;
+        }
+
+        auto offsetInPart = static_cast<u_int64_t>(position - partIndex * static_cast<int64_t>(partSize));
+        auto chunk = static_cast<u_int64_t>(min(remaining, static_cast<int64_t>(partSize - offsetInPart)));
+        if (part->size() < offsetInPart + chunk)
+            part->resize(offsetInPart + chunk); // Gaps are filled with zeros.
+        memcpy(part->data() + offsetInPart, message, chunk);
+
+        message += chunk;
+        remaining -= chunk;
+        position += chunk;
+        writtenSize = max(writtenSize, position);
+    }
+}
+
+int64_t S3Sink::seek(int64_t nByte, bool absolute) {
+    if (!_isOpen)
+        return 0;
+    int64_t target = absolute ? nByte : position + nByte;
+    if (target < 0)
+        return 0;
+    position = target;
+    return 1;
+}
+
+bool S3Sink::finishUploads() {
+    {
+        unique_lock<mutex> lock(uploadMutex);
+        uploadStateChanged.wait(lock, [this] { return uploadQueue.empty() && runningUploads == 0; });
+        stopUploaders = true;
+    }
+    uploadStateChanged.notify_all();
+    for (auto &uploader : uploaders)
+        uploader.join();
+    uploaders.clear();
+    return !uploadFailed;
+}
+
+void S3Sink::stopUploads() {
+    {
+        lock_guard<mutex> lock(uploadMutex);
+        uploadQueue.clear();
+    }
+    finishUploads();
+}
+
+void S3Sink::release() {
+    firstPart = vector<char>();
+    currentPart = vector<char>();
+    freeBuffers.clear();
+    _isOpen = false;
+}
+
+bool S3Sink::closeWithoutPublishing() {
+    if (!isOpen())
+        return true;
+
+    stopUploads();
+    bool ok = !uploadStarted || abortMultipartUpload(uploadId);
+    debug("The upload of '", name, "' was discarded.");
+    release();
+    return ok;
+}
+
+bool S3Sink::close() {
+    if (!isOpen())
+        return true;
+
+    bool ok = !writeFailed;
+    if (!uploadStarted) {
+        // Everything fits into the first part.
+        if (ok)
+            ok = putObject(firstPart.data(), static_cast<int64_t>(firstPart.size()));
+    } else {
+        if (ok) {
+            // A seek might have moved the end of the data into the current part without writing to it.
+            auto lastPartLength = static_cast<u_int64_t>(writtenSize - (currentPartNumber - 1) * partSize);
+            currentPart.resize(lastPartLength);
+            queuePart(currentPartNumber, std::move(currentPart));
+            queuePart(1, std::move(firstPart));
+        }
+        ok = finishUploads() && ok;
+        if (ok)
+            ok = completeMultipartUpload(uploadId, uploadedParts);
+        if (!ok) {
+            addErrorMessage("The upload of '", name, "' failed and is aborted.");
+            abortMultipartUpload(uploadId);
+        }
+    }
+
+    if (ok)
+        info(join("Uploaded '", name, "' (", to_string(writtenSize), " Bytes)"));
+
+    release();
+    return ok;
+}
+
+void S3Sink::addErrorMessageSafe(const string &message) {
+    lock_guard<mutex> lock(uploadMutex);
+    addErrorMessage(message);
+}
+
+bool S3Sink::isGood() {
+    lock_guard<mutex> lock(uploadMutex);
+    return !writeFailed && !uploadFailed;
+}
+
+vector<string> S3Sink::getErrorMessages() {
+    lock_guard<mutex> lock(uploadMutex);
+    auto l = ErrorAccumulator::getErrorMessages();
+    if (!fqiS3Client)
+        return l;
+    auto r = fqiS3Client->getErrorMessages();
+    return concatenateVectors(l, r);
+}
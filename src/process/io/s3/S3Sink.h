@@ -8,134 +8,226 @@
 #define FASTQINDEX_S3SINK_H
 
 #include "common/StringHelper.h"
-#include "process/io/FileSink.h"
 #include "process/io/Sink.h"
 #include "S3Config.h"
 #include "FQIS3Client.h"
-#include <cstdio>
-#include <fcntl.h>
+#include <condition_variable>
+#include <deque>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
-#include <aws/core/auth/AWSAuthSigner.h>
-#include <aws/core/auth/AWSCredentialsProvider.h>
-#include <aws/core/utils/HashingUtils.h>
-#include <aws/core/Aws.h>
-#include <aws/s3/model/ListObjectsRequest.h>
-#include <aws/s3/model/PutObjectRequest.h>
-#include <aws/s3/S3Client.h>
-
-using namespace Aws::Utils;
-using namespace Aws::S3;
-using namespace Aws::S3::Model;
-
+/**
+ * Sink which streams its data to an S3 object with a multipart upload. No local temporary file is needed.
+ *
+ * The data is collected in parts of S3ServiceOptions::partSize Bytes. Full parts are uploaded by background threads,
+ * up to S3ServiceOptions::partsInFlight of them in parallel. If all of them are busy, write() blocks. The memory
+ * consumption is therefore bounded by (partsInFlight + 2) * partSize.
+ *
+ * The first part is kept in memory and uploaded last, when the sink is closed. This allows small patches at the
+ * beginning of the object, e.g. of the index header. Apart from that, seek() is only allowed within the part which is
+ * currently filled, writes to parts which were already uploaded fail.
+ *
+ * Objects which are not larger than a single part are uploaded with a single PUT request.
+ *
+ * Call close() to finish the upload. A sink which is destroyed while it is still open aborts its upload. Subclasses
+ * which override the request methods need to close the sink in their own destructor, the upload threads would call
+ * into the destroyed subclass otherwise.
+ */
 class S3Sink : public Sink {
+
 private:
 
     bool _isOpen{false};
 
     bool objectAlreadyExists{false};
 
-    FileSink *tempFile{nullptr};
+    u_int64_t partSize;
 
-    FQIS3Client fqiS3Client;
+    uint partsInFlight;
 
-public:
+    /**
+     * Part 1 of the object, it is uploaded on close().
+     */
+    vector<char> firstPart;
 
-    static shared_ptr<S3Sink> from(const string &file, bool forceOverwrite, const S3ServiceOptions &s3ServiceOptions) {
-        return make_shared<S3Sink>(file, forceOverwrite, s3ServiceOptions);
-    }
+    /**
+     * The part which is filled at the moment. If currentPartNumber is 1, firstPart is used instead.
+     */
+    vector<char> currentPart;
 
-    S3Sink(const string &s3Path, bool forceOverwrite, const S3ServiceOptions &s3ServiceOptions) :
-            fqiS3Client(s3Path, s3ServiceOptions),
-            Sink(forceOverwrite) {
-    }
+    int currentPartNumber{1};
 
-    ~S3Sink() override {
-        close();
-    }
+    int64_t position{0};
 
-    bool openWithWriteLock() override {
-        return open();
-    }
+    int64_t writtenSize{0};
 
-    bool fulfillsPremises() override {
-        return true;
-    }
+    /**
+     * Set, if a write was rejected.
+     */
+    bool writeFailed{false};
+
+    string uploadId;
+
+    bool uploadStarted{false};
+
+    /*
+     * Everything below is shared with the upload threads and guarded by uploadMutex.
+     */
+
+    mutex uploadMutex;
+
+    condition_variable uploadStateChanged;
+
+    deque<tuple<int, vector<char>>> uploadQueue;
+
+    vector<vector<char>> freeBuffers;
+
+    /**
+     * The number of part buffers which were allocated, except for the first part.
+     */
+    uint allocatedBuffers{0};
+
+    uint runningUploads{0};
+
+    map<int, string> uploadedParts;
+
+    bool uploadFailed{false};
+
+    bool stopUploaders{false};
+
+    vector<thread> uploaders;
+
+    void uploaderLoop();
 
+    bool startUpload();
 
-    bool open() override {
-        if (isOpen())
-            return true;
+    /**
+     * Waits for a free part buffer.
+     */
+    bool acquireBuffer(vector<char> &buffer);
 
-        if (!fqiS3Client.isValid()) {
-            return false;
-        }
+    /**
+     * Hands the current part over to the upload threads and starts the next part.
+     */
+    bool startNextPart();
 
-        // Assign these values before running the program
-        bool ok = true;
+    void queuePart(int partNumber, vector<char> &&data);
 
-        auto result = fqiS3Client.checkObjectExistence();
-        if (!result.success)
-            return false;
+    /**
+     * Waits for all queued and running uploads and stops the upload threads.
+     * @return true, if all parts were uploaded.
+     */
+    bool finishUploads();
 
-        objectAlreadyExists = result.result;
+    /**
+     * Drops the queued parts, waits for the running uploads and stops the upload threads.
+     */
+    void stopUploads();
 
-        if (objectAlreadyExists && !this->forceOverwrite) {
-            addErrorMessage("File '", this->fqiS3Client.getS3Path(), "' already exists. ",
-                            "Use -w to force the application to overwrite the file.");
-            return false;
-        }
+    /**
+     * Frees the part buffers and marks the sink as closed.
+     */
+    void release();
 
-        auto[success, tempFilePath] = IOHelper::createTempFile("FastqIndEx_S3TemporaryIndex");
-        if (!success) {
-            addErrorMessage("Could not create an intermediate temporary file for '", fqiS3Client.getS3Path(), "'.");
-            return false;
-        }
+    void reset();
 
-        this->tempFile = new FileSink(tempFilePath, true);
-        if (!tempFile->openWithWriteLock()) {
-            delete tempFile;
-            tempFile = nullptr;
-            return false;
-        }
+    /**
+     * The upload threads add error messages as well.
+     */
+    void addErrorMessageSafe(const string &message);
 
-        _isOpen = ok;
-        return ok;
+protected:
+
+    string name;
+
+    shared_ptr<FQIS3Client> fqiS3Client;
+
+    /**
+     * For test implementations which don't access S3.
+     */
+    S3Sink(const string &name, u_int64_t partSize, uint partsInFlight) :
+            Sink(true),
+            partSize(max(partSize, static_cast<u_int64_t>(1))),
+            partsInFlight(max(partsInFlight, 1U)),
+            name(name) {}
+
+    /**
+     * Starts a multipart upload.
+     * @return A tuple indicating [success, upload id]
+     */
+    virtual tuple<bool, string> createMultipartUpload();
+
+    /**
+     * Uploads a part. Must be thread safe.
+     * @return A tuple indicating [success, ETag]
+     */
+    virtual tuple<bool, string> uploadPart(const string &uploadId, int partNumber, const char *data, int64_t length);
+
+    virtual bool completeMultipartUpload(const string &uploadId, const map<int, string> &parts);
+
+    virtual bool abortMultipartUpload(const string &uploadId);
+
+    /**
+     * Uploads the whole object with a single request.
+     */
+    virtual bool putObject(const char *data, int64_t length);
+
+public:
+
+    /**
+     * S3 rejects smaller parts (except for the last one).
+     */
+    static const u_int64_t MINIMUM_PART_SIZE;
+
+    /**
+     * Failed part uploads are repeated this often. The delays between the attempts are the ones of
+     * S3RangeSource::RETRY_DELAY.
+     */
+    static const uint MAXIMUM_ATTEMPTS;
+
+    static shared_ptr<S3Sink> from(const string &file, bool forceOverwrite, const S3ServiceOptions &s3ServiceOptions) {
+        return make_shared<S3Sink>(file, forceOverwrite, s3ServiceOptions);
     }
 
-    bool close() override {
-        if (!isOpen())
-            return true;
+    S3Sink(const string &s3Path, bool forceOverwrite, const S3ServiceOptions &s3ServiceOptions) :
+            Sink(forceOverwrite),
+            partSize(max(s3ServiceOptions.partSize, MINIMUM_PART_SIZE)),
+            partsInFlight(max(s3ServiceOptions.partsInFlight, 1U)),
+            name(s3Path),
+            fqiS3Client(make_shared<FQIS3Client>(s3Path, s3ServiceOptions)) {
+    }
 
-        auto result = fqiS3Client.putFile(tempFile->toString());
-        bool ok = result.success && result.result;
-        if (result.result)
-            ErrorAccumulator::always("Uploaded FQI file to bucket s3://", fqiS3Client.getBucketName());
+    ~S3Sink() override;
 
+    bool openWithWriteLock() override {
+        return open();
+    }
 
-        if (tempFile) {
-            ok = tempFile->close();
-            if (tempFile->exists())
-                remove(tempFile->getPath());
-            delete tempFile;
-            tempFile = nullptr;
-        }
-        _isOpen = false;
-        return ok;
+    bool fulfillsPremises() override {
+        return true;
     }
 
+    bool open() override;
+
+    bool close() override;
+
+    /**
+     * Aborts the upload, an existing object stays as it is.
+     */
+    bool closeWithoutPublishing() override;
+
     bool isOpen() override {
-        return tempFile && _isOpen;
+        return _isOpen;
     }
 
     bool eof() override {
-        return tempFile && tempFile->eof();
+        return false;
     }
 
-    bool isGood() override {
-
-        return tempFile && tempFile->isGood();
-    }
+    bool isGood() override;
 
     bool isFile() override {
         return true;
@@ -150,72 +242,60 @@ public:
     }
 
     bool exists() override {
-        return tempFile && tempFile->exists();
+        return _isOpen || objectAlreadyExists;
     }
 
     int64_t size() override {
-        return tempFile ? tempFile->size() : 0;
+        return writtenSize;
     }
 
     bool empty() override {
-        return tempFile ? tempFile->empty() : true;
+        return writtenSize == 0;
     }
 
     bool canRead() override {
-        return tempFile && tempFile->canRead();
+        return false;
     }
 
     bool canWrite() override {
-        //Also check for existence...
-        return tempFile && tempFile->canWrite();
+        return !writeFailed;
     }
 
-    int64_t seek(int64_t nByte, bool absolute) override {
-        return tempFile ? tempFile->seek(nByte, absolute) : 0;
-    }
+    u_int64_t getPartSize() { return partSize; }
+
+    /**
+     * Seeks are always possible, but writes will fail, if the position lies in a part which was already uploaded.
+     */
+    int64_t seek(int64_t nByte, bool absolute) override;
 
     int64_t skip(int64_t nByte) override {
-        return tempFile ? tempFile->skip(nByte) : 0;
+        return seek(nByte, false);
     }
 
     string toString() override {
-        return fqiS3Client.getS3Path();
+        return name;
     }
 
     int64_t tell() override {
-        return tempFile ? tempFile->tell() : 0;
+        return position;
     }
 
     int lastError() override {
         return 0;
     }
 
-    void write(const char *message) override {
-        if (tempFile)tempFile->write(message);
-    }
+    void write(const char *message) override;
 
-    void write(const char *message, int len) override {
-        if (tempFile) tempFile->write(message, len);
-    }
+    void write(const char *message, int len) override;
 
-    void write(const string &message) override {
-        if (tempFile) tempFile->write(message);
-    }
+    void write(const string &message) override;
 
-    void flush() override {
-        if (tempFile) tempFile->flush();
-    }
+    /**
+     * Nothing to do, parts are uploaded as soon as they are complete.
+     */
+    void flush() override {}
 
-    vector<string> getErrorMessages() override {
-        auto l = ErrorAccumulator::getErrorMessages();
-        auto r = fqiS3Client.getErrorMessages();
-        if (!tempFile) {
-            return concatenateVectors(l, r);
-        } else {
-            auto s = tempFile->getErrorMessages();
-            return concatenateVectors(l, r, s);
-        }
-    }
+    vector<string> getErrorMessages() override;
 
 };
 
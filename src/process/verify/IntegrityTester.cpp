@@ -0,0 +1,63 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#include "IntegrityTester.h"
+#include <iostream>
+#include <zlib.h>
+
+IntegrityTester::IntegrityTester(const SourceFactory &createSource, const shared_ptr<Source> &indexFile,
+                                 uint threads) : Verifier(createSource, indexFile, threads) {
+}
+
+bool IntegrityTester::test() {
+    if (!readEntries())
+        return false;
+
+    decompressIntervals(0, true);
+
+    uLong crc = crc32(0L, Z_NULL, 0);
+    u_int64_t length{0};
+    int64_t intervalOfStreamStart{0};
+    for (int64_t i = 0; i < numberOfIntervals && firstCorruptInterval == -1; i++) {
+        auto &interval = intervals[i];
+        if (!interval->wasSuccessful()) {
+            reportFailedInterval(i);
+            firstCorruptInterval = i;
+            break;
+        }
+        for (const auto &segment : interval->getSegments()) {
+            crc = crc32_combine(crc, segment.crc, static_cast<z_off_t>(segment.length));
+            length += segment.length;
+            if (!segment.endsStream)
+                continue;
+
+            // ISIZE is the size modulo 2^32.
+            if (crc != segment.trailerCRC || static_cast<u_int32_t>(length) != segment.trailerSize) {
+                reportProblem("The gzip stream #" + to_string(numberOfStreams) + " with the trailer at offset " +
+                              to_string(segment.trailerOffset) + " does not match its CRC32 or size. It starts in " +
+                              "the interval after index entry #" + to_string(intervalStart(intervalOfStreamStart)) +
+                              ".");
+                firstCorruptInterval = intervalOfStreamStart;
+                break;
+            }
+            numberOfStreams++;
+            decompressedBytes += length;
+            crc = crc32(0L, Z_NULL, 0);
+            length = 0;
+            intervalOfStreamStart = i;
+        }
+    }
+
+    if (firstCorruptInterval >= 0) {
+        severe("The file is corrupt. The first corrupt interval starts at offset " +
+               to_string(firstCorruptInterval > 0 ? entries[intervalStart(firstCorruptInterval)].blockOffsetInRawFile
+                                                  : 0) + ".");
+        return false;
+    }
+    cerr << "Tested " << numberOfStreams << " gzip streams with " << decompressedBytes << " Bytes of data in "
+         << numberOfIntervals << " intervals with " << min<int64_t>(threads, numberOfIntervals) << " threads.\n";
+    return true;
+}
@@ -0,0 +1,47 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#ifndef FASTQINDEX_INTEGRITYTESTER_H
+#define FASTQINDEX_INTEGRITYTESTER_H
+
+#include "process/verify/Verifier.h"
+
+/**
+ * Tests the integrity of a compressed FASTQ file like gzip -t, but with many threads. The intervals of the Verifier are
+ * decompressed in parallel, each calculates the CRC32 of its part of the data. The CRC32s of the parts of a gzip stream
+ * are combined with crc32_combine() and compared to the CRC32 and size in the trailer of the stream.
+ */
+class IntegrityTester : public Verifier {
+
+private:
+
+    u_int64_t numberOfStreams{0};
+
+    u_int64_t decompressedBytes{0};
+
+    /**
+     * The interval, which failed first, or -1.
+     */
+    int64_t firstCorruptInterval{-1};
+
+public:
+
+    IntegrityTester(const SourceFactory &createSource, const shared_ptr<Source> &indexFile, uint threads);
+
+    /**
+     * @return true, if all gzip streams could be decompressed and match their trailers.
+     */
+    bool test();
+
+    u_int64_t getNumberOfStreams() { return numberOfStreams; }
+
+    u_int64_t getDecompressedBytes() { return decompressedBytes; }
+
+    int64_t getFirstCorruptInterval() { return firstCorruptInterval; }
+};
+
+
+#endif //FASTQINDEX_INTEGRITYTESTER_H
@@ -0,0 +1,288 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#include "common/RunStatistics.h"
+#include "common/Tracer.h"
+#include "IntervalVerifier.h"
+#include <cstring>
+
+IntervalVerifier::IntervalVerifier(const shared_ptr<Source> &source,
+                                   const vector<VerifiedIndexEntry> &entries,
+                                   const shared_ptr<IndexEntry> &startEntry,
+                                   int64_t firstEntry,
+                                   int64_t endEntry,
+                                   uint numberOfSampledLines,
+                                   u_int64_t seed) :
+        ZLibBasedFASTQProcessorBaseClass(source, shared_ptr<Source>(nullptr), false),
+        entries(entries),
+        startEntry(startEntry),
+        nextEntry(firstEntry),
+        endEntry(endEntry),
+        numberOfSampledLines(numberOfSampledLines),
+        randomState(seed) {
+}
+
+/**
+ * splitmix64, see http://prng.di.unimi.it/splitmix64.c
+ */
+u_int64_t IntervalVerifier::nextRandom() {
+    u_int64_t z = (randomState += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30U)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27U)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31U);
+}
+
+bool IntervalVerifier::verify() {
+    FQI_TRACE_SPAN("verify interval");
+    wasStarted = true;
+    sourceFile->open();
+    if (computeChecksums)
+        segments.emplace_back();
+
+    bool prepared;
+    if (startEntry) {
+        prepared = prepareForStartEntry();
+    } else {
+        sourceFile->adviseRange(0, !endsWithFile() ? entries[endEntry].blockOffsetInRawFile : 0);
+        lineStartsAtNextByte = numberOfSampledLines > 0;
+        prepared = initializeZStreamForInflate();
+    }
+
+    finishedSuccessful = prepared && decompressInterval();
+    inflateEnd(&zStream);
+    sourceFile->close();
+    return finishedSuccessful;
+}
+
+bool IntervalVerifier::prepareForStartEntry() {
+    if (!initializeZStreamForRawInflate())
+        return false;
+
+    off_t initialOffset = startEntry->blockOffsetInRawFile;
+    if (startEntry->bits > 0)
+        initialOffset--;
+    int64_t endOffset = !endsWithFile() ? entries[endEntry].blockOffsetInRawFile : 0;
+    sourceFile->setReadStart(initialOffset);
+    sourceFile->adviseRange(initialOffset, endOffset > initialOffset ? endOffset - initialOffset : 0);
+
+    if (!seekAndPrimeZStreamForIndexEntry(startEntry) || !setDictionaryForIndexEntry(startEntry))
+        return false;
+
+    currentStreamIsRawDeflateStream = true;
+    boundaries.push_back({nextEntry, 0, -1});
+    openBoundary = 0;
+    newlinesOfOpenBoundary = 0;
+    nextEntry++;
+    return true;
+}
+
+bool IntervalVerifier::prepareForNextConcatenatedPart() {
+    // Like for the Extractor, the next gzip stream starts directly after the trailer of the current one.
+    if (currentStreamIsRawDeflateStream)
+        totalBytesIn += 8;
+    currentStreamIsRawDeflateStream = false;
+
+    sourceFile->seek(totalBytesIn, true);
+    if (!sourceFile->canRead())
+        return false;
+
+    inflateEnd(&zStream);
+    if (!initializeZStreamForInflate()) {
+        errorWasRaised = true;
+        return false;
+    }
+    return true;
+}
+
+bool IntervalVerifier::decompressInterval() {
+    while (true) {
+        if (zStream.avail_in == 0) {
+            if (!sourceFile->canRead()) {
+                addErrorMessage("The compressed data in '", sourceFile->toString(), "' ended unexpectedly at offset ",
+                                to_string(totalBytesIn), ".");
+                return false;
+            }
+            if (!readCompressedDataFromSource())
+                return false;
+        }
+
+        if (!inflateNextChunk())
+            return false;
+
+        if (zlibResult == Z_STREAM_END) {
+            openBoundary = -1;
+            if (computeChecksums && !readStreamTrailer())
+                return false;
+            if (prepareForNextConcatenatedPart())
+                continue;
+            if (errorWasRaised)
+                return false;
+            // End of the file.
+            reportMissingEntries(endEntry);
+            if (numberOfSampledLines > 0 && capturingSample >= 0 && !endsWithFile())
+                sampledLines.erase(sampledLines.begin() + capturingSample);
+            return true;
+        }
+
+        if (checkStreamForBlockEnd() && !processBlockEnd())
+            return true;
+    }
+}
+
+bool IntervalVerifier::inflateNextChunk() {
+    resetSlidingWindowIfNecessary();
+    const Bytef *output = zStream.next_out;
+    int64_t availableInBeforeInflate = zStream.avail_in;
+    int64_t availableOutBeforeInflate = zStream.avail_out;
+
+    {
+        FQI_TRACE_SPAN("inflate");
+        ScopedRunTimer timer(TIME_IN_INFLATE);
+        zlibResult = inflate(&zStream, Z_BLOCK);
+    }
+    int64_t readBytes = availableInBeforeInflate - zStream.avail_in;
+    int64_t writtenBytes = availableOutBeforeInflate - zStream.avail_out;
+    totalBytesIn += readBytes;
+    totalBytesOut += writtenBytes;
+    RunStatistics::count(COMPRESSED_BYTES_READ, readBytes);
+    RunStatistics::count(UNCOMPRESSED_BYTES_PRODUCED, writtenBytes);
+
+    if (zlibResult == Z_NEED_DICT || zlibResult == Z_DATA_ERROR || zlibResult == Z_MEM_ERROR) {
+        addErrorMessage("The data in '", sourceFile->toString(), "' could not be decompressed at offset ",
+                        to_string(totalBytesIn), ". zlib reported: '", zStream.msg ? zStream.msg : "", "'.");
+        errorWasRaised = true;
+        return false;
+    }
+
+    if (computeChecksums && writtenBytes > 0) {
+        auto &segment = segments.back();
+        segment.crc = crc32(segment.crc, output, static_cast<uInt>(writtenBytes));
+        segment.length += writtenBytes;
+    }
+    scanDecompressedData(output, static_cast<u_int64_t>(writtenBytes));
+    return true;
+}
+
+/**
+ * The trailer consists of the CRC32 and the size (ISIZE, modulo 2^32) of the decompressed data, both little endian.
+ * The raw inflate stops in front of it, the gzip inflate already consumed it.
+ */
+bool IntervalVerifier::readStreamTrailer() {
+    int64_t trailerOffset = currentStreamIsRawDeflateStream ? totalBytesIn : totalBytesIn - 8;
+    Bytef trailer[8]{0};
+    if (sourceFile->readAt(trailerOffset, trailer, 8) != 8) {
+        addErrorMessage("Could not read the gzip trailer at offset ", to_string(trailerOffset), " in '",
+                        sourceFile->toString(), "'.");
+        return false;
+    }
+    auto littleEndian = [&trailer](int position) {
+        return static_cast<u_int32_t>(trailer[position]) | static_cast<u_int32_t>(trailer[position + 1]) << 8U |
+               static_cast<u_int32_t>(trailer[position + 2]) << 16U | static_cast<u_int32_t>(trailer[position + 3]) << 24U;
+    };
+    auto &segment = segments.back();
+    segment.endsStream = true;
+    segment.trailerOffset = trailerOffset;
+    segment.trailerCRC = littleEndian(0);
+    segment.trailerSize = littleEndian(4);
+    segments.emplace_back();
+    return true;
+}
+
+void IntervalVerifier::scanDecompressedData(const Bytef *data, u_int64_t length) {
+    if (length == 0)
+        return;
+
+    ScopedRunTimer timer(TIME_IN_LINE_SCANNING);
+    auto begin = reinterpret_cast<const char *>(data);
+    auto end = begin + length;
+    const char *position = begin;
+    while (position < end) {
+        if (lineStartsAtNextByte) {
+            startLine();
+            lineStartsAtNextByte = false;
+        }
+        auto newline = static_cast<const char *>(memchr(position, '\n', end - position));
+        if (capturingSample >= 0)
+            sampledLines[capturingSample].line.append(position, (newline ? newline : end) - position);
+        if (!newline)
+            break;
+
+        if (openBoundary >= 0) {
+            auto &boundary = boundaries[openBoundary];
+            boundary.newlinesInBlock[newlinesOfOpenBoundary++] = bytesSinceOpenBoundary + (newline - begin);
+            if (newlinesOfOpenBoundary == sizeof(boundary.newlinesInBlock) / sizeof(boundary.newlinesInBlock[0]))
+                openBoundary = -1;
+        }
+        newlines++;
+        capturingSample = -1;
+        lineStartsAtNextByte = numberOfSampledLines > 0;
+        position = newline + 1;
+    }
+    bytesSinceOpenBoundary += length;
+    lastCharacter = static_cast<unsigned char>(end[-1]);
+}
+
+/**
+ * Reservoir sampling over all lines, which start in the interval.
+ */
+void IntervalVerifier::startLine() {
+    lineStarts++;
+    if (sampledLines.size() < numberOfSampledLines) {
+        sampledLines.push_back({newlines, ""});
+        capturingSample = static_cast<int64_t>(sampledLines.size()) - 1;
+        return;
+    }
+    u_int64_t slot = nextRandom() % lineStarts;
+    if (slot < numberOfSampledLines) {
+        sampledLines[slot] = {newlines, ""};
+        capturingSample = static_cast<int64_t>(slot);
+    } else {
+        capturingSample = -1;
+    }
+}
+
+bool IntervalVerifier::processBlockEnd() {
+    openBoundary = -1;
+    auto offset = static_cast<u_int64_t>(totalBytesIn);
+    // This will pop up a clang-tidy warning, but as Mark Adler does it, I don't want to change it.
+    u_int32_t bits = zStream.data_type & 7;
+
+    while (nextEntry < endEntry && entries[nextEntry].blockOffsetInRawFile < offset) {
+        addProblem("Index entry #", nextEntry, " at offset ", entries[nextEntry].blockOffsetInRawFile,
+                   " does not point to the start of a compressed block.");
+        nextEntry++;
+    }
+
+    if (!endsWithFile() && entries[endEntry].blockOffsetInRawFile <= offset) {
+        // The next interval starts here. If the entry is broken, the next interval reports it.
+        if (entries[endEntry].blockOffsetInRawFile < offset)
+            addProblem("Index entry #", endEntry, " at offset ", entries[endEntry].blockOffsetInRawFile,
+                       " does not point to the start of a compressed block.");
+        else if (entries[endEntry].bits != bits)
+            addProblem("Index entry #", endEntry, " has ", entries[endEntry].bits, " bits instead of ", bits, ".");
+        if (numberOfSampledLines > 0 && capturingSample >= 0)
+            sampledLines.erase(sampledLines.begin() + capturingSample);
+        return false;
+    }
+
+    if (nextEntry < endEntry && entries[nextEntry].blockOffsetInRawFile == offset) {
+        if (entries[nextEntry].bits != bits)
+            addProblem("Index entry #", nextEntry, " has ", entries[nextEntry].bits, " bits instead of ", bits, ".");
+        boundaries.push_back({nextEntry, newlines, lastCharacter});
+        openBoundary = static_cast<int64_t>(boundaries.size()) - 1;
+        newlinesOfOpenBoundary = 0;
+        bytesSinceOpenBoundary = 0;
+        nextEntry++;
+    }
+    return true;
+}
+
+void IntervalVerifier::reportMissingEntries(int64_t upToEntry) {
+    for (; nextEntry < upToEntry; nextEntry++) {
+        addProblem("Index entry #", nextEntry, " at offset ", entries[nextEntry].blockOffsetInRawFile,
+                   " does not point to the start of a compressed block.");
+    }
+}
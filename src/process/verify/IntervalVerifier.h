@@ -0,0 +1,248 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#ifndef FASTQINDEX_INTERVALVERIFIER_H
+#define FASTQINDEX_INTERVALVERIFIER_H
+
+#include "process/base/ZLibBasedFASTQProcessorBaseClass.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * The fields of an IndexEntry, which are checked by the verify mode. The dictionaries are only kept for the entries,
+ * where an interval starts, as they would need a lot of memory for large files.
+ */
+struct VerifiedIndexEntry {
+
+    u_int64_t blockOffsetInRawFile{0};
+
+    u_int64_t startingLineInEntry{0};
+
+    u_int32_t bits{0};
+
+    u_int32_t offsetToNextLineStart{0};
+};
+
+/**
+ * What an IntervalVerifier found at the compressed block of an index entry. The line values are relative to the start
+ * of the interval, the Verifier combines them with the results of the previous intervals.
+ */
+struct EntryBoundary {
+
+    int64_t entryNumber{0};
+
+    /**
+     * The number of newlines between the start of the interval and the block.
+     */
+    u_int64_t newlinesBefore{0};
+
+    /**
+     * The last decompressed character in front of the block or -1, if the interval starts with the block.
+     */
+    int lastCharacterBefore{-1};
+
+    /**
+     * The positions of the first newlines in the decompressed block or -1, if the block contains less newlines. Four
+     * newlines are enough to find the start of the first FASTQ record in the block.
+     */
+    int64_t newlinesInBlock[4]{-1, -1, -1, -1};
+};
+
+/**
+ * A line, which was randomly picked for a spot check.
+ */
+struct SampledLine {
+
+    /**
+     * The number of newlines between the start of the interval and the line.
+     */
+    u_int64_t newlinesBefore{0};
+
+    string line;
+};
+
+/**
+ * The part of a gzip stream, which was decompressed by an IntervalVerifier. Only filled, if checksums are enabled.
+ */
+struct StreamSegment {
+
+    /**
+     * CRC32 and length of the decompressed data of the segment. 0 is also the CRC32 of no data.
+     */
+    uLong crc{0};
+
+    u_int64_t length{0};
+
+    /**
+     * Set, if the gzip stream ended in the interval, then the trailer values are set as well.
+     */
+    bool endsStream{false};
+
+    int64_t trailerOffset{0};
+
+    u_int32_t trailerCRC{0};
+
+    u_int32_t trailerSize{0};
+};
+
+/**
+ * Decompresses the data between two index entries (or from the start of the file) and records, what it finds at the
+ * compressed block of every entry in between. Several IntervalVerifiers can work in parallel, each needs its own
+ * Source instance.
+ */
+class IntervalVerifier : public ZLibBasedFASTQProcessorBaseClass {
+
+private:
+
+    const vector<VerifiedIndexEntry> &entries;
+
+    /**
+     * The entry to start from with its dictionary or nullptr to start at the beginning of the file.
+     */
+    shared_ptr<IndexEntry> startEntry;
+
+    /**
+     * The entry, which is expected at the next block boundary.
+     */
+    int64_t nextEntry;
+
+    /**
+     * The interval ends at the block boundary of this entry, which is the start of the next interval. If this is the
+     * number of entries, the interval ends with the file.
+     */
+    int64_t endEntry;
+
+    uint numberOfSampledLines;
+
+    u_int64_t randomState;
+
+    /**
+     * After a concatenated gzip stream ended, raw inflate does not consume its trailer.
+     */
+    bool currentStreamIsRawDeflateStream{false};
+
+    vector<EntryBoundary> boundaries;
+
+    vector<SampledLine> sampledLines;
+
+    vector<string> problems;
+
+    bool computeChecksums{false};
+
+    vector<StreamSegment> segments;
+
+    u_int64_t newlines{0};
+
+    int lastCharacter{-1};
+
+    /**
+     * The boundary, for which the newlines in the block are still searched for or -1.
+     */
+    int64_t openBoundary{-1};
+
+    uint newlinesOfOpenBoundary{0};
+
+    u_int64_t bytesSinceOpenBoundary{0};
+
+    /**
+     * The number of lines, which started in the interval and could have been sampled.
+     */
+    u_int64_t lineStarts{0};
+
+    /**
+     * The sample, which receives the characters of the current line or -1.
+     */
+    int64_t capturingSample{-1};
+
+    /**
+     * Lines which start in front of the first newline of the interval can't be sampled, as they might have started in
+     * the previous interval. This is different for the interval, which starts with the file.
+     */
+    bool lineStartsAtNextByte{false};
+
+    bool endsWithFile() { return endEntry >= static_cast<int64_t>(entries.size()); }
+
+    u_int64_t nextRandom();
+
+    bool prepareForStartEntry();
+
+    bool prepareForNextConcatenatedPart();
+
+    bool readStreamTrailer();
+
+    bool decompressInterval();
+
+    bool inflateNextChunk();
+
+    void scanDecompressedData(const Bytef *data, u_int64_t length);
+
+    void startLine();
+
+    /**
+     * @return false, if the end of the interval was reached.
+     */
+    bool processBlockEnd();
+
+    void reportMissingEntries(int64_t upToEntry);
+
+    template<typename... Args>
+    void addProblem(Args... args) {
+        stringstream message;
+        (message << ... << args);
+        problems.emplace_back(message.str());
+    }
+
+public:
+
+    /**
+     * @param source               The compressed FASTQ file, the IntervalVerifier will open and close it.
+     * @param entries              The entries of the whole index.
+     * @param startEntry           The dictionary holding entry at firstEntry or nullptr to start at the beginning of
+     *                             the file with firstEntry 0.
+     * @param firstEntry           The first entry of the interval.
+     * @param endEntry             The first entry of the next interval or the number of entries.
+     * @param numberOfSampledLines The number of lines, which shall be picked for spot checks.
+     * @param seed                 Seed for the line sampling.
+     */
+    IntervalVerifier(const shared_ptr<Source> &source,
+                     const vector<VerifiedIndexEntry> &entries,
+                     const shared_ptr<IndexEntry> &startEntry,
+                     int64_t firstEntry,
+                     int64_t endEntry,
+                     uint numberOfSampledLines = 0,
+                     u_int64_t seed = 0);
+
+    /**
+     * Also calculate the CRC32 of the decompressed data and read the trailers of the gzip streams, see getSegments().
+     */
+    void enableChecksums() { computeChecksums = true; }
+
+    /**
+     * Decompresses the interval. Problems with the index entries are collected in getProblems(), the method only
+     * returns false, if the interval could not be decompressed at all.
+     */
+    bool verify();
+
+    const vector<EntryBoundary> &getBoundaries() { return boundaries; }
+
+    const vector<SampledLine> &getSampledLines() { return sampledLines; }
+
+    const vector<string> &getProblems() { return problems; }
+
+    const vector<StreamSegment> &getSegments() { return segments; }
+
+    u_int64_t getNewlines() { return newlines; }
+
+    /**
+     * The last decompressed character of the interval or -1, if the interval was empty.
+     */
+    int getLastCharacter() { return lastCharacter; }
+};
+
+
+#endif //FASTQINDEX_INTERVALVERIFIER_H
@@ -0,0 +1,215 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#include "common/RunStatistics.h"
+#include "process/extract/Extractor.h"
+#include "process/io/ConsoleSink.h"
+#include "process/index/FastqRecordScanner.h"
+#include "process/io/ReadAheadSource.h"
+#include "Verifier.h"
+#include <atomic>
+#include <iostream>
+#include <thread>
+
+Verifier::Verifier(const SourceFactory &createSource,
+                   const shared_ptr<Source> &indexFile,
+                   uint threads,
+                   uint spotChecks,
+                   uint maximumNumberOfReportedProblems) :
+        createSource(createSource),
+        indexFile(indexFile),
+        threads(threads),
+        spotChecks(spotChecks),
+        maximumNumberOfReportedProblems(maximumNumberOfReportedProblems) {
+    this->indexReader = make_shared<IndexReader>(indexFile);
+}
+
+bool Verifier::fulfillsPremises() {
+    if (threads == 0) {
+        addErrorMessage("The number of threads needs to be a positive number.");
+        return false;
+    }
+    return indexReader->tryOpenAndReadHeader();
+}
+
+void Verifier::reportProblem(const string &problem) {
+    numberOfProblems++;
+    if (numberOfProblems > maximumNumberOfReportedProblems)
+        return;
+    // The runners don't print error messages after a run, so the problems are also printed directly.
+    addErrorMessage(problem);
+    severe(problem);
+}
+
+bool Verifier::readEntries() {
+    if (!indexReader->tryOpenAndReadHeader())
+        return false;
+
+    header = indexReader->getIndexHeader();
+    int64_t numberOfEntries = indexReader->getIndicesLeft();
+    numberOfIntervals = max<int64_t>(1, min<int64_t>(numberOfEntries, static_cast<int64_t>(threads) * 4));
+
+    // Keep the dictionaries only for the entries, where an interval starts.
+    entries.reserve(static_cast<size_t>(numberOfEntries));
+    startEntries.resize(static_cast<size_t>(numberOfIntervals));
+    int64_t nextInterval = 1;
+    for (int64_t i = 0; i < numberOfEntries; i++) {
+        auto entry = indexReader->readIndexEntry();
+        if (!entry) {
+            addErrorMessage("Could not read index entry #", to_string(i), " from '", indexFile->toString(), "'.");
+            return false;
+        }
+        entries.push_back({entry->blockOffsetInRawFile, entry->startingLineInEntry, entry->bits,
+                           entry->offsetToNextLineStart});
+        if (nextInterval < numberOfIntervals && nextInterval * numberOfEntries / numberOfIntervals == i)
+            startEntries[nextInterval++] = entry;
+    }
+    // The Extractor of the spot checks opens the index again.
+    indexFile->close();
+    if (header.hasTrailer && !indexReader->checksumWasVerified())
+        reportProblem("The checksum of the index file '" + indexFile->toString() + "' does not match its entries.");
+    return true;
+}
+
+void Verifier::decompressIntervals(uint samplesPerInterval, bool computeChecksums) {
+    if (RunStatistics::isEnabled())
+        RunStatistics::setProgressTotal(COMPRESSED_BYTES_READ, createSource()->size());
+
+    auto numberOfEntries = static_cast<int64_t>(entries.size());
+    intervals.resize(static_cast<size_t>(numberOfIntervals));
+    atomic<int64_t> nextIntervalToVerify{0};
+    auto worker = [&]() {
+        for (int64_t i = nextIntervalToVerify++; i < numberOfIntervals; i = nextIntervalToVerify++) {
+            int64_t end = i + 1 < numberOfIntervals ? intervalStart(i + 1) : numberOfEntries;
+            auto interval = make_shared<IntervalVerifier>(ReadAheadSource::wrapIfPossible(createSource()), entries,
+                                                          startEntries[i], intervalStart(i), end,
+                                                          samplesPerInterval, static_cast<u_int64_t>(i));
+            if (computeChecksums)
+                interval->enableChecksums();
+            interval->verify();
+            intervals[i] = interval;
+        }
+    };
+    vector<thread> workers;
+    for (uint i = 1; i < min<int64_t>(threads, numberOfIntervals); i++)
+        workers.emplace_back(worker);
+    worker();
+    for (auto &thread : workers)
+        thread.join();
+}
+
+void Verifier::reportFailedInterval(int64_t interval) {
+    for (const auto &message : intervals[interval]->getErrorMessages())
+        reportProblem(message);
+    reportProblem("The data after index entry #" + to_string(intervalStart(interval)) + " at offset " +
+                  to_string(interval > 0 ? entries[intervalStart(interval)].blockOffsetInRawFile : 0) +
+                  " could not be decompressed.");
+}
+
+bool Verifier::verify() {
+    if (!readEntries())
+        return false;
+
+    auto samplesPerInterval = static_cast<uint>((spotChecks + numberOfIntervals - 1) / numberOfIntervals);
+    decompressIntervals(samplesPerInterval, false);
+
+    // Sum up the relative line numbers of the intervals.
+    u_int64_t newlines{0};
+    int lastCharacter{-1};
+    vector<pair<u_int64_t, string>> samples;
+    for (int64_t i = 0; i < numberOfIntervals; i++) {
+        auto &interval = intervals[i];
+        if (!interval->wasSuccessful()) {
+            reportFailedInterval(i);
+            return false;
+        }
+        for (const auto &problem : interval->getProblems())
+            reportProblem(problem);
+
+        for (const auto &boundary : interval->getBoundaries()) {
+            const auto &entry = entries[boundary.entryNumber];
+            int characterBefore = boundary.lastCharacterBefore >= 0 ? boundary.lastCharacterBefore : lastCharacter;
+            bool startsWithLine = characterBefore == -1 || characterBefore == '\n';
+            u_int64_t expectedLine = newlines + boundary.newlinesBefore + (startsWithLine ? 0 : 1);
+            // The newline in front of the expected line or -1 for the start of the block.
+            int64_t newlineBefore = startsWithLine ? -1 : 0;
+            if (header.entriesStartWithRecords) {
+                int64_t linesToRecord = (FastqRecordScanner::LINES_PER_RECORD -
+                                         expectedLine % FastqRecordScanner::LINES_PER_RECORD) %
+                                        FastqRecordScanner::LINES_PER_RECORD;
+                expectedLine += linesToRecord;
+                newlineBefore += linesToRecord;
+                if (newlineBefore >= 0 && boundary.newlinesInBlock[newlineBefore] < 0) {
+                    reportProblem("Index entry #" + to_string(boundary.entryNumber) +
+                                  " points to a block, in which no FASTQ record starts.");
+                    continue;
+                }
+            }
+            auto expectedOffset = static_cast<u_int32_t>(
+                    newlineBefore < 0 || boundary.newlinesInBlock[newlineBefore] < 0
+                    ? 0 : boundary.newlinesInBlock[newlineBefore] + 1);
+            if (entry.startingLineInEntry != expectedLine)
+                reportProblem("Index entry #" + to_string(boundary.entryNumber) + " has the starting line " +
+                              to_string(entry.startingLineInEntry) + " instead of " + to_string(expectedLine) + ".");
+            if (entry.offsetToNextLineStart != expectedOffset)
+                reportProblem("Index entry #" + to_string(boundary.entryNumber) + " has the line offset " +
+                              to_string(entry.offsetToNextLineStart) + " instead of " + to_string(expectedOffset) +
+                              ".");
+        }
+        for (const auto &sample : interval->getSampledLines())
+            samples.emplace_back(newlines + sample.newlinesBefore, sample.line);
+
+        newlines += interval->getNewlines();
+        if (interval->getLastCharacter() >= 0)
+            lastCharacter = interval->getLastCharacter();
+    }
+
+    linesInFile = newlines + (lastCharacter == -1 || lastCharacter == '\n' ? 0 : 1);
+    if (static_cast<u_int64_t>(header.linesInIndexedFile) != linesInFile)
+        reportProblem("The index header states " + to_string(header.linesInIndexedFile) + " lines, but the file has " +
+                      to_string(linesInFile) + " lines.");
+
+    // Take evenly spread samples, if the intervals picked more than necessary.
+    u_int64_t numberOfSpotChecks = min<u_int64_t>(spotChecks, samples.size());
+    for (u_int64_t i = 0; i < numberOfSpotChecks; i++) {
+        const auto &sample = samples[i * samples.size() / numberOfSpotChecks];
+        if (spotCheck(sample.first, sample.second))
+            numberOfPassedSpotChecks++;
+    }
+
+    cerr << "Verified " << entries.size() << " index entries and " << linesInFile << " lines in "
+         << numberOfIntervals << " intervals with " << min<int64_t>(threads, numberOfIntervals) << " threads.\n";
+    if (numberOfSpotChecks > 0)
+        cerr << " " << numberOfPassedSpotChecks << " of " << numberOfSpotChecks << " spot checks passed.\n";
+    if (numberOfProblems > maximumNumberOfReportedProblems)
+        severe("... and " + to_string(numberOfProblems - maximumNumberOfReportedProblems) + " more problems.");
+    if (numberOfProblems > 0)
+        severe("Found " + to_string(numberOfProblems) + " problems, the index does not match the FASTQ file.");
+    return numberOfProblems == 0;
+}
+
+bool Verifier::spotCheck(u_int64_t lineNumber, const string &line) {
+    auto extractor = make_shared<Extractor>(createSource(), indexFile, ConsoleSink::create(CERR), false,
+                                            ExtractMode::lines, lineNumber, 1, 1, true);
+    extractor->setPrintUsedIndexEntry(false);
+    bool extracted = extractor->fulfillsPremises() && extractor->extract();
+    if (!extracted || extractor->getStoredLines().size() != 1) {
+        reportProblem("Line " + to_string(lineNumber) + " could not be extracted.");
+        return false;
+    }
+    if (extractor->getStoredLines()[0] != line) {
+        reportProblem("The extracted line " + to_string(lineNumber) + " '" + extractor->getStoredLines()[0] +
+                      "' differs from the decompressed line '" + line + "'.");
+        return false;
+    }
+    return true;
+}
+
+vector<string> Verifier::getErrorMessages() {
+    vector<string> l = ErrorAccumulator::getErrorMessages();
+    vector<string> r = indexReader->getErrorMessages();
+    return concatenateVectors(l, r);
+}
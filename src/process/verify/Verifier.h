@@ -0,0 +1,124 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#ifndef FASTQINDEX_VERIFIER_H
+#define FASTQINDEX_VERIFIER_H
+
+#include "common/ErrorAccumulator.h"
+#include "process/extract/IndexReader.h"
+#include "process/io/Source.h"
+#include "process/verify/IntervalVerifier.h"
+
+using namespace std;
+
+/**
+ * The Verifier checks an index against its FASTQ file: Every index entry needs to point to the start of a compressed
+ * block and its startingLineInEntry, offsetToNextLineStart and bits need to match the decompressed data. Also the line
+ * count in the index header is checked. If the index is record aware, the entries need to point to the first FASTQ
+ * record in their block. Optionally, randomly picked lines are extracted with the Extractor and compared to the
+ * decompressed data.
+ *
+ * The file is not decompressed in one go. The index entries are split into intervals, which are decompressed in
+ * parallel from their first entry on. The line numbers found in the intervals are relative, they are summed up in
+ * order afterwards.
+ */
+class Verifier : public ErrorAccumulator {
+
+protected:
+
+    SourceFactory createSource;
+
+    shared_ptr<Source> indexFile;
+
+    shared_ptr<IndexReader> indexReader;
+
+    uint threads;
+
+    uint spotChecks;
+
+    /**
+     * Only this many problems are reported in detail.
+     */
+    uint maximumNumberOfReportedProblems;
+
+    u_int64_t numberOfProblems{0};
+
+    u_int64_t numberOfPassedSpotChecks{0};
+
+    u_int64_t linesInFile{0};
+
+    IndexHeader header;
+
+    vector<VerifiedIndexEntry> entries;
+
+    /**
+     * The dictionary holding entries, where the intervals start. The first interval starts with the file.
+     */
+    vector<shared_ptr<IndexEntry>> startEntries;
+
+    vector<shared_ptr<IntervalVerifier>> intervals;
+
+    int64_t numberOfIntervals{0};
+
+    int64_t intervalStart(int64_t interval) {
+        return interval * static_cast<int64_t>(entries.size()) / numberOfIntervals;
+    }
+
+    /**
+     * Reads all index entries and splits them into intervals.
+     */
+    bool readEntries();
+
+    /**
+     * Runs an IntervalVerifier for every interval, the intervals are distributed to the threads.
+     */
+    void decompressIntervals(uint samplesPerInterval, bool computeChecksums);
+
+    /**
+     * Reports the errors of an interval, which could not be decompressed.
+     */
+    void reportFailedInterval(int64_t interval);
+
+    void reportProblem(const string &problem);
+
+    bool spotCheck(u_int64_t lineNumber, const string &line);
+
+public:
+
+    /**
+     * @param createSource                    Creates the Source instances of the compressed FASTQ file.
+     * @param indexFile                       The index of the FASTQ file.
+     * @param threads                         The number of threads used to decompress the file.
+     * @param spotChecks                      The number of lines, which are extracted and compared.
+     * @param maximumNumberOfReportedProblems The number of problems, which are reported in detail.
+     */
+    Verifier(const SourceFactory &createSource,
+             const shared_ptr<Source> &indexFile,
+             uint threads,
+             uint spotChecks = 0,
+             uint maximumNumberOfReportedProblems = 20);
+
+    bool fulfillsPremises();
+
+    /**
+     * @return true, if no problem was found.
+     */
+    bool verify();
+
+    u_int64_t getNumberOfProblems() { return numberOfProblems; }
+
+    u_int64_t getNumberOfPassedSpotChecks() { return numberOfPassedSpotChecks; }
+
+    /**
+     * The number of lines found in the FASTQ file.
+     */
+    u_int64_t getLinesInFile() { return linesInFile; }
+
+    vector<string> getErrorMessages() override;
+};
+
+
+#endif //FASTQINDEX_VERIFIER_H
@@ -5,6 +5,8 @@
  */
 
 #include "common/ErrorMessages.h"
+#include "common/RunStatistics.h"
+#include "common/Tracer.h"
 #include "process/io/StreamSource.h"
 #include "runners/ActualRunner.h"
 #include <experimental/filesystem>
@@ -37,6 +39,48 @@ bool ActualRunner::fulfillsPremises() {
     return fastqIsValid;
 }
 
+void ActualRunner::startInstrumentation() {
+    if (!statisticsFile.empty() || progressInterval > 0) {
+        RunStatistics::enable();
+        if (progressInterval > 0)
+            RunStatistics::startProgressReport(seconds(progressInterval));
+    }
+    if (!traceFile.empty()) {
+        if (!Tracer::isCompiledIn())
+            severe("The application was built without FQI_ENABLE_TRACING, the trace will not contain any spans.");
+        Tracer::enable();
+    }
+}
+
+bool ActualRunner::finishInstrumentation(const string &mode, bool successful) {
+    // Errors after the run are not printed by main, so tell the user directly.
+    bool filesWritten = true;
+    if (RunStatistics::isEnabled()) {
+        RunStatistics::disable();
+        if (progressInterval > 0)
+            cerr << RunStatistics::createProgressLine() << "\n";
+        if (!statisticsFile.empty() && !RunStatistics::writeJSON(statisticsFile, mode, successful)) {
+            string message = join("Could not write the run statistics to '", statisticsFile.string(), "'.");
+            addErrorMessage(message);
+            severe(message);
+            filesWritten = false;
+        }
+    }
+    if (Tracer::isEnabled()) {
+        Tracer::disable();
+        if (Tracer::getNumberOfDroppedEvents() > 0)
+            severe(join("The trace is incomplete, ", to_string(Tracer::getNumberOfDroppedEvents()),
+                        " spans were dropped after ", to_string(Tracer::DEFAULT_MAXIMUM_EVENTS), " spans."));
+        if (!Tracer::writeJSON(traceFile)) {
+            string message = join("Could not write the trace to '", traceFile.string(), "'.");
+            addErrorMessage(message);
+            severe(message);
+            filesWritten = false;
+        }
+    }
+    return filesWritten;
+}
+
 bool IndexReadingRunner::fulfillsPremises() {
     bool fastqIsValid = ActualRunner::fulfillsPremises();
     bool indexIsValid = indexFile->fulfillsPremises();
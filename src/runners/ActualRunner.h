@@ -31,6 +31,32 @@ protected:
      */
     shared_ptr<Source> sourceFile = shared_ptr<Source>(nullptr);
 
+    /**
+     * If set, the RunStatistics are written to this file as JSON after the run.
+     */
+    path statisticsFile;
+
+    /**
+     * Seconds between two progress lines, 0 turns the progress report off.
+     */
+    uint progressInterval{0};
+
+    /**
+     * If set, a Tracer timeline of the run is written to this file.
+     */
+    path traceFile;
+
+    /**
+     * Enables RunStatistics, the progress report and the Tracer, if the user requested them.
+     */
+    void startInstrumentation();
+
+    /**
+     * Stops the progress report and the Tracer and writes the statistics and the trace file.
+     * @return false, if one of the files could not be written.
+     */
+    bool finishInstrumentation(const string &mode, bool successful);
+
     /**
      * For index mode (writing)
      * @param sourceFile
@@ -57,6 +83,21 @@ public:
 
     shared_ptr<Source> getSourceFile() { return sourceFile; }
 
+    void enableRunStatistics(const path &statisticsFile, uint progressInterval) {
+        this->statisticsFile = statisticsFile;
+        this->progressInterval = progressInterval;
+    }
+
+    path getStatisticsFile() { return statisticsFile; }
+
+    uint getProgressInterval() { return progressInterval; }
+
+    void enableTracing(const path &traceFile) {
+        this->traceFile = traceFile;
+    }
+
+    path getTraceFile() { return traceFile; }
+
 
 };
 
@@ -0,0 +1,36 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#include "ByteRangeExtractorRunner.h"
+
+ByteRangeExtractorRunner::ByteRangeExtractorRunner(const shared_ptr<Source> &sourceFile,
+                                                   const shared_ptr<Source> &indexFile,
+                                                   const shared_ptr<Sink> &resultFile,
+                                                   u_int64_t start,
+                                                   u_int64_t length,
+                                                   bool alignToRecords,
+                                                   uint recordSize) : IndexReadingRunner(sourceFile, indexFile) {
+    this->extractor = make_shared<ByteRangeExtractor>(sourceFile, indexFile, resultFile, start, length,
+                                                      alignToRecords, recordSize);
+}
+
+bool ByteRangeExtractorRunner::fulfillsPremises() {
+    bool baseClassChecksPassed = IndexReadingRunner::fulfillsPremises();
+    return baseClassChecksPassed && extractor->fulfillsPremises();
+}
+
+unsigned char ByteRangeExtractorRunner::_run() {
+    startInstrumentation();
+    bool successful = extractor->extract();
+    bool instrumentationWritten = finishInstrumentation("extract", successful);
+    return successful && instrumentationWritten ? static_cast<char>(0) : static_cast<char>(1);
+}
+
+vector<string> ByteRangeExtractorRunner::getErrorMessages() {
+    vector<string> l = IndexReadingRunner::getErrorMessages();
+    vector<string> r = extractor->getErrorMessages();
+    return concatenateVectors(l, r);
+}
@@ -0,0 +1,51 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#ifndef FASTQINDEX_BYTERANGEEXTRACTORRUNNER_H
+#define FASTQINDEX_BYTERANGEEXTRACTORRUNNER_H
+
+#include "runners/ActualRunner.h"
+#include "process/extract/ByteRangeExtractor.h"
+
+/**
+ * Runs the ByteRangeExtractor for extract --bytes.
+ */
+class ByteRangeExtractorRunner : public IndexReadingRunner {
+protected:
+
+    shared_ptr<ByteRangeExtractor> extractor;
+
+public:
+    /**
+     * @param sourceFile     The file to extract from.
+     * @param indexFile      The index of the file, which needs uncompressed offsets.
+     * @param resultFile     The file which shall be written or - for stdout.
+     * @param start          The first Byte of the range in the uncompressed data.
+     * @param length         The length of the range.
+     * @param alignToRecords Extract the complete records, which start in the range.
+     * @param recordSize     The number of lines of a record.
+     */
+    ByteRangeExtractorRunner(const shared_ptr<Source> &sourceFile,
+                             const shared_ptr<Source> &indexFile,
+                             const shared_ptr<Sink> &resultFile,
+                             u_int64_t start,
+                             u_int64_t length,
+                             bool alignToRecords,
+                             uint recordSize);
+
+    shared_ptr<ByteRangeExtractor> getExtractor() { return extractor; }
+
+    bool isExtractor() override { return true; };
+
+    bool fulfillsPremises() override;
+
+    unsigned char _run() override;
+
+    vector<string> getErrorMessages() override;
+};
+
+
+#endif //FASTQINDEX_BYTERANGEEXTRACTORRUNNER_H
@@ -8,6 +8,7 @@
 #include "ExtractorRunner.h"
 #include "process/extract/Extractor.h"
 #include "process/io/FileSource.h"
+#include "process/io/ReadAheadSource.h"
 
 ExtractorRunner::ExtractorRunner(
         const shared_ptr<Source> &sourceFile,
@@ -27,7 +28,7 @@ ExtractorRunner::ExtractorRunner(
     this->enableDebugging = enableDebugging;
     this->mode = mode;
     this->extractor.reset(
-            new Extractor(sourceFile, indexFile, resultFile,
+            new Extractor(ReadAheadSource::wrapIfPossible(sourceFile), indexFile, resultFile,
                           forceOverwrite, mode, start, count,
                           recordSize, enableDebugging
             )
@@ -46,7 +47,10 @@ bool ExtractorRunner::fulfillsPremises() {
 }
 
 unsigned char ExtractorRunner::_run() {
-    return extractor->extract() ? static_cast<char>(0) : static_cast<char>(1);
+    startInstrumentation();
+    bool successful = extractor->extract();
+    bool instrumentationWritten = finishInstrumentation("extract", successful);
+    return successful && instrumentationWritten ? static_cast<char>(0) : static_cast<char>(1);
 }
 
 vector<string> ExtractorRunner::getErrorMessages() {
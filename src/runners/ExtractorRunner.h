@@ -61,6 +61,11 @@ public:
 
     bool isExtractor() override { return true; };
 
+    /**
+     * Piped input is skipped up to the offset of the used index entry without being decompressed.
+     */
+    bool allowsReadFromStreamedSource() override { return true; }
+
     bool fulfillsPremises() override;
 
     unsigned char _run() override;
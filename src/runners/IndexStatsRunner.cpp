@@ -40,6 +40,10 @@ unsigned char IndexStatsRunner::_run() {
     }
     cout << "\tIndex entries:    " << indicesLeft << "\n";
     cout << "\tLines in file:    " << header.linesInIndexedFile << "\n";
+    if (header.entriesStartWithRecords)
+        cout << "\tEntries start with FASTQ records\n";
+    if (header.entriesHaveUncompressedOffsets)
+        cout << "\tEntries store uncompressed offsets\n";
 
     for (int i = 0; i < start; i++)
         this->indexReader->readIndexEntry();
@@ -56,7 +60,7 @@ unsigned char IndexStatsRunner::_run() {
         for (int i = 0; i < toRead && this->indexReader->getIndicesLeft() > 0; i++) {
             auto entry = this->indexReader->readIndexEntry();
 
-            printIndexEntryToConsole(entry, (i + start));
+            printIndexEntryToConsole(entry, (i + start), false);
         }
         return 0;
     }
@@ -64,13 +68,15 @@ unsigned char IndexStatsRunner::_run() {
 
 void IndexStatsRunner::printIndexEntryToConsole(const shared_ptr<IndexEntry> &entry, int64_t entryNumber,
                                                 bool toCErr) {
-    auto &_ostream = toCErr ? cout : cerr;
+    auto &_ostream = toCErr ? cerr : cout;
     _ostream << "Entry number:    " << entryNumber << "\n";
     _ostream << "  Entry id:      " << entry->id << "\n";
     _ostream << "  Raw offset:    " << entry->blockOffsetInRawFile << "\n";
     _ostream << "  Starting line: " << entry->startingLineInEntry << "\n";
     _ostream << "    Record (/4): " << (entry->startingLineInEntry / 4) << "\n";
     _ostream << "  Line offset:   " << entry->offsetToNextLineStart << "\n";
+    if (entry->offsetInUncompressedData >= 0)
+        _ostream << "  Uncompr. offset: " << entry->offsetInUncompressedData << "\n";
     _ostream << "  Bits:          " << entry->bits << "\n";
 }
 
@@ -7,6 +7,7 @@
 #include <iostream>
 #include "IndexerRunner.h"
 #include "process/index/Indexer.h"
+#include "process/io/ReadAheadSource.h"
 
 using namespace std;
 
@@ -20,7 +21,7 @@ IndexerRunner::IndexerRunner(
         bool compressDictionaries) :
         IndexWritingRunner(sourceFile, indexFile) {
     this->indexer = make_shared<Indexer>(
-            this->sourceFile,
+            ReadAheadSource::wrapIfPossible(this->sourceFile),
             this->indexFile,
             storageStrategy,
             enableDebugging,
@@ -47,7 +48,10 @@ bool IndexerRunner::allowsReadFromStreamedSource() {
 }
 
 unsigned char IndexerRunner::_run() {
-    if (indexer->createIndex()) return 0;
+    startInstrumentation();
+    bool successful = indexer->createIndex();
+    bool instrumentationWritten = finishInstrumentation("index", successful);
+    if (successful && instrumentationWritten) return 0;
     else return 1;
 }
 
@@ -61,6 +61,18 @@ public:
     void enableWritingPartialDecompressedBlocks(const path &location) {
         this->indexer->enableWritingPartialDecompressedBlocks(location);
     }
+
+    void setRecordAwareIndexing(bool value) {
+        this->indexer->setRecordAwareIndexing(value);
+    }
+
+    void setUncompressedOffsetStorage(bool value) {
+        this->indexer->setUncompressedOffsetStorage(value);
+    }
+
+    void setReadNameIndex(const shared_ptr<Sink> &readNameIndex) {
+        this->indexer->setReadNameIndex(readNameIndex);
+    }
 };
 
 
@@ -0,0 +1,31 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#include "IntegrityTestRunner.h"
+
+IntegrityTestRunner::IntegrityTestRunner(const SourceFactory &createSource,
+                                         const shared_ptr<Source> &indexFile,
+                                         uint threads) : IndexReadingRunner(createSource(), indexFile) {
+    this->tester = make_shared<IntegrityTester>(createSource, indexFile, threads);
+}
+
+bool IntegrityTestRunner::fulfillsPremises() {
+    bool baseClassChecksPassed = IndexReadingRunner::fulfillsPremises();
+    return baseClassChecksPassed && tester->fulfillsPremises();
+}
+
+unsigned char IntegrityTestRunner::_run() {
+    startInstrumentation();
+    bool successful = tester->test();
+    bool instrumentationWritten = finishInstrumentation("test", successful);
+    return successful && instrumentationWritten ? static_cast<char>(0) : static_cast<char>(1);
+}
+
+vector<string> IntegrityTestRunner::getErrorMessages() {
+    vector<string> l = IndexReadingRunner::getErrorMessages();
+    vector<string> r = tester->getErrorMessages();
+    return concatenateVectors(l, r);
+}
@@ -0,0 +1,39 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#ifndef FASTQINDEX_INTEGRITYTESTRUNNER_H
+#define FASTQINDEX_INTEGRITYTESTRUNNER_H
+
+#include "runners/ActualRunner.h"
+#include "process/verify/IntegrityTester.h"
+
+/**
+ * Runs the IntegrityTester to check the compressed data of a FASTQ file with the help of its index.
+ */
+class IntegrityTestRunner : public IndexReadingRunner {
+protected:
+
+    shared_ptr<IntegrityTester> tester;
+
+public:
+    /**
+     * @param createSource  Creates the Source instances of the FASTQ file, one for every thread.
+     * @param indexFile     The index of the FASTQ file.
+     * @param threads       The number of threads used to decompress the FASTQ file.
+     */
+    IntegrityTestRunner(const SourceFactory &createSource, const shared_ptr<Source> &indexFile, uint threads);
+
+    shared_ptr<IntegrityTester> getTester() { return tester; }
+
+    bool fulfillsPremises() override;
+
+    unsigned char _run() override;
+
+    vector<string> getErrorMessages() override;
+};
+
+
+#endif //FASTQINDEX_INTEGRITYTESTRUNNER_H
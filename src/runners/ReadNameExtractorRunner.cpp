@@ -0,0 +1,36 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#include "ReadNameExtractorRunner.h"
+
+ReadNameExtractorRunner::ReadNameExtractorRunner(const shared_ptr<Source> &sourceFile,
+                                                 const shared_ptr<Source> &indexFile,
+                                                 const shared_ptr<Source> &readNameIndexFile,
+                                                 const shared_ptr<Source> &namesFile,
+                                                 const shared_ptr<Sink> &resultFile,
+                                                 bool enableDebugging) : IndexReadingRunner(sourceFile, indexFile) {
+    // The records are picked from several intervals, the FASTQ file is not read sequentially.
+    this->extractor = make_shared<ReadNameExtractor>(sourceFile, indexFile, readNameIndexFile, namesFile, resultFile,
+                                                     enableDebugging);
+}
+
+bool ReadNameExtractorRunner::fulfillsPremises() {
+    bool baseClassChecksPassed = IndexReadingRunner::fulfillsPremises();
+    return baseClassChecksPassed && extractor->fulfillsPremises();
+}
+
+unsigned char ReadNameExtractorRunner::_run() {
+    startInstrumentation();
+    bool successful = extractor->extract();
+    bool instrumentationWritten = finishInstrumentation("extract", successful);
+    return successful && instrumentationWritten ? static_cast<char>(0) : static_cast<char>(1);
+}
+
+vector<string> ReadNameExtractorRunner::getErrorMessages() {
+    vector<string> l = IndexReadingRunner::getErrorMessages();
+    vector<string> r = extractor->getErrorMessages();
+    return concatenateVectors(l, r);
+}
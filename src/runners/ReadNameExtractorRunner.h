@@ -0,0 +1,49 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#ifndef FASTQINDEX_READNAMEEXTRACTORRUNNER_H
+#define FASTQINDEX_READNAMEEXTRACTORRUNNER_H
+
+#include "runners/ActualRunner.h"
+#include "process/extract/ReadNameExtractor.h"
+
+/**
+ * Runs the ReadNameExtractor for extract --names.
+ */
+class ReadNameExtractorRunner : public IndexReadingRunner {
+protected:
+
+    shared_ptr<ReadNameExtractor> extractor;
+
+public:
+    /**
+     * @param sourceFile        The file to extract from.
+     * @param indexFile         The index of the file.
+     * @param readNameIndexFile The read name index, which was written along with the index.
+     * @param namesFile         The file with the read names, one per line.
+     * @param resultFile        The file which shall be written or - for stdout.
+     * @param enableDebugging   Used for debugging with e.g. an IDE and for unit tests.
+     */
+    ReadNameExtractorRunner(const shared_ptr<Source> &sourceFile,
+                            const shared_ptr<Source> &indexFile,
+                            const shared_ptr<Source> &readNameIndexFile,
+                            const shared_ptr<Source> &namesFile,
+                            const shared_ptr<Sink> &resultFile,
+                            bool enableDebugging = false);
+
+    shared_ptr<ReadNameExtractor> getExtractor() { return extractor; }
+
+    bool isExtractor() override { return true; };
+
+    bool fulfillsPremises() override;
+
+    unsigned char _run() override;
+
+    vector<string> getErrorMessages() override;
+};
+
+
+#endif //FASTQINDEX_READNAMEEXTRACTORRUNNER_H
@@ -0,0 +1,32 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#include "VerifierRunner.h"
+
+VerifierRunner::VerifierRunner(const SourceFactory &createSource,
+                               const shared_ptr<Source> &indexFile,
+                               uint threads,
+                               uint spotChecks) : IndexReadingRunner(createSource(), indexFile) {
+    this->verifier = make_shared<Verifier>(createSource, indexFile, threads, spotChecks);
+}
+
+bool VerifierRunner::fulfillsPremises() {
+    bool baseClassChecksPassed = IndexReadingRunner::fulfillsPremises();
+    return baseClassChecksPassed && verifier->fulfillsPremises();
+}
+
+unsigned char VerifierRunner::_run() {
+    startInstrumentation();
+    bool successful = verifier->verify();
+    bool instrumentationWritten = finishInstrumentation("verify", successful);
+    return successful && instrumentationWritten ? static_cast<char>(0) : static_cast<char>(1);
+}
+
+vector<string> VerifierRunner::getErrorMessages() {
+    vector<string> l = IndexReadingRunner::getErrorMessages();
+    vector<string> r = verifier->getErrorMessages();
+    return concatenateVectors(l, r);
+}
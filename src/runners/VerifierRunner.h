@@ -0,0 +1,43 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#ifndef FASTQINDEX_VERIFIERRUNNER_H
+#define FASTQINDEX_VERIFIERRUNNER_H
+
+#include "runners/ActualRunner.h"
+#include "process/verify/Verifier.h"
+
+/**
+ * Runs the Verifier to check an existing index against its FASTQ file.
+ */
+class VerifierRunner : public IndexReadingRunner {
+protected:
+
+    shared_ptr<Verifier> verifier;
+
+public:
+    /**
+     * @param createSource  Creates the Source instances of the FASTQ file, one for every thread and spot check.
+     * @param indexFile     The index which shall be verified.
+     * @param threads       The number of threads used to decompress the FASTQ file.
+     * @param spotChecks    The number of randomly picked lines, which are extracted and compared.
+     */
+    VerifierRunner(const SourceFactory &createSource,
+                   const shared_ptr<Source> &indexFile,
+                   uint threads,
+                   uint spotChecks);
+
+    shared_ptr<Verifier> getVerifier() { return verifier; }
+
+    bool fulfillsPremises() override;
+
+    unsigned char _run() override;
+
+    vector<string> getErrorMessages() override;
+};
+
+
+#endif //FASTQINDEX_VERIFIERRUNNER_H
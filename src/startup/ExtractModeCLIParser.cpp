@@ -5,6 +5,7 @@
  */
 
 #include "ExtractModeCLIParser.h"
+#include "process/io/CompressingSink.h"
 #include "process/io/s3/S3Sink.h"
 
 #include <tclap/CmdLine.h>
@@ -12,27 +13,41 @@
 using namespace std;
 using namespace TCLAP;
 
-ExtractorRunner *ExtractModeCLIParser::parse(int argc, const char **argv) {
+IndexReadingRunner *ExtractModeCLIParser::parse(int argc, const char **argv) {
     auto cmdLineParser = createCommandLineParser();
 
     auto verbosityArg = createVerbosityArg(cmdLineParser.get());
 
     auto debugSwitch = createDebugSwitchArg(cmdLineParser.get());
 
+    auto namesFileArg = createNamesFileArg(cmdLineParser.get());
+    auto byteRangeArg = createByteRangeArg(cmdLineParser.get());
+    auto alignToRecordsSwitch = createAlignToRecordsSwitchArg(cmdLineParser.get());
     auto recordSizeArg = createrecordSizeArg(cmdLineParser.get());
     auto numberOfReadsArg = createNumberOfReadsArg(cmdLineParser.get());
     auto startingReadArg = createStartingReadArg(cmdLineParser.get());
 
     auto segmentIdentifierArg = createSegmentIdentifierArg(cmdLineParser.get());
     auto segmentCountArg = createSegmentCountArg(cmdLineParser.get());
+    auto alignSegmentsSwitch = createAlignSegmentsSwitchArg(cmdLineParser.get());
+
+    auto statsJSONArg = createStatsJSONArg(cmdLineParser.get());
+    auto progressArg = createProgressArg(cmdLineParser.get());
+    auto traceArg = createTraceArg(cmdLineParser.get());
 
     auto forceOverwriteArg = createForceOverwriteSwitchArg(cmdLineParser.get());
 
     auto s3ConfigFileSectionArg = createS3ConfigFileSectionArg(cmdLineParser.get());
     auto s3CredentialsFileArg = createS3CredentialsFileArg(cmdLineParser.get());
     auto s3ConfigFileArg = createS3ConfigFileArg(cmdLineParser.get());
+    auto s3PartSizeArg = createS3PartSizeArg(cmdLineParser.get());
+    auto s3PartsInFlightArg = createS3PartsInFlightArg(cmdLineParser.get());
+    auto indexCacheArg = createIndexCacheArg(cmdLineParser.get());
 
     auto outputFileArg = createOutputFileArg(cmdLineParser.get());
+    auto[compressionArg, compressionConstraints] = createCompressionArg(cmdLineParser.get());
+    auto compressionThreadsArg = createCompressionThreadsArg(cmdLineParser.get());
+    auto[syncPolicyArg, syncPolicyConstraints] = createSyncPolicyArg(cmdLineParser.get());
     auto indexFileArg = createIndexFileArg(cmdLineParser.get());
     auto sourceFileArg = createFastqFileArg(cmdLineParser.get());
 
@@ -44,6 +59,9 @@ ExtractorRunner *ExtractModeCLIParser::parse(int argc, const char **argv) {
     S3ServiceOptions s3ServiceOptions(s3ConfigFileArg->getValue(),
                                       s3CredentialsFileArg->getValue(),
                                       s3ConfigFileSectionArg->getValue());
+    s3ServiceOptions.partSize = max(s3PartSizeArg->getValue(), 1U) * 1024ULL * 1024ULL;
+    s3ServiceOptions.partsInFlight = max(s3PartsInFlightArg->getValue(), 1U);
+    s3ServiceOptions.indexCacheDirectory = indexCacheArg->getValue();
     S3Service::setS3ServiceOptions(s3ServiceOptions);
 
     auto sourceFile = processSourceFileSource(sourceFileArg->getValue(), s3ServiceOptions);
@@ -53,23 +71,69 @@ ExtractorRunner *ExtractModeCLIParser::parse(int argc, const char **argv) {
     bool forceOverwrite = forceOverwriteArg->getValue();
 
     auto outputFile = processFileSink(outputFileArg->getValue(), forceOverwrite, s3ServiceOptions);
+    if (auto outputFileSink = dynamic_pointer_cast<FileSink>(outputFile)) {
+        if (syncPolicyArg->getValue() == "close")
+            outputFileSink->setSyncPolicy(SYNC_ON_CLOSE);
+        else if (syncPolicyArg->getValue() == "flush")
+            outputFileSink->setSyncPolicy(SYNC_ON_FLUSH);
+    }
+
+    if (compressionArg->getValue() != "none") {
+        CompressionFormat format = compressionArg->getValue() == "bgzf" ? BGZF : GZIP;
+        shared_ptr<Sink> outputIndexFile;
+        if (format == BGZF && outputFileArg->getValue() != "-") {
+            outputIndexFile = processFileSink(outputFileArg->getValue() + ".fqi", forceOverwrite, s3ServiceOptions);
+        } else if (format == BGZF) {
+            ErrorAccumulator::always("No index will be written for BGZF output to stdout.");
+        }
+        outputFile = CompressingSink::from(outputFile, format, compressionThreadsArg->getValue(), outputIndexFile);
+    }
 
     ErrorAccumulator::setVerbosity(verbosityArg->getValue());
     bool enableDebugging = debugSwitch->getValue();
     if (enableDebugging)
         ErrorAccumulator::setVerbosity(3);
 
+    if (namesFileArg->isSet()) {
+        // The read name index is written next to the index by the index mode.
+        auto readNameIndexFile = processIndexFileSource(
+                resolveIndexFileName(indexFileArg->getValue(), sourceFile) + ".names", s3ServiceOptions);
+        auto namesFile = processSourceFileSource(namesFileArg->getValue(), s3ServiceOptions);
+        ErrorAccumulator::always("Read name index file: '", readNameIndexFile->toString(), "'");
+        auto runner = new ReadNameExtractorRunner(sourceFile, indexFile, readNameIndexFile, namesFile, outputFile,
+                                                  enableDebugging);
+        runner->enableRunStatistics(statsJSONArg->getValue(), progressArg->getValue());
+        runner->enableTracing(traceArg->getValue());
+        return runner;
+    }
+
     uint recordSize = recordSizeArg->getValue();
     if (recordSize <= 0)
         recordSize = 0;
 
+    if (byteRangeArg->isSet()) {
+        int64_t rangeStart{0}, rangeLength{0};
+        // A malformed range is passed on with a length of 0, the runner will then refuse to start.
+        if (!StringHelper::parseByteRange(byteRangeArg->getValue(), &rangeStart, &rangeLength))
+            ErrorAccumulator::severe("The Byte range '" + byteRangeArg->getValue() +
+                                     "' is malformed or too large, use <start>:<length> with a length larger than 0.");
+        auto runner = new ByteRangeExtractorRunner(sourceFile, indexFile, outputFile,
+                                                   static_cast<u_int64_t>(rangeStart),
+                                                   static_cast<u_int64_t>(rangeLength),
+                                                   alignToRecordsSwitch->getValue(),
+                                                   recordSize);
+        runner->enableRunStatistics(statsJSONArg->getValue(), progressArg->getValue());
+        runner->enableTracing(traceArg->getValue());
+        return runner;
+    }
+
     int64_t start{0}, count{0};
     ExtractMode extractMode = ExtractMode::lines;
     if (segmentIdentifierArg->isSet()) {
         // Enable segment extraction mode
         start = segmentIdentifierArg->getValue();
         count = segmentCountArg->getValue();
-        extractMode = ExtractMode::segment;
+        extractMode = alignSegmentsSwitch->getValue() ? ExtractMode::alignedSegment : ExtractMode::segment;
     } else {
         start = startingReadArg->getValue() * recordSize;
         count = numberOfReadsArg->getValue() * recordSize;
@@ -87,6 +151,8 @@ ExtractorRunner *ExtractModeCLIParser::parse(int argc, const char **argv) {
             enableDebugging
     );
 
+    runner->enableRunStatistics(statsJSONArg->getValue(), progressArg->getValue());
+    runner->enableTracing(traceArg->getValue());
     return runner;
 }
 
@@ -99,6 +165,34 @@ _StringValueArg ExtractModeCLIParser::createOutputFileArg(CmdLine *cmdLineParser
             "-", cmdLineParser);
 }
 
+_StringValueArg ExtractModeCLIParser::createNamesFileArg(CmdLine *cmdLineParser) const {
+    return _makeStringValueArg(
+            "", "names",
+            string("Extract the FASTQ records with the read names listed in this file (one name per line, a leading ") +
+            "'@' and everything after the first whitespace are ignored) instead of a range of records. This needs " +
+            "the read name index <index file>.names, see index --readNameIndex. The records are written in the " +
+            "order of the FASTQ file.",
+            false, "", cmdLineParser);
+}
+
+_StringValueArg ExtractModeCLIParser::createByteRangeArg(CmdLine *cmdLineParser) const {
+    return _makeStringValueArg(
+            "", "bytes",
+            string("Extract a range of Bytes of the uncompressed data instead of a range of records. The range is ") +
+            "given as <start>:<length>, both accept the units k, m, g and t (e.g. 2G:512M). This needs an index with " +
+            "uncompressed offsets, see index --uncompressedOffsets.",
+            false, "", cmdLineParser);
+}
+
+_SwitchArg ExtractModeCLIParser::createAlignToRecordsSwitchArg(CmdLine *cmdLineParser) const {
+    return _makeSwitchArg(
+            "", "alignToRecords",
+            string("Only used with --bytes. Extract the complete records (see recordSize), which start in the Byte ") +
+            "range, instead of the exact range. Use a recordSize of 1 for lines. Consecutive ranges then split the " +
+            "file without gaps or overlaps. Records need an index created with index --recordAware.",
+            cmdLineParser);
+}
+
 _UIntValueArg ExtractModeCLIParser::createrecordSizeArg(CmdLine *cmdLineParser) const {
     return _makeUIntValueArg(
             "e", "recordSize",
@@ -144,3 +238,49 @@ _UIntValueArg ExtractModeCLIParser::createSegmentCountArg(CmdLine *cmdLineParser
             false,
             16, cmdLineParser);
 }
+
+_SwitchArg ExtractModeCLIParser::createAlignSegmentsSwitchArg(CmdLine *cmdLineParser) const {
+    return _makeSwitchArg(
+            "a", "alignSegments",
+            string("Only used in segment extraction mode. Moves the segment boundaries to the nearest index entry, so ") +
+            "that no data needs to be decompressed and discarded before the first line of a segment. Segments might " +
+            "then differ a bit in size.",
+            cmdLineParser);
+}
+
+tuple<_StringValueArg, shared_ptr<ValuesConstraint<string>>>
+ExtractModeCLIParser::createCompressionArg(CmdLine *cmdLineParser) const {
+    vector<string> allowedFormats{"none", "gzip", "bgzf"};
+    auto allowedFormatsConstraint = make_shared<ValuesConstraint<string>>(allowedFormats);
+
+    auto arg = make_shared<ValueArg<string>>(
+            "c", "compress",
+            string("Compress the extracted data with gzip or bgzf (blocked gzip like bgzip). For bgzf, an index file ") +
+            "<outfile>.fqi is written along with the output file, if the output is not stdout. Compression is done " +
+            "in parallel, see --threads.",
+            false,
+            "none", allowedFormatsConstraint.get(), *cmdLineParser);
+    return {arg, allowedFormatsConstraint};
+}
+
+tuple<_StringValueArg, shared_ptr<ValuesConstraint<string>>>
+ExtractModeCLIParser::createSyncPolicyArg(CmdLine *cmdLineParser) const {
+    vector<string> allowedPolicies{"never", "close", "flush"};
+    auto allowedPoliciesConstraint = make_shared<ValuesConstraint<string>>(allowedPolicies);
+
+    auto arg = make_shared<ValueArg<string>>(
+            "", "sync",
+            string("Sync the output file to the disk with fsync() when it is closed or on every flush of the ") +
+            "output buffer. Ignored for stdout and S3.",
+            false,
+            "never", allowedPoliciesConstraint.get(), *cmdLineParser);
+    return {arg, allowedPoliciesConstraint};
+}
+
+_UIntValueArg ExtractModeCLIParser::createCompressionThreadsArg(CmdLine *cmdLineParser) const {
+    return _makeUIntValueArg(
+            "t", "threads",
+            "The number of threads used for the compression of the extracted data. Only used with --compress.",
+            false,
+            1, cmdLineParser);
+}
@@ -7,18 +7,25 @@
 #ifndef FASTQINDEX_EXTRACTMODECLIPARSER_H
 #define FASTQINDEX_EXTRACTMODECLIPARSER_H
 
+#include "runners/ByteRangeExtractorRunner.h"
 #include "runners/ExtractorRunner.h"
+#include "runners/ReadNameExtractorRunner.h"
 #include "ModeCLIParser.h"
 
 class ExtractModeCLIParser : public ModeCLIParser {
 
 public:
-    ExtractorRunner *parse(int arc, const char **argv) override;
+    /**
+     * Creates an ExtractorRunner or, with --names, a ReadNameExtractorRunner.
+     */
+    IndexReadingRunner *parse(int arc, const char **argv) override;
 
     _UIntValueArg createSegmentCountArg(CmdLine *cmdLineParser) const;
 
     _UIntValueArg createSegmentIdentifierArg(CmdLine *cmdLineParser) const;
 
+    _SwitchArg createAlignSegmentsSwitchArg(CmdLine *cmdLineParser) const;
+
     _UInt64ValueArg createNumberOfReadsArg(CmdLine *cmdLineParser) const;
 
     _UInt64ValueArg createStartingReadArg(CmdLine *cmdLineParser) const;
@@ -27,6 +34,20 @@ public:
 
     _StringValueArg createOutputFileArg(CmdLine *cmdLineParser) const;
 
+    _StringValueArg createNamesFileArg(CmdLine *cmdLineParser) const;
+
+    _StringValueArg createByteRangeArg(CmdLine *cmdLineParser) const;
+
+    _SwitchArg createAlignToRecordsSwitchArg(CmdLine *cmdLineParser) const;
+
+    tuple<_StringValueArg, shared_ptr<ValuesConstraint<string>>>
+    createCompressionArg(CmdLine *cmdLineParser) const;
+
+    _UIntValueArg createCompressionThreadsArg(CmdLine *cmdLineParser) const;
+
+    tuple<_StringValueArg, shared_ptr<ValuesConstraint<string>>>
+    createSyncPolicyArg(CmdLine *cmdLineParser) const;
+
 };
 
 
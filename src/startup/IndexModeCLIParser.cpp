@@ -35,12 +35,21 @@ IndexerRunner *IndexModeCLIParser::parse(int argc, const char **argv) {
     auto byteDistanceArg = createByteDistanceArg(cmdLineParser.get());
     auto[selectIndexMetricArg, constraints] = createSelectIndexEntryStorageStrategyArg(cmdLineParser.get());
 
+    auto statsJSONArg = createStatsJSONArg(cmdLineParser.get());
+    auto progressArg = createProgressArg(cmdLineParser.get());
+    auto traceArg = createTraceArg(cmdLineParser.get());
+
     auto forceOverwriteArg = createForceOverwriteSwitchArg(cmdLineParser.get());
+    auto readNameIndexSwitch = createReadNameIndexSwitchArg(cmdLineParser.get());
+    auto uncompressedOffsetsSwitch = createUncompressedOffsetsSwitchArg(cmdLineParser.get());
+    auto recordAwareSwitch = createRecordAwareSwitchArg(cmdLineParser.get());
     auto dictCompressionSwitch = createDictCompressionSwitchArg(cmdLineParser.get());
 
     auto s3ConfigFileSectionArg = createS3ConfigFileSectionArg(cmdLineParser.get());
     auto s3CredentialsFileArg = createS3CredentialsFileArg(cmdLineParser.get());
     auto s3ConfigFileArg = createS3ConfigFileArg(cmdLineParser.get());
+    auto s3PartSizeArg = createS3PartSizeArg(cmdLineParser.get());
+    auto s3PartsInFlightArg = createS3PartsInFlightArg(cmdLineParser.get());
 
     auto indexFileArg = createIndexFileArg(cmdLineParser.get());
     auto sourceFileArg = createFastqFileArg(cmdLineParser.get());
@@ -55,11 +64,23 @@ IndexerRunner *IndexModeCLIParser::parse(int argc, const char **argv) {
     S3ServiceOptions s3ServiceOptions(s3ConfigFileArg->getValue(),
                                       s3CredentialsFileArg->getValue(),
                                       s3ConfigFileSectionArg->getValue());
+    s3ServiceOptions.partSize = max(s3PartSizeArg->getValue(), 1U) * 1024ULL * 1024ULL;
+    s3ServiceOptions.partsInFlight = max(s3PartsInFlightArg->getValue(), 1U);
     S3Service::setS3ServiceOptions(s3ServiceOptions);
 
     auto fastq = processSourceFileSource(sourceFileArg->getValue(), s3ServiceOptions);
     auto index = processIndexFileSink(indexFileArg->getValue(), forceOverwrite, fastq, s3ServiceOptions);
 
+    // The read name index is stored next to the index, so it needs an index with a name.
+    shared_ptr<Sink> readNameIndex;
+    if (readNameIndexSwitch->getValue()) {
+        string indexFile = resolveIndexFileName(indexFileArg->getValue(), fastq);
+        if (indexFile == "-" || indexFile.empty())
+            ErrorAccumulator::severe("A read name index can't be written for a streamed index file, it is skipped.");
+        else
+            readNameIndex = processFileSink(indexFile + ".names", forceOverwrite, s3ServiceOptions);
+    }
+
     shared_ptr<IndexEntryStorageDecisionStrategy> storageStrategy;
     if (selectIndexMetricArg->getValue() == "BlockDistance") {
         int blockInterval = blockIntervalArg->getValue();
@@ -88,10 +109,20 @@ IndexerRunner *IndexModeCLIParser::parse(int argc, const char **argv) {
         ErrorAccumulator::always("FQI file must not be written");
     if (disableFailsafeDistanceSwitch->getValue())
         ErrorAccumulator::always("Failsafe distance is turned off");
+    if (recordAwareSwitch->getValue() || readNameIndex)
+        ErrorAccumulator::always("FASTQ records are validated, index entries start with records");
+    if (readNameIndex)
+        ErrorAccumulator::always("Read name index file: '", readNameIndex->toString(), "'");
+    if (uncompressedOffsetsSwitch->getValue())
+        ErrorAccumulator::always("Index entries store their uncompressed offsets");
 
     auto runner = new IndexerRunner(fastq, index, storageStrategy, enableDebugging, forceOverwrite,
                                     forbidIndexWriteoutSwitch->getValue(),
                                     dictCompressionSwitch->getValue());
+    runner->setRecordAwareIndexing(recordAwareSwitch->getValue());
+    if (readNameIndex)
+        runner->setReadNameIndex(readNameIndex);
+    runner->setUncompressedOffsetStorage(uncompressedOffsetsSwitch->getValue());
 
     if (storeForDecompressedBlocksArg->isSet()) {
         runner->enableWritingDecompressedBlocksAndStatistics(storeForDecompressedBlocksArg->getValue());
@@ -104,6 +135,8 @@ IndexerRunner *IndexModeCLIParser::parse(int argc, const char **argv) {
                                  storeForPartialDecompressedBlocksArg->getValue(), "'");
         runner->enableWritingPartialDecompressedBlocks(storeForPartialDecompressedBlocksArg->getValue());
     }
+    runner->enableRunStatistics(statsJSONArg->getValue(), progressArg->getValue());
+    runner->enableTracing(traceArg->getValue());
     return runner;
 }
 
@@ -147,6 +180,30 @@ _SwitchArg IndexModeCLIParser::createForbidIndexWriteoutSwitchArg(CmdLine *cmdLi
             cmdLineParser);
 }
 
+_SwitchArg IndexModeCLIParser::createRecordAwareSwitchArg(CmdLine *cmdLineParser) const {
+    return _makeSwitchArg(
+            "r", "recordAware",
+            string("Validate the FASTQ records (header, sequence, separator and quality lines) during indexing and ") +
+            "let the index entries start with records instead of lines. The indexing fails for malformed FASTQ data.",
+            cmdLineParser);
+}
+
+_SwitchArg IndexModeCLIParser::createReadNameIndexSwitchArg(CmdLine *cmdLineParser) const {
+    return _makeSwitchArg(
+            "", "readNameIndex",
+            string("Also write a read name index to <index file>.names, which is used by extract --names. The read ") +
+            "name index needs 16 Bytes per record in memory and on disk. Implies --recordAware.",
+            cmdLineParser);
+}
+
+_SwitchArg IndexModeCLIParser::createUncompressedOffsetsSwitchArg(CmdLine *cmdLineParser) const {
+    return _makeSwitchArg(
+            "", "uncompressedOffsets",
+            string("Store the offset in the uncompressed data with every index entry (8 additional Bytes per entry). ") +
+            "This is needed by extract --bytes.",
+            cmdLineParser);
+}
+
 _SwitchArg IndexModeCLIParser::createDisableFailsafeDistanceSwitchArg(CmdLine *cmdLineParser) const {
     return _makeSwitchArg(
             "S", "disableFailsafeDistance",
@@ -29,6 +29,12 @@ public:
 
     _SwitchArg createForbidIndexWriteoutSwitchArg(CmdLine *cmdLineParser) const;
 
+    _SwitchArg createRecordAwareSwitchArg(CmdLine *cmdLineParser) const;
+
+    _SwitchArg createReadNameIndexSwitchArg(CmdLine *cmdLineParser) const;
+
+    _SwitchArg createUncompressedOffsetsSwitchArg(CmdLine *cmdLineParser) const;
+
     _StringValueArg createStoreForPartialDecompressedBlocksArg(CmdLine *cmdLineParser) const;
 
     _StringValueArg createStoreForDecompressedBlocksArg(CmdLine *cmdLineParser) const;
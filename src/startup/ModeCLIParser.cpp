@@ -6,6 +6,7 @@
 
 #include "process/io/FileSink.h"
 #include "process/io/FileSource.h"
+#include "process/io/s3/IndexCache.h"
 #include "process/io/s3/S3Sink.h"
 #include "process/io/s3/S3Source.h"
 #include "process/io/Source.h"
@@ -15,6 +16,7 @@
 #include <tclap/CmdLine.h>
 
 #include <memory>
+#include <thread>
 
 _IntValueArg ModeCLIParser::createVerbosityArg(CmdLine *cmdLineParser) const {
     return _makeIntValueArg(
@@ -40,8 +42,8 @@ _StringValueArg ModeCLIParser::createIndexFileArg(CmdLine *cmdLineParser) const
             string("The index file which shall be created or - for stdout or \"\" to append .fqi to the FASTQ filename. ") +
             "Note, that the index will be streamed to stdout, if you provide \"\" or - as the FASTQ file parameter. " +
             "The index file can also reside in an S3 bucket. Enter the filename here like s3:<filename> and set the"
-            " bucket with --bucket." +
-            " Note, that this software will create the index in the tmp directory before uploading it to S3!",
+            " bucket with --bucket. Indices written to stdout end with a trailer instead of a complete header, they" +
+            " need to be stored in a file or in S3, before they can be used for extraction.",
             false, "",
             cmdLineParser);
 }
@@ -88,6 +90,60 @@ _StringValueArg ModeCLIParser::createS3ConfigFileSectionArg(CmdLine *cmdLinePars
             cmdLineParser);
 }
 
+_UIntValueArg ModeCLIParser::createS3PartSizeArg(CmdLine *cmdLineParser) const {
+    return _makeUIntValueArg(
+            "", "s3PartSize",
+            "Objects in S3 are read and written in parts of this size in MiB. Uploaded parts are at least 5 MiB.",
+            false,
+            8, cmdLineParser);
+}
+
+_UIntValueArg ModeCLIParser::createS3PartsInFlightArg(CmdLine *cmdLineParser) const {
+    return _makeUIntValueArg(
+            "", "s3Parts",
+            "The number of parts which are downloaded or uploaded in parallel when accessing objects in S3.",
+            false,
+            8, cmdLineParser);
+}
+
+_StringValueArg ModeCLIParser::createIndexCacheArg(CmdLine *cmdLineParser) const {
+    return _makeStringValueArg(
+            "", "indexCache",
+            string("Keep local copies of index files from S3 in this directory. An index is then only downloaded ") +
+            "again, if it changed in S3.",
+            false,
+            "", cmdLineParser);
+}
+
+_StringValueArg ModeCLIParser::createStatsJSONArg(CmdLine *cmdLineParser) const {
+    return _makeStringValueArg(
+            "", "stats-json",
+            string("Collect run statistics (read and decompressed Bytes, blocks, index entries, time spent in read, ") +
+            "inflate, line scanning, dictionary compression, sink writes and S3 requests and the peak memory) and " +
+            "write them to this file as JSON, when the run is finished.",
+            false,
+            "", cmdLineParser);
+}
+
+_UIntValueArg ModeCLIParser::createProgressArg(CmdLine *cmdLineParser) const {
+    return _makeUIntValueArg(
+            "", "progress",
+            string("Print the progress (read and decompressed MB, MB/s and, if the amount of work is known, the ") +
+            "estimated time left) every n seconds to stderr. 0 (default) turns the report off.",
+            false,
+            0, cmdLineParser);
+}
+
+_StringValueArg ModeCLIParser::createTraceArg(CmdLine *cmdLineParser) const {
+    return _makeStringValueArg(
+            "", "trace",
+            string("Record a timeline of the run per thread (reads, inflate calls, block finalization, dictionary ") +
+            "compression, index writes, S3 requests and output writes) and write it to this file in the Chrome " +
+            "trace event format. Open it with https://ui.perfetto.dev or chrome://tracing.",
+            false,
+            "", cmdLineParser);
+}
+
 _SwitchArg ModeCLIParser::createForceOverwriteSwitchArg(CmdLine *cmdLineParser) const {
     return _makeSwitchArg(
             "w",
@@ -96,6 +152,14 @@ _SwitchArg ModeCLIParser::createForceOverwriteSwitchArg(CmdLine *cmdLineParser)
             cmdLineParser);
 }
 
+_UIntValueArg ModeCLIParser::createDecompressionThreadsArg(CmdLine *cmdLineParser) const {
+    return _makeUIntValueArg(
+            "t", "threads",
+            "The number of threads which decompress the FASTQ file in parallel. Defaults to the number of cores.",
+            false,
+            max(thread::hardware_concurrency(), 1U), cmdLineParser);
+}
+
 tuple<shared_ptr<UnlabeledValueArg<string>>, shared_ptr<ValuesConstraint<string>>>
 ModeCLIParser::createAllowedModeArg(const string &mode, CmdLine *cmdLineParser) const {
     vector<string> allowedMode{mode};
@@ -115,6 +179,11 @@ shared_ptr<Source> ModeCLIParser::processSourceFileSource(const string &sourceFi
     return FileSource::from(sourceFileArg);
 }
 
+SourceFactory ModeCLIParser::createSourceFileSourceFactory(const string &sourceFileArg,
+                                                           const S3ServiceOptions &s3ServiceOptions) {
+    return [sourceFileArg, s3ServiceOptions]() { return processSourceFileSource(sourceFileArg, s3ServiceOptions); };
+}
+
 shared_ptr<Source> ModeCLIParser::processIndexFileSource(const string &indexFile,
                                                          const shared_ptr<Source> &fastqSource,
                                                          const S3ServiceOptions &s3ServiceOptions) {
@@ -126,6 +195,16 @@ shared_ptr<Source> ModeCLIParser::processIndexFileSource(const string &indexFile
 shared_ptr<Source> ModeCLIParser::processIndexFileSource(const string &indexFile,
                                                          const S3ServiceOptions &s3ServiceOptions) {
     if (isS3Path(indexFile)) {
+        if (!s3ServiceOptions.indexCacheDirectory.empty()) {
+            IndexCache cache(s3ServiceOptions.indexCacheDirectory);
+            auto cachedIndex = cache.fetch(make_shared<S3RangeSource>(indexFile, s3ServiceOptions),
+                                           s3ServiceOptions.partsInFlight, s3ServiceOptions.partSize);
+            if (cachedIndex)
+                return cachedIndex;
+            for (const auto &message : cache.getErrorMessages())
+                ErrorAccumulator::warning(message);
+            ErrorAccumulator::warning("Reading '" + indexFile + "' without the index cache.");
+        }
         return S3Source::from(indexFile, s3ServiceOptions);
     } else {
         return FileSource::from(indexFile);
@@ -138,7 +217,10 @@ shared_ptr<Sink> ModeCLIParser::processIndexFileSink(const string &_indexFile,
                                                      const S3ServiceOptions &s3ServiceOptions) {
     string indexFile = resolveIndexFileName(_indexFile, fastqSource);
 
-    if (isS3Path(indexFile)) {
+    // A streamed index can't be patched afterwards, the IndexWriter appends a trailer instead.
+    if (indexFile == "-" || indexFile.empty()) {
+        return ConsoleSink::create();
+    } else if (isS3Path(indexFile)) {
         return S3Sink::from(indexFile, forceOverwrite, s3ServiceOptions);
     } else {
         return FileSink::from(indexFile, forceOverwrite);
@@ -83,8 +83,22 @@ public:
 
     _StringValueArg createS3ConfigFileSectionArg(CmdLine *cmdLineParser) const;
 
+    _UIntValueArg createS3PartSizeArg(CmdLine *cmdLineParser) const;
+
+    _UIntValueArg createS3PartsInFlightArg(CmdLine *cmdLineParser) const;
+
+    _StringValueArg createIndexCacheArg(CmdLine *cmdLineParser) const;
+
+    _StringValueArg createStatsJSONArg(CmdLine *cmdLineParser) const;
+
+    _UIntValueArg createProgressArg(CmdLine *cmdLineParser) const;
+
+    _StringValueArg createTraceArg(CmdLine *cmdLineParser) const;
+
     _SwitchArg createForceOverwriteSwitchArg(CmdLine *cmdLineParser) const;
 
+    _UIntValueArg createDecompressionThreadsArg(CmdLine *cmdLineParser) const;
+
     tuple<shared_ptr<UnlabeledValueArg<string>>, shared_ptr<ValuesConstraint<string>>>
     createAllowedModeArg(const string &mode, CmdLine *cmdLineParser) const;
     
@@ -108,6 +122,12 @@ public:
      */
     static shared_ptr<Source> processSourceFileSource(const string &sourceFileArg, const S3ServiceOptions &s3ServiceOptions);
 
+    /**
+     * For modes, which read the FASTQ file with several threads. Each call of the factory creates a new Source.
+     */
+    static SourceFactory createSourceFileSourceFactory(const string &sourceFileArg,
+                                                       const S3ServiceOptions &s3ServiceOptions);
+
     static shared_ptr<Source> processIndexFileSource(const string &indexFile,
                                                      const shared_ptr<Source> &fastqSource,
                                                      const S3ServiceOptions &s3ServiceOptions);
@@ -8,10 +8,14 @@
 #include "process/io/FileSource.h"
 #include "runners/ExtractorRunner.h"
 #include "runners/IndexerRunner.h"
+#include "runners/IntegrityTestRunner.h"
+#include "runners/VerifierRunner.h"
 #include "ExtractModeCLIParser.h"
 #include "IndexModeCLIParser.h"
 #include "IndexStatsModeCLIParser.h"
 #include "Starter.h"
+#include "TestModeCLIParser.h"
+#include "VerifyModeCLIParser.h"
 #include <tclap/CmdLine.h>
 
 DoNothingRunner *Starter::assembleSmallCmdLineParserAndParseOpts(int argc, const char *argv[]) {
@@ -20,9 +24,11 @@ DoNothingRunner *Starter::assembleSmallCmdLineParserAndParseOpts(int argc, const
     allowedValues.emplace_back("index");
     allowedValues.emplace_back("extract");
     allowedValues.emplace_back("stats");
+    allowedValues.emplace_back("verify");
+    allowedValues.emplace_back("test");
     ValuesConstraint<string> allowedModesConstraint(allowedValues);
-    UnlabeledValueArg<string> mode("mode", "mode is either index, extract or stats", true, "", &allowedModesConstraint,
-                                   cmdLineParser);
+    UnlabeledValueArg<string> mode("mode", "mode is either index, extract, stats, verify or test", true, "",
+                                   &allowedModesConstraint, cmdLineParser);
     cmdLineParser.parse(argc, argv);
     return new DoNothingRunner();
 }
@@ -35,10 +41,18 @@ IndexerRunner *Starter::assembleCmdLineParserForIndexAndParseOpts(int argc, cons
     return IndexModeCLIParser().parse(argc, argv);
 }
 
-ExtractorRunner *Starter::assembleCmdLineParserForExtractAndParseOpts(int argc, const char **argv) {
+IndexReadingRunner *Starter::assembleCmdLineParserForExtractAndParseOpts(int argc, const char **argv) {
     return ExtractModeCLIParser().parse(argc, argv);
 }
 
+VerifierRunner *Starter::assembleCmdLineParserForVerifyAndParseOpts(int argc, const char **argv) {
+    return VerifyModeCLIParser().parse(argc, argv);
+}
+
+IntegrityTestRunner *Starter::assembleCmdLineParserForTestAndParseOpts(int argc, const char **argv) {
+    return TestModeCLIParser().parse(argc, argv);
+}
+
 /**
  * Effectively checks parameter count and file existence and accessibility
  * @param argc parameter count
@@ -54,7 +68,9 @@ Runner *Starter::assembleCLIOptions(int argc, const char *argv[]) {
         if (argc == 1 || (
                 mode != "index" &&
                 mode != "extract" &&
-                mode != "stats")
+                mode != "stats" &&
+                mode != "verify" &&
+                mode != "test")
                 ) {
             assembleSmallCmdLineParserAndParseOpts(argc, argv);
             return new DoNothingRunner();
@@ -64,6 +80,10 @@ Runner *Starter::assembleCLIOptions(int argc, const char *argv[]) {
             return assembleCmdLineParserForExtractAndParseOpts(argc, argv);
         } else if (mode == "stats") {
             return assembleCmdLineParserForIndexStatsAndParseOpts(argc, argv);
+        } else if (mode == "verify") {
+            return assembleCmdLineParserForVerifyAndParseOpts(argc, argv);
+        } else if (mode == "test") {
+            return assembleCmdLineParserForTestAndParseOpts(argc, argv);
         }
     } catch (TCLAP::ArgException &e) { // catch any exceptions
         std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
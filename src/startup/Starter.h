@@ -11,7 +11,9 @@
 #include "runners/ExtractorRunner.h"
 #include "runners/IndexerRunner.h"
 #include "runners/IndexStatsRunner.h"
+#include "runners/IntegrityTestRunner.h"
 #include "runners/Runner.h"
+#include "runners/VerifierRunner.h"
 #include <tclap/CmdLine.h>
 #include <cstring>
 #include <memory>
@@ -45,7 +47,11 @@ public:
 
     IndexerRunner *assembleCmdLineParserForIndexAndParseOpts(int argc, const char **argv);
 
-    ExtractorRunner *assembleCmdLineParserForExtractAndParseOpts(int argc, const char **argv);
+    IndexReadingRunner *assembleCmdLineParserForExtractAndParseOpts(int argc, const char **argv);
+
+    VerifierRunner *assembleCmdLineParserForVerifyAndParseOpts(int argc, const char **argv);
+
+    IntegrityTestRunner *assembleCmdLineParserForTestAndParseOpts(int argc, const char **argv);
 
     Runner *assembleCLIOptions(int argc, const char *argv[]);
 
@@ -0,0 +1,61 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#include "TestModeCLIParser.h"
+#include "process/io/s3/S3Service.h"
+#include <tclap/CmdLine.h>
+
+using namespace std;
+using namespace TCLAP;
+
+IntegrityTestRunner *TestModeCLIParser::parse(int argc, const char **argv) {
+    auto cmdLineParser = createCommandLineParser();
+
+    auto verbosityArg = createVerbosityArg(cmdLineParser.get());
+
+    auto statsJSONArg = createStatsJSONArg(cmdLineParser.get());
+    auto progressArg = createProgressArg(cmdLineParser.get());
+    auto traceArg = createTraceArg(cmdLineParser.get());
+
+    auto s3ConfigFileSectionArg = createS3ConfigFileSectionArg(cmdLineParser.get());
+    auto s3CredentialsFileArg = createS3CredentialsFileArg(cmdLineParser.get());
+    auto s3ConfigFileArg = createS3ConfigFileArg(cmdLineParser.get());
+    auto s3PartSizeArg = createS3PartSizeArg(cmdLineParser.get());
+    auto s3PartsInFlightArg = createS3PartsInFlightArg(cmdLineParser.get());
+    auto indexCacheArg = createIndexCacheArg(cmdLineParser.get());
+
+    auto threadsArg = createDecompressionThreadsArg(cmdLineParser.get());
+    auto indexFileArg = createIndexFileArg(cmdLineParser.get());
+    auto sourceFileArg = createFastqFileArg(cmdLineParser.get());
+
+    // Keep the mode constraints on the stack, so allowedModeArg won't access invalid memory!
+    auto[allowedModeArg, modeConstraints] = createAllowedModeArg("test", cmdLineParser.get());
+
+    cmdLineParser->parse(argc, argv);
+
+    S3ServiceOptions s3ServiceOptions(s3ConfigFileArg->getValue(),
+                                      s3CredentialsFileArg->getValue(),
+                                      s3ConfigFileSectionArg->getValue());
+    s3ServiceOptions.partSize = max(s3PartSizeArg->getValue(), 1U) * 1024ULL * 1024ULL;
+    s3ServiceOptions.partsInFlight = max(s3PartsInFlightArg->getValue(), 1U);
+    s3ServiceOptions.indexCacheDirectory = indexCacheArg->getValue();
+    S3Service::setS3ServiceOptions(s3ServiceOptions);
+
+    // Every thread reads the FASTQ file with its own Source.
+    auto createSource = createSourceFileSourceFactory(sourceFileArg->getValue(), s3ServiceOptions);
+
+    auto sourceFile = createSource();
+
+    auto indexFile = processIndexFileSource(indexFileArg->getValue(), sourceFile, s3ServiceOptions);
+
+    ErrorAccumulator::setVerbosity(verbosityArg->getValue());
+
+    auto runner = new IntegrityTestRunner(createSource, indexFile, threadsArg->getValue());
+
+    runner->enableRunStatistics(statsJSONArg->getValue(), progressArg->getValue());
+    runner->enableTracing(traceArg->getValue());
+    return runner;
+}
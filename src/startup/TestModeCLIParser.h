@@ -0,0 +1,21 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#ifndef FASTQINDEX_TESTMODECLIPARSER_H
+#define FASTQINDEX_TESTMODECLIPARSER_H
+
+#include "runners/IntegrityTestRunner.h"
+#include "ModeCLIParser.h"
+
+class TestModeCLIParser : public ModeCLIParser {
+
+public:
+    IntegrityTestRunner *parse(int argc, const char **argv) override;
+
+};
+
+
+#endif //FASTQINDEX_TESTMODECLIPARSER_H
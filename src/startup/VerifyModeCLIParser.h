@@ -0,0 +1,23 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#ifndef FASTQINDEX_VERIFYMODECLIPARSER_H
+#define FASTQINDEX_VERIFYMODECLIPARSER_H
+
+#include "runners/VerifierRunner.h"
+#include "ModeCLIParser.h"
+
+class VerifyModeCLIParser : public ModeCLIParser {
+
+public:
+    VerifierRunner *parse(int argc, const char **argv) override;
+
+    _UIntValueArg createSpotChecksArg(CmdLine *cmdLineParser) const;
+
+};
+
+
+#endif //FASTQINDEX_VERIFYMODECLIPARSER_H
@@ -11,6 +11,7 @@
 #include <iostream>
 #include <UnitTest++/UnitTest++.h>
 #include <common/IOHelper.h>
+#include <zlib.h>
 
 using namespace std::experimental::filesystem;
 using std::experimental::filesystem::path;
@@ -201,6 +202,27 @@ bool TestResourcesAndFunctions::createConcatenatedFile(const path &file, const p
     return res;
 }
 
+vector<string> TestResourcesAndFunctions::createFastqWithLongReads(const path &file, int reads) {
+    vector<string> lines;
+    gzFile output = gzopen(file.string().c_str(), "wb");
+    for (int i = 0; i < reads; i++) {
+        auto length = static_cast<size_t>(150000 + (i * 7919) % 150000);
+        string sequence(length, 'A');
+        for (size_t j = 0; j < length; j++)
+            sequence[j] = "ACGT"[(j / (i % 5 + 1)) % 4];
+        lines.emplace_back("@read" + to_string(i));
+        lines.emplace_back(sequence);
+        lines.emplace_back("+");
+        lines.emplace_back(string(length, static_cast<char>('A' + i % 20)));
+    }
+    for (const auto &line : lines) {
+        gzwrite(output, line.data(), static_cast<unsigned int>(line.size()));
+        gzputc(output, '\n');
+    }
+    gzclose(output);
+    return lines;
+}
+
 vector<string> TestResourcesAndFunctions::readLinesOfFile(const path &file) {
     ifstream strm(file);
     vector<string> decompressedSourceContent;
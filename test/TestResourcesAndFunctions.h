@@ -92,6 +92,13 @@ public:
 
     static bool createConcatenatedFile(const path &file, const path &result, int repetitions);
 
+    /**
+     * Writes a gzip compressed FASTQ file with reads of 150 to 300 kB. The sequences are repetitive, so the deflate blocks
+     * span several reads and often start far in front of the next line.
+     * @return The lines of the written file.
+     */
+    static vector<string> createFastqWithLongReads(const path &file, int reads);
+
     static vector<string> readLinesOfFile(const path &file);
 
     static string readFile(const path &file);
@@ -0,0 +1,96 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#include "common/RunStatistics.h"
+#include "process/io/FileSink.h"
+#include "process/io/FileSource.h"
+#include "runners/IndexerRunner.h"
+#include "TestConstants.h"
+#include "TestResourcesAndFunctions.h"
+#include <UnitTest++/UnitTest++.h>
+
+const char *const RUN_STATISTICS_TESTS = "Test suite for the RunStatistics class";
+const char *const TEST_COUNT_ONLY_WHEN_ENABLED = "Test counting and timing only when enabled";
+const char *const TEST_PROGRESS_LINE = "Test the progress line with and without ETA";
+const char *const TEST_JSON_OUTPUT = "Test the JSON output";
+const char *const TEST_INDEXER_RUNNER_WRITES_STATISTICS = "Test writing statistics for an indexer run";
+
+SUITE (RUN_STATISTICS_TESTS) {
+
+    TEST (TEST_COUNT_ONLY_WHEN_ENABLED) {
+        RunStatistics::enable();
+        RunStatistics::count(BLOCKS);
+        RunStatistics::count(COMPRESSED_BYTES_READ, 1024);
+        {
+            ScopedRunTimer timer(TIME_IN_INFLATE);
+        }
+        RunStatistics::disable();
+                CHECK_EQUAL(1, RunStatistics::get(BLOCKS));
+                CHECK_EQUAL(1024, RunStatistics::get(COMPRESSED_BYTES_READ));
+                CHECK(RunStatistics::get(TIME_IN_INFLATE).count() > 0);
+
+        // Values are kept, but not changed after disable().
+        RunStatistics::count(BLOCKS);
+        RunStatistics::addTime(TIME_IN_INFLATE, seconds(10));
+                CHECK_EQUAL(1, RunStatistics::get(BLOCKS));
+                CHECK(RunStatistics::get(TIME_IN_INFLATE) < seconds(10));
+
+        // enable() starts from scratch.
+        RunStatistics::enable();
+                CHECK_EQUAL(0, RunStatistics::get(BLOCKS));
+                CHECK_EQUAL(0, RunStatistics::get(TIME_IN_INFLATE).count());
+        RunStatistics::disable();
+    }
+
+    TEST (TEST_PROGRESS_LINE) {
+        RunStatistics::enable();
+        RunStatistics::count(COMPRESSED_BYTES_READ, 2 * 1024 * 1024);
+                CHECK_EQUAL(string::npos, RunStatistics::createProgressLine().find("ETA"));
+
+        RunStatistics::setProgressTotal(COMPRESSED_BYTES_READ, 8 * 1024 * 1024);
+        string line = RunStatistics::createProgressLine();
+                CHECK(line.find("Progress: 2.0 MB read, 0.0 MB decompressed, ") == 0);
+                CHECK(line.find(", 25.0%, ETA ") != string::npos);
+        RunStatistics::disable();
+    }
+
+    TEST (TEST_JSON_OUTPUT) {
+        RunStatistics::enable();
+        RunStatistics::count(INDEX_ENTRIES_STORED, 3);
+        RunStatistics::addTime(TIME_IN_SINK_WRITES, milliseconds(1500));
+        RunStatistics::disable();
+
+        string json = RunStatistics::toJSON("index", true);
+                CHECK(json.find("\"mode\": \"index\"") != string::npos);
+                CHECK(json.find("\"successful\": true") != string::npos);
+                CHECK(json.find("\"indexEntriesStored\": 3,") != string::npos);
+                CHECK(json.find("\"sinkWrites\": 1.500000,") != string::npos);
+                CHECK(json.find("\"peakMemoryBytes\": ") != string::npos);
+                CHECK(RunStatistics::getPeakMemory() > 0);
+    }
+
+    TEST (TEST_INDEXER_RUNNER_WRITES_STATISTICS) {
+        TestResourcesAndFunctions res(RUN_STATISTICS_TESTS, TEST_INDEXER_RUNNER_WRITES_STATISTICS);
+
+        path fastq = res.getResource(TEST_FASTQ_LARGE);
+        path index = res.filePath("test2.fastq.gz.fqi");
+        path statistics = res.filePath("statistics.json");
+        IndexerRunner runner(make_shared<FileSource>(fastq), make_shared<FileSink>(index),
+                             BlockDistanceStorageDecisionStrategy::from(1), false, true, false, true);
+        runner.enableRunStatistics(statistics, 0);
+                CHECK(runner.fulfillsPremises());
+                CHECK_EQUAL(0, runner.run());
+                CHECK(!RunStatistics::isEnabled());
+                CHECK_EQUAL(static_cast<int64_t>(file_size(fastq)), RunStatistics::get(COMPRESSED_BYTES_READ));
+                CHECK(RunStatistics::get(UNCOMPRESSED_BYTES_PRODUCED) > RunStatistics::get(COMPRESSED_BYTES_READ));
+                CHECK(RunStatistics::get(BLOCKS) > 0);
+                CHECK(RunStatistics::get(INDEX_ENTRIES_STORED) > 0);
+
+        string json = TestResourcesAndFunctions::readFile(statistics);
+                CHECK(json.find("\"mode\": \"index\"") != string::npos);
+                CHECK(json.find("\"blocks\": " + to_string(RunStatistics::get(BLOCKS))) != string::npos);
+    }
+}
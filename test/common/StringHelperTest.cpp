@@ -11,6 +11,8 @@
 const char *const STRINGHELPER_TESTS = "Test suite for IOHelper class";
 
 const char *const TEST_SPLIT_STR = "Test splitStr()";
+const char *const TEST_PARSE_BYTE_RANGE = "Test parseByteRange()";
+const char *const TEST_FNV1A = "Test fnv1a()";
 
 SUITE (STRINGHELPER_TESTS) {
 
@@ -44,4 +46,36 @@ SUITE (STRINGHELPER_TESTS) {
                 CHECK_EQUAL(3 * TB, StringHelper::parseStringValue("3t"));
                 CHECK_EQUAL(3 * TB, StringHelper::parseStringValue("3T"));
     }
-}
\ No newline at end of file
+
+    TEST (TEST_PARSE_BYTE_RANGE) {
+        int64_t start{-1}, length{-1};
+                CHECK(!StringHelper::parseByteRange("", &start, &length));
+                CHECK(!StringHelper::parseByteRange("100", &start, &length));
+                CHECK(!StringHelper::parseByteRange("100:", &start, &length));
+                CHECK(!StringHelper::parseByteRange("-1:100", &start, &length));
+                CHECK(!StringHelper::parseByteRange("100:0", &start, &length));
+                CHECK(!StringHelper::parseByteRange("99999999999999999999:1", &start, &length));
+                CHECK(!StringHelper::parseByteRange("1:99999999999999999999", &start, &length));
+                CHECK(!StringHelper::parseByteRange("9000000000T:1", &start, &length));
+                CHECK(!StringHelper::parseByteRange("8000000T:8000000T", &start, &length));
+
+                CHECK(StringHelper::parseByteRange("0:4096", &start, &length));
+                CHECK_EQUAL(0, start);
+                CHECK_EQUAL(4096, length);
+
+                CHECK(StringHelper::parseByteRange("2G:512m", &start, &length));
+                CHECK_EQUAL(2 * GB, start);
+                CHECK_EQUAL(512 * MB, length);
+    }
+
+    TEST (TEST_FNV1A) {
+        // Reference values of the 64 bit FNV-1a hash.
+                CHECK_EQUAL(StringHelper::FNV1A_OFFSET_BASIS, StringHelper::fnv1a("", 0));
+                CHECK_EQUAL(0xaf63dc4c8601ec8cULL, StringHelper::fnv1a("a", 1));
+                CHECK_EQUAL(0x85944171f73967e8ULL, StringHelper::fnv1a("foobar", 6));
+
+        // A text can be hashed in parts.
+        u_int64_t hashOfFoo = StringHelper::fnv1a("foo", 3);
+                CHECK_EQUAL(StringHelper::fnv1a("foobar", 6), StringHelper::fnv1a("bar", 3, hashOfFoo));
+    }
+}
@@ -0,0 +1,102 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#include "common/Tracer.h"
+#include "process/io/FileSink.h"
+#include "process/io/FileSource.h"
+#include "runners/IndexerRunner.h"
+#include "TestConstants.h"
+#include "TestResourcesAndFunctions.h"
+#include <algorithm>
+#include <thread>
+#include <UnitTest++/UnitTest++.h>
+
+const char *const TRACER_TESTS = "Test suite for the Tracer class";
+const char *const TEST_RECORD_SPANS_ONLY_WHEN_ENABLED = "Test recording spans only when enabled";
+const char *const TEST_TRACE_JSON = "Test the trace event JSON";
+const char *const TEST_LIMIT_RECORDED_SPANS = "Test dropping spans after the limit was reached";
+const char *const TEST_INDEXER_RUNNER_WRITES_TRACE = "Test writing a trace for an indexer run";
+
+int countEvents(const string &name) {
+    auto events = Tracer::getEvents();
+    return static_cast<int>(count_if(events.begin(), events.end(),
+                                     [&name](const TraceEvent &event) { return name == event.name; }));
+}
+
+SUITE (TRACER_TESTS) {
+
+    TEST (TEST_RECORD_SPANS_ONLY_WHEN_ENABLED) {
+        Tracer::enable();
+        {
+            TraceSpan span("span");
+        }
+        thread([]() { TraceSpan span("span in thread"); }).join();
+        Tracer::disable();
+        {
+            TraceSpan span("span");
+        }
+                CHECK_EQUAL(1, countEvents("span"));
+                CHECK_EQUAL(1, countEvents("span in thread"));
+
+        // enable() drops the old spans, also the ones of finished threads.
+        Tracer::enable();
+        Tracer::disable();
+                CHECK(Tracer::getEvents().empty());
+    }
+
+    TEST (TEST_TRACE_JSON) {
+        Tracer::enable();
+        auto start = steady_clock::now();
+        Tracer::record("inflate", start, start + microseconds(1500));
+        Tracer::disable();
+
+        string json = Tracer::toJSON();
+                CHECK_EQUAL(0U, json.find("{\"traceEvents\":["));
+                CHECK(json.find(R"("name":"thread_name","ph":"M")") != string::npos);
+                CHECK(json.find(R"("args":{"name":"main"})") != string::npos);
+                CHECK(json.find(R"({"name":"inflate","cat":"fastqindex","ph":"X")") != string::npos);
+                CHECK(json.find(R"("dur":1500.000})") != string::npos);
+    }
+
+    TEST (TEST_LIMIT_RECORDED_SPANS) {
+        Tracer::enable(3);
+        auto start = steady_clock::now();
+        for (int i = 0; i < 5; i++)
+            Tracer::record("span", start, start + microseconds(i));
+        thread([start]() { Tracer::record("span in thread", start, start); }).join();
+        Tracer::disable();
+                CHECK_EQUAL(3, countEvents("span"));
+                CHECK_EQUAL(0, countEvents("span in thread"));
+                CHECK_EQUAL(3U, Tracer::getNumberOfDroppedEvents());
+
+        // enable() resets the limit and the count.
+        Tracer::enable();
+        Tracer::record("span", start, start);
+        Tracer::disable();
+                CHECK_EQUAL(1, countEvents("span"));
+                CHECK_EQUAL(0U, Tracer::getNumberOfDroppedEvents());
+    }
+
+    TEST (TEST_INDEXER_RUNNER_WRITES_TRACE) {
+        TestResourcesAndFunctions res(TRACER_TESTS, TEST_INDEXER_RUNNER_WRITES_TRACE);
+
+        path index = res.filePath("test2.fastq.gz.fqi");
+        path trace = res.filePath("trace.json");
+        IndexerRunner runner(make_shared<FileSource>(res.getResource(TEST_FASTQ_LARGE)), make_shared<FileSink>(index),
+                             BlockDistanceStorageDecisionStrategy::from(1), false, true, false, true);
+        runner.enableTracing(trace);
+                CHECK(runner.fulfillsPremises());
+                CHECK_EQUAL(0, runner.run());
+                CHECK(!Tracer::isEnabled());
+        if (Tracer::isCompiledIn()) {
+                    CHECK(countEvents("inflate") > 0);
+                    CHECK(countEvents("finalize block") > 0);
+                    CHECK(countEvents("compress dictionary") > 0);
+                    CHECK(countEvents("write index entry") > 0);
+        }
+                CHECK(TestResourcesAndFunctions::readFile(trace).find("\"traceEvents\"") != string::npos);
+    }
+}
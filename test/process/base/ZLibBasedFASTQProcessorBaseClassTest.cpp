@@ -6,6 +6,9 @@
 
 #include "process/io/Source.h"
 #include "common/IOHelper.h"
+#include "process/extract/IndexReader.h"
+#include "process/index/Indexer.h"
+#include "process/io/FileSink.h"
 #include "process/io/FileSource.h"
 #include "process/base/ZLibBasedFASTQProcessorBaseClass.h"
 #include "../../TestResourcesAndFunctions.h"
@@ -14,6 +17,7 @@
 
 const char *const TEST_ZLIBBASE_SUITE = "Test suite for ZLibBasedFASTQProcessorBaseClass tests.";
 const char *const TEST_ZLIBBASE_CREATION = "Test creation of ZLibBasedFASTQProcessorBaseClass with a mock class.";
+const char *const TEST_ZLIBBASE_PRIME_WITH_PARTIAL_BYTE = "Test the input Byte count after priming for an entry within a Byte.";
 
 class ZLibBasedFASTQProcessorBaseTestClass : public ZLibBasedFASTQProcessorBaseClass {
 public:
@@ -25,6 +29,10 @@ public:
     z_stream *getZStream() {
         return &zStream;
     }
+
+    int64_t getTotalBytesIn() {
+        return totalBytesIn;
+    }
 };
 
 SUITE (TEST_ZLIBBASE_SUITE) {
@@ -44,4 +52,34 @@ SUITE (TEST_ZLIBBASE_SUITE) {
                 CHECK(zStream->next_in == nullptr);
                 CHECK(zStream->avail_in == 0);
     }
+
+    TEST (TEST_ZLIBBASE_PRIME_WITH_PARTIAL_BYTE) {
+        TestResourcesAndFunctions res(TEST_ZLIBBASE_SUITE, TEST_ZLIBBASE_PRIME_WITH_PARTIAL_BYTE);
+
+        path fastq = TestResourcesAndFunctions::getResource(string(TEST_FASTQ_LARGE));
+        path index = res.filePath("test2.fastq.gz.fqi");
+        Indexer indexer(make_shared<FileSource>(fastq), make_shared<FileSink>(index),
+                        BlockDistanceStorageDecisionStrategy::from(1), false, true, false, false);
+                CHECK(indexer.fulfillsPremises());
+                CHECK(indexer.createIndex());
+
+        IndexReader reader(make_shared<FileSource>(index));
+                CHECK(reader.tryOpenAndReadHeader());
+        shared_ptr<IndexEntry> entry;
+        while (reader.getIndicesLeft() > 0 && (!entry || entry->bits == 0))
+            entry = reader.readIndexEntry();
+                CHECK(entry && entry->bits > 0);
+        if (!entry || entry->bits == 0)
+            return;
+
+        // The partial Byte in front of the block is read, but it is already part of the block offset. The count must
+        // match the offset, otherwise the end of a concatenated part is searched at the wrong position.
+        ZLibBasedFASTQProcessorBaseTestClass mock(fastq, index);
+                CHECK(mock.initializeZStreamForRawInflate());
+        mock.getSource()->open();
+                CHECK(mock.seekAndPrimeZStreamForIndexEntry(entry));
+                CHECK_EQUAL(static_cast<int64_t>(entry->blockOffsetInRawFile), mock.getTotalBytesIn());
+                CHECK_EQUAL(static_cast<int64_t>(entry->blockOffsetInRawFile), mock.getSource()->tell());
+        inflateEnd(mock.getZStream());
+    }
 }
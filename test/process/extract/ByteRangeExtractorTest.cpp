@@ -0,0 +1,168 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#include "process/extract/ByteRangeExtractor.h"
+#include "process/index/Indexer.h"
+#include "process/io/FileSink.h"
+#include "TestResourcesAndFunctions.h"
+#include <fstream>
+#include <sstream>
+#include <UnitTest++/UnitTest++.h>
+
+const char *const BYTE_RANGE_EXTRACTOR_TESTS = "Test suite for the ByteRangeExtractor class";
+const char *const TEST_EXTRACT_BYTE_RANGES = "Test extracting exact and record aligned Byte ranges";
+const char *const TEST_EXTRACT_WITHOUT_UNCOMPRESSED_OFFSETS = "Test extracting a Byte range with an index without uncompressed offsets";
+const char *const TEST_EXTRACT_BYTE_RANGES_FROM_CONCATENATED_FILE = "Test extracting record aligned Byte ranges from concatenated gzip streams";
+const char *const TEST_ALIGN_WITH_LINE_BASED_INDEX = "Test aligning a Byte range to records with a line based index";
+
+string readFileContent(const path &file) {
+    ifstream stream(file, ios::binary);
+    stringstream content;
+    content << stream.rdbuf();
+    return content.str();
+}
+
+string extractByteRange(const path &fastq, const path &index, const path &result, u_int64_t start, u_int64_t length,
+                        bool alignToRecords, uint recordSize = 4) {
+    ByteRangeExtractor extractor(make_shared<FileSource>(fastq), make_shared<FileSource>(index),
+                                 make_shared<FileSink>(result), start, length, alignToRecords, recordSize);
+            CHECK(extractor.fulfillsPremises());
+            CHECK(extractor.extract());
+    return readFileContent(result);
+}
+
+bool createByteRangeIndex(const path &fastq, const path &index, bool recordAware) {
+    Indexer indexer(make_shared<FileSource>(fastq), make_shared<FileSink>(index),
+                    BlockDistanceStorageDecisionStrategy::from(1), false);
+    indexer.setUncompressedOffsetStorage(true);
+    indexer.setRecordAwareIndexing(recordAware);
+    return indexer.fulfillsPremises() && indexer.createIndex();
+}
+
+/**
+ * Extracts consecutive record aligned ranges, which need to split the content into complete records.
+ */
+void checkAlignedRanges(TestResourcesAndFunctions &res, const path &fastq, const path &index, const string &content,
+                        u_int64_t rangeLength) {
+    string concatenated;
+    for (u_int64_t start = 0; start < content.size(); start += rangeLength) {
+        string result = extractByteRange(fastq, index, res.filePath("aligned" + to_string(start) + ".fastq"),
+                                         start, rangeLength, true);
+                CHECK(result.empty() || result[0] == '@');
+                CHECK_EQUAL(0, count(result.begin(), result.end(), '\n') % 4);
+        concatenated += result;
+    }
+            CHECK_EQUAL(content.size(), concatenated.size());
+            CHECK(content == concatenated);
+}
+
+SUITE (BYTE_RANGE_EXTRACTOR_TESTS) {
+
+    TEST (TEST_EXTRACT_BYTE_RANGES) {
+        TestResourcesAndFunctions res(BYTE_RANGE_EXTRACTOR_TESTS, TEST_EXTRACT_BYTE_RANGES);
+
+        path fastq = res.getResource(string(TEST_FASTQ_LARGE));
+        path index = res.filePath("test2.fastq.gz.fqi");
+
+        auto indexer = make_shared<Indexer>(make_shared<FileSource>(fastq), make_shared<FileSink>(index),
+                                            BlockDistanceStorageDecisionStrategy::from(1), true);
+        indexer->setUncompressedOffsetStorage(true);
+        indexer->setRecordAwareIndexing(true);
+                CHECK(indexer->fulfillsPremises());
+                CHECK(indexer->createIndex());
+        auto storedLines = indexer->getStoredLines();
+        indexer.reset();
+
+        string content;
+        for (const auto &line : storedLines)
+            content += line + "\n";
+
+        // The first record of every entry starts at its uncompressed offset plus the line offset.
+        auto indexReader = make_shared<IndexReader>(make_shared<FileSource>(index));
+                CHECK(indexReader->tryOpenAndReadHeader());
+                CHECK(indexReader->getIndexHeader().entriesHaveUncompressedOffsets);
+                CHECK_EQUAL(INDEX_WITH_UNCOMPRESSED_OFFSETS, indexReader->getIndexHeader().indexWriterVersion);
+        u_int64_t entries = 0;
+        while (indexReader->getIndicesLeft() > 0) {
+            auto entry = indexReader->readIndexEntry();
+            auto lineStart = static_cast<u_int64_t>(entry->offsetInUncompressedData + entry->offsetToNextLineStart);
+                    CHECK_EQUAL(storedLines[entry->startingLineInEntry],
+                                content.substr(lineStart, storedLines[entry->startingLineInEntry].size()));
+            entries++;
+        }
+                CHECK(entries > 1);
+
+        // Ranges at the start, across several entries and beyond the end of the data.
+        vector<pair<u_int64_t, u_int64_t>> ranges{{0,                    100},
+                                                  {100000,               300000},
+                                                  {content.size() - 10,  100}};
+        for (u_int64_t i = 0; i < ranges.size(); i++) {
+            auto[start, length] = ranges[i];
+            string result = extractByteRange(fastq, index, res.filePath("exact" + to_string(i) + ".fastq"),
+                                             start, length, false);
+                    CHECK(content.substr(start, length) == result);
+        }
+
+        // Consecutive aligned ranges split the file into complete records.
+        checkAlignedRanges(res, fastq, index, content, content.size() / 3 + 17);
+    }
+
+    TEST (TEST_EXTRACT_BYTE_RANGES_FROM_CONCATENATED_FILE) {
+        TestResourcesAndFunctions res(BYTE_RANGE_EXTRACTOR_TESTS, TEST_EXTRACT_BYTE_RANGES_FROM_CONCATENATED_FILE);
+
+        path fastq = res.filePath("test2_concat.fastq.gz");
+        path index = res.filePath("test2_concat.fastq.gz.fqi");
+        path extractedFastq = res.filePath("test2_concat.fastq");
+                CHECK(TestResourcesAndFunctions::createConcatenatedFile(res.getResource(TEST_FASTQ_LARGE), fastq, 4));
+                CHECK(TestResourcesAndFunctions::extractGZFile(fastq, extractedFastq));
+        string content = readFileContent(extractedFastq);
+                CHECK(createByteRangeIndex(fastq, index, true));
+
+        // The ranges start and end in different members.
+        for (u_int64_t start : {0UL, 2000006UL, content.size() / 2 - 1000}) {
+            string result = extractByteRange(fastq, index, res.filePath("exact" + to_string(start) + ".fastq"),
+                                             start, 1000003, false);
+                    CHECK(content.substr(start, 1000003) == result);
+        }
+        checkAlignedRanges(res, fastq, index, content, 1000003);
+    }
+
+    TEST (TEST_ALIGN_WITH_LINE_BASED_INDEX) {
+        TestResourcesAndFunctions res(BYTE_RANGE_EXTRACTOR_TESTS, TEST_ALIGN_WITH_LINE_BASED_INDEX);
+
+        path fastq = res.getResource(string(TEST_FASTQ_LARGE));
+        path index = res.filePath("test2.fastq.gz.fqi");
+                CHECK(createByteRangeIndex(fastq, index, false));
+
+        // The line numbers of line based indices are not validated, records need a record aware index.
+        ByteRangeExtractor extractor(make_shared<FileSource>(fastq), make_shared<FileSource>(index),
+                                     make_shared<FileSink>(res.filePath("result.fastq")), 0, 100, true, 4);
+                CHECK(!extractor.fulfillsPremises());
+                CHECK_EQUAL(1U, extractor.getErrorMessages().size());
+
+        // Lines can still be aligned.
+        string result = extractByteRange(fastq, index, res.filePath("lines.fastq"), 100, 1000, true, 1);
+                CHECK(!result.empty() && result.back() == '\n');
+    }
+
+    TEST (TEST_EXTRACT_WITHOUT_UNCOMPRESSED_OFFSETS) {
+        TestResourcesAndFunctions res(BYTE_RANGE_EXTRACTOR_TESTS, TEST_EXTRACT_WITHOUT_UNCOMPRESSED_OFFSETS);
+
+        path fastq = res.getResource(string(TEST_FASTQ_LARGE));
+        path index = res.filePath("test2.fastq.gz.fqi");
+
+        auto indexer = make_shared<Indexer>(make_shared<FileSource>(fastq), make_shared<FileSink>(index),
+                                            BlockDistanceStorageDecisionStrategy::from(1), false);
+                CHECK(indexer->fulfillsPremises());
+                CHECK(indexer->createIndex());
+        indexer.reset();
+
+        ByteRangeExtractor extractor(make_shared<FileSource>(fastq), make_shared<FileSource>(index),
+                                     make_shared<FileSink>(res.filePath("result.fastq")), 0, 100, false, 4);
+                CHECK(!extractor.fulfillsPremises());
+                CHECK_EQUAL(1U, extractor.getErrorMessages().size());
+    }
+}
@@ -5,11 +5,14 @@
  */
 
 #include "common/StringHelper.h"
+#include "process/base/IndexHeader.h"
 #include "process/extract/Extractor.h"
 #include "process/index/Indexer.h"
 #include "process/io/FileSink.h"
 #include "process/io/ConsoleSink.h"
+#include "process/io/StreamSource.h"
 #include "TestResourcesAndFunctions.h"
+#include <fstream>
 #include <iostream>
 #include <UnitTest++/UnitTest++.h>
 #include <zlib.h>
@@ -19,6 +22,7 @@ const char *const TEST_EXTRACTOR_CREATION = "Extractor creation";
 const char *const TEST_CREATE_EXTRACTOR_AND_EXTRACT_SMALL_TO_COUT = "Combined test for index creation and extraction with the small dataset, extracts to cout.";
 const char *const TEST_CREATE_EXTRACTOR_AND_EXTRACT_LARGE_TO_COUT = "Combined test for index creation and extraction with the larger dataset, extracts to cout.";
 const char *const TEST_CREATE_EXTRACTOR_AND_EXTRACT_CONCAT_TO_COUT = "Combined test for index creation and extraction with the concatenated dataset, extracts to cout.";
+const char *const TEST_EXTRACT_ACROSS_CONCATENATED_PARTS = "Extraction which starts within a Byte of a concatenated part and continues with the next part.";
 const char *const TEST_PROCESS_DECOMPRESSED_DATA = "Test processDecompressedChunkOfData() with some test data files (analogous to IndexerTest::TEST_CORRECT_BLOCK_LINE_COUNTING.)";
 const char *const TEST_EXTRACTOR_CHECKPREM_OVERWRITE_EXISTING = "Test fail on exsiting file with disabled overwrite.";
 const char *const TEST_EXTRACTOR_CHECKPREM_MISSING_NOTWRITABLE = "Test fail on non-writable result file with overwrite enabled.";
@@ -26,6 +30,9 @@ const char *const TEST_EXTRACTOR_CHECKPREM_MISSING_PARENTNOTWRITABLE = "Test fai
 const char *const TEST_EXTRACTOR_EXTRACT_WITH_OUTFILE = "Text extract to an output file.";
 const char *const TEST_EXTRACTOR_EXTRACT_WITH_EXISTINGOUTFILE = "Text extract to an output file which already exists.";
 const char *const TEST_EXTRACT_SEGMENTS = "Test segment extraction mode.";
+const char *const TEST_EXTRACT_ALIGNED_SEGMENTS = "Test segment extraction mode with segments aligned to index entries.";
+const char *const TEST_EXTRACT_FROM_STREAM = "Test extraction from a non seekable stream.";
+const char *const TEST_EXTRACT_WITH_TRUNCATED_LINE_OFFSETS = "Test extraction with a version 1 index, which stored the line offsets with 16 Bit.";
 
 void runRangedExtractionTest(const path &fastq,
                              const path &index,
@@ -307,6 +314,155 @@ SUITE (INDEXER_SUITE_TESTS) {
         runRangedExtractionTest(fastqConcat, index, decompressedSourceContent, 16000, 4000, 0);
     }
 
+    TEST (TEST_EXTRACT_ACROSS_CONCATENATED_PARTS) {
+        TestResourcesAndFunctions res(INDEXER_SUITE_TESTS, TEST_EXTRACT_ACROSS_CONCATENATED_PARTS);
+
+        path fastq = res.getResource(TEST_FASTQ_LARGE);
+        path fastqConcat = res.filePath("test2_concat.fastq.gz");
+        path index = res.filePath("test2_concat.fastq.gz.fqi_v1");
+        path extractedFastq = res.filePath("test2_concat.fastq");
+        vector<string> decompressedSourceContent;
+
+                CHECK(TestResourcesAndFunctions::createConcatenatedFile(fastq, fastqConcat, 2));
+        if (!initializeComplexTest(fastqConcat, index, extractedFastq, 1, 320000, &decompressedSourceContent))
+            return;
+
+        // The last entry of the first part does not start at a Byte boundary. The end of the part must still be found.
+        Extractor extractor(make_shared<FileSource>(fastqConcat), make_shared<FileSource>(index),
+                            ConsoleSink::create(), false, ExtractMode::lines, 159000, 4000, DEFAULT_RECORD_SIZE, true);
+                CHECK(extractor.extract());
+                CHECK(extractor.getUsedIndexEntry()->bits > 0);
+                CHECK_EQUAL(4000U, extractor.getStoredLines().size());
+                CHECK(TestResourcesAndFunctions::compareVectorContent(decompressedSourceContent,
+                                                                      extractor.getStoredLines(), 159000));
+    }
+
+    TEST (TEST_EXTRACT_FROM_STREAM) {
+        TestResourcesAndFunctions res(INDEXER_SUITE_TESTS, TEST_EXTRACT_FROM_STREAM);
+
+        path fastq = res.getResource(TEST_FASTQ_LARGE);
+        path index = res.filePath(TEST_INDEX_LARGE);
+        path extractedFastq = res.filePath("test2.fastq");
+        u_int64_t linesInFastq = 160000;
+        vector<string> decompressedSourceContent;
+
+        if (!initializeComplexTest(fastq, index, extractedFastq, 1, linesInFastq, &decompressedSourceContent))
+            return;
+
+        auto extractFromStream = [&](const path &file, int64_t firstLine, int64_t lineCount) {
+            ifstream input(file, ios::binary);
+            auto stream = StreamSource::from(&input);
+            Extractor extractor(stream, make_shared<FileSource>(index), ConsoleSink::create(), false,
+                                ExtractMode::lines, firstLine, lineCount, DEFAULT_RECORD_SIZE, true);
+            bool ok = extractor.extract();
+            // The compressed data in front of the index entry was skipped, not read and decompressed. One more Byte is
+            // read for entries which start within a Byte.
+            bool skipped = ok && stream->getTotalReadBytes() <= static_cast<int64_t>(
+                    file_size(file) - extractor.getUsedIndexEntry()->blockOffsetInRawFile + 1);
+            return make_tuple(ok, skipped, extractor.getStoredLines());
+        };
+
+        for (int64_t firstLine : {0, 14223, 80000, 155000}) {
+            auto[ok, skipped, lines] = extractFromStream(fastq, firstLine, 4000);
+                    CHECK(ok);
+                    CHECK(skipped);
+                    CHECK_EQUAL(4000U, lines.size());
+                    CHECK(TestResourcesAndFunctions::compareVectorContent(decompressedSourceContent, lines, firstLine));
+        }
+
+        // The stream ends before the offset of the index entry.
+        path truncatedFastq = res.filePath("truncated.fastq.gz");
+        copy_file(fastq, truncatedFastq);
+        resize_file(truncatedFastq, 100000);
+        auto[ok, skipped, lines] = extractFromStream(truncatedFastq, 150000, 4000);
+                CHECK(!ok);
+    }
+
+    TEST (TEST_EXTRACT_WITH_TRUNCATED_LINE_OFFSETS) {
+        TestResourcesAndFunctions res(INDEXER_SUITE_TESTS, TEST_EXTRACT_WITH_TRUNCATED_LINE_OFFSETS);
+
+        path fastq = res.filePath("longreads.fastq.gz");
+        path index = res.filePath("longreads.fastq.gz.fqi");
+        auto lines = TestResourcesAndFunctions::createFastqWithLongReads(fastq, 40);
+        Indexer indexer(make_shared<FileSource>(fastq), make_shared<FileSink>(index),
+                        BlockDistanceStorageDecisionStrategy::from(1), false, false, false, false);
+                CHECK(indexer.fulfillsPremises());
+                CHECK(indexer.createIndex());
+
+        // Older Indexers cut the offsets down to 16 Bit. The dictionaries are not compressed, so all entries have the
+        // same size.
+        fstream file(index, ios::in | ios::out | ios::binary);
+        IndexHeader header;
+        file.read(reinterpret_cast<char *>(&header), sizeof(IndexHeader));
+                CHECK_EQUAL(INDEX_WITH_LINE_ENTRIES, header.indexWriterVersion);
+        bool anOffsetWasTruncated = false;
+        for (int64_t i = 0; i < header.numberOfEntries; i++) {
+            IndexEntryV1 entry;
+            int64_t position = sizeof(IndexHeader) + i * sizeof(IndexEntryV1);
+            file.seekg(position);
+            file.read(reinterpret_cast<char *>(&entry), sizeof(IndexEntryV1));
+            anOffsetWasTruncated |= entry.offsetToNextLineStart > 65535;
+            entry.offsetToNextLineStart &= 0xFFFFU;
+            file.seekp(position);
+            file.write(reinterpret_cast<char *>(&entry), sizeof(IndexEntryV1));
+        }
+        file.close();
+                CHECK(anOffsetWasTruncated);
+
+        for (u_int64_t firstLine = 0; firstLine < lines.size(); firstLine += 4) {
+            Extractor extractor(make_shared<FileSource>(fastq), make_shared<FileSource>(index), ConsoleSink::create(),
+                                false, ExtractMode::lines, firstLine, 4, DEFAULT_RECORD_SIZE, true);
+                    CHECK(extractor.extract());
+                    CHECK_EQUAL(4U, extractor.getStoredLines().size());
+                    CHECK(TestResourcesAndFunctions::compareVectorContent(lines, extractor.getStoredLines(),
+                                                                          static_cast<uint32_t>(firstLine)));
+        }
+    }
+
+    TEST (TEST_EXTRACT_ALIGNED_SEGMENTS) {
+        TestResourcesAndFunctions res(INDEXER_SUITE_TESTS, TEST_EXTRACT_ALIGNED_SEGMENTS);
+
+        path fastq = res.getResource(TEST_FASTQ_LARGE);
+        path index = res.filePath(TEST_INDEX_LARGE);
+        path extractedFastq = res.filePath("test2.fastq");
+        u_int64_t linesInFastq = 160000;
+        vector<string> decompressedSourceContent;
+
+        if (!initializeComplexTest(fastq, index, extractedFastq, 1, linesInFastq, &decompressedSourceContent))
+            return;
+
+        // Also use more segments than there are index entries, which will lead to some empty segments.
+        for (int64_t segments : {1, 7, 24, 200}) {
+            int64_t expectedStartingLine = 0;
+            for (int64_t segment = 0; segment < segments; segment++) {
+                Extractor extractor(make_shared<FileSource>(fastq),
+                                    make_shared<FileSource>(index),
+                                    ConsoleSink::create(),
+                                    false, ExtractMode::alignedSegment, segment, segments, DEFAULT_RECORD_SIZE, true);
+                        CHECK(extractor.fulfillsPremises());
+                        CHECK(extractor.extract());
+
+                        CHECK(extractor.getExtractMode() == ExtractMode::alignedSegment);
+                        CHECK_EQUAL(expectedStartingLine, extractor.getStartingLine());
+                        CHECK_EQUAL(0, extractor.getStartingLine() % DEFAULT_RECORD_SIZE);
+                        CHECK_EQUAL(0, extractor.getLineCount() % DEFAULT_RECORD_SIZE);
+
+                // The extraction starts within the first record of the used index entry.
+                auto entryStart = static_cast<int64_t>(extractor.getUsedIndexEntry()->startingLineInEntry);
+                        CHECK(entryStart <= extractor.getStartingLine());
+                        CHECK(extractor.getStartingLine() - entryStart < DEFAULT_RECORD_SIZE ||
+                              extractor.getLineCount() == 0);
+
+                vector<string> lines = extractor.getStoredLines();
+                        CHECK_EQUAL(extractor.getLineCount(), static_cast<int64_t>(lines.size()));
+                        CHECK(TestResourcesAndFunctions::compareVectorContent(decompressedSourceContent, lines,
+                                                                              extractor.getStartingLine()));
+                expectedStartingLine += extractor.getLineCount();
+            }
+                    CHECK_EQUAL(static_cast<int64_t>(linesInFastq), expectedStartingLine);
+        }
+    }
+
 //    TEST (TEST_EXTRACT_SEGMENTS) {
 //        TestResourcesAndFunctions res(INDEXER_SUITE_TESTS, TEST_CREATE_EXTRACTOR_AND_EXTRACT_CONCAT_TO_COUT);
 //
@@ -0,0 +1,175 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#include "process/extract/ReadNameExtractor.h"
+#include "process/index/Indexer.h"
+#include "process/io/ConsoleSink.h"
+#include "process/io/FileSink.h"
+#include "TestResourcesAndFunctions.h"
+#include <atomic>
+#include <fstream>
+#include <UnitTest++/UnitTest++.h>
+
+const char *const READ_NAME_EXTRACTOR_TESTS = "Test suite for the ReadNameExtractor class";
+const char *const TEST_EXTRACT_RECORDS_BY_READ_NAME = "Test extracting records by their read names";
+const char *const TEST_EXTRACT_WITHOUT_READ_NAME_INDEX = "Test extracting records by read name without a read name index";
+const char *const TEST_EXTRACT_WITH_STALE_READ_NAME_INDEX = "Test extracting records with a left over read name index";
+const char *const TEST_FIND_READ_NAMES_WITH_FEW_READS = "Test looking up read names with few reads";
+
+/**
+ * Counts the positional reads, each of them would be a request for an index in S3.
+ */
+class ReadAtCountingFileSource : public FileSource {
+
+public:
+
+    atomic<int> readAtCalls{0};
+
+    explicit ReadAtCountingFileSource(const path &file) : FileSource(file) {}
+
+    int64_t readAt(int64_t offset, Bytef *targetBuffer, int64_t length) override {
+        readAtCalls++;
+        return FileSource::readAt(offset, targetBuffer, length);
+    }
+};
+
+/**
+ * Writes a record aware index and a read name index for the file.
+ * @return The lines of the file.
+ */
+vector<string> createIndexWithReadNames(const path &fastq, const path &index, const path &nameIndex) {
+    auto indexer = make_shared<Indexer>(make_shared<FileSource>(fastq), make_shared<FileSink>(index),
+                                        BlockDistanceStorageDecisionStrategy::from(1), true);
+    indexer->setReadNameIndex(make_shared<FileSink>(nameIndex));
+            CHECK(indexer->fulfillsPremises());
+            CHECK(indexer->createIndex());
+    return indexer->getStoredLines();
+}
+
+SUITE (READ_NAME_EXTRACTOR_TESTS) {
+
+    TEST (TEST_EXTRACT_RECORDS_BY_READ_NAME) {
+        TestResourcesAndFunctions res(READ_NAME_EXTRACTOR_TESTS, TEST_EXTRACT_RECORDS_BY_READ_NAME);
+
+        path fastq = res.getResource(string(TEST_FASTQ_LARGE));
+        path index = res.filePath("test2.fastq.gz.fqi");
+        path nameIndex = res.filePath("test2.fastq.gz.fqi.names");
+
+        auto storedLines = createIndexWithReadNames(fastq, index, nameIndex);
+
+        auto nameIndexReader = make_shared<ReadNameIndexReader>(make_shared<FileSource>(nameIndex));
+                CHECK(nameIndexReader->tryOpenAndReadHeader());
+                CHECK_EQUAL(40000U, nameIndexReader->getNumberOfEntries());
+
+        // The first and the last record, records from the middle in unsorted order, a header line with a comment and
+        // a name, which is not in the file.
+        vector<u_int64_t> records{39999, 0, 20000, 12345};
+        path names = res.filePath("names.txt");
+        {
+            ofstream namesStream(names);
+            for (auto record : records)
+                namesStream << ReadNameHash::readNameOf(storedLines[record * 4]) << "\n";
+            namesStream << storedLines[4 * 777] << " some comment\n";
+            namesStream << "\n@not_a_read_name\n";
+        }
+        records.push_back(777);
+        sort(records.begin(), records.end());
+
+        ReadNameExtractor extractor(make_shared<FileSource>(fastq), make_shared<FileSource>(index),
+                                    make_shared<FileSource>(nameIndex), make_shared<FileSource>(names),
+                                    ConsoleSink::create(), true);
+                CHECK(extractor.fulfillsPremises());
+                CHECK(extractor.extract());
+                CHECK_EQUAL(6U, extractor.getNumberOfRequestedNames());
+                CHECK_EQUAL(5U, extractor.getNumberOfFoundNames());
+                CHECK_EQUAL(5U, extractor.getNumberOfExtractedRecords());
+                CHECK(extractor.getMissingNames() == vector<string>{ReadNameHash::readNameOf("@not_a_read_name")});
+
+        // The records are extracted in the order of the file.
+        auto extractedLines = extractor.getStoredLines();
+                CHECK_EQUAL(20U, extractedLines.size());
+        for (u_int64_t i = 0; i < records.size() && i * 4 + 3 < extractedLines.size(); i++) {
+            for (u_int64_t line = 0; line < 4; line++) {
+                        CHECK_EQUAL(storedLines[records[i] * 4 + line], extractedLines[i * 4 + line]);
+            }
+        }
+    }
+
+    TEST (TEST_EXTRACT_WITHOUT_READ_NAME_INDEX) {
+        TestResourcesAndFunctions res(READ_NAME_EXTRACTOR_TESTS, TEST_EXTRACT_WITHOUT_READ_NAME_INDEX);
+
+        path fastq = res.getResource(string(TEST_FASTQ_LARGE));
+        path index = res.filePath("test2.fastq.gz.fqi");
+        path names = res.createEmptyFile("names.txt");
+
+        auto indexer = make_shared<Indexer>(make_shared<FileSource>(fastq), make_shared<FileSink>(index),
+                                            BlockDistanceStorageDecisionStrategy::getDefault());
+        indexer->setRecordAwareIndexing(true);
+                CHECK(indexer->createIndex());
+        indexer.reset();
+
+        ReadNameExtractor extractor(make_shared<FileSource>(fastq), make_shared<FileSource>(index),
+                                    make_shared<FileSource>(res.filePath("test2.fastq.gz.fqi.names")),
+                                    make_shared<FileSource>(names), ConsoleSink::create());
+                CHECK(!extractor.fulfillsPremises());
+                CHECK_EQUAL(1U, extractor.getErrorMessages().size());
+    }
+
+    TEST (TEST_EXTRACT_WITH_STALE_READ_NAME_INDEX) {
+        TestResourcesAndFunctions res(READ_NAME_EXTRACTOR_TESTS, TEST_EXTRACT_WITH_STALE_READ_NAME_INDEX);
+
+        path fastq = res.getResource(string(TEST_FASTQ_LARGE));
+        path index = res.filePath("test2.fastq.gz.fqi");
+        path nameIndex = res.filePath("test2.fastq.gz.fqi.names");
+        auto storedLines = createIndexWithReadNames(fastq, index, nameIndex);
+        path names = res.filePath("names.txt");
+        {
+            ofstream namesStream(names);
+            namesStream << storedLines[4 * 123] << "\n";
+        }
+
+        // The index is written again without record awareness, the read name index is left over. Both still know the
+        // same number of records.
+        auto indexer = make_shared<Indexer>(make_shared<FileSource>(fastq), make_shared<FileSink>(index, true),
+                                            BlockDistanceStorageDecisionStrategy::from(1));
+                CHECK(indexer->createIndex());
+        indexer.reset();
+
+        ReadNameExtractor extractor(make_shared<FileSource>(fastq), make_shared<FileSource>(index),
+                                    make_shared<FileSource>(nameIndex), make_shared<FileSource>(names),
+                                    ConsoleSink::create());
+                CHECK(!extractor.fulfillsPremises());
+        auto messages = extractor.getErrorMessages();
+                CHECK_EQUAL(1U, messages.size());
+                CHECK(!messages.empty() && messages[0].find("is not record aware") != string::npos);
+    }
+
+    TEST (TEST_FIND_READ_NAMES_WITH_FEW_READS) {
+        TestResourcesAndFunctions res(READ_NAME_EXTRACTOR_TESTS, TEST_FIND_READ_NAMES_WITH_FEW_READS);
+
+        path fastq = res.getResource(string(TEST_FASTQ_LARGE));
+        path index = res.filePath("test2.fastq.gz.fqi");
+        path nameIndex = res.filePath("test2.fastq.gz.fqi.names");
+        auto storedLines = createIndexWithReadNames(fastq, index, nameIndex);
+
+        vector<u_int64_t> hashes;
+        for (u_int64_t record : {0, 5000, 12345, 20000, 39999})
+            hashes.push_back(ReadNameHash::of(ReadNameHash::readNameOf(storedLines[record * 4])));
+        sort(hashes.begin(), hashes.end());
+
+        auto source = make_shared<ReadAtCountingFileSource>(nameIndex);
+        ReadNameIndexReader reader(source);
+        auto entries = reader.findEntries(hashes);
+                CHECK_EQUAL(5U, entries.size());
+                CHECK(reader.getErrorMessages().empty());
+
+        // The 40000 entries fit into 10 blocks. A read per probe would need about 16 reads per name.
+        u_int64_t blocks = (reader.getNumberOfEntries() + ReadNameIndexReader::ENTRIES_PER_BLOCK - 1) /
+                           ReadNameIndexReader::ENTRIES_PER_BLOCK;
+                CHECK_EQUAL(10U, blocks);
+                CHECK(source->readAtCalls <= static_cast<int>(1 + blocks));
+    }
+}
@@ -0,0 +1,65 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#include "process/index/FastqRecordScanner.h"
+#include <UnitTest++/UnitTest++.h>
+
+const char *const FASTQ_RECORD_SCANNER_TESTS = "Test suite for the FastqRecordScanner class";
+const char *const TEST_SCAN_VALID_RECORDS_IN_CHUNKS = "Test scanning valid records, which are split into chunks";
+const char *const TEST_SCAN_WITHOUT_FINAL_NEWLINE = "Test scanning valid records without a final newline";
+const char *const TEST_SCAN_MALFORMED_RECORDS = "Test scanning malformed records";
+
+const string VALID_RECORDS = "@read1\nACGT\n+\nIIII\n@read2\nACGTAC\n+read2\nIIIIII\n";
+
+bool scanAll(FastqRecordScanner &scanner, const string &data) {
+    int64_t firstRecordStart{-1};
+    u_int64_t lineOfFirstRecordStart{0};
+    return scanner.scan(data.data(), data.size(), &firstRecordStart, &lineOfFirstRecordStart) && scanner.finish();
+}
+
+SUITE (FASTQ_RECORD_SCANNER_TESTS) {
+
+    TEST (TEST_SCAN_VALID_RECORDS_IN_CHUNKS) {
+        // Split the data in front of every position, the second chunk contains the start of the second record.
+        for (u_int64_t split = 1; split <= 19; split++) {
+            FastqRecordScanner scanner;
+            int64_t firstRecordStart{-1};
+            u_int64_t lineOfFirstRecordStart{0};
+                    CHECK(scanner.scan(VALID_RECORDS.data(), split, &firstRecordStart, &lineOfFirstRecordStart));
+                    CHECK_EQUAL(0, firstRecordStart);
+                    CHECK_EQUAL(0U, lineOfFirstRecordStart);
+
+                    CHECK(scanner.scan(VALID_RECORDS.data() + split, VALID_RECORDS.size() - split, &firstRecordStart,
+                                       &lineOfFirstRecordStart));
+                    CHECK_EQUAL(19 - static_cast<int64_t>(split), firstRecordStart);
+                    CHECK_EQUAL(4U, lineOfFirstRecordStart);
+
+                    CHECK(scanner.finish());
+                    CHECK_EQUAL(8U, scanner.getLines());
+                    CHECK_EQUAL(2U, scanner.getRecords());
+        }
+    }
+
+    TEST (TEST_SCAN_WITHOUT_FINAL_NEWLINE) {
+        FastqRecordScanner scanner;
+                CHECK(scanAll(scanner, VALID_RECORDS.substr(0, VALID_RECORDS.size() - 1)));
+                CHECK_EQUAL(8U, scanner.getLines());
+    }
+
+    TEST (TEST_SCAN_MALFORMED_RECORDS) {
+        vector<string> malformedData{
+                "read1\nACGT\n+\nIIII\n",               // Header without '@'
+                "@read1\nACGT\n-\nIIII\n",              // Separator without '+'
+                "@read1\nACGT\n+\nIII\n",               // Quality string too short
+                "@read1\nACGT\n+\nIIII\n@read2\nACGT\n" // Incomplete last record
+        };
+        for (const auto &data : malformedData) {
+            FastqRecordScanner scanner;
+                    CHECK(!scanAll(scanner, data));
+                    CHECK_EQUAL(1U, scanner.getErrorMessages().size());
+        }
+    }
+}
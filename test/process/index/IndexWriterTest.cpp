@@ -28,6 +28,40 @@ const char *const TEST_WRITE_HEADER_TWICE = "Write header a second time";
 const char *const TEST_WRITE_INDEX_TO_NEWLY_OPENED_FILE = "Write index entry to newly opened file";
 const char *const TEST_WRITE_INDEX_TO_END_OF_FILE = "Write index entry at end of file";
 const char *const TEST_WRITE_ENTRY_CHECK_HEADER_AFTER_CLOSE = "Write index - delete the writer - check the header for validity.";
+const char *const TEST_WRITE_INCOMPLETE_INDEX = "Write index - finalize it as incomplete - the reader rejects it";
+const char *const TEST_WRITE_INDEX_WITH_TRAILER = "Write index to a sink which can't seek back - read it with the trailer";
+const char *const TEST_WRITE_INDEX_WITH_TRAILER_AND_DAMAGE_IT = "Write index with a trailer - damage it - check the checksum";
+
+/**
+ * Behaves like a pipe for the IndexWriter, but the result can be read afterwards.
+ */
+class PipeLikeFileSink : public FileSink {
+public:
+    explicit PipeLikeFileSink(const path &file) : FileSink(file) {}
+
+    bool canSeekBack() override { return false; }
+};
+
+/**
+ * Writes the index in place like sinks, which can't publish, so the incomplete index can be inspected.
+ */
+class InPlaceFileSink : public FileSink {
+public:
+    explicit InPlaceFileSink(const path &file) : FileSink(file) {}
+
+    bool openForPublishing() override { return openWithWriteLock(); }
+};
+
+path writeIndexWithTrailer(const path &index) {
+    auto iw = make_shared<IndexWriter>(make_shared<PipeLikeFileSink>(index));
+    iw->tryOpen();
+    iw->writeIndexHeader(make_shared<IndexHeader>(1, sizeof(IndexEntryV1), 1, false));
+    iw->writeIndexEntry(make_shared<IndexEntryV1>(0, 0, 0, 0, 0));
+    iw->writeIndexEntry(make_shared<IndexEntryV1>(0, 1, 0, 100, 4));
+    iw->setNumberOfLinesInFile(8);
+    iw->finalize();
+    return index;
+}
 
 
 SUITE (SUITE_INDEXWRITER_TESTS) {
@@ -64,8 +98,10 @@ SUITE (SUITE_INDEXWRITER_TESTS) {
         auto header = make_shared<IndexHeader>(1, sizeof(IndexEntryV1), 1, true);
         bool writeOk = iw->writeIndexHeader(header);
                 CHECK(writeOk);
+        // The index is only published, when it is complete.
+                CHECK(!exists(index));
+        iw->finalize();
                 CHECK(exists(index));
-        iw->flush();
                 CHECK(file_size(index) == sizeof(IndexHeader));
     }
 
@@ -99,7 +135,7 @@ SUITE (SUITE_INDEXWRITER_TESTS) {
         auto entry = make_shared<IndexEntryV1>(0, 0, 0, 0, 0);
         bool writeOk1 = iw->writeIndexEntry(entry);
         bool writeOk2 = iw->writeIndexEntry(entry);
-        iw->flush();
+        iw->finalize();
 
                 CHECK(writeOk);
                 CHECK(writeOk1);
@@ -126,4 +162,85 @@ SUITE (SUITE_INDEXWRITER_TESTS) {
         auto readHeader = ir.getIndexHeader();
                 CHECK(readHeader.numberOfEntries == 2);
     }
-}
\ No newline at end of file
+
+    TEST (TEST_WRITE_INCOMPLETE_INDEX) {
+        TestResourcesAndFunctions res(SUITE_INDEXWRITER_TESTS, TEST_WRITE_INCOMPLETE_INDEX);
+        path index = res.filePath(INDEX_FILENAME);
+        path completeIndex = res.filePath("complete.fqi");
+        path publishedIndex = res.filePath("published.fqi");
+
+        for (auto file : {index, completeIndex}) {
+            IndexWriter iw(make_shared<InPlaceFileSink>(file));
+                    CHECK(iw.tryOpen());
+                    CHECK(iw.writeIndexHeader(make_shared<IndexHeader>(1, sizeof(IndexEntryV1), 1, false)));
+                    CHECK(iw.writeIndexEntry(make_shared<IndexEntryV1>(0, 0, 0, 0, 0)));
+            iw.finalize(file == completeIndex);
+        }
+
+        IndexHeader writtenHeader;
+        ifstream(index, ios::binary).read(reinterpret_cast<char *>(&writtenHeader), sizeof(IndexHeader));
+                CHECK_EQUAL(INDEX_IS_INCOMPLETE, writtenHeader.completion);
+        IndexReader ir(make_shared<FileSource>(index));
+                CHECK(!ir.tryOpenAndReadHeader());
+
+        ifstream(completeIndex, ios::binary).read(reinterpret_cast<char *>(&writtenHeader), sizeof(IndexHeader));
+                CHECK_EQUAL(INDEX_IS_COMPLETE, writtenHeader.completion);
+        IndexReader completeReader(make_shared<FileSource>(completeIndex));
+                CHECK(completeReader.tryOpenAndReadHeader());
+
+        // A published index is not written at all, if it is incomplete.
+        {
+            IndexWriter iw(make_shared<FileSink>(publishedIndex));
+                    CHECK(iw.tryOpen());
+                    CHECK(!iw.hasLock());
+                    CHECK(iw.writeIndexHeader(make_shared<IndexHeader>(1, sizeof(IndexEntryV1), 1, false)));
+            iw.finalize(false);
+        }
+                CHECK(!exists(publishedIndex));
+    }
+
+    TEST (TEST_WRITE_INDEX_WITH_TRAILER) {
+        TestResourcesAndFunctions res(SUITE_INDEXWRITER_TESTS, TEST_WRITE_INDEX_WITH_TRAILER);
+        path index = writeIndexWithTrailer(res.filePath(INDEX_FILENAME));
+
+        // The counts are not patched into the header.
+                CHECK_EQUAL(sizeof(IndexHeader) + 2 * sizeof(IndexEntryV1) + sizeof(IndexTrailer), file_size(index));
+        IndexHeader writtenHeader;
+        ifstream(index, ios::binary).read(reinterpret_cast<char *>(&writtenHeader), sizeof(IndexHeader));
+                CHECK(writtenHeader.hasTrailer);
+                CHECK_EQUAL(0, writtenHeader.numberOfEntries);
+
+        IndexReader ir(make_shared<FileSource>(index));
+                CHECK(ir.tryOpenAndReadHeader());
+                CHECK_EQUAL(2, ir.getIndexHeader().numberOfEntries);
+                CHECK_EQUAL(8, ir.getIndexHeader().linesInIndexedFile);
+                CHECK_EQUAL(2, ir.getIndicesLeft());
+                CHECK(ir.readIndexEntryV1());
+                CHECK(!ir.checksumWasVerified());
+        auto entry = ir.readIndexEntryV1();
+                CHECK_EQUAL(100U, entry->blockOffsetInRawFile);
+                CHECK(ir.checksumWasVerified());
+                CHECK(ir.getErrorMessages().empty());
+    }
+
+    TEST (TEST_WRITE_INDEX_WITH_TRAILER_AND_DAMAGE_IT) {
+        TestResourcesAndFunctions res(SUITE_INDEXWRITER_TESTS, TEST_WRITE_INDEX_WITH_TRAILER_AND_DAMAGE_IT);
+        path index = writeIndexWithTrailer(res.filePath(INDEX_FILENAME));
+
+        {
+            fstream file(index, ios::binary | ios::in | ios::out);
+            file.seekp(sizeof(IndexHeader) + 100);
+            file.put(1);
+        }
+        IndexReader ir(make_shared<FileSource>(index));
+                CHECK(ir.tryOpenAndReadHeader());
+        ir.readIndexFileV1();
+                CHECK(!ir.checksumWasVerified());
+                CHECK_EQUAL(1U, ir.getErrorMessages().size());
+
+        // Without the trailer, the index is incomplete.
+        resize_file(index, file_size(index) - sizeof(IndexTrailer));
+        IndexReader truncatedReader(make_shared<FileSource>(index));
+                CHECK(!truncatedReader.tryOpenAndReadHeader());
+    }
+}
@@ -26,6 +26,10 @@ const char *const TEST_CREATE_INDEX_W_STREAMED_DATA = "Test create index with st
 const char *const TEST_CREATE_INDEX_LARGE = "Test create index with more fastq test data.";
 const char *const TEST_CREATE_INDEX_CONCAT = "Test create index with the small fastq concatenated two times.";
 const char *const TEST_CREATE_INDEX_CONCAT_SINGLEBLOCKS = "Test create index with several concatenated FASTQ with single compressed blocks.";
+const char *const TEST_CREATE_RECORD_AWARE_INDEX = "Test create a record aware index with more fastq test data.";
+const char *const TEST_CREATE_RECORD_AWARE_INDEX_FOR_MALFORMED_DATA = "Test create a record aware index for malformed FASTQ data.";
+const char *const TEST_FAILED_INDEXING_KEEPS_EXISTING_INDEX = "Test that a failed indexing run keeps an existing index.";
+const char *const TEST_FAILED_VALIDATION_KEEPS_EXISTING_INDEX = "Test that a failed FASTQ validation keeps an existing index.";
 
 SUITE (INDEXER_SUITE_TESTS) {
 
@@ -444,4 +448,122 @@ SUITE (INDEXER_SUITE_TESTS) {
 
         delete ir;
     }
-}
\ No newline at end of file
+    TEST (TEST_CREATE_RECORD_AWARE_INDEX) {
+        TestResourcesAndFunctions res(INDEXER_SUITE_TESTS, TEST_CREATE_RECORD_AWARE_INDEX);
+
+        path fastq = res.getResource(string(TEST_FASTQ_LARGE));
+        path index = res.filePath("test2.fastq.gz.fqi");
+
+        auto indexer = make_shared<Indexer>(make_shared<FileSource>(fastq), make_shared<FileSink>(index),
+                                            BlockDistanceStorageDecisionStrategy::from(1), true, false, false, true);
+        indexer->setRecordAwareIndexing(true);
+                CHECK(indexer->fulfillsPremises());
+                CHECK(indexer->createIndex());
+                CHECK(indexer->getStoredHeader()->entriesStartWithRecords);
+
+        // Every entry needs to point to the first line of a record.
+        auto storedLines = indexer->getStoredLines();
+        auto storedEntries = indexer->getStoredEntries();
+                CHECK(storedEntries.size() > 50);
+        for (const auto &entry : storedEntries) {
+                    CHECK_EQUAL(0U, entry->startingLineInEntry % 4);
+                    CHECK_EQUAL('@', storedLines[entry->startingLineInEntry][0]);
+        }
+        indexer.reset();
+
+        auto reader = make_shared<IndexReader>(make_shared<FileSource>(index));
+                CHECK(reader->tryOpenAndReadHeader());
+                CHECK(reader->getIndexHeader().entriesStartWithRecords);
+        // Older readers only know line based entries and need to refuse the index.
+                CHECK_EQUAL(INDEX_WITH_RECORD_ENTRIES, reader->getIndexHeader().indexWriterVersion);
+                CHECK_EQUAL(160000, reader->getIndexHeader().linesInIndexedFile);
+    }
+
+    TEST (TEST_CREATE_RECORD_AWARE_INDEX_FOR_MALFORMED_DATA) {
+        TestResourcesAndFunctions res(INDEXER_SUITE_TESTS, TEST_CREATE_RECORD_AWARE_INDEX_FOR_MALFORMED_DATA);
+
+        path fastq = res.filePath("malformed.fastq.gz");
+        path index = res.filePath("malformed.fastq.gz.fqi");
+
+        // The quality string of the second record is too short.
+        string data = "@read1\nACGT\n+\nIIII\n@read2\nACGT\n+\nIII\n";
+        gzFile file = gzopen(fastq.string().c_str(), "wb");
+        gzwrite(file, data.data(), static_cast<unsigned int>(data.size()));
+        gzclose(file);
+
+        auto indexer = make_shared<Indexer>(make_shared<FileSource>(fastq), make_shared<FileSink>(index),
+                                            BlockDistanceStorageDecisionStrategy::from(1), false, false, false, true);
+        indexer->setRecordAwareIndexing(true);
+                CHECK(indexer->fulfillsPremises());
+                CHECK(!indexer->createIndex());
+
+        bool messageWasFound = false;
+        for (const auto &message : indexer->getErrorMessages())
+            messageWasFound |= message.find("The quality string of record #1 has 3 characters") != string::npos;
+                CHECK(messageWasFound);
+    }
+
+    TEST (TEST_FAILED_INDEXING_KEEPS_EXISTING_INDEX) {
+        TestResourcesAndFunctions res(INDEXER_SUITE_TESTS, TEST_FAILED_INDEXING_KEEPS_EXISTING_INDEX);
+        path fastq = res.filePath("test.fastq.gz");
+        path index = res.filePath("test.fastq.gz.fqi");
+
+        string data = "@read1\nACGT\n+\nIIII\n@read2\nACGT\n+\nIIII\n";
+        string existingIndex;
+        for (u_int64_t run = 0; run < 2; run++) {
+            gzFile file = gzopen(fastq.string().c_str(), "wb");
+            gzwrite(file, data.data(), static_cast<unsigned int>(data.size()));
+            gzclose(file);
+            // The second run fails, because the first deflate block behind the 10 Byte gzip header has the invalid
+            // block type 3.
+            if (run == 1) {
+                fstream corruptFile(fastq, ios::in | ios::out | ios::binary);
+                corruptFile.seekp(10);
+                corruptFile.put(static_cast<char>(0xFF));
+            }
+
+            auto indexer = make_shared<Indexer>(make_shared<FileSource>(fastq), make_shared<FileSink>(index, true),
+                                                BlockDistanceStorageDecisionStrategy::from(1), false, true, false,
+                                                true);
+                    CHECK(indexer->fulfillsPremises());
+                    CHECK_EQUAL(run == 0, indexer->createIndex());
+            if (run == 0)
+                existingIndex = TestResourcesAndFunctions::readFile(index);
+        }
+
+                CHECK(!existingIndex.empty());
+                CHECK(existingIndex == TestResourcesAndFunctions::readFile(index));
+        u_int64_t filesInDirectory = 0;
+        for (const auto &entry : directory_iterator(index.parent_path()))
+            filesInDirectory += entry.path() != fastq ? 1 : 0;
+                CHECK_EQUAL(1U, filesInDirectory);
+    }
+
+    TEST (TEST_FAILED_VALIDATION_KEEPS_EXISTING_INDEX) {
+        TestResourcesAndFunctions res(INDEXER_SUITE_TESTS, TEST_FAILED_VALIDATION_KEEPS_EXISTING_INDEX);
+        path fastq = res.filePath("test.fastq.gz");
+        path index = res.filePath("test.fastq.gz.fqi");
+
+        // The second run fails, because the quality string of the second record is too short.
+        vector<string> data{"@read1\nACGT\n+\nIIII\n@read2\nACGT\n+\nIIII\n",
+                            "@read1\nACGT\n+\nIIII\n@read2\nACGT\n+\nIII\n"};
+        string existingIndex;
+        for (u_int64_t run = 0; run < data.size(); run++) {
+            gzFile file = gzopen(fastq.string().c_str(), "wb");
+            gzwrite(file, data[run].data(), static_cast<unsigned int>(data[run].size()));
+            gzclose(file);
+
+            auto indexer = make_shared<Indexer>(make_shared<FileSource>(fastq), make_shared<FileSink>(index, true),
+                                                BlockDistanceStorageDecisionStrategy::from(1), false, true, false,
+                                                true);
+            indexer->setRecordAwareIndexing(true);
+                    CHECK(indexer->fulfillsPremises());
+                    CHECK_EQUAL(run == 0, indexer->createIndex());
+            if (run == 0)
+                existingIndex = TestResourcesAndFunctions::readFile(index);
+        }
+
+                CHECK(!existingIndex.empty());
+                CHECK(existingIndex == TestResourcesAndFunctions::readFile(index));
+    }
+}
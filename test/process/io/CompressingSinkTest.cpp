@@ -0,0 +1,113 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+const char *const COMPRESSING_SINK_TEST_SUITE = "Test suite for the CompressingSink class";
+const char *const COMPRESSING_SINK_GZIP = "Test parallel gzip compression";
+const char *const COMPRESSING_SINK_BGZF_WITH_INDEX = "Test parallel bgzf compression with index creation";
+const char *const COMPRESSING_SINK_REJECTS_SEEKS = "Test that seeks in the compressed output are reported as errors";
+
+#include "process/extract/Extractor.h"
+#include "process/extract/IndexReader.h"
+#include "process/io/CompressingSink.h"
+#include "process/io/ConsoleSink.h"
+#include "process/io/FileSink.h"
+#include "process/io/FileSource.h"
+#include "TestConstants.h"
+#include "TestResourcesAndFunctions.h"
+#include <UnitTest++/UnitTest++.h>
+
+/**
+ * Writes all lines of the (decompressed) large test FASTQ to sink and closes it afterwards.
+ */
+vector<string> writeLargeFastqToCompressingSink(TestResourcesAndFunctions *res, CompressingSink *sink) {
+    path extractedFastq = res->filePath("test2.fastq");
+    TestResourcesAndFunctions::extractGZFile(res->getResource(TEST_FASTQ_LARGE), extractedFastq);
+    auto lines = TestResourcesAndFunctions::readLinesOfFile(extractedFastq);
+
+            CHECK(sink->fulfillsPremises());
+            CHECK(sink->openWithWriteLock());
+    for (const auto &line : lines) {
+        sink->write(line + "\n");
+    }
+            CHECK(sink->close());
+            CHECK(sink->getErrorMessages().empty());
+    return lines;
+}
+
+SUITE (COMPRESSING_SINK_TEST_SUITE) {
+    TEST (COMPRESSING_SINK_GZIP) {
+        TestResourcesAndFunctions res(COMPRESSING_SINK_TEST_SUITE, COMPRESSING_SINK_GZIP);
+
+        path compressed = res.filePath("compressed.fastq.gz");
+        path decompressed = res.filePath("decompressed.fastq");
+        // Use small chunks, so we get a lot of them for the four threads.
+        CompressingSink sink(make_shared<FileSink>(compressed), GZIP, 4, nullptr, 16 * 1024);
+        auto lines = writeLargeFastqToCompressingSink(&res, &sink);
+
+                CHECK(sink.tell() > 0);
+                CHECK(sink.getCompressedBytes() > 0);
+                CHECK(sink.getCompressedBytes() < static_cast<u_int64_t>(sink.tell()));
+                CHECK(!sink.writesIndex());
+
+                CHECK(TestResourcesAndFunctions::extractGZFile(compressed, decompressed));
+        auto decompressedLines = TestResourcesAndFunctions::readLinesOfFile(decompressed);
+                CHECK_EQUAL(lines.size(), decompressedLines.size());
+                CHECK(TestResourcesAndFunctions::compareVectorContent(lines, decompressedLines));
+    }
+
+    TEST (COMPRESSING_SINK_BGZF_WITH_INDEX) {
+        TestResourcesAndFunctions res(COMPRESSING_SINK_TEST_SUITE, COMPRESSING_SINK_BGZF_WITH_INDEX);
+
+        path compressed = res.filePath("compressed.fastq.gz");
+        path index = res.filePath("compressed.fastq.gz.fqi");
+        path decompressed = res.filePath("decompressed.fastq");
+        // Small blocks and an entry for every block which starts with a new line.
+        CompressingSink sink(make_shared<FileSink>(compressed), BGZF, 3, make_shared<FileSink>(index), 8 * 1024, 1);
+                CHECK(sink.writesIndex());
+        auto lines = writeLargeFastqToCompressingSink(&res, &sink);
+
+                CHECK(TestResourcesAndFunctions::extractGZFile(compressed, decompressed));
+        auto decompressedLines = TestResourcesAndFunctions::readLinesOfFile(decompressed);
+                CHECK(TestResourcesAndFunctions::compareVectorContent(lines, decompressedLines));
+
+        auto reader = make_shared<IndexReader>(make_shared<FileSource>(index));
+                CHECK(reader->tryOpenAndReadHeader());
+                CHECK_EQUAL(lines.size(), reader->getIndexHeader().linesInIndexedFile);
+                CHECK(reader->getIndexHeader().numberOfEntries > 10);
+        reader.reset();
+
+        for (auto[firstLine, lineCount] : vector<tuple<int64_t, int64_t>>{{0,      100},
+                                                                         {12345,  2000},
+                                                                         {80000,  40000},
+                                                                         {159990, 10}}) {
+            Extractor extractor(make_shared<FileSource>(compressed),
+                                make_shared<FileSource>(index),
+                                ConsoleSink::create(),
+                                false,
+                                ExtractMode::lines, firstLine, lineCount, DEFAULT_RECORD_SIZE, true);
+            bool ok = extractor.extract();
+                    CHECK(ok);
+            auto extractedLines = extractor.getStoredLines();
+                    CHECK_EQUAL(lineCount, static_cast<int64_t>(extractedLines.size()));
+                    CHECK(TestResourcesAndFunctions::compareVectorContent(lines, extractedLines, firstLine));
+        }
+    }
+
+    TEST (COMPRESSING_SINK_REJECTS_SEEKS) {
+        TestResourcesAndFunctions res(COMPRESSING_SINK_TEST_SUITE, COMPRESSING_SINK_REJECTS_SEEKS);
+
+        CompressingSink sink(make_shared<FileSink>(res.filePath("compressed.fastq.gz")), GZIP, 1);
+                CHECK(sink.fulfillsPremises());
+                CHECK(sink.openWithWriteLock());
+        sink.write("@read\n");
+                CHECK_EQUAL(0, sink.seek(0, true));
+                CHECK_EQUAL(0, sink.skip(10));
+                CHECK_EQUAL(0, sink.rewind(3));
+                CHECK_EQUAL(6, sink.tell());
+                CHECK_EQUAL(3U, sink.getErrorMessages().size());
+                CHECK(!sink.close());
+    }
+}
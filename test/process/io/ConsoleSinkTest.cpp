@@ -5,11 +5,14 @@
  */
 
 #include "process/io/ConsoleSink.h"
+#include "TestResourcesAndFunctions.h"
+#include <fcntl.h>
 #include <UnitTest++/UnitTest++.h>
 
 const char *const SUITE_CONSOLESINK_TESTS = "Test suite for ConsoleSink class";
 const char *const TEST_STATIC_CREATE_COUT = "Test ::create() and construct std::cout";
 const char *const TEST_STATIC_CREATE_CERR = "Test ::create() and construct std::cerr";
+const char *const TEST_KEEP_ORDER_WITH_MESSAGES = "Test that buffered output is written before messages to cerr";
 
 SUITE (SUITE_CONSOLESINK_TESTS) {
     TEST (TEST_STATIC_CREATE_COUT) {
@@ -61,4 +64,31 @@ SUITE (SUITE_CONSOLESINK_TESTS) {
                 CHECK(!sink->isFile());
                 CHECK(!sink->isSymlink());
     }
-}
\ No newline at end of file
+
+    TEST (TEST_KEEP_ORDER_WITH_MESSAGES) {
+        TestResourcesAndFunctions res(SUITE_CONSOLESINK_TESTS, TEST_KEEP_ORDER_WITH_MESSAGES);
+
+        // Let cout and cerr write to the same file, like with "> file 2>&1".
+        path console = res.filePath("console.txt");
+        cout.flush();
+        int file = ::open(console.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        int savedStdout = dup(STDOUT_FILENO);
+        int savedStderr = dup(STDERR_FILENO);
+        dup2(file, STDOUT_FILENO);
+        dup2(file, STDERR_FILENO);
+        close(file);
+
+        auto sink = ConsoleSink::create();
+        sink->write("first line\n");
+        ErrorAccumulator::always("a message");
+        sink->write("second line\n");
+        sink.reset();
+
+        dup2(savedStdout, STDOUT_FILENO);
+        dup2(savedStderr, STDERR_FILENO);
+        close(savedStdout);
+        close(savedStderr);
+
+                CHECK_EQUAL("first line\na message\nsecond line\n", TestResourcesAndFunctions::readFile(console));
+    }
+}
@@ -0,0 +1,107 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#include "process/io/FileDescriptorWriter.h"
+#include "TestResourcesAndFunctions.h"
+#include <fcntl.h>
+#include <future>
+#include <unistd.h>
+#include <UnitTest++/UnitTest++.h>
+
+const char *const FILE_DESCRIPTOR_WRITER_TEST_SUITE = "Test suite for the FileDescriptorWriter class";
+const char *const TEST_REUSE_SPLICED_BUFFER_AFTER_PARTIAL_FLUSH = "Test reusing a spliced buffer after a partial flush";
+const char *const TEST_REUSE_SPLICED_BUFFER_AFTER_DETACH = "Test reusing a spliced buffer after detach and attach";
+
+const u_int64_t PIPE_TEST_BUFFER_SIZE = 64 * 1024;
+
+/**
+ * Reads the pipe in small pieces, so the pages of spliced buffers stay in the pipe for a while.
+ */
+future<string> readPipeSlowly(int fd) {
+    return async(launch::async, [fd]() {
+        string content;
+        char buffer[4096];
+        ssize_t readBytes;
+        usleep(20000);
+        while ((readBytes = read(fd, buffer, sizeof(buffer))) > 0) {
+            content.append(buffer, static_cast<size_t>(readBytes));
+            usleep(500);
+        }
+        return content;
+    });
+}
+
+string createPattern(char first, u_int64_t length) {
+    string pattern(length, first);
+    for (u_int64_t i = 0; i < length; i += 7)
+        pattern[i] = static_cast<char>(first + 1 + i % 13);
+    return pattern;
+}
+
+SUITE (FILE_DESCRIPTOR_WRITER_TEST_SUITE) {
+
+    TEST (TEST_REUSE_SPLICED_BUFFER_AFTER_PARTIAL_FLUSH) {
+        int pipeEnds[2];
+                CHECK_EQUAL(0, pipe(pipeEnds));
+        auto reader = readPipeSlowly(pipeEnds[0]);
+
+        string expected;
+        {
+            FileDescriptorWriter writer(PIPE_TEST_BUFFER_SIZE);
+            writer.attach(pipeEnds[1], true);
+            // A full buffer is spliced, the partial one is written and the first buffer is refilled afterwards. Small
+            // chunks are not written directly, they always go through the buffer.
+            vector<string> parts{createPattern('a', PIPE_TEST_BUFFER_SIZE), createPattern('A', 100),
+                                 createPattern('k', PIPE_TEST_BUFFER_SIZE / 2)};
+            for (u_int64_t i = 0; i < parts.size(); i++) {
+                        CHECK(writer.write(parts[i].data(), parts[i].size()));
+                if (i == 1)
+                            CHECK(writer.flush());
+                expected += parts[i];
+            }
+                    CHECK(writer.detach());
+                    CHECK(writer.getErrorMessages().empty());
+        }
+        close(pipeEnds[1]);
+
+        string content = reader.get();
+        close(pipeEnds[0]);
+                CHECK_EQUAL(expected.size(), content.size());
+                CHECK(expected == content);
+    }
+
+    TEST (TEST_REUSE_SPLICED_BUFFER_AFTER_DETACH) {
+        TestResourcesAndFunctions res(FILE_DESCRIPTOR_WRITER_TEST_SUITE, TEST_REUSE_SPLICED_BUFFER_AFTER_DETACH);
+
+        int pipeEnds[2];
+                CHECK_EQUAL(0, pipe(pipeEnds));
+        auto reader = readPipeSlowly(pipeEnds[0]);
+
+        string piped = createPattern('a', 2 * PIPE_TEST_BUFFER_SIZE);
+        string written = createPattern('k', 2 * PIPE_TEST_BUFFER_SIZE);
+        auto file = res.filePath("written.txt");
+
+        FileDescriptorWriter writer(PIPE_TEST_BUFFER_SIZE);
+        writer.attach(pipeEnds[1], true);
+                CHECK(writer.write(piped.data(), piped.size()));
+                CHECK(writer.detach());
+        // The owner may close the pipe after detach(), the reader still needs to see the spliced data.
+        close(pipeEnds[1]);
+
+        int fileDescriptor = open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+        writer.attach(fileDescriptor);
+                CHECK(!writer.isUsingVMSplice());
+        for (u_int64_t offset = 0; offset < written.size(); offset += 1000)
+                    CHECK(writer.write(written.data() + offset, min<u_int64_t>(1000, written.size() - offset)));
+                CHECK(writer.detach());
+        close(fileDescriptor);
+
+        string content = reader.get();
+        close(pipeEnds[0]);
+                CHECK(piped == content);
+                CHECK(written == TestResourcesAndFunctions::readFile(file));
+    }
+}
@@ -11,11 +11,20 @@ const char *const FILE_SINK_OPENLOCKED = "Test open and close with lock_unlock";
 const char *const FILE_SINK_AQUIRELOCK_LATER = "Test aquire lock after file open";
 const char *const FILE_SINK_WRITE_TELL_SEEK = "Test write tell seek rewind functions";
 const char *const FILE_SINK_WRITE_OVERWRITEBYTES = "Test write rewind_seek overwrite bytes";
+const char *const FILE_SINK_WRITE_SPANS = "Test writing multiple spans at once";
+const char *const FILE_SINK_PUBLISH = "Test publishing a file with openForPublishing and close";
+const char *const FILE_SINK_PUBLISH_DISCARDED = "Test discarding a file with openForPublishing and closeWithoutPublishing";
+const char *const FILE_SINK_PUBLISH_TO_FIFO = "Test publishing to a named pipe";
+const char *const FILE_SINK_PUBLISH_KEEPS_PERMISSIONS = "Test that publishing keeps the permissions of the old file";
+const char *const FILE_SINK_PUBLISH_TO_SYMLINK = "Test publishing to a symlink";
+const char *const FILE_SINK_SYNC_POLICIES = "Test the sync policies";
 
 #include "process/io/FileSink.h"
 #include "process/io/FileSource.h"
 #include "TestConstants.h"
 #include "TestResourcesAndFunctions.h"
+#include <fcntl.h>
+#include <sys/stat.h>
 #include <UnitTest++/UnitTest++.h>
 
 SUITE (FILE_SINK_TEST_SUITE) {
@@ -147,4 +156,167 @@ SUITE (FILE_SINK_TEST_SUITE) {
                 CHECK(source->readChar() == '1');
         delete source;
     }
-}
\ No newline at end of file
+
+    TEST (FILE_SINK_WRITE_SPANS) {
+        TestResourcesAndFunctions res(FILE_SINK_TEST_SUITE, FILE_SINK_WRITE_SPANS);
+
+        auto file = res.filePath("spans.txt");
+        string a("line1\n");
+        string b("line2\n");
+        string c(3 * FileDescriptorWriter::DEFAULT_BUFFER_SIZE, 'c'); // Larger than the stream buffer.
+        struct iovec spans[3]{{const_cast<char *>(a.data()), a.size()},
+                              {const_cast<char *>(b.data()), b.size()},
+                              {const_cast<char *>(c.data()), c.size()}};
+
+        auto sink = new FileSink(file);
+        sink->writeSpans(spans, 3);
+                CHECK(!sink->getErrorMessages().empty()); // Not open yet.
+        sink->openWithWriteLock();
+        sink->writeSpans(spans, 3);
+                CHECK(sink->tell() == static_cast<int64_t >(a.size() + b.size() + c.size()));
+        sink->close();
+        delete sink;
+
+        auto lines = TestResourcesAndFunctions::readLinesOfFile(file);
+                CHECK_EQUAL(3U, lines.size());
+                CHECK(lines[0] == "line1");
+                CHECK(lines[1] == "line2");
+                CHECK(lines[2] == c);
+    }
+
+    TEST (FILE_SINK_PUBLISH) {
+        TestResourcesAndFunctions res(FILE_SINK_TEST_SUITE, FILE_SINK_PUBLISH);
+
+        auto file = res.createEmptyFile("published.txt");
+        ofstream(file) << "old\n";
+
+        FileSink sink(file, true);
+                CHECK(sink.openForPublishing());
+                CHECK(sink.isPublishing());
+                CHECK(!sink.hasLock());
+        auto temporaryFile = sink.getTemporaryFile();
+                CHECK(exists(temporaryFile));
+        sink.write("new\n");
+        sink.flush();
+        // Readers still see the old file.
+                CHECK(TestResourcesAndFunctions::readLinesOfFile(file)[0] == "old");
+                CHECK(sink.close());
+                CHECK(!sink.isPublishing());
+                CHECK(!exists(temporaryFile));
+                CHECK(TestResourcesAndFunctions::readLinesOfFile(file)[0] == "new");
+    }
+
+    TEST (FILE_SINK_PUBLISH_DISCARDED) {
+        TestResourcesAndFunctions res(FILE_SINK_TEST_SUITE, FILE_SINK_PUBLISH_DISCARDED);
+
+        auto file = res.createEmptyFile("published.txt");
+        ofstream(file) << "old\n";
+
+        FileSink sink(file, true);
+                CHECK(sink.openForPublishing());
+        auto temporaryFile = sink.getTemporaryFile();
+        sink.write("new\n");
+                CHECK(sink.closeWithoutPublishing());
+                CHECK(!sink.isPublishing());
+                CHECK(!exists(temporaryFile));
+                CHECK(TestResourcesAndFunctions::readFile(file) == "old\n");
+    }
+
+    TEST (FILE_SINK_PUBLISH_TO_FIFO) {
+        TestResourcesAndFunctions res(FILE_SINK_TEST_SUITE, FILE_SINK_PUBLISH_TO_FIFO);
+
+        auto fifo = res.filePath("published.fifo");
+                CHECK_EQUAL(0, mkfifo(fifo.c_str(), 0600));
+        // Like a reader, which waits for the index. The pipe buffer keeps the data until it is read.
+        int reader = open(fifo.c_str(), O_RDONLY | O_NONBLOCK);
+                CHECK(reader >= 0);
+
+        FileSink sink(fifo, true);
+                CHECK(sink.openForPublishing());
+                CHECK(!sink.isPublishing());
+                CHECK(!sink.canSeekBack());
+        sink.write("data\n");
+                CHECK(sink.close());
+
+        char buffer[16]{0};
+                CHECK_EQUAL(5, read(reader, buffer, sizeof(buffer)));
+                CHECK(string(buffer) == "data\n");
+        close(reader);
+                CHECK(is_fifo(status(fifo)));
+    }
+
+    TEST (FILE_SINK_PUBLISH_KEEPS_PERMISSIONS) {
+        TestResourcesAndFunctions res(FILE_SINK_TEST_SUITE, FILE_SINK_PUBLISH_KEEPS_PERMISSIONS);
+
+        auto file = res.createEmptyFile("published.txt");
+                CHECK_EQUAL(0, chmod(file.c_str(), 0640));
+
+        FileSink sink(file, true);
+                CHECK(sink.openForPublishing());
+        struct stat fileStat{};
+                CHECK_EQUAL(0, stat(sink.getTemporaryFile().c_str(), &fileStat));
+                CHECK_EQUAL(0640U, fileStat.st_mode & 07777);
+        sink.write("new\n");
+                CHECK(sink.close());
+                CHECK_EQUAL(0, stat(file.c_str(), &fileStat));
+                CHECK_EQUAL(0640U, fileStat.st_mode & 07777);
+                CHECK(TestResourcesAndFunctions::readFile(file) == "new\n");
+    }
+
+    TEST (FILE_SINK_PUBLISH_TO_SYMLINK) {
+        TestResourcesAndFunctions res(FILE_SINK_TEST_SUITE, FILE_SINK_PUBLISH_TO_SYMLINK);
+
+        auto file = res.createEmptyFile("published.txt");
+        auto link = res.filePath("link.txt");
+        create_symlink(file, link);
+
+        // The file behind the link is replaced, the link is kept.
+        FileSink sink(link, true);
+                CHECK(sink.openForPublishing());
+                CHECK(sink.getTemporaryFile().parent_path() == canonical(file).parent_path());
+        sink.write("new\n");
+                CHECK(sink.close());
+                CHECK(is_symlink(symlink_status(link)));
+                CHECK(TestResourcesAndFunctions::readFile(file) == "new\n");
+
+        // For a dangling link, the missing file is created.
+        auto danglingLink = res.filePath("dangling.txt");
+        create_symlink(res.filePath("missing.txt"), danglingLink);
+        FileSink danglingSink(danglingLink, true);
+                CHECK(danglingSink.openForPublishing());
+        danglingSink.write("new\n");
+                CHECK(danglingSink.close());
+                CHECK(is_symlink(symlink_status(danglingLink)));
+                CHECK(TestResourcesAndFunctions::readFile(res.filePath("missing.txt")) == "new\n");
+    }
+
+    TEST (FILE_SINK_SYNC_POLICIES) {
+        TestResourcesAndFunctions res(FILE_SINK_TEST_SUITE, FILE_SINK_SYNC_POLICIES);
+
+        for (auto policy : {SYNC_NEVER, SYNC_ON_CLOSE, SYNC_ON_FLUSH}) {
+            auto file = res.filePath("synced" + to_string(policy) + ".txt");
+            FileSink sink(file);
+            sink.setSyncPolicy(policy);
+                    CHECK(sink.openWithWriteLock());
+            sink.write("data\n");
+            sink.flush();
+                    CHECK(sink.close());
+                    CHECK(TestResourcesAndFunctions::readFile(file) == "data\n");
+        }
+
+        // Pipes can't be synced, so the policy shows up in the errors.
+        auto fifo = res.filePath("synced.fifo");
+                CHECK_EQUAL(0, mkfifo(fifo.c_str(), 0600));
+        int reader = open(fifo.c_str(), O_RDONLY | O_NONBLOCK);
+        for (auto policy : {SYNC_NEVER, SYNC_ON_CLOSE, SYNC_ON_FLUSH}) {
+            FileSink sink(fifo, true);
+            sink.setSyncPolicy(policy);
+                    CHECK(sink.openForPublishing());
+            sink.write("data\n");
+            sink.flush();
+                    CHECK_EQUAL(policy == SYNC_ON_FLUSH, !sink.getErrorMessages().empty());
+                    CHECK_EQUAL(policy == SYNC_NEVER, sink.close());
+        }
+        close(reader);
+    }
+}
@@ -10,11 +10,16 @@ const char *const FILE_SOURCE_OPEN = "Test open and close";
 const char *const FILE_SOURCE_OPENLOCKED = "Test open and close with lock - unlock";
 const char *const FILE_SOURCE_AQUIRELOCK_LATER = "Test suite for the FileSource class";
 const char *const FILE_SOURCE_READ_TELL_SEEK = "Test suite for the FileSource class";
+const char *const FILE_SOURCE_READ_AT = "Test concurrent positional reads with readAt";
 
 #include "process/io/FileSource.h"
 #include "TestConstants.h"
 #include "TestResourcesAndFunctions.h"
 #include <UnitTest++/UnitTest++.h>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <thread>
 
 SUITE (FILE_SOURCE_TEST_SUITE) {
     TEST (FILE_SOURCE_CONSTRUCT) {
@@ -106,4 +111,47 @@ SUITE (FILE_SOURCE_TEST_SUITE) {
         p.seek(p.size() + 1, true);
                 CHECK(p.eof());
     }
-}
\ No newline at end of file
+
+    TEST (FILE_SOURCE_READ_AT) {
+        TestResourcesAndFunctions res(FILE_SOURCE_TEST_SUITE, FILE_SOURCE_READ_AT);
+
+        auto ps = TestResourcesAndFunctions::getResource(TEST_FASTQ_LARGE);
+        ifstream referenceStream(ps, ios::binary);
+        string reference((istreambuf_iterator<char>(referenceStream)), istreambuf_iterator<char>());
+
+        FileSource p(ps);
+        Bytef buffer[16]{0};
+                CHECK(p.readAt(0, buffer, sizeof(buffer)) == -1); // Not opened yet.
+
+        p.openWithReadLock();
+        p.seek(1000, true);
+
+        // Let several threads read from the same source at different positions.
+        vector<thread> threads;
+        vector<bool> results(8, false);
+        for (uint t = 0; t < results.size(); t++) {
+            threads.emplace_back([&, t]() {
+                bool allReadsMatch = true;
+                Bytef data[4096]{0};
+                for (int64_t offset = t * 777; offset < static_cast<int64_t>(reference.size()); offset += 8 * 4096) {
+                    int64_t read = p.readAt(offset, data, sizeof(data));
+                    int64_t expected = min(static_cast<int64_t>(sizeof(data)),
+                                           static_cast<int64_t>(reference.size()) - offset);
+                    allReadsMatch &= read == expected &&
+                                     memcmp(data, reference.data() + offset, static_cast<size_t>(expected)) == 0;
+                }
+                results[t] = allReadsMatch;
+            });
+        }
+        for (auto &thread : threads)
+            thread.join();
+
+        for (bool result : results)
+                    CHECK(result);
+
+        // The positional reads don't touch the position of the source.
+                CHECK(p.tell() == 1000);
+                CHECK(p.readAt(p.size(), buffer, sizeof(buffer)) == 0);
+        p.close();
+    }
+}
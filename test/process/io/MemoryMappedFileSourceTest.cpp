@@ -0,0 +1,94 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+const char *const MEMORY_MAPPED_FILE_SOURCE_TEST_SUITE = "Test suite for the MemoryMappedFileSource class";
+const char *const MEMORY_MAPPED_FILE_SOURCE_READ = "Test read, readView and readAt";
+const char *const MEMORY_MAPPED_FILE_SOURCE_SEEK = "Test seek, tell and eof";
+const char *const MEMORY_MAPPED_FILE_SOURCE_EMPTY_FILE = "Test empty and missing files";
+
+#include "process/io/MemoryMappedFileSource.h"
+#include "TestConstants.h"
+#include "TestResourcesAndFunctions.h"
+#include <UnitTest++/UnitTest++.h>
+#include <cstring>
+
+SUITE (MEMORY_MAPPED_FILE_SOURCE_TEST_SUITE) {
+    TEST (MEMORY_MAPPED_FILE_SOURCE_READ) {
+        TestResourcesAndFunctions res(MEMORY_MAPPED_FILE_SOURCE_TEST_SUITE, MEMORY_MAPPED_FILE_SOURCE_READ);
+
+        auto ps = TestResourcesAndFunctions::getResource(TEST_FASTQ_LARGE);
+        string reference = TestResourcesAndFunctions::readFile(ps);
+        MemoryMappedFileSource source(ps);
+                CHECK(source.fulfillsPremises());
+                CHECK(!source.isOpen());
+                CHECK(source.openWithReadLock());
+                CHECK(source.isOpen());
+                CHECK_EQUAL(static_cast<int64_t>(reference.size()), source.size());
+
+        // Mix copying and zero copy reads.
+        string content;
+        Bytef buffer[10000];
+        while (!source.eof()) {
+            const Bytef *view{nullptr};
+            auto viewLength = source.readView(&view, nullptr, 7000);
+                    CHECK(viewLength > 0);
+            content.append(reinterpret_cast<const char *>(view), static_cast<size_t>(viewLength));
+            auto readLength = source.read(buffer, sizeof(buffer));
+            content.append(reinterpret_cast<const char *>(buffer), static_cast<size_t>(readLength));
+        }
+                CHECK(content == reference);
+                CHECK_EQUAL(static_cast<int64_t>(reference.size()), source.getTotalReadBytes());
+                CHECK_EQUAL(0, source.read(buffer, 100));
+                CHECK_EQUAL(-1, source.readChar());
+
+        // Positional reads don't change the position.
+                CHECK_EQUAL(100, source.readAt(1000, buffer, 100));
+                CHECK(memcmp(buffer, reference.data() + 1000, 100) == 0);
+                CHECK_EQUAL(10, source.readAt(reference.size() - 10, buffer, 100));
+                CHECK_EQUAL(static_cast<int64_t>(reference.size()), source.tell());
+                CHECK(source.close());
+                CHECK(!source.isOpen());
+                CHECK_EQUAL(-1, source.readAt(0, buffer, 100));
+    }
+
+    TEST (MEMORY_MAPPED_FILE_SOURCE_SEEK) {
+        TestResourcesAndFunctions res(MEMORY_MAPPED_FILE_SOURCE_TEST_SUITE, MEMORY_MAPPED_FILE_SOURCE_SEEK);
+
+        auto ps = TestResourcesAndFunctions::getResource(TEST_FASTQ_LARGE);
+        string reference = TestResourcesAndFunctions::readFile(ps);
+        MemoryMappedFileSource source(ps);
+                CHECK(source.open());
+
+                CHECK_EQUAL(1, source.seek(500, true));
+                CHECK_EQUAL(500, source.tell());
+                CHECK_EQUAL(static_cast<int>(static_cast<Bytef>(reference[500])), source.readChar());
+                CHECK_EQUAL(1, source.skip(99));
+                CHECK_EQUAL(600, source.tell());
+                CHECK_EQUAL(1, source.rewind(100));
+                CHECK_EQUAL(500, source.tell());
+                CHECK_EQUAL(-1, source.seek(-1, true));
+
+                CHECK_EQUAL(1, source.seek(source.size(), true));
+                CHECK(source.eof());
+                CHECK(!source.canRead());
+    }
+
+    TEST (MEMORY_MAPPED_FILE_SOURCE_EMPTY_FILE) {
+        TestResourcesAndFunctions res(MEMORY_MAPPED_FILE_SOURCE_TEST_SUITE, MEMORY_MAPPED_FILE_SOURCE_EMPTY_FILE);
+
+        MemoryMappedFileSource emptySource(res.createEmptyFile("empty"));
+                CHECK(emptySource.open());
+                CHECK(emptySource.empty());
+                CHECK(emptySource.eof());
+        Bytef buffer[10];
+                CHECK_EQUAL(0, emptySource.read(buffer, 10));
+
+        MemoryMappedFileSource missingSource(res.filePath("missing"));
+                CHECK(!missingSource.fulfillsPremises());
+                CHECK(!missingSource.open());
+                CHECK(!missingSource.getErrorMessages().empty());
+    }
+}
@@ -0,0 +1,148 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+const char *const READ_AHEAD_SOURCE_TEST_SUITE = "Test suite for the ReadAheadSource class";
+const char *const READ_AHEAD_SOURCE_READ = "Test sequential reads with both backends";
+const char *const READ_AHEAD_SOURCE_SEEK = "Test seek and tell with both backends";
+const char *const READ_AHEAD_SOURCE_INDEX_AND_EXTRACT = "Test indexing and extraction through a read ahead source";
+
+#include "process/extract/Extractor.h"
+#include "process/index/Indexer.h"
+#include "process/io/ConsoleSink.h"
+#include "process/io/FileSink.h"
+#include "process/io/ReadAheadSource.h"
+#include "TestConstants.h"
+#include "TestResourcesAndFunctions.h"
+#include <UnitTest++/UnitTest++.h>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+const uint TEST_NUMBER_OF_BUFFERS = 3;
+
+const u_int64_t TEST_BUFFER_SIZE = 4096;
+
+string readReferenceContent(const path &file) {
+    ifstream referenceStream(file, ios::binary);
+    return string((istreambuf_iterator<char>(referenceStream)), istreambuf_iterator<char>());
+}
+
+SUITE (READ_AHEAD_SOURCE_TEST_SUITE) {
+    TEST (READ_AHEAD_SOURCE_READ) {
+        TestResourcesAndFunctions res(READ_AHEAD_SOURCE_TEST_SUITE, READ_AHEAD_SOURCE_READ);
+
+        auto ps = TestResourcesAndFunctions::getResource(TEST_FASTQ_LARGE);
+        string reference = readReferenceContent(ps);
+
+        for (auto backend : {READ_AHEAD_IO_URING, READ_AHEAD_THREADS}) {
+            auto source = ReadAheadSource::from(make_shared<FileSource>(ps), TEST_NUMBER_OF_BUFFERS,
+                                                TEST_BUFFER_SIZE, backend);
+                    CHECK(source->open());
+                    CHECK(source->isOpen());
+                    CHECK_EQUAL(static_cast<int64_t>(reference.size()), source->size());
+            if (backend == READ_AHEAD_THREADS)
+                        CHECK_EQUAL(READ_AHEAD_THREADS, source->getActiveBackend());
+
+            // Mix the different read methods and use odd sizes, so reads cross the buffer borders.
+            string content;
+            Bytef buffer[5000];
+            while (!source->eof()) {
+                const Bytef *view{nullptr};
+                int64_t viewLength = source->readView(&view, buffer, 3000);
+                if (viewLength <= 0)
+                    break;
+                content.append(reinterpret_cast<const char *>(view), static_cast<size_t>(viewLength));
+                int64_t readLength = source->read(buffer, 5000);
+                content.append(reinterpret_cast<const char *>(buffer), static_cast<size_t>(readLength));
+                int character = source->readChar();
+                if (character >= 0)
+                    content.push_back(static_cast<char>(character));
+            }
+                    CHECK(content == reference);
+                    CHECK_EQUAL(static_cast<int64_t>(reference.size()), source->tell());
+                    CHECK_EQUAL(static_cast<int64_t>(reference.size()), source->getTotalReadBytes());
+                    CHECK_EQUAL(0, source->read(buffer, 100));
+                    CHECK_EQUAL(-1, source->readChar());
+                    CHECK(source->isGood());
+                    CHECK(source->close());
+                    CHECK(!source->isOpen());
+        }
+    }
+
+    TEST (READ_AHEAD_SOURCE_SEEK) {
+        TestResourcesAndFunctions res(READ_AHEAD_SOURCE_TEST_SUITE, READ_AHEAD_SOURCE_SEEK);
+
+        auto ps = TestResourcesAndFunctions::getResource(TEST_FASTQ_LARGE);
+        string reference = readReferenceContent(ps);
+        auto size = static_cast<int64_t>(reference.size());
+
+        for (auto backend : {READ_AHEAD_IO_URING, READ_AHEAD_THREADS}) {
+            auto source = ReadAheadSource::from(make_shared<FileSource>(ps), TEST_NUMBER_OF_BUFFERS,
+                                                TEST_BUFFER_SIZE, backend);
+                    CHECK(source->open());
+
+            Bytef buffer[100];
+            // Start, jump into requested data, jump far ahead, jump back and relative jumps.
+            for (auto[offset, absolute] : vector<tuple<int64_t, bool>>{{0,            true},
+                                                                       {5000,         true},
+                                                                       {100,          false},
+                                                                       {size / 2,     true},
+                                                                       {1000,         true},
+                                                                       {-500,         false},
+                                                                       {size - 50,    true}}) {
+                int64_t expectedPosition = absolute ? offset : source->tell() + offset;
+                        CHECK_EQUAL(1, source->seek(offset, absolute));
+                        CHECK_EQUAL(expectedPosition, source->tell());
+                int64_t result = source->read(buffer, 100);
+                int64_t expectedResult = min(static_cast<int64_t>(100), size - expectedPosition);
+                        CHECK_EQUAL(expectedResult, result);
+                        CHECK(memcmp(buffer, reference.data() + expectedPosition, static_cast<size_t>(result)) == 0);
+                        CHECK_EQUAL(expectedPosition + result, source->tell());
+            }
+                    CHECK(source->eof());
+            source->close();
+        }
+    }
+
+    TEST (READ_AHEAD_SOURCE_INDEX_AND_EXTRACT) {
+        TestResourcesAndFunctions res(READ_AHEAD_SOURCE_TEST_SUITE, READ_AHEAD_SOURCE_INDEX_AND_EXTRACT);
+
+        auto fastq = TestResourcesAndFunctions::getResource(TEST_FASTQ_LARGE);
+        path index = res.filePath("test.fastq.gz.fqi");
+        path decompressed = res.filePath("test.fastq");
+                CHECK(TestResourcesAndFunctions::extractGZFile(fastq, decompressed));
+        auto lines = TestResourcesAndFunctions::readLinesOfFile(decompressed);
+
+        auto indexer = make_shared<Indexer>(
+                ReadAheadSource::from(make_shared<FileSource>(fastq), TEST_NUMBER_OF_BUFFERS, TEST_BUFFER_SIZE),
+                make_shared<FileSink>(index),
+                make_shared<BlockDistanceStorageDecisionStrategy>(1, true), true, false, false, true);
+                CHECK(indexer->fulfillsPremises());
+        indexer->createIndex();
+                CHECK(indexer->wasSuccessful());
+                CHECK(indexer->getStoredEntries().size() > 10);
+        indexer.reset();
+
+        for (auto backend : {READ_AHEAD_IO_URING, READ_AHEAD_THREADS}) {
+            for (auto[firstLine, lineCount] : vector<tuple<int64_t, int64_t>>{{0,      100},
+                                                                             {12345,  2000},
+                                                                             {80000,  40000},
+                                                                             {159990, 10}}) {
+                Extractor extractor(ReadAheadSource::from(make_shared<FileSource>(fastq), TEST_NUMBER_OF_BUFFERS,
+                                                          TEST_BUFFER_SIZE, backend),
+                                    make_shared<FileSource>(index),
+                                    ConsoleSink::create(),
+                                    false,
+                                    ExtractMode::lines, firstLine, lineCount, DEFAULT_RECORD_SIZE, true);
+                bool ok = extractor.extract();
+                        CHECK(ok);
+                auto extractedLines = extractor.getStoredLines();
+                        CHECK_EQUAL(lineCount, static_cast<int64_t>(extractedLines.size()));
+                        CHECK(TestResourcesAndFunctions::compareVectorContent(lines, extractedLines, firstLine));
+            }
+        }
+    }
+}
@@ -16,6 +16,7 @@ const char *SUITE_BIS_TESTS = "InputStreamTestSuite";
 const char *TEST_STREAM_ISOURCE_OPERATIONS = "Test StreamSource operations";
 const char *TEST_STREAM_ISOURCE_SKIP = "Test StreamSource skip on large dataset";
 const char *TEST_STREAM_PSOURCE_OPERATIONS = "Test FileSource operations";
+const char *TEST_STREAM_ISOURCE_READ_AT = "Test StreamSource positional reads with the default readAt";
 
 path getAndCheckTextFile() {
     path textFile = TestResourcesAndFunctions::getResource("TestTextFile.txt");
@@ -64,6 +65,25 @@ SUITE (SUITE_BIS_TESTS) {
         runInputStreamTest(&Source, file_size(textFile));
     }
 
+    TEST (TEST_STREAM_ISOURCE_READ_AT) {
+        TestResourcesAndFunctions res(SUITE_BIS_TESTS, TEST_STREAM_ISOURCE_READ_AT);
+        path testFile = getAndCheckTextFile();
+        ifstream testData(testFile);
+
+        StreamSource source(&testData);
+        source.open();
+        Byte chunk[30]{0};
+                CHECK(source.read(chunk, sizeof(chunk)) == 30);
+                CHECK(source.tell() == 30);
+
+        // Within the rewind buffer, the default implementation can jump back.
+        Byte buf[16]{0};
+                CHECK(source.readAt(11, buf, 6) == 6);
+                CHECK(string(reinterpret_cast<const char *>(buf)) == string("Second"));
+                CHECK(source.tell() == 30);
+                CHECK(source.readChar() == 'i'); // i of Third line
+    }
+
     TEST (testCanRead) {
         TestResourcesAndFunctions res(SUITE_BIS_TESTS, TEST_STREAM_ISOURCE_OPERATIONS);
         path testFile = getAndCheckTextFile();
@@ -4,4 +4,94 @@
  * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
  */
 
-// Some tests are in SourceTest. Need to move them here and add more.
\ No newline at end of file
+// Some tests are in SourceTest. Need to move them here and add more.
+
+const char *const STREAM_SOURCE_TEST_SUITE = "Test suite for the StreamSource class";
+const char *const STREAM_SOURCE_RING_WRAP_AROUND = "Test reads, views and rewinds across the ring buffer border";
+const char *const STREAM_SOURCE_LARGE_SKIP = "Test large forward skips and the retained history afterwards";
+
+#include "process/io/StreamSource.h"
+#include "TestConstants.h"
+#include "TestResourcesAndFunctions.h"
+#include <UnitTest++/UnitTest++.h>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+string readStreamSourceReference(const path &file) {
+    ifstream referenceStream(file, ios::binary);
+    return string((istreambuf_iterator<char>(referenceStream)), istreambuf_iterator<char>());
+}
+
+SUITE (STREAM_SOURCE_TEST_SUITE) {
+    TEST (STREAM_SOURCE_RING_WRAP_AROUND) {
+        TestResourcesAndFunctions res(STREAM_SOURCE_TEST_SUITE, STREAM_SOURCE_RING_WRAP_AROUND);
+
+        auto ps = TestResourcesAndFunctions::getResource(TEST_FASTQ_LARGE);
+        string reference = readStreamSourceReference(ps);
+        ifstream stream(ps, ios::binary);
+
+        // 4 * 1000 Bytes of history. Odd read sizes make sure, that reads and views cross the end of the ring.
+        StreamSource source(&stream, 4, 1000);
+        string content;
+        Bytef buffer[3000];
+        while (true) {
+            const Bytef *view{nullptr};
+            int64_t viewLength = source.readView(&view, buffer, 700);
+            if (viewLength <= 0)
+                break;
+            content.append(reinterpret_cast<const char *>(view), static_cast<size_t>(viewLength));
+
+            int64_t readLength = source.read(buffer, 1500);
+            content.append(reinterpret_cast<const char *>(buffer), static_cast<size_t>(readLength));
+
+            // Jump back and read the same data again.
+            int64_t back = min(static_cast<int64_t>(3000), source.getRewindBufferSize());
+                    CHECK_EQUAL(back, source.rewind(back));
+            int64_t position = source.tell();
+                    CHECK_EQUAL(back, source.read(buffer, static_cast<int>(back)));
+                    CHECK(memcmp(buffer, reference.data() + position, static_cast<size_t>(back)) == 0);
+        }
+                CHECK(content == reference);
+                CHECK_EQUAL(static_cast<int64_t>(reference.size()), source.tell());
+                CHECK_EQUAL(4000, source.getRewindBufferSize());
+                CHECK_EQUAL(-1, source.readChar());
+
+        // The history is limited to the ring buffer.
+                CHECK_EQUAL(-1, source.rewind(4001));
+                CHECK_EQUAL(4000, source.rewind(4000));
+                CHECK_EQUAL(reference[reference.size() - 4000], static_cast<char>(source.readChar()));
+    }
+
+    TEST (STREAM_SOURCE_LARGE_SKIP) {
+        TestResourcesAndFunctions res(STREAM_SOURCE_TEST_SUITE, STREAM_SOURCE_LARGE_SKIP);
+
+        auto ps = TestResourcesAndFunctions::getResource(TEST_FASTQ_LARGE);
+        string reference = readStreamSourceReference(ps);
+        ifstream stream(ps, ios::binary);
+
+        StreamSource source(&stream, 4, 1024);
+        Bytef buffer[100];
+                CHECK_EQUAL(100, source.read(buffer, 100));
+
+        // Far behind the ring buffer, absolute and relative.
+                CHECK_EQUAL(99900, source.seek(100000, true));
+                CHECK_EQUAL(100000, source.tell());
+                CHECK_EQUAL(4096, source.getRewindBufferSize());
+                CHECK_EQUAL(50000, source.skip(50000));
+                CHECK_EQUAL(150000, source.tell());
+
+        // The last ring buffer length in front of the target can still be read again.
+                CHECK_EQUAL(4096, source.rewind(4096));
+                CHECK_EQUAL(100, source.read(buffer, 100));
+                CHECK(memcmp(buffer, reference.data() + 150000 - 4096, 100) == 0);
+                CHECK_EQUAL(-1, source.seek(100000, true));
+
+        // Skipping over the end stops at the end.
+        auto size = static_cast<int64_t>(reference.size());
+        int64_t position = source.tell();
+                CHECK_EQUAL(size - position, source.skip(size));
+                CHECK_EQUAL(size, source.tell());
+                CHECK(!source.canRead());
+    }
+}
@@ -0,0 +1,63 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#include "process/io/s3/FQIS3Client.h"
+#include <UnitTest++/UnitTest++.h>
+
+const char *const FQIS3CLIENT_TEST_SUITE = "Test suite for the FQIS3Client class";
+const char *const FQIS3CLIENT_SPLIT_S3_PATH = "Test splitting S3 paths into bucket and object name";
+const char *const FQIS3CLIENT_COMPLETE_RANGE_RESPONSE = "Test the validation of ranged responses";
+const char *const FQIS3CLIENT_REPEATED_ATTEMPTS = "Test that repeated attempts of a ranged request start at the beginning of the buffer";
+
+SUITE (FQIS3CLIENT_TEST_SUITE) {
+
+    TEST (FQIS3CLIENT_SPLIT_S3_PATH) {
+        auto[valid, bucket, object] = FQIS3Client::splitS3Path("s3://bucket/object.fastq.gz");
+                CHECK(valid);
+                CHECK(bucket == "bucket");
+                CHECK(object == "object.fastq.gz");
+
+        tie(valid, bucket, object) = FQIS3Client::splitS3Path("s3://bucket/runs/1/object.fastq.gz");
+                CHECK(valid);
+                CHECK(bucket == "bucket");
+                CHECK(object == "runs/1/object.fastq.gz");
+
+        for (const auto &invalidPath : {"s3://bucket", "s3://bucket/", "s3:///object", "/bucket/object", ""})
+                    CHECK(!get<0>(FQIS3Client::splitS3Path(invalidPath)));
+    }
+
+    TEST (FQIS3CLIENT_REPEATED_ATTEMPTS) {
+        char memory[16]{0};
+        FixedMemoryStreamBuffer target(memory, sizeof(memory));
+
+        // The SDK creates a new response stream for each attempt, the first one breaks off after a part of the body.
+        auto firstAttempt = target.createStreamForAttempt();
+        *firstAttempt << "broken";
+        firstAttempt->flush();
+        delete firstAttempt;
+                CHECK_EQUAL(6, target.getWrittenBytes());
+
+        auto secondAttempt = target.createStreamForAttempt();
+        *secondAttempt << "0123456789abcdef";
+        secondAttempt->flush();
+                CHECK(secondAttempt->good());
+        delete secondAttempt;
+                CHECK_EQUAL(16, target.getWrittenBytes());
+                CHECK(string(memory, sizeof(memory)) == "0123456789abcdef");
+    }
+
+    TEST (FQIS3CLIENT_COMPLETE_RANGE_RESPONSE) {
+                CHECK(FQIS3Client::isCompleteRangeResponse("bytes 100-199/1000", 100, 100, 100));
+        // The range is cut at the end of the object.
+                CHECK(FQIS3Client::isCompleteRangeResponse("bytes 900-999/1000", 900, 200, 100));
+
+        // Short bodies, other ranges and responses to unranged requests.
+                CHECK(!FQIS3Client::isCompleteRangeResponse("bytes 100-199/1000", 100, 100, 50));
+                CHECK(!FQIS3Client::isCompleteRangeResponse("bytes 100-149/1000", 100, 100, 50));
+                CHECK(!FQIS3Client::isCompleteRangeResponse("bytes 0-99/1000", 100, 100, 100));
+                CHECK(!FQIS3Client::isCompleteRangeResponse("", 100, 100, 100));
+    }
+}
@@ -0,0 +1,163 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+const char *const INDEX_CACHE_TEST_SUITE = "Test suite for the IndexCache class";
+const char *const INDEX_CACHE_FETCH = "Test downloading and reusing a cached index";
+const char *const INDEX_CACHE_NEW_VERSION = "Test replacing outdated copies";
+const char *const INDEX_CACHE_FAILURES = "Test failing lookups and downloads";
+const char *const INDEX_CACHE_EXTRACT = "Test extraction with a cached index";
+const char *const INDEX_CACHE_NESTED_KEYS = "Test cache files for object names with slashes";
+
+#include "process/extract/Extractor.h"
+#include "process/index/Indexer.h"
+#include "process/io/ConsoleSink.h"
+#include "process/io/FileSink.h"
+#include "process/io/FileSource.h"
+#include "process/io/s3/IndexCache.h"
+#include "process/io/s3/LocalS3Object.h"
+#include "TestConstants.h"
+#include "TestResourcesAndFunctions.h"
+#include <UnitTest++/UnitTest++.h>
+
+SUITE (INDEX_CACHE_TEST_SUITE) {
+    TEST (INDEX_CACHE_FETCH) {
+        TestResourcesAndFunctions res(INDEX_CACHE_TEST_SUITE, INDEX_CACHE_FETCH);
+
+        auto index = TestResourcesAndFunctions::getResource(TEST_INDEX_LARGE);
+        string reference = TestResourcesAndFunctions::readFile(index);
+        IndexCache cache(res.filePath("cache"));
+
+        auto object = make_shared<LocalS3Object>(index);
+        auto cacheFile = cache.getCacheFile(object);
+                CHECK(cacheFile == res.filePath("cache") / "standin" / index.filename() / "standin.fqi");
+                CHECK(!exists(cacheFile));
+
+        auto source = cache.fetch(object, 4, 64 * 1024);
+                CHECK(source);
+                CHECK(dynamic_pointer_cast<MemoryMappedFileSource>(source));
+                CHECK(exists(cacheFile));
+                CHECK(TestResourcesAndFunctions::readFile(cacheFile) == reference);
+                CHECK_EQUAL(static_cast<int64_t>(reference.size()), object->requestedBytes.load());
+                CHECK(object->maximumRunningRequests > 1);
+
+        // The second lookup only checks the ETag.
+        auto secondObject = make_shared<LocalS3Object>(index);
+        auto secondSource = cache.fetch(secondObject, 4, 64 * 1024);
+                CHECK(secondSource);
+                CHECK_EQUAL(0, secondObject->requestedBytes.load());
+                CHECK(secondSource->open());
+                CHECK_EQUAL(static_cast<int64_t>(reference.size()), secondSource->size());
+                CHECK(cache.getErrorMessages().empty());
+    }
+
+    TEST (INDEX_CACHE_NEW_VERSION) {
+        TestResourcesAndFunctions res(INDEX_CACHE_TEST_SUITE, INDEX_CACHE_NEW_VERSION);
+
+        auto index = TestResourcesAndFunctions::getResource(TEST_INDEX_LARGE);
+        IndexCache cache(res.filePath("cache"));
+
+        auto object = make_shared<LocalS3Object>(index);
+        auto oldCopy = cache.getCacheFile(object);
+                CHECK(cache.fetch(object, 4, 64 * 1024));
+                CHECK(exists(oldCopy));
+
+        auto newObject = make_shared<LocalS3Object>(index);
+        newObject->eTag = "\"new/version\"";
+        auto newCopy = cache.getCacheFile(newObject);
+                CHECK(newCopy.filename() == "new_version.fqi");
+                CHECK(cache.fetch(newObject, 4, 64 * 1024));
+                CHECK(newObject->requestedBytes > 0);
+                CHECK(exists(newCopy));
+                CHECK(!exists(oldCopy));
+    }
+
+    TEST (INDEX_CACHE_FAILURES) {
+        TestResourcesAndFunctions res(INDEX_CACHE_TEST_SUITE, INDEX_CACHE_FAILURES);
+
+        auto index = TestResourcesAndFunctions::getResource(TEST_INDEX_LARGE);
+        IndexCache cache(res.filePath("cache"));
+
+        // Without an ETag, the version of the object is unknown.
+        auto objectWithoutETag = make_shared<LocalS3Object>(index);
+        objectWithoutETag->eTag = "";
+                CHECK(!cache.fetch(objectWithoutETag, 4, 64 * 1024));
+                CHECK(!cache.getErrorMessages().empty());
+
+        // Failed downloads leave nothing behind.
+        auto brokenObject = make_shared<LocalS3Object>(index);
+        brokenObject->failAlways = true;
+        auto cacheFile = cache.getCacheFile(brokenObject);
+                CHECK(!cache.fetch(brokenObject, 4, 64 * 1024));
+                CHECK(!exists(cacheFile));
+                CHECK(directory_iterator(cacheFile.parent_path()) == directory_iterator());
+    }
+
+    TEST (INDEX_CACHE_NESTED_KEYS) {
+        TestResourcesAndFunctions res(INDEX_CACHE_TEST_SUITE, INDEX_CACHE_NESTED_KEYS);
+
+        auto index = TestResourcesAndFunctions::getResource(TEST_INDEX_LARGE);
+        IndexCache cache(res.filePath("cache"));
+
+        auto nested = make_shared<LocalS3Object>(index, "runs/1/test.fastq.gz.fqi");
+        auto flat = make_shared<LocalS3Object>(index, "runs_1_test.fastq.gz.fqi");
+        auto nestedCopy = cache.getCacheFile(nested);
+        auto flatCopy = cache.getCacheFile(flat);
+                CHECK(!nestedCopy.empty());
+                CHECK(nestedCopy.parent_path().parent_path() == res.filePath("cache") / "standin");
+                CHECK(nestedCopy.parent_path().filename().string().find("runs_1_test.fastq.gz.fqi.") == 0);
+                CHECK(flatCopy.parent_path() == res.filePath("cache") / "standin" / "runs_1_test.fastq.gz.fqi");
+                CHECK(nestedCopy != flatCopy);
+
+                CHECK(cache.fetch(nested, 4, 64 * 1024));
+                CHECK(cache.fetch(flat, 4, 64 * 1024));
+                CHECK(exists(nestedCopy));
+                CHECK(exists(flatCopy));
+
+        // Long names are shortened, but stay unique.
+        auto longName = make_shared<LocalS3Object>(index, string(300, 'a') + "/b");
+        auto otherLongName = make_shared<LocalS3Object>(index, string(300, 'a') + "/c");
+        auto longCopy = cache.getCacheFile(longName);
+                CHECK(longCopy.parent_path().filename().string().size() <= IndexCache::MAXIMUM_FILE_NAME_LENGTH + 17);
+                CHECK(longCopy != cache.getCacheFile(otherLongName));
+                CHECK(cache.fetch(longName, 4, 64 * 1024));
+                CHECK(cache.getErrorMessages().empty());
+    }
+
+    TEST (INDEX_CACHE_EXTRACT) {
+        TestResourcesAndFunctions res(INDEX_CACHE_TEST_SUITE, INDEX_CACHE_EXTRACT);
+
+        auto fastq = TestResourcesAndFunctions::getResource(TEST_FASTQ_LARGE);
+        path index = res.filePath("test2.fastq.gz.fqi");
+        path decompressed = res.filePath("test.fastq");
+                CHECK(TestResourcesAndFunctions::extractGZFile(fastq, decompressed));
+        auto lines = TestResourcesAndFunctions::readLinesOfFile(decompressed);
+
+        auto indexer = make_shared<Indexer>(
+                make_shared<FileSource>(fastq),
+                make_shared<FileSink>(index),
+                make_shared<BlockDistanceStorageDecisionStrategy>(1, true), true, false, false, true);
+        indexer->createIndex();
+                CHECK(indexer->wasSuccessful());
+        indexer.reset();
+
+        IndexCache cache(res.filePath("cache"));
+        for (auto[firstLine, lineCount] : vector<tuple<int64_t, int64_t>>{{0,      100},
+                                                                         {80000,  40000},
+                                                                         {159990, 10}}) {
+            auto indexSource = cache.fetch(make_shared<LocalS3Object>(index), 4, 64 * 1024);
+                    CHECK(indexSource);
+            Extractor extractor(make_shared<FileSource>(fastq),
+                                indexSource,
+                                ConsoleSink::create(),
+                                false,
+                                ExtractMode::lines, firstLine, lineCount, DEFAULT_RECORD_SIZE, true);
+                    CHECK(extractor.extract());
+            auto extractedLines = extractor.getStoredLines();
+                    CHECK_EQUAL(lineCount, static_cast<int64_t>(extractedLines.size()));
+                    CHECK(TestResourcesAndFunctions::compareVectorContent(lines, extractedLines, firstLine));
+        }
+    }
+}
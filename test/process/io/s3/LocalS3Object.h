@@ -0,0 +1,103 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#ifndef FASTQINDEX_LOCALS3OBJECT_H
+#define FASTQINDEX_LOCALS3OBJECT_H
+
+#include "process/io/FileSource.h"
+#include "process/io/s3/S3RangeSource.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <set>
+#include <thread>
+
+/**
+ * Stand-in for an S3 object, which serves ranged requests from a local file. Requests are slowed down a bit, so they
+ * overlap like real network requests.
+ */
+class LocalS3Object : public S3RangeSource {
+
+private:
+
+    FileSource file;
+
+    atomic<int> runningRequests{0};
+
+public:
+
+    atomic<int> maximumRunningRequests{0};
+
+    atomic<int64_t> requestedBytes{0};
+
+    atomic<int> failures{0};
+
+    /**
+     * The first request for each offset fails.
+     */
+    bool failFirstAttempt{false};
+
+    bool failAlways{false};
+
+    /**
+     * The first request for each offset succeeds, but only returns half of the range.
+     */
+    bool shortenFirstAttempt{false};
+
+    mutex failedOffsetsMutex;
+
+    set<int64_t> failedOffsets;
+
+    /**
+     * Change this to simulate a new version of the object.
+     */
+    string eTag{"\"standin\""};
+
+    explicit LocalS3Object(const path &file) : LocalS3Object(file, file.filename().string()) {}
+
+    LocalS3Object(const path &file, const string &objectName) :
+            S3RangeSource("s3://standin/" + objectName), file(file) {
+        this->file.open();
+    }
+
+protected:
+
+    tuple<bool, int64_t, string> fetchObjectSizeAndETag() override {
+        return {true, file.size(), eTag};
+    }
+
+    tuple<bool, int64_t> fetchRange(int64_t offset, int64_t length, Bytef *buffer) override {
+        int running = ++runningRequests;
+        int maximum = maximumRunningRequests;
+        while (running > maximum && !maximumRunningRequests.compare_exchange_weak(maximum, running));
+
+        this_thread::sleep_for(chrono::milliseconds(2));
+        bool fail = failAlways;
+        bool shorten = false;
+        if (failFirstAttempt || shortenFirstAttempt) {
+            lock_guard<mutex> lock(failedOffsetsMutex);
+            bool firstAttempt = failedOffsets.insert(offset).second;
+            fail |= failFirstAttempt && firstAttempt;
+            shorten = shortenFirstAttempt && firstAttempt;
+        }
+        int64_t result = fail ? -1 : file.readAt(offset, buffer, shorten ? length / 2 : length);
+        if (shorten)
+            failures++;
+        if (fail) {
+            // Like a request, which broke off after a part of the body.
+            memset(buffer, '#', static_cast<size_t>(length / 2));
+            failures++;
+        } else {
+            requestedBytes += length;
+        }
+
+        runningRequests--;
+        return {result >= 0, max(result, static_cast<int64_t>(0))};
+    }
+};
+
+#endif //FASTQINDEX_LOCALS3OBJECT_H
@@ -193,6 +193,7 @@ SUITE (S3_CONFIG_TESTS) {
                 CHECK(configuration.proxyHost == "someproxy");
                 CHECK(configuration.endpointOverride == "https://a.nice.s3.host.com");
                 CHECK(configuration.proxyPort == 3128);
+                CHECK(configuration.scheme == Scheme::HTTP);
     }
 
     TEST (TEST_SAFE_GET) {
@@ -11,18 +11,123 @@ const char *const S3_SINK_OPENLOCKED = "Test open and close with lock_unlock";
 const char *const S3_SINK_AQUIRELOCK_LATER = "Test aquire lock after file open";
 const char *const S3_SINK_WRITE_TELL_SEEK = "Test write tell seek rewind functions";
 const char *const S3_SINK_WRITE_OVERWRITEBYTES = "Test write rewind_seek overwrite bytes";
+const char *const S3_SINK_MULTIPART_UPLOAD = "Test a multipart upload with parallel parts";
+const char *const S3_SINK_SMALL_OBJECT = "Test the upload of objects smaller than a part";
+const char *const S3_SINK_PATCH_AND_FAIL = "Test header patches and writes to uploaded parts";
+const char *const S3_SINK_FAILING_UPLOAD = "Test aborting a failed upload";
+const char *const S3_SINK_RETRY_UPLOAD = "Test repeating failed part uploads after a delay";
+const char *const S3_SINK_DISCARD = "Test discarding an upload with closeWithoutPublishing()";
+const char *const S3_SINK_INDEX = "Test writing an index to an S3 sink";
 const char *const S3_PATH("s3://bucket/some.fastq.gz");
 
+#include "process/index/Indexer.h"
+#include "process/io/s3/S3RangeSource.h"
 #include "process/io/s3/S3Sink.h"
+#include "process/io/FileSink.h"
 #include "process/io/FileSource.h"
 #include "TestConstants.h"
 #include "TestResourcesAndFunctions.h"
 #include <UnitTest++/UnitTest++.h>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <thread>
 
 shared_ptr<S3Sink> createTestSink() {
     return S3Sink::from(S3_PATH, true, S3ServiceOptions("", "", ""));
 }
 
+/**
+ * Stand-in for an S3 object, which collects the uploaded parts in memory. Part uploads are slowed down a bit, so they
+ * overlap like real network requests.
+ */
+class MemoryS3Object : public S3Sink {
+
+private:
+
+    mutex partsMutex;
+
+    map<int, string> parts;
+
+    atomic<int> runningUploads{0};
+
+public:
+
+    atomic<int> maximumRunningUploads{0};
+
+    bool failUploads{false};
+
+    /**
+     * The number of part uploads, which fail before the uploads succeed.
+     */
+    atomic<int> failingAttempts{0};
+
+    bool usedMultipartUpload{false};
+
+    bool aborted{false};
+
+    string content;
+
+    MemoryS3Object(u_int64_t partSize, uint partsInFlight) : S3Sink("s3://standin/object", partSize, partsInFlight) {}
+
+    ~MemoryS3Object() override {
+        closeWithoutPublishing();
+    }
+
+protected:
+
+    tuple<bool, string> createMultipartUpload() override {
+        usedMultipartUpload = true;
+        return {true, "upload"};
+    }
+
+    tuple<bool, string> uploadPart(const string & /*uploadId*/,
+                                   int partNumber,
+                                   const char *data,
+                                   int64_t length) override {
+        int running = ++runningUploads;
+        int maximum = maximumRunningUploads;
+        while (running > maximum && !maximumRunningUploads.compare_exchange_weak(maximum, running));
+
+        this_thread::sleep_for(chrono::milliseconds(2));
+        runningUploads--;
+        if (failUploads || failingAttempts-- > 0)
+            return {false, ""};
+        lock_guard<mutex> lock(partsMutex);
+        parts[partNumber] = string(data, static_cast<size_t>(length));
+        return {true, "etag" + to_string(partNumber)};
+    }
+
+    bool completeMultipartUpload(const string & /*uploadId*/, const map<int, string> &uploadedParts) override {
+        content.clear();
+        int expectedPartNumber = 1;
+        for (const auto &[partNumber, eTag] : uploadedParts) {
+            if (partNumber != expectedPartNumber++ || eTag != "etag" + to_string(partNumber))
+                return false;
+            content += parts[partNumber];
+        }
+        return true;
+    }
+
+    bool abortMultipartUpload(const string & /*uploadId*/) override {
+        aborted = true;
+        return true;
+    }
+
+    bool putObject(const char *data, int64_t length) override {
+        content = string(data, static_cast<size_t>(length));
+        return true;
+    }
+};
+
+string createS3SinkTestData(size_t length) {
+    string data;
+    for (size_t i = 0; i < length; i++)
+        data += static_cast<char>('A' + (i * 7) % 26);
+    return data;
+}
+
 SUITE (S3_SINK_TEST_SUITE) {
     TEST (S3_SINK_CONSTRUCT) {
         TestResourcesAndFunctions res(S3_SINK_TEST_SUITE, S3_SINK_CONSTRUCT);
@@ -146,4 +251,152 @@ SUITE (S3_SINK_TEST_SUITE) {
 //                CHECK(source->readChar() == '1');
 //        delete source;
 //    }
-}
\ No newline at end of file
+
+    TEST (S3_SINK_MULTIPART_UPLOAD) {
+        TestResourcesAndFunctions res(S3_SINK_TEST_SUITE, S3_SINK_MULTIPART_UPLOAD);
+
+        string data = createS3SinkTestData(100000);
+        MemoryS3Object object(1024, 4);
+                CHECK(object.open());
+        size_t offset = 0;
+        for (size_t chunk = 1; offset < data.size(); chunk = chunk * 3 % 4000 + 1) {
+            auto length = min(chunk, data.size() - offset);
+            object.write(data.c_str() + offset, static_cast<int>(length));
+            offset += length;
+        }
+                CHECK_EQUAL(static_cast<int64_t>(data.size()), object.tell());
+                CHECK_EQUAL(static_cast<int64_t>(data.size()), object.size());
+                CHECK(object.close());
+                CHECK(object.usedMultipartUpload);
+                CHECK(object.content == data);
+                CHECK(object.maximumRunningUploads > 1);
+                CHECK(object.maximumRunningUploads <= 4);
+    }
+
+    TEST (S3_SINK_SMALL_OBJECT) {
+        TestResourcesAndFunctions res(S3_SINK_TEST_SUITE, S3_SINK_SMALL_OBJECT);
+
+        MemoryS3Object object(1024, 4);
+                CHECK(object.open());
+        object.write(string("AShortMessage"));
+        object.seek(0, true);
+        object.write("B");
+                CHECK(object.close());
+                CHECK(!object.usedMultipartUpload);
+                CHECK(object.content == "BShortMessage");
+    }
+
+    TEST (S3_SINK_PATCH_AND_FAIL) {
+        TestResourcesAndFunctions res(S3_SINK_TEST_SUITE, S3_SINK_PATCH_AND_FAIL);
+
+        // The first part can be changed until the end, like the index header.
+        string data = createS3SinkTestData(5000);
+        MemoryS3Object object(1024, 2);
+                CHECK(object.open());
+        object.write(data);
+        object.seek(16, true);
+        object.write("12345678", 8);
+        object.seek(24, true);
+        object.write("ABCDEFGH", 8);
+        // The current part can be changed as well, also behind its end.
+        object.seek(4990, true);
+        object.write("0123456789012345", 16);
+        data.replace(16, 8, "12345678");
+        data.replace(24, 8, "ABCDEFGH");
+        data.replace(4990, 10, "0123456789");
+        data += "012345";
+                CHECK(object.isGood());
+                CHECK(object.close());
+                CHECK(object.content == data);
+
+        // Uploaded parts can't be changed anymore.
+        MemoryS3Object brokenObject(1024, 2);
+                CHECK(brokenObject.open());
+        brokenObject.write(data);
+        brokenObject.seek(2000, true);
+        brokenObject.write("X");
+                CHECK(!brokenObject.isGood());
+                CHECK(!brokenObject.getErrorMessages().empty());
+                CHECK(!brokenObject.close());
+                CHECK(brokenObject.aborted);
+    }
+
+    TEST (S3_SINK_FAILING_UPLOAD) {
+        TestResourcesAndFunctions res(S3_SINK_TEST_SUITE, S3_SINK_FAILING_UPLOAD);
+
+        string data = createS3SinkTestData(100000);
+        MemoryS3Object object(1024, 2);
+        object.failUploads = true;
+                CHECK(object.open());
+        object.write(data);
+                CHECK(!object.isGood());
+                CHECK(!object.close());
+                CHECK(object.aborted);
+                CHECK(!object.getErrorMessages().empty());
+    }
+
+    TEST (S3_SINK_RETRY_UPLOAD) {
+        TestResourcesAndFunctions res(S3_SINK_TEST_SUITE, S3_SINK_RETRY_UPLOAD);
+
+        string data = createS3SinkTestData(3000);
+        MemoryS3Object object(1024, 1);
+        object.failingAttempts = 2;
+        auto start = chrono::steady_clock::now();
+                CHECK(object.open());
+        object.write(data);
+                CHECK(object.close());
+                CHECK(object.content == data);
+        // The second attempt waits for the delay, the third one for twice the delay.
+                CHECK(chrono::steady_clock::now() - start >= 3 * S3RangeSource::RETRY_DELAY);
+    }
+
+    TEST (S3_SINK_DISCARD) {
+        TestResourcesAndFunctions res(S3_SINK_TEST_SUITE, S3_SINK_DISCARD);
+
+        string data = createS3SinkTestData(100000);
+        MemoryS3Object object(1024, 4);
+                CHECK(object.open());
+        object.write(data);
+                CHECK(object.usedMultipartUpload);
+                CHECK(object.closeWithoutPublishing());
+                CHECK(object.aborted);
+                CHECK(!object.isOpen());
+                CHECK(object.content.empty());
+
+        // Nothing was uploaded yet, so there is nothing to abort.
+        MemoryS3Object smallObject(1024, 4);
+                CHECK(smallObject.open());
+        smallObject.write(data.substr(0, 100));
+                CHECK(smallObject.closeWithoutPublishing());
+                CHECK(!smallObject.usedMultipartUpload);
+                CHECK(!smallObject.aborted);
+                CHECK(smallObject.content.empty());
+    }
+
+    TEST (S3_SINK_INDEX) {
+        TestResourcesAndFunctions res(S3_SINK_TEST_SUITE, S3_SINK_INDEX);
+
+        auto fastq = TestResourcesAndFunctions::getResource(TEST_FASTQ_LARGE);
+        path index = res.filePath("test.fastq.gz.fqi");
+        auto createIndexer = [&](const shared_ptr<Sink> &sink) {
+            return make_shared<Indexer>(make_shared<FileSource>(fastq), sink,
+                                        make_shared<BlockDistanceStorageDecisionStrategy>(1, true),
+                                        true, false, false, true);
+        };
+
+        auto indexer = createIndexer(make_shared<FileSink>(index));
+        indexer->createIndex();
+                CHECK(indexer->wasSuccessful());
+        indexer.reset();
+        ifstream referenceStream(index, ios::binary);
+        string reference((istreambuf_iterator<char>(referenceStream)), istreambuf_iterator<char>());
+
+        auto object = make_shared<MemoryS3Object>(64 * 1024, 4);
+        indexer = createIndexer(object);
+        indexer->createIndex();
+                CHECK(indexer->wasSuccessful());
+        indexer.reset();
+                CHECK(object->usedMultipartUpload);
+                CHECK(object->content == reference);
+    }
+}
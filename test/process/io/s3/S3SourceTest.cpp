@@ -0,0 +1,200 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+const char *const S3_SOURCE_TEST_SUITE = "Test suite for the S3Source class";
+const char *const S3_SOURCE_PARALLEL_READ = "Test parallel ranged reads of a whole object";
+const char *const S3_SOURCE_SEEK_AND_ADVISE = "Test seek and bounded prefetching";
+const char *const S3_SOURCE_FAILING_REQUESTS = "Test retries and failing requests";
+const char *const S3_SOURCE_EXTRACT = "Test extraction from an S3 source";
+
+#include "process/extract/Extractor.h"
+#include "process/index/Indexer.h"
+#include "process/io/ConsoleSink.h"
+#include "process/io/FileSink.h"
+#include "process/io/FileSource.h"
+#include "process/io/s3/LocalS3Object.h"
+#include "process/io/s3/S3Source.h"
+#include "TestConstants.h"
+#include "TestResourcesAndFunctions.h"
+#include <UnitTest++/UnitTest++.h>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+string readS3SourceReference(const path &file) {
+    ifstream referenceStream(file, ios::binary);
+    return string((istreambuf_iterator<char>(referenceStream)), istreambuf_iterator<char>());
+}
+
+SUITE (S3_SOURCE_TEST_SUITE) {
+    TEST (S3_SOURCE_PARALLEL_READ) {
+        TestResourcesAndFunctions res(S3_SOURCE_TEST_SUITE, S3_SOURCE_PARALLEL_READ);
+
+        auto ps = TestResourcesAndFunctions::getResource(TEST_FASTQ_LARGE);
+        string reference = readS3SourceReference(ps);
+        auto object = make_shared<LocalS3Object>(ps);
+        S3Source source(object, 6, 64 * 1024);
+
+                CHECK(source.fulfillsPremises());
+                CHECK(source.open());
+                CHECK_EQUAL(static_cast<int64_t>(reference.size()), source.size());
+
+        string content;
+        Bytef buffer[10000];
+        int64_t result;
+        while ((result = source.read(buffer, sizeof(buffer))) > 0)
+            content.append(reinterpret_cast<const char *>(buffer), static_cast<size_t>(result));
+
+                CHECK(content == reference);
+                CHECK(source.eof());
+                CHECK(object->maximumRunningRequests > 1);
+                CHECK_EQUAL(static_cast<int64_t>(reference.size()), object->requestedBytes.load());
+                CHECK(source.close());
+    }
+
+    TEST (S3_SOURCE_SEEK_AND_ADVISE) {
+        TestResourcesAndFunctions res(S3_SOURCE_TEST_SUITE, S3_SOURCE_SEEK_AND_ADVISE);
+
+        auto ps = TestResourcesAndFunctions::getResource(TEST_FASTQ_LARGE);
+        string reference = readS3SourceReference(ps);
+        auto object = make_shared<LocalS3Object>(ps);
+        const u_int64_t partSize = 16 * 1024;
+        S3Source source(object, 4, partSize);
+                CHECK(source.open());
+
+        // Only a small range is needed, nothing far behind it may be downloaded.
+        int64_t start = 1000000;
+        source.adviseRange(start, 50000);
+                CHECK_EQUAL(1, source.seek(start, true));
+                CHECK_EQUAL(start, source.tell());
+
+        Bytef buffer[50000];
+                CHECK_EQUAL(50000, source.read(buffer, 50000));
+                CHECK(memcmp(buffer, reference.data() + start, 50000) == 0);
+                CHECK_EQUAL(50000, object->requestedBytes.load());
+
+        // Reads behind the advised range still work. The range is extended by one part first, then by two parts.
+                CHECK_EQUAL(1000, source.read(buffer, 1000));
+                CHECK(memcmp(buffer, reference.data() + start + 50000, 1000) == 0);
+                CHECK_EQUAL(static_cast<int64_t>(50000 + partSize), object->requestedBytes.load());
+                CHECK_EQUAL(static_cast<int64_t>(partSize), source.read(buffer, partSize));
+                CHECK(memcmp(buffer, reference.data() + start + 51000, partSize) == 0);
+                CHECK_EQUAL(static_cast<int64_t>(50000 + 3 * partSize), object->requestedBytes.load());
+
+        // Jump back, this starts new ranges.
+                CHECK_EQUAL(1, source.seek(10, true));
+                CHECK_EQUAL(100, source.read(buffer, 100));
+                CHECK(memcmp(buffer, reference.data() + 10, 100) == 0);
+
+        // Positional reads bypass the prefetch window.
+                CHECK_EQUAL(100, source.readAt(2000000, buffer, 100));
+                CHECK(memcmp(buffer, reference.data() + 2000000, 100) == 0);
+                CHECK_EQUAL(110, source.tell());
+        source.close();
+    }
+
+    TEST (S3_SOURCE_FAILING_REQUESTS) {
+        TestResourcesAndFunctions res(S3_SOURCE_TEST_SUITE, S3_SOURCE_FAILING_REQUESTS);
+
+        auto ps = TestResourcesAndFunctions::getResource(TEST_FASTQ_LARGE);
+        string reference = readS3SourceReference(ps);
+
+        // Single failures are retried.
+        auto object = make_shared<LocalS3Object>(ps);
+        object->failFirstAttempt = true;
+        S3Source source(object, 4, 256 * 1024);
+                CHECK(source.open());
+        string content;
+        Bytef buffer[100000];
+        int64_t result;
+        while ((result = source.read(buffer, sizeof(buffer))) > 0)
+            content.append(reinterpret_cast<const char *>(buffer), static_cast<size_t>(result));
+                CHECK(content == reference);
+                CHECK(object->failures > 0);
+                CHECK(source.getErrorMessages().empty());
+        source.close();
+
+        // Short answers are retried as well, they would otherwise look like the end of the object.
+        auto shortObject = make_shared<LocalS3Object>(ps);
+        shortObject->shortenFirstAttempt = true;
+        S3Source shortSource(shortObject, 4, 256 * 1024);
+                CHECK(shortSource.open());
+        content.clear();
+        while ((result = shortSource.read(buffer, sizeof(buffer))) > 0)
+            content.append(reinterpret_cast<const char *>(buffer), static_cast<size_t>(result));
+                CHECK(content == reference);
+                CHECK(shortObject->failures > 0);
+        shortSource.close();
+
+        // If every request fails, the read fails.
+        auto brokenObject = make_shared<LocalS3Object>(ps);
+        brokenObject->failAlways = true;
+        S3Source brokenSource(brokenObject, 4, 256 * 1024);
+                CHECK(brokenSource.open());
+        auto start = chrono::steady_clock::now();
+                CHECK_EQUAL(-1, brokenSource.read(buffer, 100));
+        // The repetitions wait a bit longer each time.
+                CHECK(chrono::steady_clock::now() - start >= 3 * S3RangeSource::RETRY_DELAY);
+                CHECK(!brokenSource.isGood());
+                CHECK(!brokenSource.getErrorMessages().empty());
+        brokenSource.close();
+    }
+
+    TEST (S3_SOURCE_EXTRACT) {
+        TestResourcesAndFunctions res(S3_SOURCE_TEST_SUITE, S3_SOURCE_EXTRACT);
+
+        auto fastq = TestResourcesAndFunctions::getResource(TEST_FASTQ_LARGE);
+        path index = res.filePath("test.fastq.gz.fqi");
+        path decompressed = res.filePath("test.fastq");
+                CHECK(TestResourcesAndFunctions::extractGZFile(fastq, decompressed));
+        auto lines = TestResourcesAndFunctions::readLinesOfFile(decompressed);
+
+        auto indexer = make_shared<Indexer>(
+                make_shared<S3Source>(make_shared<LocalS3Object>(fastq), 4, 64 * 1024),
+                make_shared<FileSink>(index),
+                make_shared<BlockDistanceStorageDecisionStrategy>(1, true), true, false, false, true);
+                CHECK(indexer->fulfillsPremises());
+        indexer->createIndex();
+                CHECK(indexer->wasSuccessful());
+        indexer.reset();
+
+        for (auto[firstLine, lineCount] : vector<tuple<int64_t, int64_t>>{{0,      100},
+                                                                         {80000,  40000},
+                                                                         {159990, 10}}) {
+            auto object = make_shared<LocalS3Object>(fastq);
+            Extractor extractor(make_shared<S3Source>(object, 4, 64 * 1024),
+                                make_shared<FileSource>(index),
+                                ConsoleSink::create(),
+                                false,
+                                ExtractMode::lines, firstLine, lineCount, DEFAULT_RECORD_SIZE, true);
+            bool ok = extractor.extract();
+                    CHECK(ok);
+            auto extractedLines = extractor.getStoredLines();
+                    CHECK_EQUAL(lineCount, static_cast<int64_t>(extractedLines.size()));
+                    CHECK(TestResourcesAndFunctions::compareVectorContent(lines, extractedLines, firstLine));
+
+            // Only the range between the used index entry and the end offset is downloaded.
+            int64_t startOffset = extractor.getUsedIndexEntry()->blockOffsetInRawFile;
+            int64_t endOffset = extractor.getExtractionEndOffset();
+            if (endOffset < 0)
+                endOffset = object->size();
+                    CHECK(object->requestedBytes <= endOffset - startOffset + 1);
+        }
+
+        // A few records from the start of the file are only a small part of the file.
+        {
+            auto object = make_shared<LocalS3Object>(fastq);
+            Extractor extractor(make_shared<S3Source>(object, 4, 256 * 1024),
+                                make_shared<FileSource>(index),
+                                ConsoleSink::create(),
+                                false,
+                                ExtractMode::lines, 0, 1000, DEFAULT_RECORD_SIZE, true);
+                    CHECK(extractor.extract());
+                    CHECK(extractor.getExtractionEndOffset() > 0);
+                    CHECK(object->requestedBytes < object->size() / 10);
+        }
+    }
+}
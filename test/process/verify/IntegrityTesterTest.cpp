@@ -0,0 +1,92 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#include "process/index/Indexer.h"
+#include "process/io/FileSink.h"
+#include "process/io/FileSource.h"
+#include "process/verify/IntegrityTester.h"
+#include "TestConstants.h"
+#include "TestResourcesAndFunctions.h"
+#include <fstream>
+#include <UnitTest++/UnitTest++.h>
+
+const char *const INTEGRITY_TESTER_TESTS = "Test suite for the IntegrityTester class";
+const char *const TEST_INTACT_CONCATENATED_FILE = "Test an intact file with concatenated gzip streams";
+const char *const TEST_WRONG_TRAILER_CRC = "Test a file with a wrong CRC32 in the gzip trailer";
+const char *const TEST_CORRUPT_SECOND_STREAM = "Test a file with corrupt data in the second gzip stream";
+
+/**
+ * Creates a file of 3 concatenated test2.fastq.gz files and its index.
+ */
+void createConcatenatedFileAndIndex(const path &fastq, const path &index) {
+            CHECK(TestResourcesAndFunctions::createConcatenatedFile(
+                    TestResourcesAndFunctions::getResource(TEST_FASTQ_LARGE), fastq, 3));
+    Indexer indexer(make_shared<FileSource>(fastq), make_shared<FileSink>(index),
+                    BlockDistanceStorageDecisionStrategy::from(1), false, true);
+            CHECK(indexer.fulfillsPremises() && indexer.createIndex());
+}
+
+void invertByte(const path &file, int64_t position) {
+    fstream stream(file, ios::in | ios::out | ios::binary);
+    stream.seekg(position);
+    char value = static_cast<char>(~stream.get());
+    stream.seekp(position);
+    stream.put(value);
+}
+
+shared_ptr<IntegrityTester> createTester(const path &fastq, const path &index, uint threads) {
+    auto tester = make_shared<IntegrityTester>([fastq]() { return make_shared<FileSource>(fastq); },
+                                               make_shared<FileSource>(index), threads);
+            CHECK(tester->fulfillsPremises());
+    return tester;
+}
+
+SUITE (INTEGRITY_TESTER_TESTS) {
+
+    TEST (TEST_INTACT_CONCATENATED_FILE) {
+        TestResourcesAndFunctions res(INTEGRITY_TESTER_TESTS, TEST_INTACT_CONCATENATED_FILE);
+
+        path fastq = res.filePath("test2_concat.fastq.gz");
+        path index = res.filePath("test2_concat.fastq.gz.fqi");
+        createConcatenatedFileAndIndex(fastq, index);
+
+        auto tester = createTester(fastq, index, 4);
+                CHECK(tester->test());
+                CHECK_EQUAL(3U, tester->getNumberOfStreams());
+                CHECK(tester->getDecompressedBytes() > file_size(fastq));
+                CHECK_EQUAL(-1, tester->getFirstCorruptInterval());
+    }
+
+    TEST (TEST_WRONG_TRAILER_CRC) {
+        TestResourcesAndFunctions res(INTEGRITY_TESTER_TESTS, TEST_WRONG_TRAILER_CRC);
+
+        path fastq = res.filePath("test2_concat.fastq.gz");
+        path index = res.filePath("test2_concat.fastq.gz.fqi");
+        createConcatenatedFileAndIndex(fastq, index);
+        // The CRC32 of the last stream.
+        invertByte(fastq, file_size(fastq) - 8);
+
+        auto tester = createTester(fastq, index, 4);
+                CHECK(!tester->test());
+                CHECK_EQUAL(2U, tester->getNumberOfStreams());
+                CHECK(tester->getFirstCorruptInterval() > 0);
+    }
+
+    TEST (TEST_CORRUPT_SECOND_STREAM) {
+        TestResourcesAndFunctions res(INTEGRITY_TESTER_TESTS, TEST_CORRUPT_SECOND_STREAM);
+
+        path fastq = res.filePath("test2_concat.fastq.gz");
+        path index = res.filePath("test2_concat.fastq.gz.fqi");
+        createConcatenatedFileAndIndex(fastq, index);
+        int64_t streamSize = file_size(TestResourcesAndFunctions::getResource(TEST_FASTQ_LARGE));
+        invertByte(fastq, streamSize + streamSize / 2);
+
+        auto tester = createTester(fastq, index, 2);
+                CHECK(!tester->test());
+                CHECK_EQUAL(1U, tester->getNumberOfStreams());
+                CHECK(tester->getFirstCorruptInterval() > 0);
+    }
+}
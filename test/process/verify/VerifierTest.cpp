@@ -0,0 +1,172 @@
+/**
+ * Copyright (c) 2019 DKFZ - ODCF
+ *
+ * Distributed under the MIT License (license terms are at https://github.com/dkfz-odcf/FastqIndEx/blob/master/LICENSE.txt).
+ */
+
+#include "process/base/IndexEntryV1.h"
+#include "process/base/IndexHeader.h"
+#include "process/extract/IndexReader.h"
+#include "process/index/Indexer.h"
+#include "process/io/FileSink.h"
+#include "process/io/FileSource.h"
+#include "process/verify/Verifier.h"
+#include "TestConstants.h"
+#include "TestResourcesAndFunctions.h"
+#include <fstream>
+#include <sstream>
+#include <UnitTest++/UnitTest++.h>
+
+const char *const VERIFIER_TESTS = "Test suite for the Verifier class";
+const char *const TEST_VERIFY_CORRECT_INDEX = "Test verification of a correct index with spot checks";
+const char *const TEST_VERIFY_CONCATENATED_FILE = "Test verification of an index for concatenated gzip streams";
+const char *const TEST_VERIFY_DETECTS_WRONG_ENTRY = "Test verification of an index with a wrong starting line";
+const char *const TEST_VERIFY_DETECTS_WRONG_LINE_COUNT = "Test verification of an index with a wrong line count";
+const char *const TEST_VERIFY_RECORD_AWARE_INDEX = "Test verification of a record aware index with spot checks";
+const char *const TEST_VERIFY_LONG_LINES = "Test verification of an index for lines longer than 64kB";
+
+bool createIndexForVerification(const path &fastq, const path &index, bool recordAware = false) {
+    Indexer indexer(make_shared<FileSource>(fastq), make_shared<FileSink>(index),
+                    BlockDistanceStorageDecisionStrategy::from(1), false, true, false, false);
+    indexer.setRecordAwareIndexing(recordAware);
+    return indexer.fulfillsPremises() && indexer.createIndex();
+}
+
+shared_ptr<Verifier> createVerifier(const path &fastq, const path &index, uint threads, uint spotChecks = 0) {
+    return make_shared<Verifier>([fastq]() { return make_shared<FileSource>(fastq); }, make_shared<FileSource>(index),
+                                 threads, spotChecks);
+}
+
+/**
+ * Reads a struct from the index file, changes it and writes it back.
+ */
+template<typename T, typename F>
+void modifyIndexFile(const path &index, int64_t position, F modify) {
+    fstream file(index, ios::in | ios::out | ios::binary);
+    T value;
+    file.seekg(position);
+    file.read(reinterpret_cast<char *>(&value), sizeof(T));
+    modify(value);
+    file.seekp(position);
+    file.write(reinterpret_cast<char *>(&value), sizeof(T));
+}
+
+SUITE (VERIFIER_TESTS) {
+
+    TEST (TEST_VERIFY_CORRECT_INDEX) {
+        TestResourcesAndFunctions res(VERIFIER_TESTS, TEST_VERIFY_CORRECT_INDEX);
+
+        path fastq = res.getResource(TEST_FASTQ_LARGE);
+        path index = res.filePath("test2.fastq.gz.fqi");
+                CHECK(createIndexForVerification(fastq, index));
+
+        auto verifier = createVerifier(fastq, index, 4, 20);
+                CHECK(verifier->fulfillsPremises());
+        stringstream console;
+        auto cerrBuffer = cerr.rdbuf(console.rdbuf());
+        bool verified = verifier->verify();
+        cerr.rdbuf(cerrBuffer);
+                CHECK(verified);
+                CHECK_EQUAL(0U, verifier->getNumberOfProblems());
+                CHECK_EQUAL(160000U, verifier->getLinesInFile());
+                CHECK_EQUAL(20U, verifier->getNumberOfPassedSpotChecks());
+        // The spot checks don't print their index entries.
+                CHECK(console.str().find("Entry number:") == string::npos);
+                CHECK(console.str().find("20 of 20 spot checks passed.") != string::npos);
+    }
+
+    TEST (TEST_VERIFY_CONCATENATED_FILE) {
+        TestResourcesAndFunctions res(VERIFIER_TESTS, TEST_VERIFY_CONCATENATED_FILE);
+
+        path fastq = res.filePath("test2_concat.fastq.gz");
+        path index = res.filePath("test2_concat.fastq.gz.fqi");
+                CHECK(TestResourcesAndFunctions::createConcatenatedFile(res.getResource(TEST_FASTQ_LARGE), fastq, 3));
+                CHECK(createIndexForVerification(fastq, index));
+
+        auto verifier = createVerifier(fastq, index, 3, 10);
+                CHECK(verifier->fulfillsPremises());
+                CHECK(verifier->verify());
+                CHECK_EQUAL(480000U, verifier->getLinesInFile());
+                CHECK_EQUAL(10U, verifier->getNumberOfPassedSpotChecks());
+    }
+
+    TEST (TEST_VERIFY_DETECTS_WRONG_ENTRY) {
+        TestResourcesAndFunctions res(VERIFIER_TESTS, TEST_VERIFY_DETECTS_WRONG_ENTRY);
+
+        path fastq = res.getResource(TEST_FASTQ_LARGE);
+        path index = res.filePath("test2.fastq.gz.fqi");
+                CHECK(createIndexForVerification(fastq, index));
+
+        // The dictionaries are not compressed, so all entries have the same size.
+        int64_t entryPosition = sizeof(IndexHeader) + 5 * sizeof(IndexEntryV1);
+        modifyIndexFile<IndexEntryV1>(index, entryPosition, [](IndexEntryV1 &entry) { entry.startingLineInEntry++; });
+
+        auto verifier = createVerifier(fastq, index, 2);
+                CHECK(verifier->fulfillsPremises());
+                CHECK(!verifier->verify());
+                CHECK_EQUAL(1U, verifier->getNumberOfProblems());
+        auto messages = verifier->getErrorMessages();
+                CHECK(!messages.empty() && messages[0].find("Index entry #5 has the starting line") == 0);
+    }
+
+    TEST (TEST_VERIFY_DETECTS_WRONG_LINE_COUNT) {
+        TestResourcesAndFunctions res(VERIFIER_TESTS, TEST_VERIFY_DETECTS_WRONG_LINE_COUNT);
+
+        path fastq = res.getResource(TEST_FASTQ_LARGE);
+        path index = res.filePath("test2.fastq.gz.fqi");
+                CHECK(createIndexForVerification(fastq, index));
+        modifyIndexFile<IndexHeader>(index, 0, [](IndexHeader &header) { header.linesInIndexedFile = 159999; });
+
+        auto verifier = createVerifier(fastq, index, 2);
+                CHECK(verifier->fulfillsPremises());
+                CHECK(!verifier->verify());
+                CHECK_EQUAL(1U, verifier->getNumberOfProblems());
+                CHECK_EQUAL(160000U, verifier->getLinesInFile());
+    }
+
+    TEST (TEST_VERIFY_RECORD_AWARE_INDEX) {
+        TestResourcesAndFunctions res(VERIFIER_TESTS, TEST_VERIFY_RECORD_AWARE_INDEX);
+
+        path fastq = res.filePath("test2_concat.fastq.gz");
+        path index = res.filePath("test2_concat.fastq.gz.fqi");
+                CHECK(TestResourcesAndFunctions::createConcatenatedFile(res.getResource(TEST_FASTQ_LARGE), fastq, 2));
+                CHECK(createIndexForVerification(fastq, index, true));
+
+        // The spot checks extract the lines with the record aware index.
+        auto verifier = createVerifier(fastq, index, 4, 50);
+                CHECK(verifier->fulfillsPremises());
+                CHECK(verifier->verify());
+                CHECK_EQUAL(0U, verifier->getNumberOfProblems());
+                CHECK_EQUAL(320000U, verifier->getLinesInFile());
+                CHECK_EQUAL(50U, verifier->getNumberOfPassedSpotChecks());
+
+        // Without the header flag, the entries are checked like line based entries, most of them don't match then.
+        modifyIndexFile<IndexHeader>(index, 0, [](IndexHeader &header) { header.entriesStartWithRecords = false; });
+        verifier = createVerifier(fastq, index, 4);
+                CHECK(verifier->fulfillsPremises());
+                CHECK(!verifier->verify());
+    }
+
+    TEST (TEST_VERIFY_LONG_LINES) {
+        TestResourcesAndFunctions res(VERIFIER_TESTS, TEST_VERIFY_LONG_LINES);
+
+        path fastq = res.filePath("longreads.fastq.gz");
+        path index = res.filePath("longreads.fastq.gz.fqi");
+        TestResourcesAndFunctions::createFastqWithLongReads(fastq, 60);
+                CHECK(createIndexForVerification(fastq, index));
+
+        // The offsets of the line starts need more than 16 Bit.
+        IndexReader reader(make_shared<FileSource>(index));
+                CHECK(reader.tryOpenAndReadHeader());
+        u_int32_t largestOffset = 0;
+        while (reader.getIndicesLeft() > 0)
+            largestOffset = max(largestOffset, reader.readIndexEntry()->offsetToNextLineStart);
+                CHECK(largestOffset > 65535U);
+
+        auto verifier = createVerifier(fastq, index, 4, 20);
+                CHECK(verifier->fulfillsPremises());
+                CHECK(verifier->verify());
+                CHECK_EQUAL(0U, verifier->getNumberOfProblems());
+                CHECK_EQUAL(240U, verifier->getLinesInFile());
+    }
+}